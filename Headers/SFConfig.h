@@ -19,6 +19,12 @@
 
 /* #define SF_CONFIG_UNITY */
 
+/*
+ * Define to compute the variation deltas in fixed point arithmetic, which is faster on machines
+ * without a floating point unit and gives identical results on all machines.
+ */
+/* #define SF_CONFIG_FIXED_VARIATIONS */
+
 #ifdef SF_CONFIG_UNITY
 #define SF_INTERNAL static
 #define SF_PRIVATE  static
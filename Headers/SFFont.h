@@ -30,6 +30,13 @@ typedef SFUInt32 SFFontLayout;
  */
 typedef struct _SFFont *SFFontRef;
 
+/**
+ * A 128-bit hash identifying the shaping relevant data of a font.
+ */
+typedef struct SFFontFingerprint {
+    SFUInt32 words[4]; /**< The words of the hash. */
+} SFFontFingerprint;
+
 /**
  * The function invoked when a font is about to be deallocated.
  *
@@ -65,6 +72,22 @@ typedef void (*SFFontProtocolLoadTableFunc)(void *object, SFTag tableTag, SFUInt
  */
 typedef SFGlyphID (*SFFontProtocolGetGlyphIDForCodepointFunc)(void *object, SFCodepoint codepoint);
 
+/**
+ * The function used to get the glyph IDs of a sequence of code points in a single call.
+ *
+ * @param object
+ *      The object associated with the font.
+ * @param codepoints
+ *      The array of code points for which to get the glyph IDs.
+ * @param glyphIDs
+ *      The array that takes the glyph IDs of the passed-in code points. It has the same length as
+ *      the code points array.
+ * @param count
+ *      The number of code points in the array.
+ */
+typedef void (*SFFontProtocolGetGlyphIDsForCodepointsFunc)(void *object,
+    const SFCodepoint *codepoints, SFGlyphID *glyphIDs, SFUInteger count);
+
 /**
  * The function used to get the advance of a glyph.
  *
@@ -79,8 +102,57 @@ typedef SFGlyphID (*SFFontProtocolGetGlyphIDForCodepointFunc)(void *object, SFCo
  */
 typedef SFAdvance (*SFFontProtocolGetAdvanceForGlyphFunc)(void *object, SFFontLayout fontLayout, SFGlyphID glyphID);
 
+/**
+ * The function used to get the advances of a sequence of glyphs in a single call.
+ *
+ * @param object
+ *      The object associated with the font.
+ * @param fontLayout
+ *      The drawing layout of the glyphs.
+ * @param glyphIDs
+ *      The array of glyph IDs for which to get the advances.
+ * @param advances
+ *      The array that takes the advances of the passed-in glyph IDs. It has the same length as the
+ *      glyph IDs array.
+ * @param count
+ *      The number of glyph IDs in the array.
+ */
+typedef void (*SFFontProtocolGetAdvancesForGlyphsFunc)(void *object, SFFontLayout fontLayout,
+    const SFGlyphID *glyphIDs, SFAdvance *advances, SFUInteger count);
+
+/**
+ * The function used to get a pointer to the data of a font table without copying it.
+ *
+ * @param object
+ *      The object associated with the font.
+ * @param tableTag
+ *      The tag of the table to get.
+ * @param length
+ *      The pointer that takes the length of the table.
+ * @return
+ *      A pointer to the data of the table, or NULL if the font does not contain the table. The data
+ *      must remain valid until it is released with the releaseTablePointer function.
+ */
+typedef const SFUInt8 *(*SFFontProtocolGetTablePointerFunc)(void *object, SFTag tableTag, SFUInteger *length);
+
+/**
+ * The function invoked when a font no longer needs a table obtained with getTablePointer.
+ *
+ * @param object
+ *      The object associated with the font.
+ * @param tableTag
+ *      The tag of the table being released.
+ * @param pointer
+ *      The pointer that was returned by getTablePointer for the table.
+ */
+typedef void (*SFFontProtocolReleaseTablePointerFunc)(void *object, SFTag tableTag, const SFUInt8 *pointer);
+
 /**
  * Structure containing the functions of a SFFont.
+ *
+ * The tables of a font are loaded lazily, when they are needed for the first time by a scheme or a
+ * shaping call. So the table functions may be invoked after the font has been created, from the
+ * thread using the font at that time, but never concurrently for the same font.
  */
 typedef struct _SFFontProtocol {
     /**
@@ -88,18 +160,40 @@ typedef struct _SFFontProtocol {
      */
     SFFontProtocolFinalizeFunc finalize;
     /**
-     * The function used to load the table of a font into a buffer.
+     * The function used to load the table of a font into a buffer. This function may be NULL if
+     * getTablePointer is implemented.
      */
     SFFontProtocolLoadTableFunc loadTable;
     /**
-     * The function used to get the glyph ID of a code point.
+     * The function used to get the glyph ID of a code point. This function may be NULL if
+     * getGlyphIDsForCodepoints is implemented.
      */
     SFFontProtocolGetGlyphIDForCodepointFunc getGlyphIDForCodepoint;
     /**
      * The function used to get the advance of a glyph. This function may be NULL, which is
-     * equivalent to a getAdvanceForGlyph function that always returns 0.
+     * equivalent to a getAdvanceForGlyph function that always returns 0, unless
+     * getAdvancesForGlyphs is implemented.
      */
     SFFontProtocolGetAdvanceForGlyphFunc getAdvanceForGlyph;
+    /**
+     * The function used to borrow the table of a font without copying it. This function may be
+     * NULL. If implemented, it is preferred over loadTable.
+     */
+    SFFontProtocolGetTablePointerFunc getTablePointer;
+    /**
+     * The function used to release a borrowed table. This function may be NULL.
+     */
+    SFFontProtocolReleaseTablePointerFunc releaseTablePointer;
+    /**
+     * The function used to get the glyph IDs of all code points of a text in a single call. This
+     * function may be NULL. If implemented, it is preferred over getGlyphIDForCodepoint.
+     */
+    SFFontProtocolGetGlyphIDsForCodepointsFunc getGlyphIDsForCodepoints;
+    /**
+     * The function used to get the advances of all glyphs of a text in a single call. This
+     * function may be NULL. If implemented, it is preferred over getAdvanceForGlyph.
+     */
+    SFFontProtocolGetAdvancesForGlyphsFunc getAdvancesForGlyphs;
 } SFFontProtocol;
 
 /**
@@ -114,9 +208,120 @@ typedef struct _SFFontProtocol {
  */
 SFFontRef SFFontCreateWithProtocol(const SFFontProtocol *protocol, void *object);
 
+/**
+ * Enables or disables sharing of the tables between the fonts created with identical content.
+ *
+ * When enabled, the fonts created with SFFontCreateWithProtocol, whose tables are loaded through
+ * the loadTable function, keep a single copy of identical tables in a process wide cache. A copy is
+ * evicted from the cache as soon as the last font using it is released. The cache is disabled by
+ * default.
+ *
+ * As the content of the tables is compared on creation, such fonts load all their tables right
+ * away instead of on first use, and never call the loadTable function afterwards.
+ *
+ * @param enabled
+ *      SFTrue to enable the cache, SFFalse to disable it. It should be set before creating any font
+ *      as the setting itself is not synchronized.
+ */
+void SFFontSetResourceCacheEnabled(SFBoolean enabled);
+
+/**
+ * Enables or disables validation of the tables of the fonts created afterwards.
+ *
+ * When enabled, each of GDEF, GSUB and GPOS tables is validated once as soon as it is loaded. A
+ * table with a malformed header, script list or feature list is ignored as a whole, whereas a
+ * malformed lookup is only left out while shaping. The validated tables are then accessed without
+ * repeating the checks. The sanitizer is disabled by default.
+ *
+ * @param enabled
+ *      SFTrue to enable the sanitizer, SFFalse to disable it. It should be set before creating any
+ *      font as the setting itself is not synchronized.
+ */
+void SFFontSetSanitizerEnabled(SFBoolean enabled);
+
+/**
+ * Creates a font by mapping an sfnt (TrueType or OpenType) file into memory. The font tables are
+ * used directly from the mapping without being copied. If the file is a collection, the font is
+ * created for its first face.
+ *
+ * @param filePath
+ *      The path of the font file.
+ * @param protocol
+ *      A structure holding pointers to the functions used for glyph IDs and advances. The table
+ *      functions of the protocol are ignored. If neither of the glyph ID functions is implemented,
+ *      the code points are mapped with the cmap table of the font. Similarly, if neither of the
+ *      advance functions is implemented, the horizontal advances are taken from the hmtx table,
+ *      varied with the HVAR table for the instances having variation coordinates. This
+ *      parameter can be NULL.
+ * @param object
+ *      An object associated with the created font to identify it.
+ * @return
+ *      A reference to a font object if the call was successful, NULL otherwise.
+ */
+SFFontRef SFFontCreateWithFile(const char *filePath, const SFFontProtocol *protocol, void *object);
+
+/**
+ * Creates a font from the data of an sfnt (TrueType or OpenType) file residing in memory. The
+ * font tables are used directly from the buffer without being copied. If the data is a collection,
+ * the font is created for its first face.
+ *
+ * @param buffer
+ *      The buffer containing the data of the font file. It must remain valid until the font is
+ *      deallocated.
+ * @param length
+ *      The length of the buffer in bytes.
+ * @param protocol
+ *      A structure holding pointers to the functions used for glyph IDs and advances. The table
+ *      functions of the protocol are ignored. If neither of the glyph ID functions is implemented,
+ *      the code points are mapped with the cmap table of the font. Similarly, if neither of the
+ *      advance functions is implemented, the horizontal advances are taken from the hmtx table,
+ *      varied with the HVAR table for the instances having variation coordinates. This
+ *      parameter can be NULL.
+ * @param object
+ *      An object associated with the created font to identify it.
+ * @return
+ *      A reference to a font object if the call was successful, NULL otherwise.
+ */
+SFFontRef SFFontCreateWithMemory(const void *buffer, SFUInteger length, const SFFontProtocol *protocol, void *object);
+
+/**
+ * Returns the number of faces in the file from which the font was created.
+ *
+ * @param font
+ *      The font whose file is inspected.
+ * @return
+ *      The number of faces in the file, which is greater than one for a collection, or zero if the
+ *      font was not created from a file or memory.
+ */
+SFUInteger SFFontGetFaceCount(SFFontRef font);
+
+/**
+ * Creates a font for another face of the file from which the specified font was created. The
+ * faces keep a single copy of the file, and the faces referring to the same layout tables share
+ * them as well.
+ *
+ * @param font
+ *      A font created from a file or memory.
+ * @param faceIndex
+ *      The index of the face in the file.
+ * @param protocol
+ *      A structure holding pointers to the functions used for glyph IDs and advances. The table
+ *      functions of the protocol are ignored. If neither of the glyph ID functions is implemented,
+ *      the code points are mapped with the cmap table of the font. Similarly, if neither of the
+ *      advance functions is implemented, the horizontal advances are taken from the hmtx table,
+ *      varied with the HVAR table for the instances having variation coordinates. This
+ *      parameter can be NULL.
+ * @param object
+ *      An object associated with the created font to identify it.
+ * @return
+ *      A reference to a font object if the call was successful, NULL otherwise.
+ */
+SFFontRef SFFontCreateWithFace(SFFontRef font, SFUInteger faceIndex,
+    const SFFontProtocol *protocol, void *object);
+
 /**
  * Creates a variable font from the specified font instance. The derived font will share the
- * protocol and resources of the parent font.
+ * protocol and resources of the parent font, keeping the parent font alive until it is released.
  *
  * @param font
  *      A font whose protocol and resources will be shared in the created font.
@@ -131,6 +336,36 @@ SFFontRef SFFontCreateWithProtocol(const SFFontProtocol *protocol, void *object)
  */
 SFFontRef SFFontCreateWithVariationCoordinates(SFFontRef font, void *object, const SFInt16 *coordArray, SFUInteger coordCount);
 
+/**
+ * Returns a fingerprint of the data of the font that affects shaping, i.e. the contents of GDEF,
+ * GSUB and GPOS tables along with the variation coordinates.
+ *
+ * The fingerprint depends only on the data, so it remains the same for the fonts created with
+ * identical data in any process or on any platform. The hash of the tables is computed once on the
+ * first call and shared by all fonts using the same tables.
+ *
+ * @param font
+ *      The font whose fingerprint is required.
+ * @return
+ *      The fingerprint of the font.
+ */
+SFFontFingerprint SFFontGetFingerprint(SFFontRef font);
+
+/**
+ * Gets the number of hits and misses of the cache placed in front of the glyph ID function of the
+ * font protocol. The cache is only used if the glyphs are obtained one code point at a time, i.e.
+ * with getGlyphIDForCodepoint function, so both counts remain zero otherwise. The counts are not
+ * synchronized and are meant to be used as a hint for tuning.
+ *
+ * @param font
+ *      The font whose cache is inspected.
+ * @param hitCount
+ *      A pointer to the variable that takes the number of code points found in the cache.
+ * @param missCount
+ *      A pointer to the variable that takes the number of code points passed to the protocol.
+ */
+void SFFontGetGlyphCacheStatistics(SFFontRef font, SFUInteger *hitCount, SFUInteger *missCount);
+
 SFFontRef SFFontRetain(SFFontRef font);
 void SFFontRelease(SFFontRef font);
 
@@ -76,6 +76,44 @@ SFUInteger SFPatternGetFeatureCount(SFPatternRef pattern);
  */
 void SFPatternGetFeatureTags(SFPatternRef pattern, SFTag *buffer);
 
+/**
+ * Writes a compact binary image of the pattern, which can be stored in a cache and loaded again
+ * with SFPatternCreateFromBlob, instead of building the pattern with a scheme.
+ *
+ * The image is bound to the fingerprint of the font of the pattern. It is written in a portable
+ * byte order, so it can be loaded in any process or on any platform.
+ *
+ * @param pattern
+ *      The pattern whose image is to be written.
+ * @param buffer
+ *      The buffer where the image will be written to, or NULL if only the size of the image is
+ *      required. Nothing is written if the buffer is not large enough.
+ * @param capacity
+ *      The size of the buffer in bytes.
+ * @return
+ *      The size of the image in bytes.
+ */
+SFUInteger SFPatternSerialize(SFPatternRef pattern, void *buffer, SFUInteger capacity);
+
+/**
+ * Creates a pattern from an image written by SFPatternSerialize.
+ *
+ * The image is validated without copying it first, so it can be read directly from a memory
+ * mapped file. The pattern is then placed in a single allocation, and the image is no longer
+ * needed after the call returns.
+ *
+ * @param font
+ *      The font of the pattern. Its fingerprint must match the one the image was written with.
+ * @param blob
+ *      The image of the pattern.
+ * @param length
+ *      The length of the image in bytes.
+ * @return
+ *      A reference to a pattern object, or NULL if the image is malformed or belongs to a
+ *      different font.
+ */
+SFPatternRef SFPatternCreateFromBlob(SFFontRef font, const void *blob, SFUInteger length);
+
 SFPatternRef SFPatternRetain(SFPatternRef pattern);
 void SFPatternRelease(SFPatternRef pattern);
 
@@ -78,6 +78,23 @@ void SFSchemeSetLanguageTag(SFSchemeRef scheme, SFTag languageTag);
 void SFSchemeSetFeatureValues(SFSchemeRef scheme,
     SFTag *featureTags, SFUInt16 *featureValues, SFUInteger featureCount);
 
+/**
+ * Enables or disables caching of the patterns built by the schemes.
+ *
+ * When enabled, each font keeps the patterns built for it against the script tag, the language tag
+ * and the feature values of the scheme, so that building a pattern with identical inputs returns
+ * the existing one after retaining it. The cache of a font is synchronized, so the schemes of
+ * multiple threads can build patterns for the same font. A cached pattern keeps the font alive only
+ * while it is retained outside of the cache, and the cached patterns are released along with the
+ * font. The retain count of the font is synchronized for this reason, so retaining and releasing a
+ * cached pattern on any thread is safe. The cache is disabled by default.
+ *
+ * @param enabled
+ *      SFTrue to enable the cache, SFFalse to disable it. It should be set before building any
+ *      pattern as the setting itself is not synchronized.
+ */
+void SFSchemeSetPatternCacheEnabled(SFBoolean enabled);
+
 /**
  * Builds a pattern for the scheme.
  *
@@ -222,8 +222,8 @@ static void ArabicEngineProcessAlbum(const void *object, SFAlbumRef album)
     SFArtistRef artist = arabicEngine->_artist;
     TextProcessor processor;
 
-    TextProcessorInitialize(&processor, artist->pattern, album, artist->textDirection,
-                              artist->ppemWidth, artist->ppemHeight, SFTrue);
+    TextProcessorInitialize(&processor, artist->pattern, album, &artist->_pairCache, &artist->_deltaCache,
+                              artist->textDirection, artist->ppemWidth, artist->ppemHeight, SFTrue);
     TextProcessorDiscoverGlyphs(&processor);
     PutArabicFeatureMask(album);
     TextProcessorSubstituteGlyphs(&processor);
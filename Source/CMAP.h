@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_CMAP_H
+#define _SF_INTERNAL_CMAP_H
+
+#include "Data.h"
+#include "SFBase.h"
+
+enum {
+    PlatformIDUnicode = 0,
+    PlatformIDWindows = 3
+};
+
+enum {
+    EncodingIDUnicodeBMP = 3,       /**< Unicode platform, BMP only. */
+    EncodingIDUnicodeFull = 4,      /**< Unicode platform, full repertoire. */
+    EncodingIDUnicodeVariation = 5, /**< Unicode platform, variation sequences. */
+    EncodingIDWindowsSymbol = 0,
+    EncodingIDWindowsBMP = 1,
+    EncodingIDWindowsFull = 10
+};
+
+/*******************************************CMAP HEADER********************************************/
+
+#define CMAP_Version(data)                              Data_UInt16(data, 0)
+#define CMAP_NumTables(data)                            Data_UInt16(data, 2)
+#define CMAP_EncodingRecord(data, index)                Data_Subdata(data, 4 + ((index) * 8))
+#define CMAP_Size(numTables)                            (4 + ((numTables) * 8))
+
+#define EncodingRecord_PlatformID(data)                 Data_UInt16(data, 0)
+#define EncodingRecord_EncodingID(data)                 Data_UInt16(data, 2)
+#define EncodingRecord_SubtableOffset(data)             Data_UInt32(data, 4)
+
+#define CMAPSubtable_Format(data)                       Data_UInt16(data, 0)
+
+/**************************************************************************************************/
+
+/*****************************************FORMAT 4 SUBTABLE****************************************/
+
+#define CMAPF4_SegCountX2(data)                         Data_UInt16(data, 6)
+#define CMAPF4_EndCodeArray(data)                       Data_Subdata(data, 14)
+#define CMAPF4_StartCodeArray(data, segCount)           Data_Subdata(data, 16 + ((segCount) * 2))
+#define CMAPF4_IDDeltaArray(data, segCount)             Data_Subdata(data, 16 + ((segCount) * 4))
+#define CMAPF4_IDRangeOffsetArray(data, segCount)       Data_Subdata(data, 16 + ((segCount) * 6))
+#define CMAPF4_Size(segCount)                           (16 + ((segCount) * 8))
+
+/**************************************************************************************************/
+
+/****************************************FORMAT 12 SUBTABLE****************************************/
+
+#define CMAPF12_NumGroups(data)                         Data_UInt32(data, 12)
+#define CMAPF12_SequentialMapGroup(data, index)         Data_Subdata(data, 16 + ((index) * 12))
+#define CMAPF12_Size(numGroups)                         (16 + ((numGroups) * 12))
+
+#define SequentialMapGroup_StartCharCode(data)          Data_UInt32(data, 0)
+#define SequentialMapGroup_EndCharCode(data)            Data_UInt32(data, 4)
+#define SequentialMapGroup_StartGlyphID(data)           Data_UInt32(data, 8)
+
+/**************************************************************************************************/
+
+/****************************************FORMAT 14 SUBTABLE****************************************/
+
+#define CMAPF14_NumVarSelectorRecords(data)             Data_UInt32(data, 6)
+#define CMAPF14_VariationSelector(data, index)          Data_Subdata(data, 10 + ((index) * 11))
+#define CMAPF14_Size(numRecords)                        (10 + ((numRecords) * 11))
+
+#define VariationSelector_VarSelector(data)             Data_UInt24(data, 0)
+#define VariationSelector_DefaultUVSOffset(data)        Data_UInt32(data, 3)
+#define VariationSelector_NonDefaultUVSOffset(data)     Data_UInt32(data, 7)
+
+#define DefaultUVS_NumUnicodeValueRanges(data)          Data_UInt32(data, 0)
+#define DefaultUVS_UnicodeRange(data, index)            Data_Subdata(data, 4 + ((index) * 4))
+#define DefaultUVS_Size(numRanges)                      (4 + ((numRanges) * 4))
+
+#define UnicodeRange_StartUnicodeValue(data)            Data_UInt24(data, 0)
+#define UnicodeRange_AdditionalCount(data)              Data_UInt8(data, 3)
+
+#define NonDefaultUVS_NumUVSMappings(data)              Data_UInt32(data, 0)
+#define NonDefaultUVS_UVSMapping(data, index)           Data_Subdata(data, 4 + ((index) * 5))
+#define NonDefaultUVS_Size(numMappings)                 (4 + ((numMappings) * 5))
+
+#define UVSMapping_UnicodeValue(data)                   Data_UInt24(data, 0)
+#define UVSMapping_GlyphID(data)                        Data_UInt16(data, 3)
+
+/**************************************************************************************************/
+
+#endif
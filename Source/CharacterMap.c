@@ -0,0 +1,506 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "SFBase.h"
+#include "CMAP.h"
+#include "Data.h"
+#include "CharacterMap.h"
+
+/**
+ * The page shared by all BMP ranges which do not map any glyph.
+ */
+static SFGlyphID EmptyPage[CharacterMapPageSize];
+
+static SFBoolean IsUnicodeEncoding(SFUInt16 platformID, SFUInt16 encodingID)
+{
+    switch (platformID) {
+        case PlatformIDUnicode:
+            return (encodingID != EncodingIDUnicodeVariation);
+
+        case PlatformIDWindows:
+            return (encodingID == EncodingIDWindowsBMP || encodingID == EncodingIDWindowsFull);
+    }
+
+    return SFFalse;
+}
+
+static void SetBMPGlyph(CharacterMapRef characterMap, SFCodepoint codepoint, SFGlyphID glyph)
+{
+    SFUInteger pageIndex = codepoint >> 8;
+    SFGlyphID *page;
+
+    /* Keep the empty pages shared by never writing a zero glyph. */
+    if (!glyph) {
+        return;
+    }
+
+    page = characterMap->pages[pageIndex];
+
+    if (page == EmptyPage) {
+        page = calloc(CharacterMapPageSize, sizeof(SFGlyphID));
+        characterMap->pages[pageIndex] = page;
+    }
+
+    page[codepoint & 0xFF] = glyph;
+}
+
+static SFBoolean LoadFormat4(CharacterMapRef characterMap, Data subtable, SFUInteger length)
+{
+    SFUInteger segCount;
+    Data endCodes;
+    Data startCodes;
+    Data idDeltas;
+    Data idRangeOffsets;
+    SFUInteger segIndex;
+
+    if (length < CMAPF4_Size(0)) {
+        return SFFalse;
+    }
+
+    segCount = CMAPF4_SegCountX2(subtable) >> 1;
+
+    if (CMAPF4_Size(segCount) > length) {
+        return SFFalse;
+    }
+
+    endCodes = CMAPF4_EndCodeArray(subtable);
+    startCodes = CMAPF4_StartCodeArray(subtable, segCount);
+    idDeltas = CMAPF4_IDDeltaArray(subtable, segCount);
+    idRangeOffsets = CMAPF4_IDRangeOffsetArray(subtable, segCount);
+
+    /*
+     * The segments must be in increasing order without overlapping each other, so that loading
+     * them writes each code point of the BMP at most once.
+     */
+    for (segIndex = 0; segIndex < segCount; segIndex++) {
+        SFUInt16 endCode = Data_UInt16(endCodes, segIndex * 2);
+        SFUInt16 startCode = Data_UInt16(startCodes, segIndex * 2);
+
+        if (startCode > endCode) {
+            return SFFalse;
+        }
+        if (segIndex > 0 && startCode <= Data_UInt16(endCodes, (segIndex - 1) * 2)) {
+            return SFFalse;
+        }
+    }
+
+    for (segIndex = 0; segIndex < segCount; segIndex++) {
+        SFUInt16 endCode = Data_UInt16(endCodes, segIndex * 2);
+        SFUInt16 startCode = Data_UInt16(startCodes, segIndex * 2);
+        SFUInt16 idDelta = Data_UInt16(idDeltas, segIndex * 2);
+        SFUInt16 idRangeOffset = Data_UInt16(idRangeOffsets, segIndex * 2);
+        /* The range offset is relative to its own position in the subtable. */
+        SFUInteger rangeOffsetPosition = (idRangeOffsets - subtable) + (segIndex * 2);
+        SFUInt32 codepoint;
+
+        for (codepoint = startCode; codepoint <= endCode; codepoint++) {
+            SFGlyphID glyph;
+
+            if (idRangeOffset == 0) {
+                glyph = (SFGlyphID)(codepoint + idDelta);
+            } else {
+                SFUInteger glyphPosition = rangeOffsetPosition + idRangeOffset
+                                         + ((codepoint - startCode) * 2);
+
+                if (glyphPosition > length - 2) {
+                    break;
+                }
+
+                glyph = Data_UInt16(subtable, glyphPosition);
+
+                if (glyph) {
+                    glyph = (SFGlyphID)(glyph + idDelta);
+                }
+            }
+
+            SetBMPGlyph(characterMap, codepoint, glyph);
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean LoadFormat12(CharacterMapRef characterMap, Data subtable, SFUInteger length)
+{
+    SFUInt32 numGroups;
+    SFUInt32 groupIndex;
+    SFUInteger groupCount = 0;
+
+    if (length < CMAPF12_Size(0)) {
+        return SFFalse;
+    }
+
+    numGroups = CMAPF12_NumGroups(subtable);
+
+    if (numGroups > (length - CMAPF12_Size(0)) / 12) {
+        return SFFalse;
+    }
+
+    /*
+     * The groups must be in increasing order without overlapping each other, so that loading them
+     * writes each code point of the BMP at most once and keeps the supplementary groups sorted.
+     */
+    for (groupIndex = 0; groupIndex < numGroups; groupIndex++) {
+        Data group = CMAPF12_SequentialMapGroup(subtable, groupIndex);
+        SFUInt32 startCode = SequentialMapGroup_StartCharCode(group);
+
+        if (startCode > SequentialMapGroup_EndCharCode(group)) {
+            return SFFalse;
+        }
+        if (groupIndex > 0) {
+            Data previous = CMAPF12_SequentialMapGroup(subtable, groupIndex - 1);
+
+            if (startCode <= SequentialMapGroup_EndCharCode(previous)) {
+                return SFFalse;
+            }
+        }
+    }
+
+    characterMap->groups = malloc(sizeof(CharacterMapGroup) * (numGroups ? numGroups : 1));
+
+    for (groupIndex = 0; groupIndex < numGroups; groupIndex++) {
+        Data group = CMAPF12_SequentialMapGroup(subtable, groupIndex);
+        SFUInt32 startCode = SequentialMapGroup_StartCharCode(group);
+        SFUInt32 endCode = SequentialMapGroup_EndCharCode(group);
+        SFUInt32 startGlyph = SequentialMapGroup_StartGlyphID(group);
+        SFUInt32 codepoint;
+
+        if (endCode > 0x10FFFF || startGlyph > 0xFFFF) {
+            continue;
+        }
+
+        /* Spread the BMP part of the group into the pages. */
+        for (codepoint = startCode; codepoint <= endCode && codepoint <= 0xFFFF; codepoint++) {
+            SFUInt32 glyph = startGlyph + (codepoint - startCode);
+
+            if (glyph > 0xFFFF) {
+                break;
+            }
+
+            SetBMPGlyph(characterMap, codepoint, (SFGlyphID)glyph);
+        }
+
+        /* Keep the supplementary part of the group for binary search. */
+        if (endCode > 0xFFFF) {
+            CharacterMapGroup *supplementary = &characterMap->groups[groupCount++];
+            SFCodepoint firstCode = (startCode > 0xFFFF ? startCode : 0x10000);
+
+            supplementary->start = firstCode;
+            supplementary->end = endCode;
+            supplementary->startGlyph = startGlyph + (firstCode - startCode);
+        }
+    }
+
+    characterMap->groupCount = groupCount;
+
+    return SFTrue;
+}
+
+static SFBoolean IsValidFormat14(Data subtable, SFUInteger length)
+{
+    SFUInt32 numRecords;
+    SFUInt32 recordIndex;
+    SFUInt32 lastSelector = 0;
+
+    if (length < CMAPF14_Size(0)) {
+        return SFFalse;
+    }
+
+    numRecords = CMAPF14_NumVarSelectorRecords(subtable);
+
+    if (numRecords > (length - CMAPF14_Size(0)) / 11) {
+        return SFFalse;
+    }
+
+    for (recordIndex = 0; recordIndex < numRecords; recordIndex++) {
+        Data record = CMAPF14_VariationSelector(subtable, recordIndex);
+        SFUInt32 varSelector = VariationSelector_VarSelector(record);
+        SFUInt32 defaultOffset = VariationSelector_DefaultUVSOffset(record);
+        SFUInt32 nonDefaultOffset = VariationSelector_NonDefaultUVSOffset(record);
+
+        /* The records are binary searched, so they must be in increasing order. */
+        if (recordIndex > 0 && varSelector <= lastSelector) {
+            return SFFalse;
+        }
+        lastSelector = varSelector;
+
+        if (defaultOffset) {
+            Data defaultUVS;
+
+            if (defaultOffset > length - DefaultUVS_Size(0)) {
+                return SFFalse;
+            }
+
+            defaultUVS = Data_Subdata(subtable, defaultOffset);
+
+            if (DefaultUVS_NumUnicodeValueRanges(defaultUVS)
+                > (length - defaultOffset - DefaultUVS_Size(0)) / 4) {
+                return SFFalse;
+            }
+        }
+
+        if (nonDefaultOffset) {
+            Data nonDefaultUVS;
+
+            if (nonDefaultOffset > length - NonDefaultUVS_Size(0)) {
+                return SFFalse;
+            }
+
+            nonDefaultUVS = Data_Subdata(subtable, nonDefaultOffset);
+
+            if (NonDefaultUVS_NumUVSMappings(nonDefaultUVS)
+                > (length - nonDefaultOffset - NonDefaultUVS_Size(0)) / 5) {
+                return SFFalse;
+            }
+        }
+    }
+
+    return SFTrue;
+}
+
+SF_INTERNAL CharacterMapRef CharacterMapCreate(Data cmap, SFUInteger length)
+{
+    Data format4 = NULL;
+    Data format12 = NULL;
+    Data format14 = NULL;
+    SFUInteger format4Length = 0;
+    SFUInteger format12Length = 0;
+    SFUInteger format14Length = 0;
+    SFBoolean isSymbolFormat4 = SFFalse;
+    CharacterMapRef characterMap;
+    SFBoolean isLoaded = SFFalse;
+    SFUInteger numTables;
+    SFUInteger tableIndex;
+
+    if (!cmap || length < CMAP_Size(0)) {
+        return NULL;
+    }
+
+    numTables = CMAP_NumTables(cmap);
+
+    if (CMAP_Size(numTables) > length) {
+        return NULL;
+    }
+
+    for (tableIndex = 0; tableIndex < numTables; tableIndex++) {
+        Data record = CMAP_EncodingRecord(cmap, tableIndex);
+        SFUInt16 platformID = EncodingRecord_PlatformID(record);
+        SFUInt16 encodingID = EncodingRecord_EncodingID(record);
+        SFUInt32 offset = EncodingRecord_SubtableOffset(record);
+        Data subtable;
+        SFUInt16 format;
+
+        if (offset > length - 2) {
+            continue;
+        }
+
+        subtable = Data_Subdata(cmap, offset);
+        format = CMAPSubtable_Format(subtable);
+
+        if (IsUnicodeEncoding(platformID, encodingID)) {
+            if (format == 12 && !format12) {
+                format12 = subtable;
+                format12Length = length - offset;
+            } else if (format == 4 && (!format4 || isSymbolFormat4)) {
+                format4 = subtable;
+                format4Length = length - offset;
+                isSymbolFormat4 = SFFalse;
+            }
+        } else if (platformID == PlatformIDUnicode && encodingID == EncodingIDUnicodeVariation) {
+            if (format == 14 && !format14) {
+                format14 = subtable;
+                format14Length = length - offset;
+            }
+        } else if (platformID == PlatformIDWindows && encodingID == EncodingIDWindowsSymbol) {
+            /* Use a symbol subtable only if the font does not have a Unicode one. */
+            if (format == 4 && !format4) {
+                format4 = subtable;
+                format4Length = length - offset;
+                isSymbolFormat4 = SFTrue;
+            }
+        }
+    }
+
+    characterMap = malloc(sizeof(CharacterMap));
+    characterMap->groups = NULL;
+    characterMap->groupCount = 0;
+    characterMap->variations = NULL;
+
+    for (tableIndex = 0; tableIndex < CharacterMapPageCount; tableIndex++) {
+        characterMap->pages[tableIndex] = EmptyPage;
+    }
+
+    if (format12) {
+        isLoaded = LoadFormat12(characterMap, format12, format12Length);
+    }
+    if (!isLoaded && format4) {
+        isLoaded = LoadFormat4(characterMap, format4, format4Length);
+    }
+    if (format14 && IsValidFormat14(format14, format14Length)) {
+        characterMap->variations = format14;
+        isLoaded = SFTrue;
+    }
+
+    if (!isLoaded) {
+        CharacterMapDestroy(characterMap);
+        return NULL;
+    }
+
+    return characterMap;
+}
+
+SF_INTERNAL SFGlyphID CharacterMapGetGlyphID(CharacterMapRef characterMap, SFCodepoint codepoint)
+{
+    const CharacterMapGroup *groups;
+    SFUInteger low;
+    SFUInteger high;
+
+    if (codepoint <= 0xFFFF) {
+        return characterMap->pages[codepoint >> 8][codepoint & 0xFF];
+    }
+
+    groups = characterMap->groups;
+    low = 0;
+    high = characterMap->groupCount;
+
+    while (low < high) {
+        SFUInteger mid = low + (high - low) / 2;
+        const CharacterMapGroup *group = &groups[mid];
+
+        if (codepoint < group->start) {
+            high = mid;
+        } else if (codepoint > group->end) {
+            low = mid + 1;
+        } else {
+            SFUInt32 glyph = group->startGlyph + (codepoint - group->start);
+            return (glyph <= 0xFFFF ? (SFGlyphID)glyph : 0);
+        }
+    }
+
+    return 0;
+}
+
+static Data SearchVariationSelector(Data variations, SFCodepoint variationSelector)
+{
+    SFUInt32 low = 0;
+    SFUInt32 high = CMAPF14_NumVarSelectorRecords(variations);
+
+    while (low < high) {
+        SFUInt32 mid = low + (high - low) / 2;
+        Data record = CMAPF14_VariationSelector(variations, mid);
+        SFUInt32 varSelector = VariationSelector_VarSelector(record);
+
+        if (variationSelector < varSelector) {
+            high = mid;
+        } else if (variationSelector > varSelector) {
+            low = mid + 1;
+        } else {
+            return record;
+        }
+    }
+
+    return NULL;
+}
+
+static SFBoolean SearchDefaultUVS(Data defaultUVS, SFCodepoint codepoint)
+{
+    SFUInt32 low = 0;
+    SFUInt32 high = DefaultUVS_NumUnicodeValueRanges(defaultUVS);
+
+    while (low < high) {
+        SFUInt32 mid = low + (high - low) / 2;
+        Data range = DefaultUVS_UnicodeRange(defaultUVS, mid);
+        SFUInt32 startValue = UnicodeRange_StartUnicodeValue(range);
+        SFUInt32 endValue = startValue + UnicodeRange_AdditionalCount(range);
+
+        if (codepoint < startValue) {
+            high = mid;
+        } else if (codepoint > endValue) {
+            low = mid + 1;
+        } else {
+            return SFTrue;
+        }
+    }
+
+    return SFFalse;
+}
+
+static SFGlyphID SearchNonDefaultUVS(Data nonDefaultUVS, SFCodepoint codepoint)
+{
+    SFUInt32 low = 0;
+    SFUInt32 high = NonDefaultUVS_NumUVSMappings(nonDefaultUVS);
+
+    while (low < high) {
+        SFUInt32 mid = low + (high - low) / 2;
+        Data mapping = NonDefaultUVS_UVSMapping(nonDefaultUVS, mid);
+        SFUInt32 unicodeValue = UVSMapping_UnicodeValue(mapping);
+
+        if (codepoint < unicodeValue) {
+            high = mid;
+        } else if (codepoint > unicodeValue) {
+            low = mid + 1;
+        } else {
+            return UVSMapping_GlyphID(mapping);
+        }
+    }
+
+    return 0;
+}
+
+SF_INTERNAL SFGlyphID CharacterMapGetVariantGlyphID(CharacterMapRef characterMap,
+    SFCodepoint codepoint, SFCodepoint variationSelector)
+{
+    Data variations = characterMap->variations;
+
+    if (variations) {
+        Data record = SearchVariationSelector(variations, variationSelector);
+
+        if (record) {
+            SFUInt32 defaultOffset = VariationSelector_DefaultUVSOffset(record);
+            SFUInt32 nonDefaultOffset = VariationSelector_NonDefaultUVSOffset(record);
+
+            /* The default sequences take the glyph of the base code point. */
+            if (defaultOffset && SearchDefaultUVS(Data_Subdata(variations, defaultOffset), codepoint)) {
+                return CharacterMapGetGlyphID(characterMap, codepoint);
+            }
+            if (nonDefaultOffset) {
+                return SearchNonDefaultUVS(Data_Subdata(variations, nonDefaultOffset), codepoint);
+            }
+        }
+    }
+
+    return 0;
+}
+
+SF_INTERNAL void CharacterMapDestroy(CharacterMapRef characterMap)
+{
+    SFUInteger pageIndex;
+
+    for (pageIndex = 0; pageIndex < CharacterMapPageCount; pageIndex++) {
+        SFGlyphID *page = characterMap->pages[pageIndex];
+
+        if (page != EmptyPage) {
+            free(page);
+        }
+    }
+
+    free(characterMap->groups);
+    free(characterMap);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_CHARACTER_MAP_H
+#define _SF_INTERNAL_CHARACTER_MAP_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+
+#define CharacterMapPageCount   256
+#define CharacterMapPageSize    256
+
+/**
+ * A range of supplementary code points mapped to consecutive glyphs.
+ */
+typedef struct _CharacterMapGroup {
+    SFCodepoint start;
+    SFCodepoint end;
+    SFUInt32 startGlyph;
+} CharacterMapGroup;
+
+/**
+ * Maps code points to glyphs with the help of the cmap table of a font.
+ *
+ * The BMP is kept in a dense table of 256 pages of 256 glyphs each, so that a BMP code point is
+ * mapped with a couple of loads. The pages having no glyph at all point to a shared empty page. The
+ * supplementary code points are mapped by binary searching the sorted groups.
+ */
+typedef struct _CharacterMap {
+    SFGlyphID *pages[CharacterMapPageCount]; /**< The pages of BMP glyphs. */
+    CharacterMapGroup *groups;  /**< The sorted groups of supplementary code points. */
+    SFUInteger groupCount;      /**< The number of supplementary groups. */
+    Data variations;            /**< The validated format 14 subtable, or NULL. */
+} CharacterMap, *CharacterMapRef;
+
+/**
+ * Builds a character map from a cmap table. Format 12 is preferred over format 4 for Unicode
+ * encodings, and a format 14 subtable is used for variation sequences if present. The table is
+ * validated while building, so a malformed subtable is simply left out.
+ *
+ * @return
+ *      A new character map, or NULL if the table does not have any supported subtable.
+ */
+SF_INTERNAL CharacterMapRef CharacterMapCreate(Data cmap, SFUInteger length);
+
+/**
+ * Returns the glyph of a code point, or zero if the font does not map it.
+ */
+SF_INTERNAL SFGlyphID CharacterMapGetGlyphID(CharacterMapRef characterMap, SFCodepoint codepoint);
+
+/**
+ * Returns the glyph of a variation sequence, or zero if the font does not support the sequence.
+ */
+SF_INTERNAL SFGlyphID CharacterMapGetVariantGlyphID(CharacterMapRef characterMap,
+    SFCodepoint codepoint, SFCodepoint variationSelector);
+
+SF_INTERNAL void CharacterMapDestroy(CharacterMapRef characterMap);
+
+#endif
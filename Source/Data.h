@@ -31,6 +31,14 @@ typedef const SFUInt8 * Data;
  | ((SFUInt16)(data)[(offset) + 1] << 0)    \
 )
 
+#define Data_UInt24(data, offset)           \
+(SFUInt32)                                  \
+(                                           \
+   ((SFUInt32)(data)[(offset) + 0] << 16)   \
+ | ((SFUInt32)(data)[(offset) + 1] <<  8)   \
+ | ((SFUInt32)(data)[(offset) + 2] <<  0)   \
+)
+
 #define Data_UInt32(data, offset)           \
 (SFUInt32)                                  \
 (                                           \
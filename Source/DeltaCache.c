@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <SFConfig.h>
+#include <stddef.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "DeltaCache.h"
+#include "SlotCache.h"
+
+#define DeltaEntryOf(deltaCache, table, ppemSize) \
+    (&(deltaCache)->entries[SlotIndexOf(table, ppemSize, DeltaCacheBits)])
+
+SF_INTERNAL void DeltaCacheClear(DeltaCacheRef deltaCache)
+{
+    SlotCacheClear(deltaCache->entries, DeltaCacheSize, sizeof(DeltaCacheEntry));
+}
+
+SF_INTERNAL SFBoolean DeltaCacheLookup(DeltaCacheRef deltaCache,
+    Data table, SFUInt16 ppemSize, SFInt32 *outPixels)
+{
+    DeltaCacheEntry *entry = DeltaEntryOf(deltaCache, table, ppemSize);
+
+    if (SlotKeyMatches(&entry->key, table, ppemSize)) {
+        *outPixels = entry->pixels;
+
+        return SFTrue;
+    }
+
+    return SFFalse;
+}
+
+SF_INTERNAL void DeltaCacheStore(DeltaCacheRef deltaCache,
+    Data table, SFUInt16 ppemSize, SFInt32 pixels)
+{
+    DeltaCacheEntry *entry = DeltaEntryOf(deltaCache, table, ppemSize);
+
+    SlotKeySet(&entry->key, table, ppemSize);
+    entry->pixels = pixels;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SF_INTERNAL_DELTA_CACHE_H
+#define _SF_INTERNAL_DELTA_CACHE_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "SlotCache.h"
+
+#define DeltaCacheBits  7
+#define DeltaCacheSize  (1 << DeltaCacheBits)
+
+typedef struct _DeltaCacheEntry {
+    SlotKey key;                /**< The device or variation index table along with the ppem size. */
+    SFInt32 pixels;             /**< The resolved adjustment in pixels. */
+} DeltaCacheEntry;
+
+/**
+ * A direct-mapped cache of the pixels resolved from device and variation index tables.
+ *
+ * The same few tables are resolved over and over while shaping at a fixed size, so the decoded
+ * pixels are remembered against the table and the ppem size. The cache is kept by an artist and is
+ * only valid as long as its pattern, and so the tables and the variation instance, stays the same.
+ */
+typedef struct _DeltaCache {
+    DeltaCacheEntry entries[DeltaCacheSize];
+} DeltaCache, *DeltaCacheRef;
+
+/**
+ * Empties the cache, so that it no longer refers to any table.
+ */
+SF_INTERNAL void DeltaCacheClear(DeltaCacheRef deltaCache);
+
+/**
+ * Looks up the pixels of a table at a ppem size.
+ *
+ * @return
+ *      SFTrue if the pixels were found in the cache, SFFalse otherwise.
+ */
+SF_INTERNAL SFBoolean DeltaCacheLookup(DeltaCacheRef deltaCache,
+    Data table, SFUInt16 ppemSize, SFInt32 *outPixels);
+
+/**
+ * Stores the pixels of a table at a ppem size, evicting the entry previously occupying its slot.
+ */
+SF_INTERNAL void DeltaCacheStore(DeltaCacheRef deltaCache,
+    Data table, SFUInt16 ppemSize, SFInt32 pixels);
+
+#endif
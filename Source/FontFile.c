@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define FONT_FILE_MAPPING_WIN32
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FONT_FILE_MAPPING_POSIX
+#endif
+
+#include "SFBase.h"
+#include "Data.h"
+#include "List.h"
+#include "Mutex.h"
+#include "SFAssert.h"
+#include "SFNT.h"
+#include "FontFile.h"
+
+#if defined(FONT_FILE_MAPPING_WIN32)
+
+static Data MapFile(const char *filePath, SFUInteger *outLength)
+{
+    HANDLE fileHandle;
+    Data data = NULL;
+
+    fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fileSize;
+
+        if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0) {
+            HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+            if (mappingHandle) {
+                data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+                *outLength = (SFUInteger)fileSize.QuadPart;
+
+                /* The view keeps the mapping alive, so the handle is no longer needed. */
+                CloseHandle(mappingHandle);
+            }
+        }
+
+        CloseHandle(fileHandle);
+    }
+
+    return data;
+}
+
+static void UnmapFile(Data data, SFUInteger length)
+{
+    UnmapViewOfFile((LPCVOID)data);
+}
+
+#elif defined(FONT_FILE_MAPPING_POSIX)
+
+static Data MapFile(const char *filePath, SFUInteger *outLength)
+{
+    Data data = NULL;
+    int fileDescriptor;
+
+    fileDescriptor = open(filePath, O_RDONLY);
+
+    if (fileDescriptor != -1) {
+        struct stat fileStatus;
+
+        if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0) {
+            size_t fileSize = (size_t)fileStatus.st_size;
+            void *address = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+
+            if (address != MAP_FAILED) {
+                data = address;
+                *outLength = (SFUInteger)fileSize;
+            }
+        }
+
+        /* The mapping stays valid after closing the file. */
+        close(fileDescriptor);
+    }
+
+    return data;
+}
+
+static void UnmapFile(Data data, SFUInteger length)
+{
+    munmap((void *)data, (size_t)length);
+}
+
+#else
+
+static Data MapFile(const char *filePath, SFUInteger *outLength)
+{
+    return NULL;
+}
+
+static void UnmapFile(Data data, SFUInteger length)
+{
+}
+
+#endif
+
+static Data ReadWholeFile(const char *filePath, SFUInteger *outLength)
+{
+    SFUInt8 *data = NULL;
+    FILE *file;
+
+    file = fopen(filePath, "rb");
+
+    if (file) {
+        long fileSize = -1;
+
+        if (fseek(file, 0, SEEK_END) == 0) {
+            fileSize = ftell(file);
+        }
+
+        if (fileSize > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = malloc((size_t)fileSize);
+
+            if (fread(data, 1, (size_t)fileSize, file) == (size_t)fileSize) {
+                *outLength = (SFUInteger)fileSize;
+            } else {
+                free(data);
+                data = NULL;
+            }
+        }
+
+        fclose(file);
+    }
+
+    return data;
+}
+
+static FontFileRef CreateFontFile(Data data, SFUInteger length, FontFileStorage storage)
+{
+    FontFileRef fontFile = malloc(sizeof(FontFile));
+    fontFile->data = data;
+    fontFile->length = length;
+    fontFile->faceCount = 0;
+    fontFile->storage = storage;
+    fontFile->retainCount = 1;
+
+    ListInitialize(&fontFile->resources, sizeof(struct _FontResource *));
+    MutexInitialize(&fontFile->mutex);
+
+    return fontFile;
+}
+
+static void DestroyFontFile(FontFileRef fontFile)
+{
+    /* All resources MUST be released before the file. */
+    SFAssert(fontFile->resources.count == 0);
+
+    ListFinalize(&fontFile->resources);
+    MutexFinalize(&fontFile->mutex);
+
+    switch (fontFile->storage) {
+        case FontFileStorageMapped:
+            UnmapFile(fontFile->data, fontFile->length);
+            break;
+
+        case FontFileStorageAllocated:
+            free((void *)fontFile->data);
+            break;
+
+        default:
+            break;
+    }
+
+    free(fontFile);
+}
+
+static SFBoolean IsValidTableDirectory(Data data, SFUInteger length)
+{
+    if (length >= TableDirectory_Size(0)) {
+        SFUInt32 sfntVersion = TableDirectory_SFNTVersion(data);
+        SFUInt16 numTables = TableDirectory_NumTables(data);
+
+        switch (sfntVersion) {
+            case 0x00010000:
+            case TAG('O', 'T', 'T', 'O'):
+            case TAG('t', 'r', 'u', 'e'):
+                return (TableDirectory_Size(numTables) <= length);
+        }
+    }
+
+    return SFFalse;
+}
+
+static SFBoolean IsCollection(Data data, SFUInteger length)
+{
+    return (length >= TTCHeader_Size(0) && TTCHeader_TTCTag(data) == TAG('t', 't', 'c', 'f'));
+}
+
+static SFUInteger GetFaceCount(Data data, SFUInteger length)
+{
+    if (IsCollection(data, length)) {
+        SFUInt32 numFonts = TTCHeader_NumFonts(data);
+
+        /* Make sure that the offsets of all table directories fit in the file. */
+        if (numFonts <= (length - TTCHeader_Size(0)) / 4) {
+            return numFonts;
+        }
+
+        return 0;
+    }
+
+    return 1;
+}
+
+static FontFileRef ValidateFontFile(FontFileRef fontFile)
+{
+    if (fontFile) {
+        fontFile->faceCount = GetFaceCount(fontFile->data, fontFile->length);
+
+        /* The first face MUST be valid. */
+        if (!FontFileGetTableDirectory(fontFile, 0)) {
+            DestroyFontFile(fontFile);
+            return NULL;
+        }
+    }
+
+    return fontFile;
+}
+
+SF_INTERNAL FontFileRef FontFileCreateWithPath(const char *filePath)
+{
+    FontFileRef fontFile = NULL;
+    SFUInteger length = 0;
+    Data data;
+
+    data = MapFile(filePath, &length);
+
+    if (data) {
+        fontFile = CreateFontFile(data, length, FontFileStorageMapped);
+    } else {
+        /* Fallback to reading the whole file if it could not be mapped. */
+        data = ReadWholeFile(filePath, &length);
+
+        if (data) {
+            fontFile = CreateFontFile(data, length, FontFileStorageAllocated);
+        }
+    }
+
+    return ValidateFontFile(fontFile);
+}
+
+SF_INTERNAL FontFileRef FontFileCreateWithMemory(const void *buffer, SFUInteger length)
+{
+    if (buffer && length) {
+        FontFileRef fontFile = CreateFontFile(buffer, length, FontFileStorageBorrowed);
+        return ValidateFontFile(fontFile);
+    }
+
+    return NULL;
+}
+
+SF_INTERNAL Data FontFileGetTableDirectory(FontFileRef fontFile, SFUInteger faceIndex)
+{
+    if (faceIndex < fontFile->faceCount) {
+        Data data = fontFile->data;
+        SFUInteger offset = 0;
+
+        if (IsCollection(data, fontFile->length)) {
+            offset = TTCHeader_TableDirectoryOffset(data, faceIndex);
+        }
+
+        if (offset < fontFile->length) {
+            Data directory = Data_Subdata(data, offset);
+
+            if (IsValidTableDirectory(directory, fontFile->length - offset)) {
+                return directory;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+SF_INTERNAL Data FontFileSearchTable(FontFileRef fontFile, SFUInteger faceIndex,
+    SFTag tableTag, SFUInteger *outLength)
+{
+    Data directory = FontFileGetTableDirectory(fontFile, faceIndex);
+
+    if (directory) {
+        SFUInt16 numTables = TableDirectory_NumTables(directory);
+        SFUInt16 index;
+
+        for (index = 0; index < numTables; index++) {
+            Data tableRecord = TableDirectory_TableRecord(directory, index);
+
+            if (TableRecord_TableTag(tableRecord) == tableTag) {
+                SFUInt32 offset = TableRecord_Offset(tableRecord);
+                SFUInt32 length = TableRecord_Length(tableRecord);
+
+                /* Ignore the table if it does not fit in the file. */
+                if (length != 0 && offset <= fontFile->length && length <= fontFile->length - offset) {
+                    *outLength = length;
+                    return Data_Subdata(fontFile->data, offset);
+                }
+                break;
+            }
+        }
+    }
+
+    *outLength = 0;
+    return NULL;
+}
+
+SF_INTERNAL FontFileRef FontFileRetain(FontFileRef fontFile)
+{
+    if (fontFile) {
+        MutexLock(&fontFile->mutex);
+        fontFile->retainCount++;
+        MutexUnlock(&fontFile->mutex);
+    }
+
+    return fontFile;
+}
+
+SF_INTERNAL void FontFileRelease(FontFileRef fontFile)
+{
+    if (fontFile) {
+        SFBoolean isReleased;
+
+        MutexLock(&fontFile->mutex);
+        isReleased = (--fontFile->retainCount == 0);
+        MutexUnlock(&fontFile->mutex);
+
+        if (isReleased) {
+            DestroyFontFile(fontFile);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_FONT_FILE_H
+#define _SF_INTERNAL_FONT_FILE_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "List.h"
+#include "Mutex.h"
+
+typedef enum {
+    FontFileStorageBorrowed,    /**< The data is owned by the client. */
+    FontFileStorageMapped,      /**< The data is mapped into memory from a file. */
+    FontFileStorageAllocated    /**< The data is read from a file into an allocated buffer. */
+} FontFileStorage;
+
+/**
+ * Keeps the whole data of an sfnt file or collection, either mapped into memory or provided by the
+ * client.
+ */
+typedef struct _FontFile {
+    Data data;                  /**< The data of the whole file. */
+    SFUInteger length;          /**< The length of the data in bytes. */
+    SFUInteger faceCount;       /**< The number of faces in the file. */
+    FontFileStorage storage;    /**< The storage of the data. */
+    /**
+     * Weak references of the resources created for the faces of the file so that the faces
+     * pointing at the same tables can share them.
+     */
+    LIST(struct _FontResource *) resources;
+    /**
+     * The mutex guarding the list of resources, the retain counts of those resources and the
+     * retain count of the file, as the faces of a collection may be used by different threads.
+     */
+    Mutex mutex;
+    SFUInteger retainCount;
+} FontFile, *FontFileRef;
+
+SF_INTERNAL FontFileRef FontFileCreateWithPath(const char *filePath);
+SF_INTERNAL FontFileRef FontFileCreateWithMemory(const void *buffer, SFUInteger length);
+
+/**
+ * Returns the table directory of a face, or NULL if the face does not exist or its directory does
+ * not fit in the file.
+ */
+SF_INTERNAL Data FontFileGetTableDirectory(FontFileRef fontFile, SFUInteger faceIndex);
+
+/**
+ * Returns the data of a table in the table directory of a face, or NULL if the table does not
+ * exist or does not fit in the file.
+ */
+SF_INTERNAL Data FontFileSearchTable(FontFileRef fontFile, SFUInteger faceIndex,
+    SFTag tableTag, SFUInteger *outLength);
+
+SF_INTERNAL FontFileRef FontFileRetain(FontFileRef fontFile);
+SF_INTERNAL void FontFileRelease(FontFileRef fontFile);
+
+#endif
@@ -53,10 +53,16 @@ typedef SFUInt16 GlyphClassValue;
 #define GDEFv13_ItemVarStoreTable(data) \
     Data_Subdata(data, GDEFv13_ItemVarStoreOffset(data))
 
+#define GDEF_OptionalGlyphClassDefTable(data) \
+    (GDEF_GlyphClassDefOffset(data) ? GDEF_GlyphClassDefTable(data) : NULL)
+#define GDEF_OptionalMarkAttachClassDefTable(data) \
+    (GDEF_MarkAttachClassDefOffset(data) ? GDEF_MarkAttachClassDefTable(data) : NULL)
 #define GDEF_MarkGlyphSetsDefTable(data) \
-    (GDEF_Version(data) >= 0x00010002 ? GDEFv12_MarkGlyphSetsDefTable(data) : NULL)
+    (GDEF_Version(data) >= 0x00010002 && GDEFv12_MarkGlyphSetsDefOffset(data) \
+     ? GDEFv12_MarkGlyphSetsDefTable(data) : NULL)
 #define GDEF_ItemVarStoreTable(data) \
-    (GDEF_Version(data) >= 0x00010003 ? GDEFv13_ItemVarStoreTable(data) : NULL)
+    (GDEF_Version(data) >= 0x00010003 && GDEFv13_ItemVarStoreOffset(data) \
+     ? GDEFv13_ItemVarStoreTable(data) : NULL)
 
 /**************************************************************************************************/
 
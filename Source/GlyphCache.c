@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "SFBase.h"
+#include "GlyphCache.h"
+
+#define SlotMask        (GlyphCacheSize - 1)
+#define SlotBits        9
+#define MaxCodepoint    0x10FFFF
+
+/* An entry is laid out as the occupied flag, the high bits of the code point and the glyph. */
+#define EntryOccupied   0x80000000
+#define EntryTagShift   16
+#define EntryGlyphMask  0xFFFF
+
+/**
+ * Spreads the neighbouring blocks of different scripts over different slots. The mapping stays
+ * invertible for a given tag, so the tag alone identifies the code point within its slot.
+ */
+#define SlotOf(codepoint, tag) \
+    (((codepoint) ^ ((tag) * 0x9D)) & SlotMask)
+
+SF_INTERNAL GlyphCacheRef GlyphCacheCreate(void)
+{
+    GlyphCacheRef glyphCache = malloc(sizeof(GlyphCache));
+    SFUInteger index;
+
+    for (index = 0; index < GlyphCacheSize; index++) {
+        glyphCache->entries[index] = 0;
+    }
+    glyphCache->hitCount = 0;
+    glyphCache->missCount = 0;
+
+    return glyphCache;
+}
+
+SF_INTERNAL SFBoolean GlyphCacheLookup(GlyphCacheRef glyphCache, SFCodepoint codepoint, SFGlyphID *glyphID)
+{
+    SFUInt32 tag = codepoint >> SlotBits;
+    SFUInt32 entry = glyphCache->entries[SlotOf(codepoint, tag)];
+
+    if (codepoint <= MaxCodepoint && (entry & ~EntryGlyphMask) == (EntryOccupied | (tag << EntryTagShift))) {
+        *glyphID = (SFGlyphID)(entry & EntryGlyphMask);
+        glyphCache->hitCount++;
+
+        return SFTrue;
+    }
+
+    glyphCache->missCount++;
+
+    return SFFalse;
+}
+
+SF_INTERNAL void GlyphCacheStore(GlyphCacheRef glyphCache, SFCodepoint codepoint, SFGlyphID glyphID)
+{
+    if (codepoint <= MaxCodepoint) {
+        SFUInt32 tag = codepoint >> SlotBits;
+        glyphCache->entries[SlotOf(codepoint, tag)] = EntryOccupied | (tag << EntryTagShift) | glyphID;
+    }
+}
+
+SF_INTERNAL void GlyphCacheDestroy(GlyphCacheRef glyphCache)
+{
+    free(glyphCache);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_GLYPH_CACHE_H
+#define _SF_INTERNAL_GLYPH_CACHE_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+
+#define GlyphCacheSize  512
+
+/**
+ * A direct-mapped cache of code point to glyph mappings, placed in front of the glyph function of a
+ * font protocol.
+ *
+ * Each entry packs the high bits of a code point along with its glyph into a single 32-bit word,
+ * the low bits being implied by the slot. So an entry is always read and written with a single
+ * aligned access, which lets the fonts shared between threads use the cache without any locking. A
+ * racing store can only replace an entry as a whole, in which case the lookup simply misses.
+ */
+typedef struct _GlyphCache {
+    volatile SFUInt32 entries[GlyphCacheSize];
+    SFUInteger hitCount;        /**< The number of lookups found in the cache, approximate under contention. */
+    SFUInteger missCount;       /**< The number of lookups not found in the cache, approximate under contention. */
+} GlyphCache, *GlyphCacheRef;
+
+SF_INTERNAL GlyphCacheRef GlyphCacheCreate(void);
+
+/**
+ * Looks up the glyph of a code point, counting the lookup as a hit or a miss.
+ *
+ * @return
+ *      SFTrue if the code point was found in the cache, SFFalse otherwise.
+ */
+SF_INTERNAL SFBoolean GlyphCacheLookup(GlyphCacheRef glyphCache, SFCodepoint codepoint, SFGlyphID *glyphID);
+
+/**
+ * Stores the glyph of a code point, evicting the entry previously occupying its slot. Code points
+ * outside the Unicode range are never cached.
+ */
+SF_INTERNAL void GlyphCacheStore(GlyphCacheRef glyphCache, SFCodepoint codepoint, SFGlyphID glyphID);
+
+SF_INTERNAL void GlyphCacheDestroy(GlyphCacheRef glyphCache);
+
+#endif
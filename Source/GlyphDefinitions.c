@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "SFBase.h"
+#include "Common.h"
+#include "Data.h"
+#include "GDEF.h"
+#include "GlyphDefinitions.h"
+
+#define GDEFv10_Size()                  12
+#define GDEFv12_Size()                  14
+#define MarkGlyphSets_Size(count)       (4 + ((count) * 4))
+
+/**
+ * Returns the subtable at the given offset if its header fits in the available data.
+ */
+static Data GetBoundedSubtable(Data data, SFUInteger length, SFUInt32 offset, SFUInteger minLength,
+    SFUInteger *outLength)
+{
+    if (offset > length || minLength > length - offset) {
+        return NULL;
+    }
+
+    *outLength = length - offset;
+
+    return Data_Subdata(data, offset);
+}
+
+/**
+ * Validates a class definition table, extending the glyph limit to cover all its glyphs.
+ */
+static SFBoolean ScanClassDef(Data classDef, SFUInteger length, SFUInteger *glyphLimit)
+{
+    SFUInt16 format;
+
+    if (length < 4) {
+        return SFFalse;
+    }
+
+    format = ClassDef_Format(classDef);
+
+    switch (format) {
+        case 1: {
+            SFUInt16 startGlyph;
+            SFUInt16 glyphCount;
+
+            if (length < 6) {
+                return SFFalse;
+            }
+
+            startGlyph = ClassDefF1_StartGlyphID(classDef);
+            glyphCount = ClassDefF1_GlyphCount(classDef);
+
+            if (6 + ((SFUInteger)glyphCount * 2) > length) {
+                return SFFalse;
+            }
+            if (glyphCount && (SFUInteger)startGlyph + glyphCount > *glyphLimit) {
+                *glyphLimit = (SFUInteger)startGlyph + glyphCount;
+            }
+            return SFTrue;
+        }
+
+        case 2: {
+            SFUInt16 rangeCount = ClassDefF2_ClassRangeCount(classDef);
+            SFUInteger index;
+
+            if (4 + ((SFUInteger)rangeCount * GlyphRange_Size()) > length) {
+                return SFFalse;
+            }
+
+            for (index = 0; index < rangeCount; index++) {
+                Data rangeRecord = ClassDefF2_ClassRangeRecord(classDef, index);
+                SFUInt16 end = ClassRangeRecord_End(rangeRecord);
+
+                if (ClassRangeRecord_Start(rangeRecord) <= end && (SFUInteger)end + 1 > *glyphLimit) {
+                    *glyphLimit = (SFUInteger)end + 1;
+                }
+            }
+            return SFTrue;
+        }
+    }
+
+    return SFFalse;
+}
+
+/**
+ * Validates a coverage table, extending the glyph limit to cover all its glyphs.
+ */
+static SFBoolean ScanCoverage(Data coverage, SFUInteger length, SFUInteger *glyphLimit)
+{
+    SFUInt16 format;
+    SFUInt16 count;
+    SFUInteger index;
+
+    if (length < 4) {
+        return SFFalse;
+    }
+
+    format = Coverage_Format(coverage);
+    count = Data_UInt16(coverage, 2);
+
+    switch (format) {
+        case 1: {
+            Data glyphArray = CoverageF1_GlyphArray(coverage);
+
+            if (4 + ((SFUInteger)count * 2) > length) {
+                return SFFalse;
+            }
+
+            for (index = 0; index < count; index++) {
+                SFGlyphID glyph = GlyphArray_Value(glyphArray, index);
+
+                if ((SFUInteger)glyph + 1 > *glyphLimit) {
+                    *glyphLimit = (SFUInteger)glyph + 1;
+                }
+            }
+            return SFTrue;
+        }
+
+        case 2: {
+            if (4 + ((SFUInteger)count * GlyphRange_Size()) > length) {
+                return SFFalse;
+            }
+
+            for (index = 0; index < count; index++) {
+                Data rangeRecord = CoverageF2_RangeRecord(coverage, index);
+                SFUInt16 end = RangeRecord_EndGlyphID(rangeRecord);
+
+                if (RangeRecord_StartGlyphID(rangeRecord) <= end && (SFUInteger)end + 1 > *glyphLimit) {
+                    *glyphLimit = (SFUInteger)end + 1;
+                }
+            }
+            return SFTrue;
+        }
+    }
+
+    return SFFalse;
+}
+
+/**
+ * Stores the classes of a validated class definition table in the class array with the given
+ * transformation.
+ */
+static void FillClassDef(Data classDef, SFUInt16 *classArray, SFBoolean isMarkAttach)
+{
+    SFUInt16 format = ClassDef_Format(classDef);
+    SFUInteger index;
+
+    switch (format) {
+        case 1: {
+            SFUInt16 startGlyph = ClassDefF1_StartGlyphID(classDef);
+            SFUInt16 glyphCount = ClassDefF1_GlyphCount(classDef);
+            Data valueArray = ClassDefF1_ClassValueArray(classDef);
+
+            for (index = 0; index < glyphCount; index++) {
+                SFUInt16 *entry = &classArray[startGlyph + index];
+                SFUInt16 glyphClass = UInt16Array_Value(valueArray, index);
+
+                if (isMarkAttach) {
+                    *entry |= (glyphClass > 0xFF ? 0x100 : glyphClass);
+                } else if (glyphClass <= GlyphClassValueComponent) {
+                    *entry |= (SFUInt16)(glyphClass << GlyphDefinitionsClassShift);
+                }
+            }
+            break;
+        }
+
+        case 2: {
+            SFUInt16 rangeCount = ClassDefF2_ClassRangeCount(classDef);
+
+            for (index = 0; index < rangeCount; index++) {
+                Data rangeRecord = ClassDefF2_ClassRangeRecord(classDef, index);
+                SFUInteger start = ClassRangeRecord_Start(rangeRecord);
+                SFUInteger end = ClassRangeRecord_End(rangeRecord);
+                SFUInt16 glyphClass = ClassRangeRecord_Class(rangeRecord);
+                SFUInt16 bits = 0;
+                SFUInteger glyph;
+
+                if (isMarkAttach) {
+                    bits = (glyphClass > 0xFF ? 0x100 : glyphClass);
+                } else if (glyphClass <= GlyphClassValueComponent) {
+                    bits = (SFUInt16)(glyphClass << GlyphDefinitionsClassShift);
+                }
+
+                for (glyph = start; glyph <= end; glyph++) {
+                    classArray[glyph] |= bits;
+                }
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Sets the bits of all glyphs of a validated coverage table.
+ */
+static void FillCoverage(Data coverage, SFUInt8 *markSet)
+{
+    SFUInt16 format = Coverage_Format(coverage);
+    SFUInt16 count = Data_UInt16(coverage, 2);
+    SFUInteger index;
+
+    switch (format) {
+        case 1: {
+            Data glyphArray = CoverageF1_GlyphArray(coverage);
+
+            for (index = 0; index < count; index++) {
+                SFGlyphID glyph = GlyphArray_Value(glyphArray, index);
+                markSet[glyph >> 3] |= (SFUInt8)(1 << (glyph & 7));
+            }
+            break;
+        }
+
+        case 2: {
+            for (index = 0; index < count; index++) {
+                Data rangeRecord = CoverageF2_RangeRecord(coverage, index);
+                SFUInteger start = RangeRecord_StartGlyphID(rangeRecord);
+                SFUInteger end = RangeRecord_EndGlyphID(rangeRecord);
+                SFUInteger glyph;
+
+                for (glyph = start; glyph <= end; glyph++) {
+                    markSet[glyph >> 3] |= (SFUInt8)(1 << (glyph & 7));
+                }
+            }
+            break;
+        }
+    }
+}
+
+SF_INTERNAL GlyphDefinitionsRef GlyphDefinitionsCreate(Data gdef, SFUInteger length)
+{
+    Data glyphClassDef = NULL;
+    Data markAttachClassDef = NULL;
+    Data markGlyphSetsDef = NULL;
+    SFUInt16 markSetCount = 0;
+    SFUInteger glyphLimit = 0;
+    SFUInteger subtableLength;
+    GlyphDefinitionsRef definitions;
+    SFUInteger index;
+
+    if (!gdef || length < GDEFv10_Size() || (GDEF_Version(gdef) >> 16) != 1) {
+        return NULL;
+    }
+
+    if (GDEF_GlyphClassDefOffset(gdef)) {
+        glyphClassDef = GetBoundedSubtable(gdef, length, GDEF_GlyphClassDefOffset(gdef), 0, &subtableLength);
+
+        if (!glyphClassDef || !ScanClassDef(glyphClassDef, subtableLength, &glyphLimit)) {
+            return NULL;
+        }
+    }
+
+    if (GDEF_MarkAttachClassDefOffset(gdef)) {
+        markAttachClassDef = GetBoundedSubtable(gdef, length, GDEF_MarkAttachClassDefOffset(gdef), 0, &subtableLength);
+
+        if (!markAttachClassDef || !ScanClassDef(markAttachClassDef, subtableLength, &glyphLimit)) {
+            return NULL;
+        }
+    }
+
+    if (GDEF_Version(gdef) >= 0x00010002) {
+        if (length < GDEFv12_Size()) {
+            return NULL;
+        }
+
+        if (GDEFv12_MarkGlyphSetsDefOffset(gdef)) {
+            SFUInteger setsLength;
+
+            markGlyphSetsDef = GetBoundedSubtable(gdef, length, GDEFv12_MarkGlyphSetsDefOffset(gdef),
+                                           MarkGlyphSets_Size(0), &setsLength);
+
+            if (!markGlyphSetsDef || MarkGlyphSets_Format(markGlyphSetsDef) != 1) {
+                return NULL;
+            }
+
+            markSetCount = MarkGlyphSets_MarkSetCount(markGlyphSetsDef);
+
+            if (MarkGlyphSets_Size(markSetCount) > setsLength) {
+                return NULL;
+            }
+
+            for (index = 0; index < markSetCount; index++) {
+                Data coverage = GetBoundedSubtable(markGlyphSetsDef, setsLength,
+                                            MarkGlyphSets_CoverageOffset(markGlyphSetsDef, index),
+                                            0, &subtableLength);
+
+                if (!coverage || !ScanCoverage(coverage, subtableLength, &glyphLimit)) {
+                    return NULL;
+                }
+            }
+        }
+    }
+
+    if (!glyphClassDef && !markAttachClassDef && !markGlyphSetsDef) {
+        return NULL;
+    }
+
+    definitions = malloc(sizeof(GlyphDefinitions));
+    definitions->glyphCount = glyphLimit;
+    definitions->classArray = calloc(glyphLimit ? glyphLimit : 1, sizeof(SFUInt16));
+    definitions->markSetSize = (glyphLimit + 7) >> 3;
+    definitions->markSetCount = markSetCount;
+    definitions->markSetArray = NULL;
+    definitions->hasMarkAttachClasses = (markAttachClassDef != NULL);
+
+    if (glyphClassDef) {
+        FillClassDef(glyphClassDef, definitions->classArray, SFFalse);
+    }
+    if (markAttachClassDef) {
+        FillClassDef(markAttachClassDef, definitions->classArray, SFTrue);
+    }
+
+    if (markSetCount > 0) {
+        SFUInteger markSetSize = definitions->markSetSize;
+
+        definitions->markSetArray = calloc(markSetCount * (markSetSize ? markSetSize : 1), 1);
+
+        for (index = 0; index < markSetCount; index++) {
+            Data coverage = MarkGlyphSets_CoverageTable(markGlyphSetsDef, index);
+            FillCoverage(coverage, &definitions->markSetArray[index * markSetSize]);
+        }
+    }
+
+    return definitions;
+}
+
+SF_INTERNAL const SFUInt8 *GlyphDefinitionsGetMarkSet(GlyphDefinitionsRef definitions, SFUInt16 markSetIndex)
+{
+    if (markSetIndex < definitions->markSetCount) {
+        return &definitions->markSetArray[markSetIndex * definitions->markSetSize];
+    }
+
+    return NULL;
+}
+
+SF_INTERNAL void GlyphDefinitionsDestroy(GlyphDefinitionsRef definitions)
+{
+    free(definitions->classArray);
+    free(definitions->markSetArray);
+    free(definitions);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_GLYPH_DEFINITIONS_H
+#define _SF_INTERNAL_GLYPH_DEFINITIONS_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+
+#define GlyphDefinitionsClassShift      12
+#define GlyphDefinitionsAttachMask      0x01FF
+
+/**
+ * Dense form of the GDEF data looked up for every glyph while shaping.
+ *
+ * The glyph class and the mark attachment class of each glyph are packed in a single 16-bit entry,
+ * the former in the top four bits and the latter in the low nine bits. A mark attachment class
+ * beyond 255 can never be requested by a lookup flag, so all such classes are stored as 256. Each
+ * mark glyph set is kept as a bit set of all glyphs, the sets being laid out one after another.
+ */
+typedef struct _GlyphDefinitions {
+    SFUInt16 *classArray;       /**< The packed classes of the glyphs. */
+    SFUInt8 *markSetArray;      /**< The bit sets of mark glyph sets. */
+    SFUInteger glyphCount;      /**< The number of glyphs covered by any of the tables. */
+    SFUInteger markSetSize;     /**< The number of bytes taken by each mark glyph set. */
+    SFUInteger markSetCount;    /**< The number of mark glyph sets. */
+    SFBoolean hasMarkAttachClasses; /**< Whether GDEF has a mark attachment class definition table. */
+} GlyphDefinitions, *GlyphDefinitionsRef;
+
+#define GlyphDefinitionsGetEntry(definitions, glyph) \
+    ((SFUInteger)(glyph) < (definitions)->glyphCount ? (definitions)->classArray[glyph] : 0)
+
+#define GlyphDefinitionsGetGlyphClass(definitions, glyph) \
+    (SFUInt16)(GlyphDefinitionsGetEntry(definitions, glyph) >> GlyphDefinitionsClassShift)
+
+#define GlyphDefinitionsGetMarkAttachClass(definitions, glyph) \
+    (SFUInt16)(GlyphDefinitionsGetEntry(definitions, glyph) & GlyphDefinitionsAttachMask)
+
+#define GlyphDefinitionsMarkSetContains(definitions, markSet, glyph) \
+    ((SFUInteger)(glyph) < (definitions)->glyphCount && ((markSet)[(glyph) >> 3] & (1 << ((glyph) & 7))))
+
+/**
+ * Builds the dense classes and mark glyph sets of a GDEF table, validating all the subtables used.
+ *
+ * @return
+ *      New glyph definitions, or NULL if the table is malformed or has none of the subtables.
+ */
+SF_INTERNAL GlyphDefinitionsRef GlyphDefinitionsCreate(Data gdef, SFUInteger length);
+
+/**
+ * Returns the bit set of a mark glyph set, or NULL if the index is out of range.
+ */
+SF_INTERNAL const SFUInt8 *GlyphDefinitionsGetMarkSet(GlyphDefinitionsRef definitions, SFUInt16 markSetIndex);
+
+SF_INTERNAL void GlyphDefinitionsDestroy(GlyphDefinitionsRef definitions);
+
+#endif
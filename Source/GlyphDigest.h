@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_GLYPH_DIGEST_H
+#define _SF_INTERNAL_GLYPH_DIGEST_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+
+#define GlyphDigestMaskCount    3
+
+/**
+ * A compact summary of a glyph set which can tell for sure that a glyph is not in the set.
+ *
+ * Each mask keeps a bit for every group of glyphs sharing the same value when shifted by a
+ * different amount, so a glyph may be in the set only if all of its bits are set.
+ */
+typedef struct _GlyphDigest {
+    SFUInt32 masks[GlyphDigestMaskCount];
+} GlyphDigest, *GlyphDigestRef;
+
+#define GlyphDigestBit(glyph, shift) \
+    ((SFUInt32)1 << (((glyph) >> (shift)) & 31))
+
+#define GlyphDigestMayContain(digest, glyph)                            \
+(                                                                       \
+    ((digest)->masks[0] & GlyphDigestBit(glyph, 0))                     \
+ && ((digest)->masks[1] & GlyphDigestBit(glyph, 4))                     \
+ && ((digest)->masks[2] & GlyphDigestBit(glyph, 9))                     \
+)
+
+#define GlyphDigestAddGlyph(digest, glyph)                              \
+do {                                                                    \
+    (digest)->masks[0] |= GlyphDigestBit(glyph, 0);                     \
+    (digest)->masks[1] |= GlyphDigestBit(glyph, 4);                     \
+    (digest)->masks[2] |= GlyphDigestBit(glyph, 9);                     \
+} while (0)
+
+#define GlyphDigestClear(digest)                                        \
+do {                                                                    \
+    (digest)->masks[0] = 0;                                             \
+    (digest)->masks[1] = 0;                                             \
+    (digest)->masks[2] = 0;                                             \
+} while (0)
+
+/**
+ * Tells whether two glyph sets may have a common glyph. A common glyph would set the same bits in
+ * both digests, so the sets are surely disjoint if any pair of masks has nothing in common.
+ */
+#define GlyphDigestMayIntersect(digest1, digest2)                       \
+(                                                                       \
+    ((digest1)->masks[0] & (digest2)->masks[0])                         \
+ && ((digest1)->masks[1] & (digest2)->masks[1])                         \
+ && ((digest1)->masks[2] & (digest2)->masks[2])                         \
+)
+
+#endif
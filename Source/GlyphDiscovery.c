@@ -21,6 +21,7 @@
 #include "SFCodepoints.h"
 #include "SFFont.h"
 #include "GDEF.h"
+#include "GlyphDefinitions.h"
 #include "OpenType.h"
 #include "SFPattern.h"
 
@@ -33,27 +34,43 @@ static SFBoolean IsZeroWidthCodepoint(SFCodepoint codepoint)
     return SFCodepointInRange(codepoint, 0x200B, 0x200F);
 }
 
-SF_PRIVATE GlyphTraits GetGlyphTraits(TextProcessorRef textProcessor, SFGlyphID glyph)
+static SFBoolean IsVariationSelector(SFCodepoint codepoint)
 {
-    Data glyphClassDef = textProcessor->_glyphClassDef;
+    return SFCodepointInRange(codepoint, 0xFE00, 0xFE0F)
+        || SFCodepointInRange(codepoint, 0xE0100, 0xE01EF)
+        || SFCodepointInRange(codepoint, 0x180B, 0x180D);
+}
 
-    if (glyphClassDef) {
-        SFUInt16 glyphClass = SearchGlyphClass(glyphClassDef, glyph);
+static GlyphTraits GetTraitsForGlyphClass(SFUInt16 glyphClass)
+{
+    /* Convert glyph class to traits options. */
+    switch (glyphClass) {
+        case GlyphClassValueBase:
+            return GlyphTraitBase;
 
-        /* Convert glyph class to traits options. */
-        switch (glyphClass) {
-            case GlyphClassValueBase:
-                return GlyphTraitBase;
+        case GlyphClassValueLigature:
+            return GlyphTraitLigature;
 
-            case GlyphClassValueLigature:
-                return GlyphTraitLigature;
+        case GlyphClassValueMark:
+            return GlyphTraitMark;
 
-            case GlyphClassValueMark:
-                return GlyphTraitMark;
+        case GlyphClassValueComponent:
+            return GlyphTraitComponent;
+    }
 
-            case GlyphClassValueComponent:
-                return GlyphTraitComponent;
-        }
+    return GlyphTraitNone;
+}
+
+SF_PRIVATE GlyphTraits GetGlyphTraits(TextProcessorRef textProcessor, SFGlyphID glyph)
+{
+    GlyphDefinitionsRef glyphDefinitions = textProcessor->_glyphDefinitions;
+    Data glyphClassDef = textProcessor->_glyphClassDef;
+
+    if (glyphDefinitions) {
+        return GetTraitsForGlyphClass(GlyphDefinitionsGetGlyphClass(glyphDefinitions, glyph));
+    }
+    if (glyphClassDef) {
+        return GetTraitsForGlyphClass(SearchGlyphClass(glyphClassDef, glyph));
     }
 
     return GlyphTraitNone;
@@ -66,14 +83,19 @@ SF_PRIVATE void DiscoverGlyphs(TextProcessorRef textProcessor)
     SFAlbumRef album = textProcessor->_album;
     SFCodepointsRef codepoints = album->codepoints;
     SFBoolean isRTL = textProcessor->_textDirection == SFTextDirectionRightToLeft;
+    SFCodepoint *codepointArray;
+    SFUInteger glyphCount;
+    SFUInteger index;
     SFCodepoint current;
 
+    /* Each code point takes at least one code unit, so the code unit count suffices. */
+    codepointArray = SFAlbumGetTemporaryCodepointArray(album, album->codeunitCount);
+    glyphCount = 0;
+
     SFCodepointsReset(codepoints);
 
+    /* Collect the code points so that the font can map all of them in a single call. */
     while ((current = SFCodepointsNext(codepoints)) != SFCodepointInvalid) {
-        SFGlyphID glyph;
-        GlyphTraits traits;
-
         if (isRTL) {
             SFCodepoint mirror = SFCodepointsGetMirror(current);
 
@@ -82,14 +104,39 @@ SF_PRIVATE void DiscoverGlyphs(TextProcessorRef textProcessor)
             }
         }
 
-        glyph = SFFontGetGlyphIDForCodepoint(font, current);
-        traits = GetGlyphTraits(textProcessor, glyph);
+        codepointArray[glyphCount++] = current;
+        SFAlbumAddGlyph(album, 0, GlyphTraitNone, codepoints->index);
+    }
+
+    if (glyphCount) {
+        SFFontGetGlyphIDsForCodepoints(font, codepointArray, SFAlbumGetGlyphArray(album, 0), glyphCount);
+        SFAlbumDigestGlyphs(album, 0, glyphCount);
+    }
+
+    for (index = 0; index < glyphCount; index++) {
+        SFGlyphID glyph = SFAlbumGetGlyph(album, index);
+        GlyphTraits traits = GetGlyphTraits(textProcessor, glyph);
+        SFCodepoint codepoint = codepointArray[index];
+
+        /* Replace the base glyph if the font supports the variation sequence. */
+        if (index > 0 && IsVariationSelector(codepoint)) {
+            SFGlyphID variant = SFFontGetGlyphIDForVariation(font, codepointArray[index - 1], codepoint);
+
+            if (variant) {
+                SFAlbumSetGlyph(album, index - 1, variant);
+                SFAlbumSetAllTraits(album, index - 1, GetGlyphTraits(textProcessor, variant));
+
+                /* The selector itself is consumed by the sequence. */
+                textProcessor->_containsZeroWidthCodepoints = SFTrue;
+                traits |= GlyphTraitZeroWidth;
+            }
+        }
 
-        if (IsZeroWidthCodepoint(current)) {
+        if (IsZeroWidthCodepoint(codepoint)) {
             textProcessor->_containsZeroWidthCodepoints = SFTrue;
             traits |= GlyphTraitZeroWidth;
         }
 
-        SFAlbumAddGlyph(album, glyph, traits, codepoints->index);
+        SFAlbumSetAllTraits(album, index, traits);
     }
 }
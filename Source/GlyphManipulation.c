@@ -227,7 +227,8 @@ SF_PRIVATE SFBoolean ApplyContextSubtable(TextProcessorRef textProcessor, Data c
             locGlyph = SFAlbumGetGlyph(album, locator->index);
             covIndex = SearchCoverageIndex(coverage, locGlyph);
 
-            if (covIndex < ruleSetCount) {
+            /* A null rule set means that the glyph does not start any rule. */
+            if (covIndex < ruleSetCount && ContextF1_RuleSetOffset(context, covIndex)) {
                 Data ruleSet = ContextF1_RuleSetTable(context, covIndex);
                 return ApplyRuleSetTable(textProcessor, ruleSet, AssessGlyphByEquality, NULL);
             }
@@ -249,7 +250,7 @@ SF_PRIVATE SFBoolean ApplyContextSubtable(TextProcessorRef textProcessor, Data c
 
                 locClass = SearchGlyphClass(classDef, locGlyph);
 
-                if (locClass < ruleSetCount) {
+                if (locClass < ruleSetCount && ContextF2_RuleSetOffset(context, locClass)) {
                     Data ruleSet = ContextF2_RuleSetTable(context, locClass);
                     return ApplyRuleSetTable(textProcessor, ruleSet, AssessGlyphByClass, &classDef);
                 }
@@ -327,7 +328,8 @@ SF_PRIVATE SFBoolean ApplyChainContextSubtable(TextProcessorRef textProcessor, D
             locGlyph = SFAlbumGetGlyph(album, locator->index);
             covIndex = SearchCoverageIndex(coverage, locGlyph);
 
-            if (covIndex < ruleSetCount) {
+            /* A null rule set means that the glyph does not start any rule. */
+            if (covIndex < ruleSetCount && ChainContextF1_ChainRuleSetOffset(chainContext, covIndex)) {
                 Data chainRuleSet = ChainContextF1_ChainRuleSetTable(chainContext, covIndex);
                 return ApplyChainRuleSetTable(textProcessor, chainRuleSet, AssessGlyphByEquality, NULL);
             }
@@ -351,7 +353,8 @@ SF_PRIVATE SFBoolean ApplyChainContextSubtable(TextProcessorRef textProcessor, D
 
                 inputClass = SearchGlyphClass(inputClassDef, locGlyph);
 
-                if (inputClass < chainRuleSetCount) {
+                if (inputClass < chainRuleSetCount
+                    && ChainContextF2_ChainRuleSetOffset(chainContext, inputClass)) {
                     Data chainRuleSet = ChainContextF2_ChainRuleSetTable(chainContext, inputClass);
                     Data helpers[3];
 
@@ -384,10 +387,14 @@ static SFBoolean ApplyChainRuleSetTable(TextProcessorRef textProcessor,
 
     /* Match each rule sequentially as they are ordered by preference. */
     for (ruleIndex = 0; ruleIndex < ruleCount; ruleIndex++) {
-        Data chainRule = ChainRuleSet_ChainRuleTable(chainRuleSet, ruleIndex);
+        SFOffset ruleOffset = ChainRuleSet_ChainRuleOffset(chainRuleSet, ruleIndex);
 
-        if (ApplyChainRuleTable(textProcessor, chainRule, SFFalse, glyphAsessment, helperPtr)) {
-            return SFTrue;
+        if (ruleOffset) {
+            Data chainRule = Data_Subdata(chainRuleSet, ruleOffset);
+
+            if (ApplyChainRuleTable(textProcessor, chainRule, SFFalse, glyphAsessment, helperPtr)) {
+                return SFTrue;
+            }
         }
     }
 
@@ -25,15 +25,20 @@
 #include "GPOS.h"
 #include "Locator.h"
 #include "OpenType.h"
+#include "PairCache.h"
+#include "PairMatrix.h"
 
 #include "GlyphManipulation.h"
 #include "GlyphPositioning.h"
 #include "TextProcessor.h"
 
-static SFBoolean ApplyPairPosF1(TextProcessorRef textProcessor, Data pairPos,
-    SFUInteger firstIndex, SFUInteger secondIndex, SFBoolean *outShouldSkip);
-static SFBoolean ApplyPairPosF2(TextProcessorRef textProcessor, Data pairPos,
-    SFUInteger firstIndex, SFUInteger secondIndex, SFBoolean *outShouldSkip);
+static Data LocatePairPosF1(Data pairPos, SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data *outParent);
+static Data LocatePairPosF2(Data pairPos, SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data *outParent);
+static SFBoolean ApplyPairMatrix(TextProcessorRef textProcessor, PairMatrixRef pairMatrix,
+    SFGlyphID firstGlyph, SFGlyphID secondGlyph, SFUInteger firstIndex, SFUInteger secondIndex,
+    SFBoolean *outShouldSkip);
+static SFBoolean ApplyPairValues(TextProcessorRef textProcessor, Data pairPos, Data parent,
+    Data values, SFUInteger firstIndex, SFUInteger secondIndex, SFBoolean *outShouldSkip);
 
 static SFBoolean ApplyCursiveAnchors(TextProcessorRef textProcessor,
     Data exitAnchor, Data entryAnchor, SFUInteger firstIndex, SFUInteger secondIndex);
@@ -45,18 +50,32 @@ static SFBoolean ApplyMarkToLigArrays(TextProcessorRef textProcessor, Data markL
 static SFBoolean ApplyMarkToMarkArrays(TextProcessorRef textProcessor, Data markMarkPos,
     SFUInteger mark1Index, SFUInteger mark2Index, SFUInteger attachmentIndex);
 
+static SFInt32 GetDeltaPixels(TextProcessorRef textProcessor, Data devOrVarIdxTable, SFUInt16 ppemSize)
+{
+    DeltaCacheRef deltaCache = textProcessor->_deltaCache;
+    SFInt32 pixels;
+
+    if (!deltaCache || !DeltaCacheLookup(deltaCache, devOrVarIdxTable, ppemSize, &pixels)) {
+        pixels = GetRelevantDeltaPixels(devOrVarIdxTable, ppemSize,
+                                        textProcessor->_itemVarStore, textProcessor->_regionScalars,
+                                        textProcessor->_coordArray, textProcessor->_coordCount);
+
+        if (deltaCache) {
+            DeltaCacheStore(deltaCache, devOrVarIdxTable, ppemSize, pixels);
+        }
+    }
+
+    return pixels;
+}
+
 static SFInt32 GetXDeltaPixels(TextProcessorRef textProcessor, Data devOrVarIdxTable)
 {
-    return GetRelevantDeltaPixels(devOrVarIdxTable, textProcessor->_ppemWidth,
-                                  textProcessor->_itemVarStore,
-                                  textProcessor->_coordArray, textProcessor->_coordCount);
+    return GetDeltaPixels(textProcessor, devOrVarIdxTable, textProcessor->_ppemWidth);
 }
 
 static SFInt32 GetYDeltaPixels(TextProcessorRef textProcessor, Data devOrVarIdxTable)
 {
-    return GetRelevantDeltaPixels(devOrVarIdxTable, textProcessor->_ppemHeight,
-                                  textProcessor->_itemVarStore,
-                                  textProcessor->_coordArray, textProcessor->_coordCount);
+    return GetDeltaPixels(textProcessor, devOrVarIdxTable, textProcessor->_ppemHeight);
 }
 
 static void ApplyValueRecord(TextProcessorRef textProcessor, Data parentTable,
@@ -148,6 +167,43 @@ static void ApplyValueRecord(TextProcessorRef textProcessor, Data parentTable,
     }
 }
 
+/**
+ * Applies the values decoded from a device-free value record, returning the number of consumed
+ * values.
+ */
+static SFUInteger ApplyNativeValues(TextProcessorRef textProcessor,
+    const SFInt16 *values, SFUInt16 valueFormat, SFUInteger inputIndex)
+{
+    SFAlbumRef album = textProcessor->_album;
+    SFUInteger valueIndex = 0;
+
+    if (ValueFormat_XPlacement(valueFormat)) {
+        SFAlbumAddX(album, inputIndex, values[valueIndex++]);
+    }
+
+    if (ValueFormat_YPlacement(valueFormat)) {
+        SFAlbumAddY(album, inputIndex, values[valueIndex++]);
+    }
+
+    if (ValueFormat_XAdvance(valueFormat)) {
+        switch (textProcessor->_textDirection) {
+            case SFTextDirectionLeftToRight:
+            case SFTextDirectionRightToLeft:
+                SFAlbumAddAdvance(album, inputIndex, values[valueIndex]);
+                break;
+        }
+
+        valueIndex += 1;
+    }
+
+    if (ValueFormat_YAdvance(valueFormat)) {
+        /* TODO: Add support for vertical layout. */
+        valueIndex += 1;
+    }
+
+    return valueIndex;
+}
+
 static SFBoolean ApplySinglePos(TextProcessorRef textProcessor, Data singlePos)
 {
     SFAlbumRef album = textProcessor->_album;
@@ -201,18 +257,9 @@ static SFBoolean ApplySinglePos(TextProcessorRef textProcessor, Data singlePos)
     return SFFalse;
 }
 
-static int PairRecordGlyphComparison(const void *item1, const void *item2)
-{
-    SFGlyphID *ref1 = (SFGlyphID *)item1;
-    Data ref2 = (Data)item2;
-    SFUInt16 val1 = *ref1;
-    SFGlyphID val2 = PairValueRecord_SecondGlyph(ref2);
-
-    return val1 - val2;
-}
-
 static SFBoolean ApplyPairPos(TextProcessorRef textProcessor, Data pairPos)
 {
+    SFAlbumRef album = textProcessor->_album;
     LocatorRef locator = &textProcessor->_locator;
     SFBoolean didPosition = SFFalse;
     SFBoolean shouldSkip = SFFalse;
@@ -224,16 +271,41 @@ static SFBoolean ApplyPairPos(TextProcessorRef textProcessor, Data pairPos)
 
     /* Proceed only if pair glyph is available. */
     if (secondIndex != SFInvalidIndex) {
-        SFUInt16 format = PairPos_Format(pairPos);
+        PairMatrixRef pairMatrix = textProcessor->_pairMatrix;
+        PairCacheRef pairCache = textProcessor->_pairCache;
+        SFGlyphID firstGlyph = SFAlbumGetGlyph(album, firstIndex);
+        SFGlyphID secondGlyph = SFAlbumGetGlyph(album, secondIndex);
+
+        /* Use the compiled form of the subtable if available. */
+        if (pairMatrix && pairMatrix->source == pairPos) {
+            didPosition = ApplyPairMatrix(textProcessor, pairMatrix,
+                                          firstGlyph, secondGlyph, firstIndex, secondIndex, &shouldSkip);
+        } else {
+            Data parent = NULL;
+            Data values = NULL;
+
+            if (!pairCache || !PairCacheLookup(pairCache, pairPos, firstGlyph, secondGlyph, &parent, &values)) {
+                SFUInt16 format = PairPos_Format(pairPos);
+
+                switch (format) {
+                    case 1:
+                        values = LocatePairPosF1(pairPos, firstGlyph, secondGlyph, &parent);
+                        break;
+
+                    case 2:
+                        values = LocatePairPosF2(pairPos, firstGlyph, secondGlyph, &parent);
+                        break;
+                }
 
-        switch (format) {
-            case 1:
-                didPosition = ApplyPairPosF1(textProcessor, pairPos, firstIndex, secondIndex, &shouldSkip);
-                break;
+                if (pairCache) {
+                    PairCacheStore(pairCache, pairPos, firstGlyph, secondGlyph, parent, values);
+                }
+            }
 
-            case 2:
-                didPosition = ApplyPairPosF2(textProcessor, pairPos, firstIndex, secondIndex, &shouldSkip);
-                break;
+            if (values) {
+                didPosition = ApplyPairValues(textProcessor, pairPos, parent, values,
+                                              firstIndex, secondIndex, &shouldSkip);
+            }
         }
     }
 
@@ -244,20 +316,42 @@ static SFBoolean ApplyPairPos(TextProcessorRef textProcessor, Data pairPos)
     return didPosition;
 }
 
-static SFBoolean ApplyPairPosF1(TextProcessorRef textProcessor, Data pairPos,
-    SFUInteger firstIndex, SFUInteger secondIndex, SFBoolean *outShouldSkip)
+static Data SearchPairValueRecord(Data recordArray, SFUInteger recordCount,
+    SFUInteger recordSize, SFGlyphID secondGlyph)
 {
-    SFAlbumRef album = textProcessor->_album;
-    SFGlyphID firstGlyph = SFAlbumGetGlyph(album, firstIndex);
-    SFGlyphID secondGlyph = SFAlbumGetGlyph(album, secondIndex);
-    Data coverage;
-    SFUInt16 pairSetCount;
-    SFUInteger covIndex;
+    Data base = recordArray;
+    SFUInteger count = recordCount;
+
+    if (count == 0) {
+        return NULL;
+    }
 
-    *outShouldSkip = SFFalse;
+    /* Narrow down to the last record not greater than the second glyph. */
+    while (count > 1) {
+        SFUInteger half = count >> 1;
+        Data probe = base + (half * recordSize);
+
+        base = (PairValueRecord_SecondGlyph(probe) <= secondGlyph ? probe : base);
+        count -= half;
+    }
+
+    if (PairValueRecord_SecondGlyph(base) != secondGlyph) {
+        return NULL;
+    }
+
+    return base;
+}
+
+/**
+ * Locates the value record of first glyph in a PairPos format 1 subtable, the one of second glyph
+ * following it.
+ */
+static Data LocatePairPosF1(Data pairPos, SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data *outParent)
+{
+    Data coverage = PairPosF1_CoverageTable(pairPos);
+    SFUInt16 pairSetCount = PairPosF1_PairSetCount(pairPos);
+    SFUInteger covIndex;
 
-    coverage = PairPosF1_CoverageTable(pairPos);
-    pairSetCount = PairPosF1_PairSetCount(pairPos);
     covIndex = SearchCoverageIndex(coverage, firstGlyph);
 
     if (covIndex < pairSetCount) {
@@ -271,44 +365,26 @@ static SFBoolean ApplyPairPosF1(TextProcessorRef textProcessor, Data pairPos,
         SFUInteger recordSize = PairValueRecord_Size(value1Size, value2Size);
         Data pairRecord;
 
-        pairRecord = bsearch(&secondGlyph, recordArray, valueCount, recordSize, PairRecordGlyphComparison);
+        pairRecord = SearchPairValueRecord(recordArray, valueCount, recordSize, secondGlyph);
 
         if (pairRecord) {
-            if (value1Size) {
-                Data value1 = PairValueRecord_Value1(pairRecord);
-                ApplyValueRecord(textProcessor, pairSet, value1, valueFormat1, firstIndex);
-            }
-
-            if (value2Size) {
-                Data value2 = PairValueRecord_Value2(pairRecord, value1Size);
-                ApplyValueRecord(textProcessor, pairSet, value2, valueFormat2, secondIndex);
-
-                /*
-                 * Pair element should be skipped only if the value record for the second glyph
-                 * is AVAILABLE.
-                 */
-                *outShouldSkip = SFTrue;
-            }
-
-            return SFTrue;
+            *outParent = pairSet;
+            return PairValueRecord_Value1(pairRecord);
         }
     }
 
-    return SFFalse;
+    return NULL;
 }
 
-static SFBoolean ApplyPairPosF2(TextProcessorRef textProcessor, Data pairPos,
-    SFUInteger firstIndex, SFUInteger secondIndex, SFBoolean *outShouldSkip)
+/**
+ * Locates the value record of first glyph in a PairPos format 2 subtable, the one of second glyph
+ * following it.
+ */
+static Data LocatePairPosF2(Data pairPos, SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data *outParent)
 {
-    SFAlbumRef album = textProcessor->_album;
-    SFGlyphID firstGlyph = SFAlbumGetGlyph(album, firstIndex);
-    SFGlyphID secondGlyph = SFAlbumGetGlyph(album, secondIndex);
-    Data coverage;
+    Data coverage = PairPosF2_CoverageTable(pairPos);
     SFUInteger covIndex;
 
-    *outShouldSkip = SFFalse;
-
-    coverage = PairPosF2_CoverageTable(pairPos);
     covIndex = SearchCoverageIndex(coverage, firstGlyph);
 
     if (covIndex != SFInvalidIndex) {
@@ -332,29 +408,72 @@ static SFBoolean ApplyPairPosF2(TextProcessorRef textProcessor, Data pairPos,
             Data class1Record = PairPosF2_Class1Record(pairPos, class1Value, class1Size);
             Data class2Record = Class1Record_Class2Record(class1Record, class2Value, class2Size);
 
-            if (value1Size) {
-                Data value1 = Class2Record_Value1(class2Record);
-                ApplyValueRecord(textProcessor, pairPos, value1, valueFormat1, firstIndex);
-            }
+            *outParent = pairPos;
+            return Class2Record_Value1(class2Record);
+        }
+    }
 
-            if (value2Size) {
-                Data value2 = Class2Record_Value2(class2Record, value1Size);
-                ApplyValueRecord(textProcessor, pairPos, value2, valueFormat2, secondIndex);
+    return NULL;
+}
 
-                /*
-                 * Pair element should be skipped only if the value record for the second glyph is
-                 * AVAILABLE.
-                 */
-                *outShouldSkip = SFTrue;
-            }
+static SFBoolean ApplyPairMatrix(TextProcessorRef textProcessor, PairMatrixRef pairMatrix,
+    SFGlyphID firstGlyph, SFGlyphID secondGlyph, SFUInteger firstIndex, SFUInteger secondIndex,
+    SFBoolean *outShouldSkip)
+{
+    SFUInt16 class1Value = PairMatrixGetClass1(pairMatrix, firstGlyph);
+    SFUInt16 class2Value = PairMatrixGetClass2(pairMatrix, secondGlyph);
 
-            return SFTrue;
+    if (class1Value != PairMatrixInvalidClass && class2Value != PairMatrixInvalidClass) {
+        const SFInt16 *values = PairMatrixGetValues(pairMatrix, class1Value, class2Value);
+
+        values += ApplyNativeValues(textProcessor, values, pairMatrix->valueFormat1, firstIndex);
+
+        if (pairMatrix->valueFormat2) {
+            ApplyNativeValues(textProcessor, values, pairMatrix->valueFormat2, secondIndex);
+
+            /*
+             * Pair element should be skipped only if the value record for the second glyph is
+             * AVAILABLE.
+             */
+            *outShouldSkip = SFTrue;
         }
+
+        return SFTrue;
     }
 
     return SFFalse;
 }
 
+/**
+ * Applies the located value records of a pair. Both formats keep the value formats at the same
+ * place and the value record of second glyph right after the one of first glyph.
+ */
+static SFBoolean ApplyPairValues(TextProcessorRef textProcessor, Data pairPos, Data parent,
+    Data values, SFUInteger firstIndex, SFUInteger secondIndex, SFBoolean *outShouldSkip)
+{
+    SFUInt16 valueFormat1 = PairPosF1_ValueFormat1(pairPos);
+    SFUInt16 valueFormat2 = PairPosF1_ValueFormat2(pairPos);
+    SFUInteger value1Size = ValueRecord_Size(valueFormat1);
+    SFUInteger value2Size = ValueRecord_Size(valueFormat2);
+
+    if (value1Size) {
+        ApplyValueRecord(textProcessor, parent, values, valueFormat1, firstIndex);
+    }
+
+    if (value2Size) {
+        Data value2 = Data_Subdata(values, value1Size);
+        ApplyValueRecord(textProcessor, parent, value2, valueFormat2, secondIndex);
+
+        /*
+         * Pair element should be skipped only if the value record for the second glyph is
+         * AVAILABLE.
+         */
+        *outShouldSkip = SFTrue;
+    }
+
+    return SFTrue;
+}
+
 static SFPoint ConvertAnchorToPoint(TextProcessorRef textProcessor, Data anchor)
 {
     SFUInt16 format;
@@ -1042,7 +1161,7 @@ SF_PRIVATE void ResolveAttachments(TextProcessorRef textProcessor)
     SFAlbumRef album = textProcessor->_album;
     Locator locator;
 
-    LocatorInitialize(&locator, album, NULL);
+    LocatorInitialize(&locator, album, NULL, NULL);
 
     ResolveCursivePositions(textProcessor, &locator);
     ResolveMarkPositions(textProcessor, &locator);
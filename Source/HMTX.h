@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_HMTX_H
+#define _SF_INTERNAL_HMTX_H
+
+#include "Data.h"
+#include "SFBase.h"
+
+/*******************************************HHEA HEADER********************************************/
+
+#define HHEA_NumberOfHMetrics(data)                     Data_UInt16(data, 34)
+#define HHEA_Size()                                     36
+
+/**************************************************************************************************/
+
+/*******************************************MAXP HEADER********************************************/
+
+#define MAXP_NumGlyphs(data)                            Data_UInt16(data, 4)
+#define MAXP_Size()                                     6
+
+/**************************************************************************************************/
+
+/*******************************************HMTX TABLE*********************************************/
+
+#define HMTX_LongHorMetric(data, index)                 Data_Subdata(data, (index) * 4)
+#define HMTX_Size(numberOfHMetrics)                     ((numberOfHMetrics) * 4)
+
+#define LongHorMetric_AdvanceWidth(data)                Data_UInt16(data, 0)
+#define LongHorMetric_LSB(data)                         Data_Int16(data, 2)
+
+/**************************************************************************************************/
+
+/*******************************************HVAR HEADER********************************************/
+
+#define HVAR_MajorVersion(data)                         Data_UInt16(data, 0)
+#define HVAR_MinorVersion(data)                         Data_UInt16(data, 2)
+#define HVAR_ItemVarStoreOffset(data)                   Data_UInt32(data, 4)
+#define HVAR_AdvanceWidthMappingOffset(data)            Data_UInt32(data, 8)
+#define HVAR_LSBMappingOffset(data)                     Data_UInt32(data, 12)
+#define HVAR_RSBMappingOffset(data)                     Data_UInt32(data, 16)
+#define HVAR_Size()                                     20
+#define HVAR_ItemVarStoreTable(data) \
+    Data_Subdata(data, HVAR_ItemVarStoreOffset(data))
+#define HVAR_AdvanceWidthMappingTable(data) \
+    Data_Subdata(data, HVAR_AdvanceWidthMappingOffset(data))
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Hash.h"
+
+#define C1  0x239B961BU
+#define C2  0xAB0E9789U
+#define C3  0x38B34AE5U
+#define C4  0xA1E38B93U
+
+#define RotateLeft(value, shift) \
+    (SFUInt32)(((value) << (shift)) | ((value) >> (32 - (shift))))
+
+#define MixKey(key, c1, shift, c2)  \
+    (key) *= (c1);                  \
+    (key) = RotateLeft(key, shift); \
+    (key) *= (c2)
+
+static SFUInt32 ReadUInt32(const SFUInt8 *bytes)
+{
+    return (SFUInt32)bytes[0]
+         | ((SFUInt32)bytes[1] << 8)
+         | ((SFUInt32)bytes[2] << 16)
+         | ((SFUInt32)bytes[3] << 24);
+}
+
+static SFUInt32 FinalizeMix(SFUInt32 hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+SF_INTERNAL void Hash128(const SFUInt8 *bytes, SFUInteger length, SFUInt32 seed, SFUInt32 *outHash)
+{
+    SFUInteger blockCount = length / 16;
+    SFUInteger tailLength = length % 16;
+    const SFUInt8 *tail = bytes + (blockCount * 16);
+    SFUInt32 h1 = seed;
+    SFUInt32 h2 = seed;
+    SFUInt32 h3 = seed;
+    SFUInt32 h4 = seed;
+    SFUInt32 k[4] = { 0, 0, 0, 0 };
+    SFUInteger index;
+
+    for (index = 0; index < blockCount; index++) {
+        const SFUInt8 *block = bytes + (index * 16);
+        SFUInt32 k1 = ReadUInt32(block + 0);
+        SFUInt32 k2 = ReadUInt32(block + 4);
+        SFUInt32 k3 = ReadUInt32(block + 8);
+        SFUInt32 k4 = ReadUInt32(block + 12);
+
+        MixKey(k1, C1, 15, C2);
+        h1 ^= k1;
+        h1 = RotateLeft(h1, 19);
+        h1 += h2;
+        h1 = h1 * 5 + 0x561CCD1BU;
+
+        MixKey(k2, C2, 16, C3);
+        h2 ^= k2;
+        h2 = RotateLeft(h2, 17);
+        h2 += h3;
+        h2 = h2 * 5 + 0x0BCAA747U;
+
+        MixKey(k3, C3, 17, C4);
+        h3 ^= k3;
+        h3 = RotateLeft(h3, 15);
+        h3 += h4;
+        h3 = h3 * 5 + 0x96CD1C35U;
+
+        MixKey(k4, C4, 18, C1);
+        h4 ^= k4;
+        h4 = RotateLeft(h4, 13);
+        h4 += h1;
+        h4 = h4 * 5 + 0x32AC3B17U;
+    }
+
+    /* Mixing a zero key has no effect, so the missing tail words can be processed as well. */
+    for (index = 0; index < tailLength; index++) {
+        k[index / 4] ^= (SFUInt32)tail[index] << ((index % 4) * 8);
+    }
+
+    MixKey(k[3], C4, 18, C1);
+    h4 ^= k[3];
+    MixKey(k[2], C3, 17, C4);
+    h3 ^= k[2];
+    MixKey(k[1], C2, 16, C3);
+    h2 ^= k[1];
+    MixKey(k[0], C1, 15, C2);
+    h1 ^= k[0];
+
+    h1 ^= (SFUInt32)length;
+    h2 ^= (SFUInt32)length;
+    h3 ^= (SFUInt32)length;
+    h4 ^= (SFUInt32)length;
+
+    h1 += h2 + h3 + h4;
+    h2 += h1;
+    h3 += h1;
+    h4 += h1;
+
+    h1 = FinalizeMix(h1);
+    h2 = FinalizeMix(h2);
+    h3 = FinalizeMix(h3);
+    h4 = FinalizeMix(h4);
+
+    h1 += h2 + h3 + h4;
+    h2 += h1;
+    h3 += h1;
+    h4 += h1;
+
+    outHash[0] = h1;
+    outHash[1] = h2;
+    outHash[2] = h3;
+    outHash[3] = h4;
+}
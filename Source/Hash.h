@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_HASH_H
+#define _SF_INTERNAL_HASH_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+
+/**
+ * Computes the 128-bit MurmurHash3 (x86 variant) of the given bytes. The result is independent of
+ * the endianness of the machine.
+ */
+SF_INTERNAL void Hash128(const SFUInt8 *bytes, SFUInteger length, SFUInt32 seed, SFUInt32 *outHash);
+
+#endif
@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "SFBase.h"
+#include "Common.h"
+#include "Data.h"
+#include "OpenType.h"
+#include "LayoutIndex.h"
+
+/**
+ * Returns the offset of a list relative to the table if its records can be read, or
+ * SFInvalidIndex otherwise.
+ */
+static SFUInteger CheckRecordList(SFUInteger length, SFUInteger listOffset,
+    SFUInteger headerSize, SFUInteger recordCount, SFUInteger recordSize)
+{
+    if (listOffset > length || length - listOffset < headerSize
+        || headerSize + (recordCount * recordSize) > length - listOffset) {
+        return SFInvalidIndex;
+    }
+
+    return listOffset;
+}
+
+static SFUInteger GetScriptOffset(Data table, SFUInteger length, SFUInteger scriptListOffset, SFUInt16 index)
+{
+    Data scriptList = Data_Subdata(table, scriptListOffset);
+    Data scriptRecord = ScriptList_ScriptRecord(scriptList, index);
+    SFUInteger scriptOffset = scriptListOffset + ScriptRecord_ScriptOffset(scriptRecord);
+
+    if (scriptOffset > length || length - scriptOffset < 4) {
+        return SFInvalidIndex;
+    }
+
+    return CheckRecordList(length, scriptOffset, 4,
+                           Script_LangSysCount(Data_Subdata(table, scriptOffset)), TagRecord_Size());
+}
+
+static SFUInteger GetLangSysOffset(Data table, SFUInteger length, SFUInteger scriptOffset, SFOffset langSysOffset)
+{
+    SFUInteger offset = scriptOffset + langSysOffset;
+
+    if (offset > length || length - offset < 6) {
+        return SFInvalidIndex;
+    }
+
+    return CheckRecordList(length, offset, 6, LangSys_FeatureCount(Data_Subdata(table, offset)), 2);
+}
+
+static int CompareIndexedFeatures(const void *item1, const void *item2)
+{
+    const IndexedFeature *feature1 = item1;
+    const IndexedFeature *feature2 = item2;
+
+    if (feature1->tag != feature2->tag) {
+        return (feature1->tag < feature2->tag ? -1 : 1);
+    }
+
+    return (int)feature1->order - (int)feature2->order;
+}
+
+static int CompareIndexedLangSyses(const void *item1, const void *item2)
+{
+    const IndexedLangSys *langSys1 = item1;
+    const IndexedLangSys *langSys2 = item2;
+
+    if (langSys1->tag != langSys2->tag) {
+        return (langSys1->tag < langSys2->tag ? -1 : 1);
+    }
+
+    return (int)langSys1->order - (int)langSys2->order;
+}
+
+static int CompareIndexedScripts(const void *item1, const void *item2)
+{
+    const IndexedScript *script1 = item1;
+    const IndexedScript *script2 = item2;
+
+    if (script1->tag != script2->tag) {
+        return (script1->tag < script2->tag ? -1 : 1);
+    }
+
+    return (int)script1->order - (int)script2->order;
+}
+
+/**
+ * Returns the first item having the given tag in an array of items sorted by their tags, each of
+ * which begins with its tag.
+ */
+static const void *SearchTaggedItem(const void *items, SFUInteger count, SFUInteger itemSize, SFTag tag)
+{
+    const SFUInt8 *base = items;
+    const SFUInt8 *end = base + (count * itemSize);
+
+    /* Narrow down to the first item whose tag is not less than the given one. */
+    while (count > 0) {
+        SFUInteger half = count >> 1;
+        const SFUInt8 *probe = base + (half * itemSize);
+
+        if (*(const SFTag *)probe < tag) {
+            base = probe + itemSize;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    if (base == end || *(const SFTag *)base != tag) {
+        return NULL;
+    }
+
+    return base;
+}
+
+static int CompareOffsets(const void *item1, const void *item2)
+{
+    SFUInteger offset1 = *(const SFUInteger *)item1;
+    SFUInteger offset2 = *(const SFUInteger *)item2;
+
+    if (offset1 != offset2) {
+        return (offset1 < offset2 ? -1 : 1);
+    }
+
+    return 0;
+}
+
+/**
+ * Sorts the offsets and removes the duplicate ones.
+ *
+ * @return
+ *      The number of distinct offsets.
+ */
+static SFUInteger MakeOffsetsUnique(SFUInteger *offsets, SFUInteger count)
+{
+    SFUInteger uniqueCount = 0;
+    SFUInteger index;
+
+    qsort(offsets, count, sizeof(SFUInteger), CompareOffsets);
+
+    for (index = 0; index < count; index++) {
+        if (uniqueCount == 0 || offsets[uniqueCount - 1] != offsets[index]) {
+            offsets[uniqueCount++] = offsets[index];
+        }
+    }
+
+    return uniqueCount;
+}
+
+static SFUInteger SearchOffset(const SFUInteger *offsets, SFUInteger count, SFUInteger offset)
+{
+    SFUInteger low = 0;
+    SFUInteger high = count;
+
+    while (low < high) {
+        SFUInteger mid = low + ((high - low) >> 1);
+
+        if (offsets[mid] < offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static SFUInt16 IndexFeatures(LayoutIndexRef layoutIndex, SFUInt16 featureCount,
+    Data langSysTable, IndexedFeature *features)
+{
+    SFUInt16 indexCount = LangSys_FeatureCount(langSysTable);
+    SFUInt16 validCount = 0;
+    SFUInt16 arrayIndex;
+
+    for (arrayIndex = 0; arrayIndex < indexCount; arrayIndex++) {
+        SFUInt16 recordIndex = LangSys_FeatureIndex(langSysTable, arrayIndex);
+
+        /* Leave out the features referring beyond the feature list. */
+        if (recordIndex < featureCount) {
+            Data featureRecord = FeatureList_FeatureRecord(layoutIndex->featureListTable, recordIndex);
+            IndexedFeature *feature = &features[validCount++];
+
+            feature->tag = FeatureRecord_FeatureTag(featureRecord);
+            feature->recordIndex = recordIndex;
+            feature->order = arrayIndex;
+        }
+    }
+
+    qsort(features, validCount, sizeof(IndexedFeature), CompareIndexedFeatures);
+
+    return validCount;
+}
+
+static IndexedLangSysRef AddLangSys(LayoutIndexRef layoutIndex, SFUInteger *langSysTotal,
+    const IndexedLangSys *distinctLangSyses, const SFUInteger *langSysOffsets,
+    SFUInteger distinctCount, SFUInteger langSysOffset, SFTag langSysTag, SFUInt16 order)
+{
+    IndexedLangSysRef langSys = &layoutIndex->langSysArray[(*langSysTotal)++];
+    SFUInteger distinctIndex = SearchOffset(langSysOffsets, distinctCount, langSysOffset);
+
+    *langSys = distinctLangSyses[distinctIndex];
+    langSys->tag = langSysTag;
+    langSys->order = order;
+
+    return langSys;
+}
+
+SF_INTERNAL LayoutIndexRef LayoutIndexCreate(Data table, SFUInteger length)
+{
+    LayoutIndexRef layoutIndex;
+    SFUInteger scriptListOffset;
+    SFUInteger featureListOffset;
+    Data scriptList;
+    SFUInt16 scriptCount;
+    SFUInt16 featureCount;
+    SFUInteger *scriptOffsets;
+    SFUInteger *distinctScripts;
+    SFUInteger *langSysOffsets;
+    SFUInteger distinctScriptCount = 0;
+    SFUInteger distinctLangSysCount;
+    SFUInteger langSysCapacity = 0;
+    SFUInteger langSysTotal = 0;
+    SFUInteger featureTotal = 0;
+    SFUInteger scriptTotal = 0;
+    IndexedLangSys *distinctLangSyses;
+    IndexedScript *distinctIndexes;
+    SFUInteger index;
+
+    if (!table || length < 10) {
+        return NULL;
+    }
+
+    scriptListOffset = Header_ScriptListOffset(table);
+    featureListOffset = Header_FeatureListOffset(table);
+
+    if (CheckRecordList(length, scriptListOffset, 2, 0, 0) == SFInvalidIndex
+        || CheckRecordList(length, featureListOffset, 2, 0, 0) == SFInvalidIndex) {
+        return NULL;
+    }
+
+    scriptList = Data_Subdata(table, scriptListOffset);
+    scriptCount = ScriptList_ScriptCount(scriptList);
+    featureCount = FeatureList_FeatureCount(Data_Subdata(table, featureListOffset));
+
+    if (CheckRecordList(length, scriptListOffset, 2, scriptCount, TagRecord_Size()) == SFInvalidIndex
+        || CheckRecordList(length, featureListOffset, 2, featureCount, TagRecord_Size()) == SFInvalidIndex) {
+        return NULL;
+    }
+
+    /*
+     * Records of a malformed table may refer to the same scripts and language systems again and
+     * again, so each distinct one of them is indexed only once to keep the work linear in the
+     * length of the table.
+     */
+    scriptOffsets = malloc(sizeof(SFUInteger) * (scriptCount + 1));
+    distinctScripts = malloc(sizeof(SFUInteger) * (scriptCount + 1));
+
+    for (index = 0; index < scriptCount; index++) {
+        SFUInteger scriptOffset = GetScriptOffset(table, length, scriptListOffset, (SFUInt16)index);
+
+        scriptOffsets[index] = scriptOffset;
+
+        if (scriptOffset != SFInvalidIndex) {
+            distinctScripts[scriptTotal++] = scriptOffset;
+        }
+    }
+
+    distinctScriptCount = MakeOffsetsUnique(distinctScripts, scriptTotal);
+
+    /* Collect the readable language systems of distinct scripts. */
+    for (index = 0; index < distinctScriptCount; index++) {
+        langSysCapacity += 1 + Script_LangSysCount(Data_Subdata(table, distinctScripts[index]));
+    }
+
+    langSysOffsets = malloc(sizeof(SFUInteger) * (langSysCapacity + 1));
+
+    for (index = 0; index < distinctScriptCount; index++) {
+        SFUInteger scriptOffset = distinctScripts[index];
+        Data scriptTable = Data_Subdata(table, scriptOffset);
+        SFOffset defaultOffset = Script_DefaultLangSysOffset(scriptTable);
+        SFUInt16 langSysCount = Script_LangSysCount(scriptTable);
+        SFUInteger langSysOffset;
+        SFUInt16 langSysIndex;
+
+        if (defaultOffset) {
+            langSysOffset = GetLangSysOffset(table, length, scriptOffset, defaultOffset);
+
+            if (langSysOffset != SFInvalidIndex) {
+                langSysOffsets[langSysTotal++] = langSysOffset;
+            }
+        }
+
+        for (langSysIndex = 0; langSysIndex < langSysCount; langSysIndex++) {
+            Data langSysRecord = Script_LangSysRecord(scriptTable, langSysIndex);
+            langSysOffset = GetLangSysOffset(table, length, scriptOffset, LangSysRecord_LangSysOffset(langSysRecord));
+
+            if (langSysOffset != SFInvalidIndex) {
+                langSysOffsets[langSysTotal++] = langSysOffset;
+            }
+        }
+    }
+
+    distinctLangSysCount = MakeOffsetsUnique(langSysOffsets, langSysTotal);
+
+    for (index = 0; index < distinctLangSysCount; index++) {
+        featureTotal += LangSys_FeatureCount(Data_Subdata(table, langSysOffsets[index]));
+    }
+
+    layoutIndex = malloc(sizeof(LayoutIndex));
+    layoutIndex->scripts = malloc(sizeof(IndexedScript) * (scriptTotal + 1));
+    layoutIndex->langSysArray = malloc(sizeof(IndexedLangSys) * (langSysTotal + 1));
+    layoutIndex->featureArray = malloc(sizeof(IndexedFeature) * (featureTotal + 1));
+    layoutIndex->featureListTable = Data_Subdata(table, featureListOffset);
+    layoutIndex->scriptCount = scriptTotal;
+
+    /* Index the features of each distinct language system. */
+    distinctLangSyses = malloc(sizeof(IndexedLangSys) * (distinctLangSysCount + 1));
+    featureTotal = 0;
+
+    for (index = 0; index < distinctLangSysCount; index++) {
+        IndexedLangSysRef langSys = &distinctLangSyses[index];
+
+        langSys->tag = 0;
+        langSys->table = Data_Subdata(table, langSysOffsets[index]);
+        langSys->features = &layoutIndex->featureArray[featureTotal];
+        langSys->featureCount = IndexFeatures(layoutIndex, featureCount, langSys->table, langSys->features);
+        langSys->order = 0;
+
+        featureTotal += langSys->featureCount;
+    }
+
+    /* Index the language systems of each distinct script. */
+    distinctIndexes = malloc(sizeof(IndexedScript) * (distinctScriptCount + 1));
+    langSysTotal = 0;
+
+    for (index = 0; index < distinctScriptCount; index++) {
+        IndexedScriptRef script = &distinctIndexes[index];
+        SFUInteger scriptOffset = distinctScripts[index];
+        Data scriptTable = Data_Subdata(table, scriptOffset);
+        SFOffset defaultOffset = Script_DefaultLangSysOffset(scriptTable);
+        SFUInt16 langSysCount = Script_LangSysCount(scriptTable);
+        SFUInteger langSysOffset;
+        SFUInt16 langSysIndex;
+
+        script->tag = 0;
+        script->table = scriptTable;
+        script->defaultLangSys = NULL;
+        script->order = 0;
+
+        if (defaultOffset) {
+            langSysOffset = GetLangSysOffset(table, length, scriptOffset, defaultOffset);
+
+            if (langSysOffset != SFInvalidIndex) {
+                script->defaultLangSys = AddLangSys(layoutIndex, &langSysTotal,
+                                                    distinctLangSyses, langSysOffsets, distinctLangSysCount,
+                                                    langSysOffset, TAG('d', 'f', 'l', 't'), 0);
+            }
+        }
+
+        script->langSyses = &layoutIndex->langSysArray[langSysTotal];
+        script->langSysCount = 0;
+
+        for (langSysIndex = 0; langSysIndex < langSysCount; langSysIndex++) {
+            Data langSysRecord = Script_LangSysRecord(scriptTable, langSysIndex);
+            langSysOffset = GetLangSysOffset(table, length, scriptOffset, LangSysRecord_LangSysOffset(langSysRecord));
+
+            if (langSysOffset != SFInvalidIndex) {
+                AddLangSys(layoutIndex, &langSysTotal,
+                           distinctLangSyses, langSysOffsets, distinctLangSysCount,
+                           langSysOffset, LangSysRecord_LangSysTag(langSysRecord), langSysIndex);
+                script->langSysCount += 1;
+            }
+        }
+
+        qsort(script->langSyses, script->langSysCount, sizeof(IndexedLangSys), CompareIndexedLangSyses);
+    }
+
+    /* Let each script record share the index of its script table. */
+    scriptTotal = 0;
+
+    for (index = 0; index < scriptCount; index++) {
+        SFUInteger scriptOffset = scriptOffsets[index];
+
+        if (scriptOffset != SFInvalidIndex) {
+            IndexedScriptRef script = &layoutIndex->scripts[scriptTotal++];
+            Data scriptRecord = ScriptList_ScriptRecord(scriptList, index);
+
+            *script = distinctIndexes[SearchOffset(distinctScripts, distinctScriptCount, scriptOffset)];
+            script->tag = ScriptRecord_ScriptTag(scriptRecord);
+            script->order = (SFUInt16)index;
+        }
+    }
+
+    qsort(layoutIndex->scripts, layoutIndex->scriptCount, sizeof(IndexedScript), CompareIndexedScripts);
+
+    free(scriptOffsets);
+    free(distinctScripts);
+    free(langSysOffsets);
+    free(distinctLangSyses);
+    free(distinctIndexes);
+
+    return layoutIndex;
+}
+
+SF_INTERNAL void LayoutIndexDestroy(LayoutIndexRef layoutIndex)
+{
+    free(layoutIndex->scripts);
+    free(layoutIndex->langSysArray);
+    free(layoutIndex->featureArray);
+    free(layoutIndex);
+}
+
+SF_INTERNAL IndexedScriptRef LayoutIndexSearchScript(LayoutIndexRef layoutIndex, SFTag scriptTag)
+{
+    return (IndexedScriptRef)SearchTaggedItem(layoutIndex->scripts, layoutIndex->scriptCount,
+                                              sizeof(IndexedScript), scriptTag);
+}
+
+SF_INTERNAL IndexedLangSysRef LayoutIndexSearchLangSys(IndexedScriptRef script, SFTag languageTag)
+{
+    if (languageTag == TAG('d', 'f', 'l', 't')) {
+        return script->defaultLangSys;
+    }
+
+    return (IndexedLangSysRef)SearchTaggedItem(script->langSyses, script->langSysCount,
+                                               sizeof(IndexedLangSys), languageTag);
+}
+
+SF_INTERNAL Data LayoutIndexSearchFeatureTable(LayoutIndexRef layoutIndex,
+    IndexedLangSysRef langSys, Data featureSubstTable, SFTag featureTag)
+{
+    const IndexedFeature *feature = SearchTaggedItem(langSys->features, langSys->featureCount,
+                                                     sizeof(IndexedFeature), featureTag);
+
+    if (feature) {
+        Data featureRecord = FeatureList_FeatureRecord(layoutIndex->featureListTable, feature->recordIndex);
+        SFOffset featureOffset = FeatureRecord_FeatureOffset(featureRecord);
+
+        if (featureSubstTable) {
+            Data altFeatureTable = SearchAlternateFeatureTable(featureSubstTable, feature->recordIndex);
+
+            if (altFeatureTable) {
+                return altFeatureTable;
+            }
+        }
+
+        return Data_Subdata(layoutIndex->featureListTable, featureOffset);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SF_INTERNAL_LAYOUT_INDEX_H
+#define _SF_INTERNAL_LAYOUT_INDEX_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+
+typedef struct _IndexedFeature {
+    SFTag tag;
+    SFUInt16 recordIndex;       /**< The index of the feature record in the feature list. */
+    SFUInt16 order;             /**< The position in the language system, deciding between equal tags. */
+} IndexedFeature;
+
+typedef struct _IndexedLangSys {
+    SFTag tag;
+    Data table;
+    IndexedFeature *features;   /**< The features of the language system sorted by their tags. */
+    SFUInt16 featureCount;
+    SFUInt16 order;             /**< The position in the script, deciding between equal tags. */
+} IndexedLangSys, *IndexedLangSysRef;
+
+typedef struct _IndexedScript {
+    SFTag tag;
+    Data table;
+    IndexedLangSysRef defaultLangSys; /**< The default language system, NULL if the script has none. */
+    IndexedLangSys *langSyses;  /**< The other language systems sorted by their tags. */
+    SFUInt16 langSysCount;
+    SFUInt16 order;             /**< The position in the script list, deciding between equal tags. */
+} IndexedScript, *IndexedScriptRef;
+
+/**
+ * The scripts, language systems and features of a GSUB or GPOS table sorted by their tags, so that
+ * they are found with binary searches instead of scanning the records.
+ */
+typedef struct _LayoutIndex {
+    IndexedScript *scripts;
+    IndexedLangSys *langSysArray; /**< The language systems of all scripts. */
+    IndexedFeature *featureArray; /**< The features of all language systems. */
+    Data featureListTable;
+    SFUInteger scriptCount;
+} LayoutIndex, *LayoutIndexRef;
+
+/**
+ * Indexes the script list of a GSUB or GPOS table. The offsets are checked while indexing, and the
+ * scripts, language systems and feature indexes that cannot be read are left out. The records
+ * referring to the same table share its index.
+ *
+ * @return
+ *      A new index, or NULL if the script list or the feature list cannot be read.
+ */
+SF_INTERNAL LayoutIndexRef LayoutIndexCreate(Data table, SFUInteger length);
+
+SF_INTERNAL void LayoutIndexDestroy(LayoutIndexRef layoutIndex);
+
+/**
+ * Returns the first script of the table having the given tag, or NULL if there is none.
+ */
+SF_INTERNAL IndexedScriptRef LayoutIndexSearchScript(LayoutIndexRef layoutIndex, SFTag scriptTag);
+
+/**
+ * Returns the first language system of a script having the given tag, or NULL if there is none.
+ * The 'dflt' tag refers to the default language system.
+ */
+SF_INTERNAL IndexedLangSysRef LayoutIndexSearchLangSys(IndexedScriptRef script, SFTag languageTag);
+
+/**
+ * Returns the table of the first feature of a language system having the given tag, substituted
+ * with the alternate one of the feature substitution table if any, or NULL if there is none.
+ */
+SF_INTERNAL Data LayoutIndexSearchFeatureTable(LayoutIndexRef layoutIndex,
+    IndexedLangSysRef langSys, Data featureSubstTable, SFTag featureTag);
+
+#endif
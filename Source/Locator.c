@@ -24,15 +24,18 @@
 #include "OpenType.h"
 #include "Locator.h"
 
-SF_INTERNAL void LocatorInitialize(LocatorRef locator, SFAlbumRef album, Data gdef)
+SF_INTERNAL void LocatorInitialize(LocatorRef locator, SFAlbumRef album,
+    Data gdef, GlyphDefinitionsRef glyphDefinitions)
 {
     /* Album must NOT be null. */
     SFAssert(album != NULL);
 
     locator->_album = album;
+    locator->_glyphDefinitions = glyphDefinitions;
     locator->_markAttachClassDef = NULL;
     locator->_markGlyphSetsDef = NULL;
     locator->filter.markFilteringCoverage = NULL;
+    locator->filter.markFilteringSet = NULL;
     locator->filter.ignoreMask.full = 0;
     locator->filter.lookupFlag = 0;
     locator->version = SFInvalidIndex;
@@ -42,7 +45,7 @@ SF_INTERNAL void LocatorInitialize(LocatorRef locator, SFAlbumRef album, Data gd
     locator->index = SFInvalidIndex;
 
     if (gdef) {
-        locator->_markAttachClassDef = GDEF_MarkAttachClassDefTable(gdef);
+        locator->_markAttachClassDef = GDEF_OptionalMarkAttachClassDefTable(gdef);
         locator->_markGlyphSetsDef = GDEF_MarkGlyphSetsDefTable(gdef);
     }
 }
@@ -87,11 +90,15 @@ SF_INTERNAL void LocatorSetLookupFlag(LocatorRef locator, LookupFlag lookupFlag)
 
 SF_INTERNAL void LocatorSetMarkFilteringSet(LocatorRef locator, SFUInt16 markFilteringSet)
 {
+    GlyphDefinitionsRef glyphDefinitions = locator->_glyphDefinitions;
     Data markGlyphSetsDef = locator->_markGlyphSetsDef;
 
     locator->filter.markFilteringCoverage = NULL;
+    locator->filter.markFilteringSet = NULL;
 
-    if (markGlyphSetsDef) {
+    if (glyphDefinitions) {
+        locator->filter.markFilteringSet = GlyphDefinitionsGetMarkSet(glyphDefinitions, markFilteringSet);
+    } else if (markGlyphSetsDef) {
         SFUInt16 format = MarkGlyphSets_Format(markGlyphSetsDef);
         switch (format) {
             case 1: {
@@ -142,10 +149,19 @@ static SFBoolean IsIgnoredGlyph(LocatorRef locator, SFUInteger index) {
     }
 
     if (glyphMask.section.traits & GlyphTraitMark) {
+        GlyphDefinitionsRef glyphDefinitions = locator->_glyphDefinitions;
+
         if (lookupFlag & LookupFlagUseMarkFilteringSet) {
+            const SFUInt8 *markFilteringSet = locator->filter.markFilteringSet;
             Data markFilteringCoverage = locator->filter.markFilteringCoverage;
 
-            if (markFilteringCoverage) {
+            if (markFilteringSet) {
+                SFGlyphID glyph = SFAlbumGetGlyph(album, index);
+
+                if (!GlyphDefinitionsMarkSetContains(glyphDefinitions, markFilteringSet, glyph)) {
+                    return SFTrue;
+                }
+            } else if (markFilteringCoverage) {
                 SFGlyphID glyph = SFAlbumGetGlyph(album, index);
                 SFUInteger coverageIndex = SearchCoverageIndex(markFilteringCoverage, glyph);
 
@@ -158,7 +174,16 @@ static SFBoolean IsIgnoredGlyph(LocatorRef locator, SFUInteger index) {
         if (lookupFlag & LookupFlagMarkAttachmentType) {
             Data markAttachClassDef = locator->_markAttachClassDef;
 
-            if (markAttachClassDef) {
+            if (glyphDefinitions) {
+                if (glyphDefinitions->hasMarkAttachClasses) {
+                    SFGlyphID glyph = SFAlbumGetGlyph(album, index);
+                    SFUInt16 glyphClass = GlyphDefinitionsGetMarkAttachClass(glyphDefinitions, glyph);
+
+                    if (glyphClass != (lookupFlag >> 8)) {
+                        return SFTrue;
+                    }
+                }
+            } else if (markAttachClassDef) {
                 SFGlyphID glyph = SFAlbumGetGlyph(album, index);
                 SFUInt16 glyphClass = SearchGlyphClass(markAttachClassDef, glyph);
 
@@ -22,15 +22,18 @@
 #include "SFAlbum.h"
 #include "Common.h"
 #include "Data.h"
+#include "GlyphDefinitions.h"
 
 typedef struct _LocatorFilter {
     Data markFilteringCoverage;
+    const SFUInt8 *markFilteringSet;
     GlyphMask ignoreMask;
     LookupFlag lookupFlag;
 } LocatorFilter, *LocatorFilterRef;
 
 typedef struct _Locator {
     SFAlbumRef _album;
+    GlyphDefinitionsRef _glyphDefinitions;
     Data _markAttachClassDef;
     Data _markGlyphSetsDef;
     LocatorFilter filter;
@@ -40,7 +43,12 @@ typedef struct _Locator {
     SFUInteger index;
 } Locator, *LocatorRef;
 
-SF_INTERNAL void LocatorInitialize(LocatorRef locator, SFAlbumRef album, Data gdef);
+/**
+ * Initializes the locator. If the glyph definitions are available, they are used instead of
+ * searching the mark attachment classes and mark glyph sets of GDEF table.
+ */
+SF_INTERNAL void LocatorInitialize(LocatorRef locator, SFAlbumRef album,
+    Data gdef, GlyphDefinitionsRef glyphDefinitions);
 
 SF_INTERNAL void LocatorSetFeatureMask(LocatorRef locator, SFUInt16 featureMask);
 
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "SFBase.h"
+#include "Common.h"
+#include "Data.h"
+#include "GPOS.h"
+#include "GSUB.h"
+#include "LookupDigest.h"
+
+static const SFUInteger DigestShifts[GlyphDigestMaskCount] = { 0, 4, 9 };
+
+static void SetFullDigest(GlyphDigestRef digest)
+{
+    SFUInteger index;
+
+    for (index = 0; index < GlyphDigestMaskCount; index++) {
+        digest->masks[index] = 0xFFFFFFFF;
+    }
+}
+
+static void AddGlyphRange(GlyphDigestRef digest, SFGlyphID start, SFGlyphID end)
+{
+    SFUInteger index;
+
+    for (index = 0; index < GlyphDigestMaskCount; index++) {
+        SFUInteger shift = DigestShifts[index];
+        SFUInteger first = start >> shift;
+        SFUInteger last = end >> shift;
+
+        if (last - first >= 31) {
+            digest->masks[index] = 0xFFFFFFFF;
+        } else {
+            for (; first <= last; first++) {
+                digest->masks[index] |= (SFUInt32)1 << (first & 31);
+            }
+        }
+    }
+}
+
+static void UniteDigest(GlyphDigestRef digest, const GlyphDigest *other)
+{
+    SFUInteger index;
+
+    for (index = 0; index < GlyphDigestMaskCount; index++) {
+        digest->masks[index] |= other->masks[index];
+    }
+}
+
+/**
+ * Adds the glyphs of the coverage table at the given offset, returning SFFalse if it does not fit
+ * in the table.
+ */
+static SFBoolean AddCoverage(GlyphDigestRef digest, Data table, SFUInteger length, SFUInteger offset)
+{
+    Data coverage;
+    SFUInt16 format;
+    SFUInt16 count;
+    SFUInteger index;
+
+    if (offset > length || length - offset < 4) {
+        return SFFalse;
+    }
+
+    coverage = Data_Subdata(table, offset);
+    format = Coverage_Format(coverage);
+    count = Data_UInt16(coverage, 2);
+
+    switch (format) {
+        case 1: {
+            Data glyphArray = CoverageF1_GlyphArray(coverage);
+
+            if (4 + ((SFUInteger)count * 2) > length - offset) {
+                return SFFalse;
+            }
+
+            for (index = 0; index < count; index++) {
+                SFGlyphID glyph = GlyphArray_Value(glyphArray, index);
+                AddGlyphRange(digest, glyph, glyph);
+            }
+            return SFTrue;
+        }
+
+        case 2: {
+            if (4 + ((SFUInteger)count * GlyphRange_Size()) > length - offset) {
+                return SFFalse;
+            }
+
+            for (index = 0; index < count; index++) {
+                Data rangeRecord = CoverageF2_RangeRecord(coverage, index);
+                SFGlyphID start = RangeRecord_StartGlyphID(rangeRecord);
+                SFGlyphID end = RangeRecord_EndGlyphID(rangeRecord);
+
+                if (start <= end) {
+                    AddGlyphRange(digest, start, end);
+                }
+            }
+            return SFTrue;
+        }
+    }
+
+    return SFFalse;
+}
+
+/**
+ * Returns the offset of the coverage table deciding the first glyph of a subtable, or zero if the
+ * subtable does not have a known layout.
+ */
+static SFUInteger GetFirstCoverageOffset(Data table, SFUInteger length, SFUInteger offset,
+    LookupType lookupType, SFBoolean isGPOS)
+{
+    Data subtable = Data_Subdata(table, offset);
+    SFUInteger available = length - offset;
+    LookupType contextType = (isGPOS ? LookupTypeContextPositioning : LookupTypeContext);
+    LookupType chainContextType = (isGPOS ? LookupTypeChainedContextPositioning : LookupTypeChainingContext);
+    SFUInt16 format;
+
+    if (available < 4) {
+        return 0;
+    }
+
+    format = Data_UInt16(subtable, 0);
+
+    if (lookupType == contextType && format == 3) {
+        /* The coverages of the input glyphs follow the glyph count and the lookup count. */
+        if (available < 8 || Data_UInt16(subtable, 2) == 0) {
+            return 0;
+        }
+
+        return offset + Data_UInt16(subtable, 6);
+    }
+
+    if (lookupType == chainContextType && format == 3) {
+        SFUInteger inputOffset = 4 + ((SFUInteger)Data_UInt16(subtable, 2) * 2);
+
+        /* The first coverage of the input record decides the current glyph. */
+        if (inputOffset + 4 > available || Data_UInt16(subtable, inputOffset) == 0) {
+            return 0;
+        }
+
+        return offset + Data_UInt16(subtable, inputOffset + 2);
+    }
+
+    if (isGPOS) {
+        switch (lookupType) {
+            case LookupTypeSingleAdjustment:
+            case LookupTypePairAdjustment:
+            case LookupTypeCursiveAttachment:
+            case LookupTypeMarkToBaseAttachment:
+            case LookupTypeMarkToLigatureAttachment:
+            case LookupTypeMarkToMarkAttachment:
+            case LookupTypeContextPositioning:
+            case LookupTypeChainedContextPositioning:
+                /* The remaining formats keep the coverage of the first glyph after the format. */
+                return offset + Data_UInt16(subtable, 2);
+        }
+    } else {
+        switch (lookupType) {
+            case LookupTypeSingle:
+            case LookupTypeMultiple:
+            case LookupTypeAlternate:
+            case LookupTypeLigature:
+            case LookupTypeContext:
+            case LookupTypeChainingContext:
+            case LookupTypeReverseChainingContext:
+                return offset + Data_UInt16(subtable, 2);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Computes the digest of a subtable, returning SFFalse if it cannot be summarized.
+ */
+static SFBoolean DigestSubtable(GlyphDigestRef digest, Data table, SFUInteger length,
+    SFUInteger offset, LookupType lookupType, SFBoolean isGPOS)
+{
+    LookupType extensionType = (isGPOS ? LookupTypeExtensionPositioning : LookupTypeExtension);
+    SFUInteger coverageOffset;
+
+    if (offset > length) {
+        return SFFalse;
+    }
+
+    if (lookupType == extensionType) {
+        Data extension;
+
+        if (length - offset < 8) {
+            return SFFalse;
+        }
+
+        extension = Data_Subdata(table, offset);
+        lookupType = ExtensionF1_LookupType(extension);
+
+        /* An extension cannot refer to another extension. */
+        if (Extension_Format(extension) != 1 || lookupType == extensionType
+            || ExtensionF1_ExtensionOffset(extension) > length - offset) {
+            return SFFalse;
+        }
+
+        offset += ExtensionF1_ExtensionOffset(extension);
+    }
+
+    coverageOffset = GetFirstCoverageOffset(table, length, offset, lookupType, isGPOS);
+
+    /* A null coverage offset would point back to the subtable itself. */
+    return (coverageOffset > offset && AddCoverage(digest, table, length, coverageOffset));
+}
+
+SF_INTERNAL LookupDigestListRef LookupDigestListCreate(Data table, SFUInteger length, SFBoolean isGPOS)
+{
+    LookupDigestListRef digestList;
+    SFUInteger listOffset;
+    Data lookupList;
+    SFUInt16 lookupCount;
+    SFUInteger subtableTotal = 0;
+    SFUInteger lookupIndex;
+
+    if (!table || length < 10) {
+        return NULL;
+    }
+
+    listOffset = Header_LookupListOffset(table);
+
+    if (listOffset > length || length - listOffset < 2) {
+        return NULL;
+    }
+
+    lookupList = Data_Subdata(table, listOffset);
+    lookupCount = LookupList_LookupCount(lookupList);
+
+    if (2 + ((SFUInteger)lookupCount * 2) > length - listOffset) {
+        return NULL;
+    }
+
+    /* Count the subtables of all well formed lookups to allocate them at once. */
+    for (lookupIndex = 0; lookupIndex < lookupCount; lookupIndex++) {
+        SFUInteger lookupOffset = listOffset + LookupList_LookupOffset(lookupList, lookupIndex);
+
+        if (lookupOffset <= length && length - lookupOffset >= 6) {
+            SFUInt16 subtableCount = Lookup_SubtableCount(Data_Subdata(table, lookupOffset));
+
+            if (6 + ((SFUInteger)subtableCount * 2) <= length - lookupOffset) {
+                subtableTotal += subtableCount;
+            }
+        }
+    }
+
+    digestList = malloc(sizeof(LookupDigestList));
+    digestList->items = calloc(lookupCount ? lookupCount : 1, sizeof(LookupDigest));
+    digestList->subtableArray = calloc(subtableTotal ? subtableTotal : 1, sizeof(GlyphDigest));
+    digestList->count = lookupCount;
+    subtableTotal = 0;
+
+    for (lookupIndex = 0; lookupIndex < lookupCount; lookupIndex++) {
+        LookupDigestRef lookupDigest = &digestList->items[lookupIndex];
+        SFUInteger lookupOffset = listOffset + LookupList_LookupOffset(lookupList, lookupIndex);
+        Data lookup;
+        LookupType lookupType;
+        SFUInt16 subtableCount;
+        SFUInteger subtableIndex;
+
+        /* Let a malformed lookup be tried for all glyphs, leaving its handling as it is. */
+        SetFullDigest(&lookupDigest->digest);
+
+        if (lookupOffset > length || length - lookupOffset < 6) {
+            continue;
+        }
+
+        lookup = Data_Subdata(table, lookupOffset);
+        lookupType = Lookup_LookupType(lookup);
+        subtableCount = Lookup_SubtableCount(lookup);
+
+        if (6 + ((SFUInteger)subtableCount * 2) > length - lookupOffset) {
+            continue;
+        }
+
+        lookupDigest->subtables = &digestList->subtableArray[subtableTotal];
+        lookupDigest->subtableCount = subtableCount;
+        subtableTotal += subtableCount;
+
+        GlyphDigestClear(&lookupDigest->digest);
+
+        for (subtableIndex = 0; subtableIndex < subtableCount; subtableIndex++) {
+            GlyphDigestRef subtableDigest = &lookupDigest->subtables[subtableIndex];
+            SFUInteger subtableOffset = lookupOffset + Lookup_SubtableOffset(lookup, subtableIndex);
+
+            if (!DigestSubtable(subtableDigest, table, length, subtableOffset, lookupType, isGPOS)) {
+                SetFullDigest(subtableDigest);
+            }
+
+            UniteDigest(&lookupDigest->digest, subtableDigest);
+        }
+    }
+
+    return digestList;
+}
+
+SF_INTERNAL void LookupDigestListDestroy(LookupDigestListRef digestList)
+{
+    free(digestList->items);
+    free(digestList->subtableArray);
+    free(digestList);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_LOOKUP_DIGEST_H
+#define _SF_INTERNAL_LOOKUP_DIGEST_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "GlyphDigest.h"
+
+/**
+ * The digests of the glyphs a lookup can start applying at.
+ */
+typedef struct _LookupDigest {
+    GlyphDigest digest;         /**< The union of the digests of all subtables. */
+    GlyphDigest *subtables;     /**< The digests of the subtables, or NULL if the lookup is malformed. */
+    SFUInteger subtableCount;   /**< The number of subtable digests. */
+} LookupDigest, *LookupDigestRef;
+
+typedef struct _LookupDigestList {
+    LookupDigest *items;
+    GlyphDigest *subtableArray; /**< The digests of the subtables of all lookups. */
+    SFUInteger count;
+} LookupDigestList, *LookupDigestListRef;
+
+/**
+ * Builds the digests of all lookups of a GSUB or GPOS table from the coverage of the first glyph
+ * of each subtable. The offsets are checked while building, and a subtable that cannot be
+ * summarized gets a digest containing all glyphs.
+ *
+ * @return
+ *      A new list of digests, or NULL if the lookup list cannot be read.
+ */
+SF_INTERNAL LookupDigestListRef LookupDigestListCreate(Data table, SFUInteger length, SFBoolean isGPOS);
+
+SF_INTERNAL void LookupDigestListDestroy(LookupDigestListRef digestList);
+
+#endif
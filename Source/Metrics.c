@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "HMTX.h"
+#include "OpenType.h"
+#include "Variations.h"
+#include "Metrics.h"
+
+SF_INTERNAL SFAdvance *CreateAdvanceArray(Data hhea, SFUInteger hheaLength,
+    Data hmtx, SFUInteger hmtxLength, Data maxp, SFUInteger maxpLength, SFUInteger *outCount)
+{
+    SFUInt16 metricCount;
+    SFUInteger glyphCount;
+    SFAdvance *advanceArray;
+    SFAdvance lastAdvance = 0;
+    SFUInteger index;
+
+    if (!hhea || hheaLength < HHEA_Size() || !hmtx) {
+        return NULL;
+    }
+
+    metricCount = HHEA_NumberOfHMetrics(hhea);
+
+    if (metricCount == 0 || HMTX_Size(metricCount) > hmtxLength) {
+        return NULL;
+    }
+
+    /* Without maxp table, only the glyphs having a full metric are known. */
+    glyphCount = metricCount;
+
+    if (maxp && maxpLength >= MAXP_Size()) {
+        glyphCount = MAXP_NumGlyphs(maxp);
+    }
+
+    advanceArray = malloc(sizeof(SFAdvance) * (glyphCount ? glyphCount : 1));
+
+    for (index = 0; index < glyphCount; index++) {
+        /* The glyphs beyond the last metric take its advance. */
+        if (index < metricCount) {
+            lastAdvance = LongHorMetric_AdvanceWidth(HMTX_LongHorMetric(hmtx, index));
+        }
+
+        advanceArray[index] = lastAdvance;
+    }
+
+    *outCount = glyphCount;
+
+    return advanceArray;
+}
+
+static void GetDeltaSetIndex(Data indexMap, SFUInteger glyphIndex, SFUInt16 *outerIndex, SFUInt16 *innerIndex)
+{
+    SFUInt8 entryFormat;
+    SFUInteger entrySize;
+    SFUInt32 mapCount;
+    Data mapData;
+    Data entryData;
+    SFUInt32 entry = 0;
+    SFUInteger innerBitCount;
+    SFUInteger index;
+
+    /* Without a mapping, the glyph index is used as the inner index of the first subtable. */
+    if (!indexMap) {
+        *outerIndex = 0;
+        *innerIndex = (SFUInt16)glyphIndex;
+        return;
+    }
+
+    entryFormat = DeltaSetIndexMap_EntryFormat(indexMap);
+    entrySize = EntryFormat_MapEntrySize(entryFormat);
+    innerBitCount = EntryFormat_InnerIndexBitCount(entryFormat);
+
+    if (DeltaSetIndexMap_Format(indexMap) == 0) {
+        mapCount = DeltaSetIndexMapF0_MapCount(indexMap);
+        mapData = DeltaSetIndexMapF0_MapData(indexMap);
+    } else {
+        mapCount = DeltaSetIndexMapF1_MapCount(indexMap);
+        mapData = DeltaSetIndexMapF1_MapData(indexMap);
+    }
+
+    /* The glyphs beyond the map use its last entry. */
+    if (glyphIndex >= mapCount) {
+        glyphIndex = mapCount - 1;
+    }
+
+    entryData = Data_Subdata(mapData, glyphIndex * entrySize);
+
+    for (index = 0; index < entrySize; index++) {
+        entry = (entry << 8) | Data_UInt8(entryData, index);
+    }
+
+    *outerIndex = (SFUInt16)(entry >> innerBitCount);
+    *innerIndex = (SFUInt16)(entry & ((1 << innerBitCount) - 1));
+}
+
+static VarDelta CalculateDelta(Data varStore, SFUInt16 outerIndex, SFUInt16 innerIndex,
+    const VarScalar *regionScalars, SFUInt16 regionCount)
+{
+    Data varData;
+    SFUInt16 itemCount;
+    SFUInt16 shortDeltaCount;
+    SFUInt16 regionIndexCount;
+    Data deltaSet;
+    VarDelta delta = 0;
+    SFUInt16 valueIndex;
+
+    if (outerIndex >= ItemVarStore_ItemVarDataCount(varStore)) {
+        return 0;
+    }
+
+    varData = ItemVarStore_ItemVarDataTable(varStore, outerIndex);
+    itemCount = ItemVarData_ItemCount(varData);
+    shortDeltaCount = ItemVarData_ShortDeltaCount(varData);
+    regionIndexCount = ItemVarData_RegionIndexCount(varData);
+
+    if (innerIndex >= itemCount) {
+        return 0;
+    }
+
+    deltaSet = DeltaSetRowsArray_DeltaSetRecord(ItemVarData_DeltaSetRowsArray(varData, regionIndexCount),
+                   innerIndex, DeltaSetRecord_Size(shortDeltaCount, regionIndexCount));
+
+    for (valueIndex = 0; valueIndex < regionIndexCount; valueIndex++) {
+        SFUInt16 regionIndex = ItemVarData_RegionIndexItem(varData, valueIndex);
+        SFInt16 value;
+
+        if (regionIndex >= regionCount) {
+            continue;
+        }
+
+        if (valueIndex < shortDeltaCount) {
+            value = DeltaSetRecord_I16Delta(deltaSet, valueIndex);
+        } else {
+            value = DeltaSetRecord_I8Delta(deltaSet, shortDeltaCount, valueIndex - shortDeltaCount);
+        }
+
+        /* A fixed point delta wraps around, so convert the value before multiplying. */
+        delta += regionScalars[regionIndex] * (VarDelta)value;
+    }
+
+    return delta;
+}
+
+SF_INTERNAL SFAdvance *CreateVariedAdvanceArray(const SFAdvance *advanceArray, SFUInteger advanceCount,
+    Data hvar, const SFInt16 *coordArray, SFUInteger coordCount)
+{
+    SFAdvance *variedArray = malloc(sizeof(SFAdvance) * (advanceCount ? advanceCount : 1));
+    Data varStore = HVAR_ItemVarStoreTable(hvar);
+    Data indexMap = NULL;
+    SFUInt16 regionCount;
+    VarScalar *regionScalars;
+    SFUInteger index;
+
+    memcpy(variedArray, advanceArray, sizeof(SFAdvance) * advanceCount);
+
+    /* The scalars depend on the instance only, so compute them once for all glyphs. */
+    regionScalars = CreateRegionScalars(varStore, coordArray, coordCount);
+
+    /* Unknown formats of the store are ignored. */
+    if (!regionScalars) {
+        return variedArray;
+    }
+
+    if (HVAR_AdvanceWidthMappingOffset(hvar)) {
+        indexMap = HVAR_AdvanceWidthMappingTable(hvar);
+    }
+
+    regionCount = VarRegionList_RegionCount(ItemVarStore_VarRegionListTable(varStore));
+
+    for (index = 0; index < advanceCount; index++) {
+        SFUInt16 outerIndex;
+        SFUInt16 innerIndex;
+        VarDelta delta;
+
+        GetDeltaSetIndex(indexMap, index, &outerIndex, &innerIndex);
+        delta = CalculateDelta(varStore, outerIndex, innerIndex, regionScalars, regionCount);
+
+        variedArray[index] += RoundVarDelta(delta);
+    }
+
+    free(regionScalars);
+
+    return variedArray;
+}
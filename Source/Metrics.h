@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_METRICS_H
+#define _SF_INTERNAL_METRICS_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+
+/**
+ * Decodes the horizontal advances of all glyphs from hmtx table, using hhea table for the number of
+ * metrics and maxp table for the number of glyphs.
+ *
+ * @param outCount
+ *      The pointer that takes the number of glyphs in the returned array.
+ * @return
+ *      A newly allocated array of advances, or NULL if the tables are missing or malformed.
+ */
+SF_INTERNAL SFAdvance *CreateAdvanceArray(Data hhea, SFUInteger hheaLength,
+    Data hmtx, SFUInteger hmtxLength, Data maxp, SFUInteger maxpLength, SFUInteger *outCount);
+
+/**
+ * Creates a copy of an advance array after applying the deltas of a sanitized HVAR table for the
+ * given variation instance.
+ */
+SF_INTERNAL SFAdvance *CreateVariedAdvanceArray(const SFAdvance *advanceArray, SFUInteger advanceCount,
+    Data hvar, const SFInt16 *coordArray, SFUInteger coordCount);
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SFConfig.h>
+
+#include "Mutex.h"
+
+SF_INTERNAL void MutexInitialize(MutexRef mutex)
+{
+#if defined(MUTEX_WIN32)
+    InitializeSRWLock(mutex);
+#elif defined(MUTEX_POSIX)
+    pthread_mutex_init(mutex, NULL);
+#else
+    *mutex = 0;
+#endif
+}
+
+SF_INTERNAL void MutexFinalize(MutexRef mutex)
+{
+#if defined(MUTEX_POSIX)
+    pthread_mutex_destroy(mutex);
+#else
+    /* Nothing to do, slim locks do not need to be destroyed. */
+    (void)mutex;
+#endif
+}
+
+SF_INTERNAL void MutexLock(MutexRef mutex)
+{
+#if defined(MUTEX_WIN32)
+    AcquireSRWLockExclusive(mutex);
+#elif defined(MUTEX_POSIX)
+    pthread_mutex_lock(mutex);
+#else
+    (void)mutex;
+#endif
+}
+
+SF_INTERNAL void MutexUnlock(MutexRef mutex)
+{
+#if defined(MUTEX_WIN32)
+    ReleaseSRWLockExclusive(mutex);
+#elif defined(MUTEX_POSIX)
+    pthread_mutex_unlock(mutex);
+#else
+    (void)mutex;
+#endif
+}
+
+#if defined(MUTEX_POSIX) && !defined(__GNUC__)
+/* The compiler offers no atomics, so fall back to a lock providing the same ordering. */
+static Mutex FlagMutex = MUTEX_INITIALIZER;
+#endif
+
+SF_INTERNAL SFBoolean FlagLoadAcquire(const SFBoolean *flag)
+{
+#if defined(MUTEX_WIN32)
+    SFBoolean value = *(volatile const SFBoolean *)flag;
+    MemoryBarrier();
+    return value;
+#elif defined(__GNUC__)
+    return __atomic_load_n(flag, __ATOMIC_ACQUIRE);
+#elif defined(MUTEX_POSIX)
+    SFBoolean value;
+
+    MutexLock(&FlagMutex);
+    value = *flag;
+    MutexUnlock(&FlagMutex);
+
+    return value;
+#else
+    return *flag;
+#endif
+}
+
+SF_INTERNAL void FlagStoreRelease(SFBoolean *flag, SFBoolean value)
+{
+#if defined(MUTEX_WIN32)
+    MemoryBarrier();
+    *(volatile SFBoolean *)flag = value;
+#elif defined(__GNUC__)
+    __atomic_store_n(flag, value, __ATOMIC_RELEASE);
+#elif defined(MUTEX_POSIX)
+    MutexLock(&FlagMutex);
+    *flag = value;
+    MutexUnlock(&FlagMutex);
+#else
+    *flag = value;
+#endif
+}
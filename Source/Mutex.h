@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_MUTEX_H
+#define _SF_INTERNAL_MUTEX_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#define MUTEX_WIN32
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define MUTEX_POSIX
+#endif
+
+#if defined(MUTEX_WIN32)
+typedef SRWLOCK Mutex;
+#define MUTEX_INITIALIZER   SRWLOCK_INIT
+#elif defined(MUTEX_POSIX)
+typedef pthread_mutex_t Mutex;
+#define MUTEX_INITIALIZER   PTHREAD_MUTEX_INITIALIZER
+#else
+/* No threading support is available, so the mutex does nothing. */
+typedef int Mutex;
+#define MUTEX_INITIALIZER   0
+#endif
+
+typedef Mutex *MutexRef;
+
+SF_INTERNAL void MutexInitialize(MutexRef mutex);
+SF_INTERNAL void MutexFinalize(MutexRef mutex);
+
+SF_INTERNAL void MutexLock(MutexRef mutex);
+SF_INTERNAL void MutexUnlock(MutexRef mutex);
+
+/**
+ * Reads a flag set by another thread with FlagStoreRelease, so that the writes made before setting
+ * it are visible once the flag is seen. This allows checking whether something lazily built under
+ * a mutex is ready without taking the mutex.
+ */
+SF_INTERNAL SFBoolean FlagLoadAcquire(const SFBoolean *flag);
+
+/**
+ * Sets a flag after all the preceding writes, so that a thread seeing it with FlagLoadAcquire sees
+ * those writes as well.
+ */
+SF_INTERNAL void FlagStoreRelease(SFBoolean *flag, SFBoolean value);
+
+#endif
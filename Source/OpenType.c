@@ -24,127 +24,57 @@
 #include "Variations.h"
 #include "OpenType.h"
 
-SF_INTERNAL Data SearchScriptTable(Data scriptListTable, SFTag scriptTag)
+static SFUInteger BinarySearchUInt16(Data uint16Array, SFUInteger length, SFUInt16 value)
 {
-    Data scriptTable = NULL;
-    SFUInt16 scriptCount;
-    SFUInt16 index;
-
-    scriptCount = ScriptList_ScriptCount(scriptListTable);
-
-    for (index = 0; index < scriptCount; index++) {
-        Data scriptRecord = ScriptList_ScriptRecord(scriptListTable, index);
-        SFTag scriptRecTag = ScriptRecord_ScriptTag(scriptRecord);
-        SFOffset scriptOffset;
+    Data base = uint16Array;
+    SFUInteger count = length;
 
-        if (scriptRecTag == scriptTag) {
-            scriptOffset = ScriptRecord_ScriptOffset(scriptRecord);
-            scriptTable = Data_Subdata(scriptListTable, scriptOffset);
-            break;
-        }
+    if (count == 0) {
+        return SFInvalidIndex;
     }
 
-    return scriptTable;
-}
-
-SF_INTERNAL Data SearchLangSysTable(Data scriptTable, SFTag languageTag)
-{
-    Data langSysTable = NULL;
-
-    if (languageTag == SFTagMake('d', 'f', 'l', 't')) {
-        SFOffset langSysOffset = Script_DefaultLangSysOffset(scriptTable);
+    /*
+     * Narrow down to the last element not greater than the value. The probe only decides which
+     * half to keep, so the loop does not branch on the comparison result.
+     */
+    while (count > 1) {
+        SFUInteger half = count >> 1;
+        Data probe = base + (half * sizeof(SFUInt16));
 
-        if (langSysOffset) {
-            langSysTable = Data_Subdata(scriptTable, langSysOffset);
-        }
-    } else {
-        SFUInt16 langSysCount = Script_LangSysCount(scriptTable);
-        SFUInt16 index;
-
-        for (index = 0; index < langSysCount; index++) {
-            Data langSysRecord = Script_LangSysRecord(scriptTable, index);
-            SFTag langSysTag = LangSysRecord_LangSysTag(langSysRecord);
-            SFOffset langSysOffset;
-
-            if (langSysTag == languageTag) {
-                langSysOffset = LangSysRecord_LangSysOffset(langSysRecord);
-                langSysTable = Data_Subdata(scriptTable, langSysOffset);
-                break;
-            }
-        }
+        base = (UInt16Array_Value(probe, 0) <= value ? probe : base);
+        count -= half;
     }
 
-    return langSysTable;
-}
-
-SF_INTERNAL Data SearchDefaultFeatureTable(Data langSysTable,
-    Data featureListTable, SFTag featureTag, SFUInt16 *featureIndex)
-{
-    SFUInt16 featureCount = LangSys_FeatureCount(langSysTable);
-    SFUInt16 arrayIndex;
-
-    for (arrayIndex = 0; arrayIndex < featureCount; arrayIndex++) {
-        SFUInt16 recordIndex = LangSys_FeatureIndex(langSysTable, arrayIndex);
-        Data featureRecord = FeatureList_FeatureRecord(featureListTable, recordIndex);
-        SFTag recordTag = FeatureRecord_FeatureTag(featureRecord);
-
-        if (recordTag == featureTag) {
-            SFOffset featureOffset = FeatureRecord_FeatureOffset(featureRecord);
-            Data featureTable = Data_Subdata(featureListTable, featureOffset);
-
-            if (featureIndex) {
-                *featureIndex = recordIndex;
-            }
-
-            return featureTable;
-        }
+    if (UInt16Array_Value(base, 0) != value) {
+        return SFInvalidIndex;
     }
 
-    return NULL;
+    return (SFUInteger)(base - uint16Array) / sizeof(SFUInt16);
 }
 
-static int UInt16ItemsComparison(const void *item1, const void *item2)
+static Data BinarySearchGlyphRange(Data rangeArray, SFUInteger length, SFUInt16 value)
 {
-    SFUInt16 *ref1 = (SFUInt16 *)item1;
-    SFUInt16 val1 = *ref1;
-    Data ref2 = (Data)item2;
-    SFUInt16 val2 = Data_UInt16(ref2, 0);
-
-    return (int)val1 - (int)val2;
-}
+    Data base = rangeArray;
+    SFUInteger count = length;
 
-static SFUInteger BinarySearchUInt16(Data uint16Array, SFUInteger length, SFUInt16 value)
-{
-    void *item = bsearch(&value, uint16Array, length, sizeof(SFUInt16), UInt16ItemsComparison);
-    if (!item) {
-        return SFInvalidIndex;
+    if (count == 0) {
+        return NULL;
     }
 
-    return (SFUInteger)((Data)item - uint16Array) / sizeof(SFUInt16);
-}
+    /* Narrow down to the last range not starting after the value. */
+    while (count > 1) {
+        SFUInteger half = count >> 1;
+        Data probe = base + (half * GlyphRange_Size());
 
-static int GlyphRangeComparison(const void *item1, const void *item2)
-{
-    SFUInt16 *ref1 = (SFUInt16 *)item1;
-    SFUInt16 val1 = *ref1;
-    Data ref2 = (Data)item2;
-    SFUInt16 rangeStart = GlyphRange_Start(ref2);
-    SFUInt16 rangeEnd = GlyphRange_End(ref2);
-
-    if (val1 < rangeStart) {
-        return -1;
+        base = (GlyphRange_Start(probe) <= value ? probe : base);
+        count -= half;
     }
 
-    if (val1 > rangeEnd) {
-        return 1;
+    if (value < GlyphRange_Start(base) || value > GlyphRange_End(base)) {
+        return NULL;
     }
 
-    return 0;
-}
-
-static Data BinarySearchGlyphRange(Data rangeArray, SFUInteger length, SFUInt16 value)
-{
-    return bsearch(&value, rangeArray, length, GlyphRange_Size(), GlyphRangeComparison);
+    return base;
 }
 
 SF_INTERNAL SFUInteger SearchCoverageIndex(Data coverageTable, SFGlyphID glyphID)
@@ -268,6 +198,9 @@ SF_INTERNAL SFInt32 GetDevicePixels(Data deviceTable, SFUInt16 ppemSize)
     return 0;
 }
 
+/* The unity build only contains the variant of variation arithmetic that it is configured for. */
+#if !defined(SF_CONFIG_UNITY) || !defined(SF_CONFIG_FIXED_VARIATIONS)
+
 SF_INTERNAL double CalculateScalarForRegion(Data regionListTable, SFUInt16 regionIndex,
     const SFInt16 *coordArray, SFUInteger coordCount)
 {
@@ -313,12 +246,41 @@ SF_INTERNAL double CalculateScalarForRegion(Data regionListTable, SFUInt16 regio
     return regionScalar;
 }
 
-static double CalculateVariationAdjustment(Data varDataTable, Data regionListTable,
-    SFUInt16 rowIndex, const SFInt16 *coordArray, SFUInteger coordCount)
+SF_INTERNAL double *CreateFloatRegionScalars(Data varStoreTable,
+    const SFInt16 *coordArray, SFUInteger coordCount)
+{
+    Data regionList;
+    SFUInt16 regionCount;
+    double *regionScalars;
+    SFUInt16 regionIndex;
+
+    if (ItemVarStore_Format(varStoreTable) != 1) {
+        return NULL;
+    }
+
+    regionList = ItemVarStore_VarRegionListTable(varStoreTable);
+    regionCount = VarRegionList_RegionCount(regionList);
+    regionScalars = malloc(sizeof(double) * (regionCount ? regionCount : 1));
+
+    for (regionIndex = 0; regionIndex < regionCount; regionIndex++) {
+        regionScalars[regionIndex] = CalculateScalarForRegion(regionList, regionIndex, coordArray, coordCount);
+    }
+
+    return regionScalars;
+}
+
+SF_INTERNAL SFInt32 RoundFloatDelta(double delta)
+{
+    return (delta >= 0.0 ? (SFInt32)(delta + 0.5) : (SFInt32)(delta - 0.5));
+}
+
+static double CalculateFloatAdjustment(Data varDataTable, Data regionListTable,
+    SFUInt16 rowIndex, const double *regionScalars, const SFInt16 *coordArray, SFUInteger coordCount)
 {
     SFUInt16 itemCount = ItemVarData_ItemCount(varDataTable);
     SFUInt16 shortDeltaCount = ItemVarData_ShortDeltaCount(varDataTable);
     SFUInt16 regionCount = ItemVarData_RegionIndexCount(varDataTable);
+    SFUInt16 scalarCount = (regionScalars ? VarRegionList_RegionCount(regionListTable) : 0);
     double adjustment = 0.0;
 
     if (rowIndex < itemCount) {
@@ -330,6 +292,7 @@ static double CalculateVariationAdjustment(Data varDataTable, Data regionListTab
         for (valueIndex = 0; valueIndex < regionCount; valueIndex++) {
             SFUInt16 regionIndex = ItemVarData_RegionIndexItem(varDataTable, valueIndex);
             SFInt16 delta;
+            double regionScalar;
 
             if (valueIndex < shortDeltaCount) {
                 delta = DeltaSetRecord_I16Delta(deltaSet, valueIndex);
@@ -337,56 +300,219 @@ static double CalculateVariationAdjustment(Data varDataTable, Data regionListTab
                 delta = DeltaSetRecord_I8Delta(deltaSet, shortDeltaCount, valueIndex - shortDeltaCount);
             }
 
-            adjustment += CalculateScalarForRegion(regionListTable, regionIndex, coordArray, coordCount) * delta;
+            if (regionIndex < scalarCount) {
+                regionScalar = regionScalars[regionIndex];
+            } else {
+                regionScalar = CalculateScalarForRegion(regionListTable, regionIndex, coordArray, coordCount);
+            }
+
+            adjustment += regionScalar * delta;
         }
     }
 
     return adjustment;
 }
 
-static double GetDeltaFromVariationStore(Data varStoreTable,
-    SFUInt16 dataIndex, SFUInt16 rowIndex, const SFInt16 *coordArray, SFUInteger coordCount)
+SF_INTERNAL SFInt32 GetFloatVariationPixels(Data varIndexTable, Data varStoreTable,
+    const double *regionScalars, const SFInt16 *coordArray, SFUInteger coordCount)
 {
-    SFUInt16 format = ItemVarStore_Format(varStoreTable);
+    SFUInt16 outerIndex = VarIndex_DeltaSetOuterIndex(varIndexTable);
+    SFUInt16 innerIndex = VarIndex_DeltaSetInnerIndex(varIndexTable);
+    SFUInt16 deltaFormat = VarIndex_DeltaFormat(varIndexTable);
 
-    switch (format) {
-        case 1: {
-            Data regionList = ItemVarStore_VarRegionListTable(varStoreTable);
-            SFUInt16 dataCount = ItemVarStore_ItemVarDataCount(varStoreTable);
+    /* Unknown formats of the store are ignored. */
+    if (deltaFormat == 0x8000 && ItemVarStore_Format(varStoreTable) == 1) {
+        Data regionList = ItemVarStore_VarRegionListTable(varStoreTable);
+        SFUInt16 dataCount = ItemVarStore_ItemVarDataCount(varStoreTable);
 
-            if (dataIndex < dataCount) {
-                Data varDataTable = ItemVarStore_ItemVarDataTable(varStoreTable, dataIndex);
-                return CalculateVariationAdjustment(varDataTable, regionList, rowIndex, coordArray, coordCount);
-            }
-            break;
+        if (outerIndex < dataCount) {
+            Data varDataTable = ItemVarStore_ItemVarDataTable(varStoreTable, outerIndex);
+            double delta = CalculateFloatAdjustment(varDataTable, regionList, innerIndex,
+                                                    regionScalars, coordArray, coordCount);
+            return RoundFloatDelta(delta);
         }
     }
 
     return 0;
 }
 
-SF_INTERNAL SFInt32 GetVariationPixels(Data varIndexTable, Data varStoreTable,
+#endif
+
+#if !defined(SF_CONFIG_UNITY) || defined(SF_CONFIG_FIXED_VARIATIONS)
+
+SF_INTERNAL SFUInt32 CalculateFixedScalarForRegion(Data regionListTable, SFUInt16 regionIndex,
+    const SFInt16 *coordArray, SFUInteger coordCount)
+{
+    SFUInt16 axisCount = VarRegionList_AxisCount(regionListTable);
+    SFUInt16 regionCount = VarRegionList_RegionCount(regionListTable);
+    SFUInt32 regionScalar = FixedScalarOne;
+
+    if (regionIndex < regionCount) {
+        Data regionRecord = VarRegionList_VarRegionRecord(regionListTable, regionIndex, axisCount);
+        SFUInt16 axisIndex;
+
+        /* Same as CalculateScalarForRegion, except that the divisions are rounded to 16.16. */
+        for (axisIndex = 0; axisIndex < axisCount; axisIndex++) {
+            Data axisCoords = VarRegionRecord_RegionAxisCoords(regionRecord, axisIndex);
+            SFInt16 startCoord = RegionAxisCoords_StartCoord(axisCoords);
+            SFInt16 peakCoord = RegionAxisCoords_PeakCoord(axisCoords);
+            SFInt16 endCoord = RegionAxisCoords_EndCoord(axisCoords);
+            SFInt16 instanceCoord = (axisIndex < coordCount ? coordArray[axisIndex] : 0);
+            SFUInt32 axisScalar;
+
+            if (startCoord > peakCoord || peakCoord > endCoord) {
+                axisScalar = FixedScalarOne;
+            } else if (startCoord < 0 && endCoord > 0 && peakCoord != 0) {
+                axisScalar = FixedScalarOne;
+            } else if (peakCoord == 0) {
+                axisScalar = FixedScalarOne;
+            } else if (instanceCoord < startCoord || instanceCoord > endCoord) {
+                axisScalar = 0;
+            } else {
+                SFUInt32 numerator;
+                SFUInt32 denominator;
+
+                if (instanceCoord == peakCoord) {
+                    numerator = 1;
+                    denominator = 1;
+                } else if (instanceCoord < peakCoord) {
+                    numerator = (SFUInt32)(instanceCoord - startCoord);
+                    denominator = (SFUInt32)(peakCoord - startCoord);
+                } else {
+                    numerator = (SFUInt32)(endCoord - instanceCoord);
+                    denominator = (SFUInt32)(endCoord - peakCoord);
+                }
+
+                /* Both terms are below 0x10000 and the numerator never exceeds the denominator. */
+                axisScalar = ((numerator << 16) + (denominator >> 1)) / denominator;
+            }
+
+            if (regionScalar == FixedScalarOne) {
+                regionScalar = axisScalar;
+            } else {
+                regionScalar = (regionScalar * axisScalar + 0x8000) >> 16;
+            }
+        }
+    }
+
+    return regionScalar;
+}
+
+SF_INTERNAL SFUInt32 *CreateFixedRegionScalars(Data varStoreTable,
     const SFInt16 *coordArray, SFUInteger coordCount)
+{
+    Data regionList;
+    SFUInt16 regionCount;
+    SFUInt32 *regionScalars;
+    SFUInt16 regionIndex;
+
+    if (ItemVarStore_Format(varStoreTable) != 1) {
+        return NULL;
+    }
+
+    regionList = ItemVarStore_VarRegionListTable(varStoreTable);
+    regionCount = VarRegionList_RegionCount(regionList);
+    regionScalars = malloc(sizeof(SFUInt32) * (regionCount ? regionCount : 1));
+
+    for (regionIndex = 0; regionIndex < regionCount; regionIndex++) {
+        regionScalars[regionIndex] = CalculateFixedScalarForRegion(regionList, regionIndex, coordArray, coordCount);
+    }
+
+    return regionScalars;
+}
+
+SF_INTERNAL SFInt32 RoundFixedDelta(SFUInt32 delta)
+{
+    /* Round the magnitude so that the result does not depend on the shifting of negative numbers. */
+    if (delta & 0x80000000) {
+        return -(SFInt32)(((0 - delta) + 0x8000) >> 16);
+    }
+
+    return (SFInt32)((delta + 0x8000) >> 16);
+}
+
+static SFUInt32 CalculateFixedAdjustment(Data varDataTable,
+    SFUInt16 rowIndex, const SFUInt32 *regionScalars, SFUInt16 scalarCount)
+{
+    SFUInt16 itemCount = ItemVarData_ItemCount(varDataTable);
+    SFUInt16 shortDeltaCount = ItemVarData_ShortDeltaCount(varDataTable);
+    SFUInt16 regionCount = ItemVarData_RegionIndexCount(varDataTable);
+    SFUInt32 adjustment = 0;
+
+    if (rowIndex < itemCount) {
+        SFUInteger recordSize = DeltaSetRecord_Size(shortDeltaCount, regionCount);
+        Data rowsArray = ItemVarData_DeltaSetRowsArray(varDataTable, regionCount);
+        Data deltaSet = DeltaSetRowsArray_DeltaSetRecord(rowsArray, rowIndex, recordSize);
+        SFUInt16 shortCount = (shortDeltaCount < regionCount ? shortDeltaCount : regionCount);
+        SFUInt16 valueIndex;
+
+        /*
+         * The products are summed modulo 2^32, which yields the exact result as long as the final
+         * sum fits in 16.16. Each kind of deltas has its own loop so that the bodies are uniform.
+         */
+        for (valueIndex = 0; valueIndex < shortCount; valueIndex++) {
+            SFUInt16 regionIndex = ItemVarData_RegionIndexItem(varDataTable, valueIndex);
+            SFUInt32 regionScalar = (regionIndex < scalarCount ? regionScalars[regionIndex] : FixedScalarOne);
+            SFInt32 delta = DeltaSetRecord_I16Delta(deltaSet, valueIndex);
+
+            adjustment += (SFUInt32)delta * regionScalar;
+        }
+
+        for (; valueIndex < regionCount; valueIndex++) {
+            SFUInt16 regionIndex = ItemVarData_RegionIndexItem(varDataTable, valueIndex);
+            SFUInt32 regionScalar = (regionIndex < scalarCount ? regionScalars[regionIndex] : FixedScalarOne);
+            SFInt32 delta = DeltaSetRecord_I8Delta(deltaSet, shortCount, valueIndex - shortCount);
+
+            adjustment += (SFUInt32)delta * regionScalar;
+        }
+    }
+
+    return adjustment;
+}
+
+SF_INTERNAL SFInt32 GetFixedVariationPixels(Data varIndexTable, Data varStoreTable,
+    const SFUInt32 *regionScalars, const SFInt16 *coordArray, SFUInteger coordCount)
 {
     SFUInt16 outerIndex = VarIndex_DeltaSetOuterIndex(varIndexTable);
     SFUInt16 innerIndex = VarIndex_DeltaSetInnerIndex(varIndexTable);
     SFUInt16 deltaFormat = VarIndex_DeltaFormat(varIndexTable);
 
-    if (deltaFormat == 0x8000) {
-        double delta = GetDeltaFromVariationStore(varStoreTable, outerIndex, innerIndex, coordArray, coordCount);
-        return (delta >= 0.0 ? (SFInt32)(delta + 0.5) : (SFInt32)(delta - 0.5));
+    /* Unknown formats of the store are ignored. */
+    if (deltaFormat == 0x8000 && ItemVarStore_Format(varStoreTable) == 1) {
+        Data regionList = ItemVarStore_VarRegionListTable(varStoreTable);
+        SFUInt16 dataCount = ItemVarStore_ItemVarDataCount(varStoreTable);
+
+        if (outerIndex < dataCount) {
+            Data varDataTable = ItemVarStore_ItemVarDataTable(varStoreTable, outerIndex);
+            SFUInt32 *ownedScalars = NULL;
+            SFUInt32 delta;
+
+            /* The row is summed over complete scalars, so compute them if they are not given. */
+            if (!regionScalars) {
+                ownedScalars = CreateFixedRegionScalars(varStoreTable, coordArray, coordCount);
+                regionScalars = ownedScalars;
+            }
+
+            delta = CalculateFixedAdjustment(varDataTable, innerIndex,
+                                             regionScalars, VarRegionList_RegionCount(regionList));
+            free(ownedScalars);
+
+            return RoundFixedDelta(delta);
+        }
     }
 
     return 0;
 }
 
+#endif
+
 SF_INTERNAL SFInt32 GetRelevantDeltaPixels(Data devOrVarIdxTable, SFUInt16 ppemSize,
-    Data varStoreTable, const SFInt16 *coordArray, SFUInteger coordCount)
+    Data varStoreTable, const VarScalar *regionScalars, const SFInt16 *coordArray, SFUInteger coordCount)
 {
     SFInt32 format = Device_DeltaFormat(devOrVarIdxTable);
 
     if (format == 0x8000) {
-        return GetVariationPixels(devOrVarIdxTable, varStoreTable, coordArray, coordCount);
+        return GetVariationPixels(devOrVarIdxTable, varStoreTable, regionScalars, coordArray, coordCount);
     }
 
     return GetDevicePixels(devOrVarIdxTable, ppemSize);
@@ -471,18 +597,3 @@ SF_INTERNAL Data SearchAlternateFeatureTable(Data featureSubstTable, SFUInt16 fe
     return NULL;
 }
 
-SF_INTERNAL Data SearchRelevantFeatureTable(Data langSysTable,
-    Data featureListTable, Data featureSubstTable, SFTag featureTag)
-{
-    SFUInt16 featureIndex;
-    Data defFeatureTable = SearchDefaultFeatureTable(langSysTable, featureListTable, featureTag, &featureIndex);
-
-    if (defFeatureTable && featureSubstTable) {
-        Data altFeatureTable = SearchAlternateFeatureTable(featureSubstTable, featureIndex);
-        if (altFeatureTable) {
-            return altFeatureTable;
-        }
-    }
-
-    return defFeatureTable;
-}
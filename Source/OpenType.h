@@ -22,29 +22,82 @@
 #include "SFBase.h"
 #include "Data.h"
 
-SF_INTERNAL Data SearchScriptTable(Data scriptListTable, SFTag scriptTag);
-SF_INTERNAL Data SearchLangSysTable(Data scriptTable, SFTag languageTag);
-SF_INTERNAL Data SearchDefaultFeatureTable(Data langSysTable,
-    Data featureListTable, SFTag featureTag, SFUInt16 *featureIndex);
-
 SF_INTERNAL SFUInteger SearchCoverageIndex(Data coverageTable, SFGlyphID glyphID);
 SF_INTERNAL SFUInt16 SearchGlyphClass(Data classDefTable, SFGlyphID glyphID);
 
 SF_INTERNAL SFInt32 GetDevicePixels(Data deviceTable, SFUInt16 ppemSize);
 
+/**
+ * The value of one in 16.16 fixed point region scalars.
+ */
+#define FixedScalarOne          0x10000
+
+/**
+ * The variation deltas are accumulated in floating point by default. If SF_CONFIG_FIXED_VARIATIONS
+ * is defined, the region scalars are 16.16 fixed point numbers instead and the deltas are
+ * accumulated in wrapping 32-bit arithmetic, so that the results are identical on all machines.
+ */
+#ifdef SF_CONFIG_FIXED_VARIATIONS
+typedef SFUInt32 VarScalar;
+typedef SFUInt32 VarDelta;
+
+#define CreateRegionScalars     CreateFixedRegionScalars
+#define GetVariationPixels      GetFixedVariationPixels
+#define RoundVarDelta           RoundFixedDelta
+#else
+typedef double VarScalar;
+typedef double VarDelta;
+
+#define CreateRegionScalars     CreateFloatRegionScalars
+#define GetVariationPixels      GetFloatVariationPixels
+#define RoundVarDelta           RoundFloatDelta
+#endif
+
+#if !defined(SF_CONFIG_UNITY) || !defined(SF_CONFIG_FIXED_VARIATIONS)
 SF_INTERNAL double CalculateScalarForRegion(Data regionListTable, SFUInt16 regionIndex,
     const SFInt16 *coordArray, SFUInteger coordCount);
-SF_INTERNAL SFInt32 GetVariationPixels(Data varIndexTable, Data varStoreTable,
+
+/**
+ * Computes the scalars of all regions of an item variation store for the given instance, so that
+ * they can be reused for every delta. Returns NULL if the format of the store is unknown.
+ */
+SF_INTERNAL double *CreateFloatRegionScalars(Data varStoreTable,
     const SFInt16 *coordArray, SFUInteger coordCount);
 
+/**
+ * Rounds an accumulated delta to the nearest integer, with halves rounded away from zero.
+ */
+SF_INTERNAL SFInt32 RoundFloatDelta(double delta);
+
+/**
+ * Returns the pixels of a variation index. The region scalars are optional, the scalars of the
+ * missing regions being computed from the coordinates.
+ */
+SF_INTERNAL SFInt32 GetFloatVariationPixels(Data varIndexTable, Data varStoreTable,
+    const double *regionScalars, const SFInt16 *coordArray, SFUInteger coordCount);
+#endif
+
+#if !defined(SF_CONFIG_UNITY) || defined(SF_CONFIG_FIXED_VARIATIONS)
+SF_INTERNAL SFUInt32 CalculateFixedScalarForRegion(Data regionListTable, SFUInt16 regionIndex,
+    const SFInt16 *coordArray, SFUInteger coordCount);
+SF_INTERNAL SFUInt32 *CreateFixedRegionScalars(Data varStoreTable,
+    const SFInt16 *coordArray, SFUInteger coordCount);
+
+/**
+ * Rounds a 16.16 delta accumulated in wrapping arithmetic, interpreting it as a two's complement
+ * number. The halves are rounded away from zero as in the floating point variant.
+ */
+SF_INTERNAL SFInt32 RoundFixedDelta(SFUInt32 delta);
+
+SF_INTERNAL SFInt32 GetFixedVariationPixels(Data varIndexTable, Data varStoreTable,
+    const SFUInt32 *regionScalars, const SFInt16 *coordArray, SFUInteger coordCount);
+#endif
+
 SF_INTERNAL SFInt32 GetRelevantDeltaPixels(Data devOrVarIdxTable, SFUInt16 ppemSize,
-    Data varStoreTable, const SFInt16 *coordArray, SFUInteger coordCount);
+    Data varStoreTable, const VarScalar *regionScalars, const SFInt16 *coordArray, SFUInteger coordCount);
 
 SF_INTERNAL Data SearchFeatureSubstitutionTable(Data featureVarsTable,
     const SFInt16 *coordArray, SFUInteger coordCount);
 SF_INTERNAL Data SearchAlternateFeatureTable(Data featureSubstTable, SFUInt16 featureIndex);
 
-SF_INTERNAL Data SearchRelevantFeatureTable(Data langSysTable,
-    Data featureListTable, Data featureSubstTable, SFTag featureTag);
-
 #endif
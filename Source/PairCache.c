@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <SFConfig.h>
+#include <stddef.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "PairCache.h"
+#include "SlotCache.h"
+
+#define PairEntryOf(pairCache, subtable, glyphs) \
+    (&(pairCache)->entries[SlotIndexOf(subtable, glyphs, PairCacheBits)])
+
+#define PairGlyphsOf(firstGlyph, secondGlyph) \
+    (((SFUInt32)(firstGlyph) << 16) | (secondGlyph))
+
+SF_INTERNAL void PairCacheClear(PairCacheRef pairCache)
+{
+    SlotCacheClear(pairCache->entries, PairCacheSize, sizeof(PairCacheEntry));
+}
+
+SF_INTERNAL SFBoolean PairCacheLookup(PairCacheRef pairCache, Data subtable,
+    SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data *outParent, Data *outValues)
+{
+    SFUInt32 glyphs = PairGlyphsOf(firstGlyph, secondGlyph);
+    PairCacheEntry *entry = PairEntryOf(pairCache, subtable, glyphs);
+
+    if (SlotKeyMatches(&entry->key, subtable, glyphs)) {
+        *outParent = entry->parent;
+        *outValues = entry->values;
+
+        return SFTrue;
+    }
+
+    return SFFalse;
+}
+
+SF_INTERNAL void PairCacheStore(PairCacheRef pairCache, Data subtable,
+    SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data parent, Data values)
+{
+    SFUInt32 glyphs = PairGlyphsOf(firstGlyph, secondGlyph);
+    PairCacheEntry *entry = PairEntryOf(pairCache, subtable, glyphs);
+
+    SlotKeySet(&entry->key, subtable, glyphs);
+    entry->parent = parent;
+    entry->values = values;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SF_INTERNAL_PAIR_CACHE_H
+#define _SF_INTERNAL_PAIR_CACHE_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "SlotCache.h"
+
+#define PairCacheBits   8
+#define PairCacheSize   (1 << PairCacheBits)
+
+typedef struct _PairCacheEntry {
+    SlotKey key;                /**< The pair adjustment subtable along with both glyphs of the pair. */
+    Data parent;                /**< The table relative to which the device offsets are resolved. */
+    Data values;                /**< The value record of first glyph, NULL if the pair is not kerned. */
+} PairCacheEntry;
+
+/**
+ * A direct-mapped cache of the value records located by pair adjustment subtables.
+ *
+ * The located records are independent of the size and variation instance of the font, so the
+ * device and variation tables referred by them are still resolved while applying the values. The
+ * pairs without any adjustment are cached as well, being the vast majority of the pairs in a text.
+ * The cache is kept by an artist and is only valid as long as the tables of its pattern are alive.
+ */
+typedef struct _PairCache {
+    PairCacheEntry entries[PairCacheSize];
+} PairCache, *PairCacheRef;
+
+/**
+ * Empties the cache, so that it no longer refers to any table.
+ */
+SF_INTERNAL void PairCacheClear(PairCacheRef pairCache);
+
+/**
+ * Looks up the value records of a glyph pair in a subtable.
+ *
+ * @return
+ *      SFTrue if the pair was found in the cache, SFFalse otherwise.
+ */
+SF_INTERNAL SFBoolean PairCacheLookup(PairCacheRef pairCache, Data subtable,
+    SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data *outParent, Data *outValues);
+
+/**
+ * Stores the value records of a glyph pair in a subtable, evicting the entry previously occupying
+ * its slot.
+ */
+SF_INTERNAL void PairCacheStore(PairCacheRef pairCache, Data subtable,
+    SFGlyphID firstGlyph, SFGlyphID secondGlyph, Data parent, Data values);
+
+#endif
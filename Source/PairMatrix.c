@@ -0,0 +1,466 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "SFAssert.h"
+#include "SFBase.h"
+#include "Common.h"
+#include "Data.h"
+#include "GPOS.h"
+#include "PairMatrix.h"
+
+/**
+ * Finds the first and last glyphs of a coverage or class definition table. Returns SFFalse if the
+ * table is unreadable or does not refer to any glyph.
+ */
+static SFBoolean GetGlyphSpan(Data table, SFUInteger length, SFBoolean isClassDef,
+    SFGlyphID *outStart, SFGlyphID *outEnd)
+{
+    SFUInt16 format;
+    SFUInteger first = 0xFFFF;
+    SFUInteger last = 0;
+    SFUInteger count;
+    SFUInteger index;
+
+    if (length < 6) {
+        return SFFalse;
+    }
+
+    format = Data_UInt16(table, 0);
+
+    if (format == 1 && isClassDef) {
+        first = ClassDefF1_StartGlyphID(table);
+        count = ClassDefF1_GlyphCount(table);
+
+        if (count == 0 || count > (length - 6) / 2 || first + count > 0x10000) {
+            return SFFalse;
+        }
+
+        last = first + count - 1;
+    } else if (format == 1) {
+        Data glyphArray = CoverageF1_GlyphArray(table);
+        count = CoverageF1_GlyphCount(table);
+
+        if (count > (length - 4) / 2) {
+            return SFFalse;
+        }
+
+        for (index = 0; index < count; index++) {
+            SFGlyphID glyph = UInt16Array_Value(glyphArray, index);
+
+            if (glyph < first) {
+                first = glyph;
+            }
+            if (glyph > last) {
+                last = glyph;
+            }
+        }
+    } else if (format == 2) {
+        Data rangeArray = Data_Subdata(table, 4);
+        count = Data_UInt16(table, 2);
+
+        if (count > (length - 4) / GlyphRange_Size()) {
+            return SFFalse;
+        }
+
+        for (index = 0; index < count; index++) {
+            Data range = Data_Subdata(rangeArray, index * GlyphRange_Size());
+            SFGlyphID start = GlyphRange_Start(range);
+            SFGlyphID end = GlyphRange_End(range);
+
+            if (start <= end) {
+                if (start < first) {
+                    first = start;
+                }
+                if (end > last) {
+                    last = end;
+                }
+            }
+        }
+    } else {
+        return SFFalse;
+    }
+
+    if (first > last) {
+        return SFFalse;
+    }
+
+    *outStart = (SFGlyphID)first;
+    *outEnd = (SFGlyphID)last;
+
+    return SFTrue;
+}
+
+static void SetClass(SFUInt16 *classArray, SFGlyphID startGlyph,
+    SFGlyphID glyph, SFUInt16 glyphClass, SFUInt16 classCount, SFBoolean coveredOnly)
+{
+    SFUInt16 *entry = &classArray[glyph - startGlyph];
+
+    if (!coveredOnly || *entry != PairMatrixInvalidClass) {
+        *entry = (glyphClass < classCount ? glyphClass : PairMatrixInvalidClass);
+    }
+}
+
+/**
+ * Fills the class array with the classes of a class definition table, whose span must already be
+ * known to lie within the array. If `coveredOnly` is set, the glyphs having an invalid class are
+ * left untouched.
+ */
+static void FillClasses(SFUInt16 *classArray, SFGlyphID startGlyph, SFGlyphID endGlyph,
+    Data classDef, SFUInt16 classCount, SFBoolean coveredOnly)
+{
+    SFUInt16 format = ClassDef_Format(classDef);
+    SFUInteger index;
+
+    if (format == 1) {
+        SFGlyphID firstGlyph = ClassDefF1_StartGlyphID(classDef);
+        SFUInteger glyphCount = ClassDefF1_GlyphCount(classDef);
+        Data classValues = ClassDefF1_ClassValueArray(classDef);
+
+        for (index = 0; index < glyphCount; index++) {
+            SFUInteger glyph = firstGlyph + index;
+
+            if (glyph >= startGlyph && glyph <= endGlyph) {
+                SetClass(classArray, startGlyph, (SFGlyphID)glyph,
+                         UInt16Array_Value(classValues, index), classCount, coveredOnly);
+            }
+        }
+    } else {
+        SFUInteger rangeCount = ClassDefF2_ClassRangeCount(classDef);
+
+        for (index = 0; index < rangeCount; index++) {
+            Data range = ClassDefF2_ClassRangeRecord(classDef, index);
+            SFUInteger start = GlyphRange_Start(range);
+            SFUInteger end = GlyphRange_End(range);
+            SFUInt16 rangeClass = GlyphRange_Value(range);
+            SFUInteger glyph;
+
+            if (start < startGlyph) {
+                start = startGlyph;
+            }
+            if (end > endGlyph) {
+                end = endGlyph;
+            }
+
+            for (glyph = start; glyph <= end; glyph++) {
+                SetClass(classArray, startGlyph, (SFGlyphID)glyph, rangeClass, classCount, coveredOnly);
+            }
+        }
+    }
+}
+
+/**
+ * Marks the covered glyphs in the first class array with class zero.
+ */
+static void MarkCoveredGlyphs(SFUInt16 *classArray, SFGlyphID startGlyph, Data coverage)
+{
+    SFUInt16 format = Coverage_Format(coverage);
+    SFUInteger index;
+
+    if (format == 1) {
+        SFUInteger glyphCount = CoverageF1_GlyphCount(coverage);
+        Data glyphArray = CoverageF1_GlyphArray(coverage);
+
+        for (index = 0; index < glyphCount; index++) {
+            classArray[UInt16Array_Value(glyphArray, index) - startGlyph] = 0;
+        }
+    } else {
+        SFUInteger rangeCount = CoverageF2_RangeCount(coverage);
+
+        for (index = 0; index < rangeCount; index++) {
+            Data range = CoverageF2_RangeRecord(coverage, index);
+            SFUInteger start = RangeRecord_StartGlyphID(range);
+            SFUInteger end = RangeRecord_EndGlyphID(range);
+            SFUInteger glyph;
+
+            for (glyph = start; glyph <= end; glyph++) {
+                classArray[glyph - startGlyph] = 0;
+            }
+        }
+    }
+}
+
+static void DecodeValues(SFInt16 *values, Data valueRecord, SFUInteger valueCount)
+{
+    SFUInteger index;
+
+    for (index = 0; index < valueCount; index++) {
+        values[index] = Data_Int16(valueRecord, index * 2);
+    }
+}
+
+SF_INTERNAL PairMatrixRef PairMatrixCreate(Data pairPos, SFUInteger length)
+{
+    PairMatrixRef pairMatrix;
+    SFUInt16 valueFormat1;
+    SFUInt16 valueFormat2;
+    SFUInt16 class1Count;
+    SFUInt16 class2Count;
+    SFUInteger coverageOffset;
+    SFUInteger classDef1Offset;
+    SFUInteger classDef2Offset;
+    SFUInteger value1Count;
+    SFUInteger value2Count;
+    SFUInteger recordSize;
+    SFUInteger pairCount;
+    SFGlyphID coverageStart;
+    SFGlyphID coverageEnd;
+    SFGlyphID class1Start;
+    SFGlyphID class1End;
+    SFGlyphID class2Start;
+    SFGlyphID class2End;
+    SFBoolean hasClass1;
+    SFBoolean hasClass2;
+    SFUInteger index;
+
+    if (length < 16 || PairPos_Format(pairPos) != 2) {
+        return NULL;
+    }
+
+    valueFormat1 = PairPosF2_ValueFormat1(pairPos);
+    valueFormat2 = PairPosF2_ValueFormat2(pairPos);
+    class1Count = PairPosF2_Class1Count(pairPos);
+    class2Count = PairPosF2_Class2Count(pairPos);
+
+    /* Only the plain placements and advances can be kept natively. */
+    if ((valueFormat1 | valueFormat2) & 0xFFF0 || !(valueFormat1 | valueFormat2)
+        || class1Count == 0 || class2Count == 0) {
+        return NULL;
+    }
+
+    value1Count = ValueFormat_ValueCount(valueFormat1);
+    value2Count = ValueFormat_ValueCount(valueFormat2);
+    recordSize = (value1Count + value2Count) * 2;
+    pairCount = (SFUInteger)class1Count * class2Count;
+
+    if (pairCount > (length - 16) / recordSize) {
+        return NULL;
+    }
+
+    coverageOffset = PairPosF2_CoverageOffset(pairPos);
+    classDef1Offset = PairPosF2_ClassDef1Offset(pairPos);
+    classDef2Offset = PairPosF2_ClassDef2Offset(pairPos);
+
+    if (coverageOffset >= length || classDef1Offset >= length || classDef2Offset >= length) {
+        return NULL;
+    }
+
+    if (!GetGlyphSpan(Data_Subdata(pairPos, coverageOffset), length - coverageOffset,
+                      SFFalse, &coverageStart, &coverageEnd)) {
+        return NULL;
+    }
+
+    /* An empty class definition puts all glyphs in class zero. */
+    hasClass1 = GetGlyphSpan(Data_Subdata(pairPos, classDef1Offset), length - classDef1Offset,
+                             SFTrue, &class1Start, &class1End);
+    hasClass2 = GetGlyphSpan(Data_Subdata(pairPos, classDef2Offset), length - classDef2Offset,
+                             SFTrue, &class2Start, &class2End);
+
+    pairMatrix = malloc(sizeof(PairMatrix));
+    pairMatrix->source = pairPos;
+    pairMatrix->class1Start = coverageStart;
+    pairMatrix->class1Length = (SFUInteger)(coverageEnd - coverageStart) + 1;
+    pairMatrix->class1Array = malloc(sizeof(SFUInt16) * pairMatrix->class1Length);
+    pairMatrix->class2Start = (hasClass2 ? class2Start : 0);
+    pairMatrix->class2Length = (hasClass2 ? (SFUInteger)(class2End - class2Start) + 1 : 0);
+    pairMatrix->class2Array = NULL;
+    pairMatrix->class2Count = class2Count;
+    pairMatrix->valueFormat1 = valueFormat1;
+    pairMatrix->valueFormat2 = valueFormat2;
+    pairMatrix->valueCount = value1Count + value2Count;
+    pairMatrix->valueArray = malloc(sizeof(SFInt16) * pairCount * pairMatrix->valueCount);
+
+    for (index = 0; index < pairMatrix->class1Length; index++) {
+        pairMatrix->class1Array[index] = PairMatrixInvalidClass;
+    }
+
+    MarkCoveredGlyphs(pairMatrix->class1Array, coverageStart, Data_Subdata(pairPos, coverageOffset));
+
+    if (hasClass1) {
+        FillClasses(pairMatrix->class1Array, coverageStart, coverageEnd,
+                    Data_Subdata(pairPos, classDef1Offset), class1Count, SFTrue);
+    }
+
+    if (hasClass2) {
+        pairMatrix->class2Array = calloc(pairMatrix->class2Length, sizeof(SFUInt16));
+
+        FillClasses(pairMatrix->class2Array, class2Start, class2End,
+                    Data_Subdata(pairPos, classDef2Offset), class2Count, SFFalse);
+    }
+
+    /* The class records are laid out in the same order as the matrix. */
+    for (index = 0; index < pairCount; index++) {
+        DecodeValues(&pairMatrix->valueArray[index * pairMatrix->valueCount],
+                     Data_Subdata(pairPos, 16 + (index * recordSize)), pairMatrix->valueCount);
+    }
+
+    return pairMatrix;
+}
+
+SF_INTERNAL void PairMatrixDestroy(PairMatrixRef pairMatrix)
+{
+    free(pairMatrix->class1Array);
+    free(pairMatrix->class2Array);
+    free(pairMatrix->valueArray);
+    free(pairMatrix);
+}
+
+SF_INTERNAL PairMatrixListRef PairMatrixListCreate(Data gpos, SFUInteger length)
+{
+    PairMatrixListRef pairMatrixList;
+    SFUInteger listOffset;
+    SFUInteger lookupCount;
+
+    if (length < 10) {
+        return NULL;
+    }
+
+    listOffset = Header_LookupListOffset(gpos);
+
+    if (listOffset > length - 2) {
+        return NULL;
+    }
+
+    lookupCount = LookupList_LookupCount(Data_Subdata(gpos, listOffset));
+
+    if (lookupCount > (length - listOffset - 2) / 2) {
+        return NULL;
+    }
+
+    pairMatrixList = malloc(sizeof(PairMatrixList));
+    pairMatrixList->gpos = gpos;
+    pairMatrixList->length = length;
+    pairMatrixList->lookups = calloc(lookupCount ? lookupCount : 1, sizeof(PairMatrixLookup));
+    pairMatrixList->lookupCount = lookupCount;
+    MutexInitialize(&pairMatrixList->mutex);
+
+    return pairMatrixList;
+}
+
+/**
+ * Compiles the PairPos format 2 subtables of a lookup, resolving the extension subtables.
+ */
+static void CompileLookup(PairMatrixListRef pairMatrixList, PairMatrixLookup *pairLookup, SFUInt16 lookupIndex)
+{
+    Data gpos = pairMatrixList->gpos;
+    SFUInteger length = pairMatrixList->length;
+    Data lookupList = Header_LookupListTable(gpos);
+    SFUInteger lookupOffset;
+    LookupType lookupType;
+    SFUInteger subtableCount;
+    SFUInteger subtableIndex;
+
+    lookupOffset = (SFUInteger)(lookupList - gpos) + LookupList_LookupOffset(lookupList, lookupIndex);
+
+    if (lookupOffset > length - 6) {
+        return;
+    }
+
+    lookupType = Lookup_LookupType(Data_Subdata(gpos, lookupOffset));
+    subtableCount = Lookup_SubtableCount(Data_Subdata(gpos, lookupOffset));
+
+    if ((lookupType != LookupTypePairAdjustment && lookupType != LookupTypeExtensionPositioning)
+        || subtableCount > (length - lookupOffset - 6) / 2) {
+        return;
+    }
+
+    for (subtableIndex = 0; subtableIndex < subtableCount; subtableIndex++) {
+        Data lookupTable = Data_Subdata(gpos, lookupOffset);
+        SFUInteger offset = lookupOffset + Lookup_SubtableOffset(lookupTable, subtableIndex);
+        PairMatrixRef pairMatrix;
+
+        if (lookupType == LookupTypeExtensionPositioning) {
+            Data extension = Data_Subdata(gpos, offset);
+
+            if (offset > length - 8 || Extension_Format(extension) != 1
+                || ExtensionF1_LookupType(extension) != LookupTypePairAdjustment
+                || ExtensionF1_ExtensionOffset(extension) > length - offset) {
+                continue;
+            }
+
+            offset += ExtensionF1_ExtensionOffset(extension);
+        }
+
+        if (offset >= length) {
+            continue;
+        }
+
+        pairMatrix = PairMatrixCreate(Data_Subdata(gpos, offset), length - offset);
+
+        if (pairMatrix) {
+            if (!pairLookup->matrices) {
+                pairLookup->matrices = calloc(subtableCount, sizeof(PairMatrixRef));
+                pairLookup->subtableCount = subtableCount;
+            }
+
+            pairLookup->matrices[subtableIndex] = pairMatrix;
+        }
+    }
+}
+
+SF_INTERNAL PairMatrixRef *PairMatrixListGetMatrices(PairMatrixListRef pairMatrixList, SFUInt16 lookupIndex)
+{
+    PairMatrixLookup *pairLookup;
+
+    if (lookupIndex >= pairMatrixList->lookupCount) {
+        return NULL;
+    }
+
+    pairLookup = &pairMatrixList->lookups[lookupIndex];
+
+    /* Lock only while the lookup is not compiled, as the matrices never change afterwards. */
+    if (!FlagLoadAcquire(&pairLookup->isCompiled)) {
+        MutexLock(&pairMatrixList->mutex);
+
+        if (!pairLookup->isCompiled) {
+            CompileLookup(pairMatrixList, pairLookup, lookupIndex);
+            FlagStoreRelease(&pairLookup->isCompiled, SFTrue);
+        }
+
+        MutexUnlock(&pairMatrixList->mutex);
+    }
+
+    return pairLookup->matrices;
+}
+
+SF_INTERNAL void PairMatrixListDestroy(PairMatrixListRef pairMatrixList)
+{
+    SFUInteger lookupIndex;
+
+    for (lookupIndex = 0; lookupIndex < pairMatrixList->lookupCount; lookupIndex++) {
+        PairMatrixLookup *pairLookup = &pairMatrixList->lookups[lookupIndex];
+
+        if (pairLookup->matrices) {
+            SFUInteger subtableIndex;
+
+            for (subtableIndex = 0; subtableIndex < pairLookup->subtableCount; subtableIndex++) {
+                if (pairLookup->matrices[subtableIndex]) {
+                    PairMatrixDestroy(pairLookup->matrices[subtableIndex]);
+                }
+            }
+
+            free(pairLookup->matrices);
+        }
+    }
+
+    MutexFinalize(&pairMatrixList->mutex);
+    free(pairMatrixList->lookups);
+    free(pairMatrixList);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SF_INTERNAL_PAIR_MATRIX_H
+#define _SF_INTERNAL_PAIR_MATRIX_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "Mutex.h"
+
+#define PairMatrixInvalidClass          0xFFFF
+
+/**
+ * Native form of a device-free PairPos format 2 subtable.
+ *
+ * The first class array spans the covered glyphs, so that an uncovered glyph or an out of range
+ * class resolves to an invalid class. The second class array spans the glyphs of second class
+ * definition, all other glyphs being in class zero. The values of each class pair are decoded in
+ * the order of the value records, the ones of first glyph followed by the ones of second glyph.
+ */
+typedef struct _PairMatrix {
+    Data source;                /**< The subtable from which the matrix has been compiled. */
+    SFUInt16 *class1Array;      /**< The first classes of the glyphs starting from class1Start. */
+    SFUInt16 *class2Array;      /**< The second classes of the glyphs starting from class2Start. */
+    SFInt16 *valueArray;        /**< The values of all class pairs. */
+    SFUInteger class1Length;    /**< The number of glyphs in the first class array. */
+    SFUInteger class2Length;    /**< The number of glyphs in the second class array. */
+    SFUInteger valueCount;      /**< The number of values of each class pair. */
+    SFGlyphID class1Start;
+    SFGlyphID class2Start;
+    SFUInt16 class2Count;
+    SFUInt16 valueFormat1;
+    SFUInt16 valueFormat2;
+} PairMatrix, *PairMatrixRef;
+
+typedef struct _PairMatrixLookup {
+    PairMatrixRef *matrices;    /**< The matrices of the subtables, NULL for the ones not compiled. */
+    SFUInteger subtableCount;
+    SFBoolean isCompiled;       /**< Whether the subtables of the lookup have been compiled. */
+} PairMatrixLookup;
+
+/**
+ * The compiled pair subtables of a GPOS table, each lookup being compiled on first use.
+ */
+typedef struct _PairMatrixList {
+    Data gpos;
+    SFUInteger length;
+    PairMatrixLookup *lookups;
+    SFUInteger lookupCount;
+    Mutex mutex;                /**< The mutex guarding the compilation of the lookups. */
+} PairMatrixList, *PairMatrixListRef;
+
+#define PairMatrixGetClass1(matrix, glyph)                                                      \
+(                                                                                               \
+   (SFUInteger)((glyph) - (matrix)->class1Start) < (matrix)->class1Length                       \
+ ? (matrix)->class1Array[(glyph) - (matrix)->class1Start]                                       \
+ : PairMatrixInvalidClass                                                                       \
+)
+
+#define PairMatrixGetClass2(matrix, glyph)                                                      \
+(                                                                                               \
+   (SFUInteger)((glyph) - (matrix)->class2Start) < (matrix)->class2Length                       \
+ ? (matrix)->class2Array[(glyph) - (matrix)->class2Start]                                       \
+ : 0                                                                                            \
+)
+
+#define PairMatrixGetValues(matrix, class1, class2)                                             \
+    (&(matrix)->valueArray[((SFUInteger)(class1) * (matrix)->class2Count + (class2))            \
+                           * (matrix)->valueCount])
+
+/**
+ * Compiles the given PairPos subtable having `length` readable bytes. Returns NULL if the subtable
+ * is not of format 2, its value records refer to device tables, or it is malformed.
+ */
+SF_INTERNAL PairMatrixRef PairMatrixCreate(Data pairPos, SFUInteger length);
+
+SF_INTERNAL void PairMatrixDestroy(PairMatrixRef pairMatrix);
+
+/**
+ * Creates an empty list for the lookups of given GPOS table. Returns NULL if the lookup list is
+ * unreadable.
+ */
+SF_INTERNAL PairMatrixListRef PairMatrixListCreate(Data gpos, SFUInteger length);
+
+/**
+ * Returns the matrices of the subtables of a lookup, compiling them on first use. The returned
+ * array is NULL if none of the subtables could be compiled. The lock of the list is taken only
+ * until the lookup has been compiled.
+ */
+SF_INTERNAL PairMatrixRef *PairMatrixListGetMatrices(PairMatrixListRef pairMatrixList, SFUInt16 lookupIndex);
+
+SF_INTERNAL void PairMatrixListDestroy(PairMatrixListRef pairMatrixList);
+
+#endif
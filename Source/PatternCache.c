@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SFBase.h"
+#include "List.h"
+#include "Mutex.h"
+#include "SFPattern.h"
+#include "PatternCache.h"
+
+#define PatternHashStep(hash, value) \
+    (((hash) ^ (SFUInt32)(value)) * 0x01000193UL)
+
+static SFUInt32 HashPatternKey(const PatternKey *key)
+{
+    SFUInt32 hash = 0x811C9DC5UL;
+    SFUInteger index;
+
+    hash = PatternHashStep(hash, (SFUInteger)key->knowledge);
+    hash = PatternHashStep(hash, key->scriptTag);
+    hash = PatternHashStep(hash, key->languageTag);
+
+    for (index = 0; index < key->featureCount; index++) {
+        hash = PatternHashStep(hash, key->featureTags[index]);
+        hash = PatternHashStep(hash, key->featureValues[index]);
+    }
+
+    return hash & 0xFFFFFFFF;
+}
+
+static SFBoolean IsSamePatternKey(const PatternKey *key1, const PatternKey *key2)
+{
+    return key1->knowledge == key2->knowledge
+        && key1->scriptTag == key2->scriptTag
+        && key1->languageTag == key2->languageTag
+        && key1->featureCount == key2->featureCount
+        && memcmp(key1->featureTags, key2->featureTags, sizeof(SFTag) * key1->featureCount) == 0
+        && memcmp(key1->featureValues, key2->featureValues, sizeof(SFUInt16) * key1->featureCount) == 0;
+}
+
+static SFPatternRef FindCachedPattern(PatternCacheRef patternCache, const PatternKey *key, SFUInt32 hash)
+{
+    SFUInteger index;
+
+    for (index = 0; index < patternCache->entries.count; index++) {
+        PatternCacheEntry *entry = &patternCache->entries.items[index];
+
+        if (entry->hash == hash && IsSamePatternKey(&entry->key, key)) {
+            return entry->pattern;
+        }
+    }
+
+    return NULL;
+}
+
+SF_INTERNAL void PatternCacheInitialize(PatternCacheRef patternCache)
+{
+    ListInitialize(&patternCache->entries, sizeof(PatternCacheEntry));
+    MutexInitialize(&patternCache->mutex);
+}
+
+SF_INTERNAL void PatternCacheFinalize(PatternCacheRef patternCache)
+{
+    SFUInteger index;
+
+    for (index = 0; index < patternCache->entries.count; index++) {
+        PatternCacheEntry *entry = &patternCache->entries.items[index];
+
+        free(entry->key.featureTags);
+        free(entry->key.featureValues);
+        SFPatternRelease(entry->pattern);
+    }
+
+    ListFinalize(&patternCache->entries);
+    MutexFinalize(&patternCache->mutex);
+}
+
+SF_INTERNAL SFPatternRef PatternCacheSearch(PatternCacheRef patternCache, const PatternKey *key)
+{
+    SFUInt32 hash = HashPatternKey(key);
+    SFPatternRef pattern;
+
+    MutexLock(&patternCache->mutex);
+
+    pattern = SFPatternRetain(FindCachedPattern(patternCache, key, hash));
+
+    MutexUnlock(&patternCache->mutex);
+
+    return pattern;
+}
+
+SF_INTERNAL SFPatternRef PatternCacheInsert(PatternCacheRef patternCache,
+    const PatternKey *key, SFPatternRef pattern)
+{
+    SFUInt32 hash = HashPatternKey(key);
+    SFPatternRef cachedPattern;
+
+    MutexLock(&patternCache->mutex);
+
+    cachedPattern = SFPatternRetain(FindCachedPattern(patternCache, key, hash));
+
+    if (!cachedPattern && patternCache->entries.count < PatternCacheCapacity) {
+        PatternCacheEntry entry;
+        SFUInteger featureCount = key->featureCount;
+
+        entry.key = *key;
+        entry.key.featureTags = malloc(sizeof(SFTag) * (featureCount ? featureCount : 1));
+        entry.key.featureValues = malloc(sizeof(SFUInt16) * (featureCount ? featureCount : 1));
+        entry.hash = hash;
+        entry.pattern = pattern;
+
+        memcpy(entry.key.featureTags, key->featureTags, sizeof(SFTag) * featureCount);
+        memcpy(entry.key.featureValues, key->featureValues, sizeof(SFUInt16) * featureCount);
+
+        /*
+         * The pattern is about to be shared, so synchronize its retain count from now on. The
+         * reference of the cache is taken first so that it does not retain the font again.
+         */
+        SFPatternRetain(pattern);
+        SFPatternMarkShared(pattern);
+
+        ListAdd(&patternCache->entries, entry);
+    }
+
+    MutexUnlock(&patternCache->mutex);
+
+    return (cachedPattern ? cachedPattern : pattern);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SF_INTERNAL_PATTERN_CACHE_H
+#define _SF_INTERNAL_PATTERN_CACHE_H
+
+#include <SFConfig.h>
+#include <SFPattern.h>
+
+#include "SFBase.h"
+#include "List.h"
+#include "Mutex.h"
+
+/**
+ * The maximum number of patterns kept by a cache, beyond which the patterns are no longer cached.
+ */
+#define PatternCacheCapacity    64
+
+/**
+ * The inputs from which a scheme builds a pattern for a font.
+ */
+typedef struct _PatternKey {
+    const void *knowledge;      /**< The shaping knowledge used for the known features. */
+    SFTag scriptTag;
+    SFTag languageTag;
+    SFTag *featureTags;         /**< The unique feature tags in the order they were set. */
+    SFUInt16 *featureValues;
+    SFUInteger featureCount;
+} PatternKey;
+
+typedef struct _PatternCacheEntry {
+    PatternKey key;             /**< The key, owning copies of the feature arrays. */
+    SFUInt32 hash;              /**< The hash of the key, compared before the key itself. */
+    SFPatternRef pattern;
+} PatternCacheEntry;
+
+/**
+ * A cache of the patterns built for a font, keyed by the inputs of the scheme.
+ *
+ * The font and so its tables and variation coordinates are implied by the owner of the cache. The
+ * cache is guarded by its own mutex so that the schemes of multiple threads can share the font.
+ */
+typedef struct _PatternCache {
+    LIST(PatternCacheEntry) entries;
+    Mutex mutex;
+} PatternCache, *PatternCacheRef;
+
+SF_INTERNAL void PatternCacheInitialize(PatternCacheRef patternCache);
+SF_INTERNAL void PatternCacheFinalize(PatternCacheRef patternCache);
+
+/**
+ * Returns the cached pattern of a key after retaining it, or NULL if there is none.
+ */
+SF_INTERNAL SFPatternRef PatternCacheSearch(PatternCacheRef patternCache, const PatternKey *key);
+
+/**
+ * Adds a pattern against a key, retaining it. If a pattern has been added against the same key in
+ * the meanwhile, it is returned after retaining instead, otherwise the given pattern is returned.
+ */
+SF_INTERNAL SFPatternRef PatternCacheInsert(PatternCacheRef patternCache,
+    const PatternKey *key, SFPatternRef pattern);
+
+#endif
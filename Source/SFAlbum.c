@@ -99,6 +99,9 @@ SF_INTERNAL void SFAlbumInitialize(SFAlbumRef album)
     ListInitialize(&album->_details, sizeof(GlyphDetail));
     ListInitialize(&album->_offsets, sizeof(SFPoint));
     ListInitialize(&album->_advances, sizeof(SFAdvance));
+    ListInitialize(&album->_codepointBuffer, sizeof(SFCodepoint));
+
+    GlyphDigestClear(&album->_glyphDigest);
 
     album->_version = 0;
     album->_state = AlbumStateEmpty;
@@ -126,6 +129,8 @@ SF_INTERNAL void SFAlbumReset(SFAlbumRef album, SFCodepointsRef codepoints)
     ListClear(&album->_offsets);
     ListClear(&album->_advances);
 
+    GlyphDigestClear(&album->_glyphDigest);
+
     album->_version = 0;
     album->_state = AlbumStateEmpty;
 }
@@ -154,6 +159,7 @@ SF_INTERNAL void SFAlbumAddGlyph(SFAlbumRef album, SFGlyphID glyph, GlyphTraits
 
     /* Initialize the glyph along with its details. */
     ListSetVal(&album->_glyphs, index, glyph);
+    GlyphDigestAddGlyph(&album->_glyphDigest, glyph);
     detail->association = association;
     detail->mask.section.feature = SFUInt16Max;
     detail->mask.section.traits = traits;
@@ -171,6 +177,18 @@ SF_INTERNAL SFUInteger *SFAlbumGetTemporaryIndexArray(SFAlbumRef album, SFUInteg
     return album->_indexMap.items;
 }
 
+SF_INTERNAL SFCodepoint *SFAlbumGetTemporaryCodepointArray(SFAlbumRef album, SFUInteger count)
+{
+    /* The album must be in filling state. */
+    SFAssert(album->_state == AlbumStateFilling);
+
+    if (album->_codepointBuffer.capacity < count) {
+        ListSetCapacity(&album->_codepointBuffer, count);
+    }
+
+    return album->_codepointBuffer.items;
+}
+
 SF_INTERNAL void SFAlbumReserveGlyphs(SFAlbumRef album, SFUInteger index, SFUInteger count)
 {
     /* The album must be in filling state. */
@@ -188,9 +206,25 @@ SF_INTERNAL SFGlyphID SFAlbumGetGlyph(SFAlbumRef album, SFUInteger index)
     return ListGetVal(&album->_glyphs, index);
 }
 
+SF_INTERNAL SFGlyphID *SFAlbumGetGlyphArray(SFAlbumRef album, SFUInteger index)
+{
+    return ListGetRef(&album->_glyphs, index);
+}
+
+SF_INTERNAL void SFAlbumDigestGlyphs(SFAlbumRef album, SFUInteger index, SFUInteger count)
+{
+    const SFGlyphID *glyphs = ListGetRef(&album->_glyphs, index);
+    SFUInteger offset;
+
+    for (offset = 0; offset < count; offset++) {
+        GlyphDigestAddGlyph(&album->_glyphDigest, glyphs[offset]);
+    }
+}
+
 SF_INTERNAL void SFAlbumSetGlyph(SFAlbumRef album, SFUInteger index, SFGlyphID glyph)
 {
     ListSetVal(&album->_glyphs, index, glyph);
+    GlyphDigestAddGlyph(&album->_glyphDigest, glyph);
 }
 
 SF_INTERNAL SFUInteger SFAlbumGetAssociation(SFAlbumRef album, SFUInteger index)
@@ -328,6 +362,14 @@ SF_INTERNAL void SFAlbumSetAdvance(SFAlbumRef album, SFUInteger index, SFAdvance
     ListSetVal(&album->_advances, index, advance);
 }
 
+SF_INTERNAL SFAdvance *SFAlbumGetAdvanceArray(SFAlbumRef album, SFUInteger index)
+{
+    /* The album must be in arranging or arranged state. */
+    SFAssert(album->_state == AlbumStateArranging || album->_state == AlbumStateArranged);
+
+    return ListGetRef(&album->_advances, index);
+}
+
 SF_INTERNAL SFUInt16 SFAlbumGetCursiveOffset(SFAlbumRef album, SFUInteger index)
 {
     return ListGetRef(&album->_details, index)->cursiveOffset;
@@ -449,4 +491,5 @@ SF_INTERNAL void SFAlbumFinalize(SFAlbumRef album) {
     ListFinalize(&album->_details);
     ListFinalize(&album->_offsets);
     ListFinalize(&album->_advances);
+    ListFinalize(&album->_codepointBuffer);
 }
@@ -22,6 +22,7 @@
 
 #include "SFBase.h"
 #include "SFCodepoints.h"
+#include "GlyphDigest.h"
 #include "List.h"
 
 typedef enum {
@@ -75,6 +76,8 @@ typedef struct _SFAlbum {
     LIST(GlyphDetail) _details;         /**< List of details of all glyphs in the album. */
     LIST(SFPoint) _offsets;             /**< List of offsets of all glyphs in the album. */
     LIST(SFAdvance) _advances;          /**< List of advances of all glyphs in the album. */
+    LIST(SFCodepoint) _codepointBuffer; /**< Temporary list of code points being mapped into glyphs. */
+    GlyphDigest _glyphDigest;           /**< Summary of all glyphs ever put in the album since reset. */
 
     SFUInteger _version;                /**< Current version of the album. */
     AlbumState _state;                  /**< Current state of the album. */
@@ -97,6 +100,7 @@ SF_INTERNAL void SFAlbumReset(SFAlbumRef album, SFCodepointsRef codepoints);
 SF_INTERNAL void SFAlbumBeginFilling(SFAlbumRef album);
 
 SF_INTERNAL SFUInteger *SFAlbumGetTemporaryIndexArray(SFAlbumRef album, SFUInteger count);
+SF_INTERNAL SFCodepoint *SFAlbumGetTemporaryCodepointArray(SFAlbumRef album, SFUInteger count);
 
 /**
  * Adds a new glyph into the album.
@@ -111,6 +115,17 @@ SF_INTERNAL void SFAlbumAddGlyph(SFAlbumRef album, SFGlyphID glyph, GlyphTraits
 SF_INTERNAL void SFAlbumReserveGlyphs(SFAlbumRef album, SFUInteger index, SFUInteger count);
 
 SF_INTERNAL SFGlyphID SFAlbumGetGlyph(SFAlbumRef album, SFUInteger index);
+
+/**
+ * Returns a writable array of glyph IDs starting from the given index. The glyphs written into the
+ * array must be passed to SFAlbumDigestGlyphs afterwards.
+ */
+SF_INTERNAL SFGlyphID *SFAlbumGetGlyphArray(SFAlbumRef album, SFUInteger index);
+
+/**
+ * Adds the glyphs of the given range into the glyph digest of the album.
+ */
+SF_INTERNAL void SFAlbumDigestGlyphs(SFAlbumRef album, SFUInteger index, SFUInteger count);
 SF_INTERNAL void SFAlbumSetGlyph(SFAlbumRef album, SFUInteger index, SFGlyphID glyph);
 
 SF_INTERNAL SFUInteger SFAlbumGetAssociation(SFAlbumRef album, SFUInteger index);
@@ -147,6 +162,11 @@ SF_INTERNAL void SFAlbumSetY(SFAlbumRef album, SFUInteger index, SFInt32 y);
 SF_INTERNAL SFAdvance SFAlbumGetAdvance(SFAlbumRef album, SFUInteger index);
 SF_INTERNAL void SFAlbumSetAdvance(SFAlbumRef album, SFUInteger index, SFAdvance advance);
 
+/**
+ * Returns a writable array of advances starting from the given index.
+ */
+SF_INTERNAL SFAdvance *SFAlbumGetAdvanceArray(SFAlbumRef album, SFUInteger index);
+
 #define SFAlbumAddX(album, index, pos) \
     SFAlbumSetX(album, index, SFAlbumGetX(album, index) + pos)
 #define SFAlbumAddY(album, index, pos) \
@@ -46,6 +46,9 @@ SFArtistRef SFArtistCreate(void)
     artist->ppemHeight = 0;
     artist->_retainCount = 1;
 
+    PairCacheClear(&artist->_pairCache);
+    DeltaCacheClear(&artist->_deltaCache);
+
     return artist;
 }
 
@@ -53,6 +56,9 @@ void SFArtistSetPPEMSizes(SFArtistRef artist, SFUInt16 ppemWidth, SFUInt16 ppemH
 {
     artist->ppemWidth = ppemWidth;
     artist->ppemHeight = ppemHeight;
+
+    /* The cached pixels were resolved for the previous sizes. */
+    DeltaCacheClear(&artist->_deltaCache);
 }
 
 void SFArtistSetString(SFArtistRef artist, SFStringEncoding stringEncoding, void *stringBuffer, SFUInteger stringLength)
@@ -63,6 +69,10 @@ void SFArtistSetString(SFArtistRef artist, SFStringEncoding stringEncoding, void
 void SFArtistSetPattern(SFArtistRef artist, SFPatternRef pattern)
 {
     artist->pattern = SFPatternRetain(pattern);
+
+    /* The cached records and pixels belong to the tables of previous pattern. */
+    PairCacheClear(&artist->_pairCache);
+    DeltaCacheClear(&artist->_deltaCache);
 }
 
 void SFArtistSetTextDirection(SFArtistRef artist, SFTextDirection textDirection)
@@ -21,6 +21,8 @@
 #include <SFArtist.h>
 
 #include "SFBase.h"
+#include "DeltaCache.h"
+#include "PairCache.h"
 #include "SFPattern.h"
 
 typedef struct _SFArtist {
@@ -30,6 +32,8 @@ typedef struct _SFArtist {
     SFTextMode textMode;
     SFUInt16 ppemWidth;
     SFUInt16 ppemHeight;
+    PairCache _pairCache;       /**< The pair records located with the current pattern. */
+    DeltaCache _deltaCache;     /**< The device pixels resolved with the current pattern and sizes. */
     SFUInteger _retainCount;
 } SFArtist;
 
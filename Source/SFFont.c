@@ -19,33 +19,439 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "SFAssert.h"
 #include "SFBase.h"
+#include "CharacterMap.h"
 #include "Data.h"
+#include "FontFile.h"
+#include "GDEF.h"
+#include "GlyphCache.h"
+#include "GlyphDefinitions.h"
+#include "LookupDigest.h"
+#include "Hash.h"
+#include "LayoutIndex.h"
+#include "List.h"
+#include "Metrics.h"
+#include "Mutex.h"
+#include "OpenType.h"
+#include "Sanitizer.h"
 #include "SFFont.h"
 
-static SFUInt8 *CopySFNTTable(const SFFontProtocol *protocol, void *object, SFTag tableTag) {
+/**
+ * The number of leading bytes of each table that are hashed into the cache key of a resource.
+ */
+#define CACHE_KEY_SAMPLE_LENGTH 64
+
+static Mutex ResourceCacheMutex = MUTEX_INITIALIZER;
+static LIST(FontResourceRef) ResourceCache;
+static SFBoolean ResourceCacheEnabled = SFFalse;
+static SFBoolean SanitizerEnabled = SFFalse;
+static Mutex FingerprintMutex = MUTEX_INITIALIZER;
+/**
+ * The mutex guarding the retain counts of all fonts, as the patterns shared by a pattern cache may
+ * retain and release their font on any thread.
+ */
+static Mutex FontRetainMutex = MUTEX_INITIALIZER;
+
+static void CopySFNTTable(FontResourceRef fontResource, SFTag tableTag, FontTableRef fontTable)
+{
+    SFFontProtocolLoadTableFunc loadTable = fontResource->loadTable;
+    void *object = fontResource->object;
     SFUInt8 *data = NULL;
     SFUInteger length = 0;
 
-    protocol->loadTable(object, tableTag, NULL, &length);
+    loadTable(object, tableTag, NULL, &length);
 
     if (length != 0) {
         data = malloc(length);
-        protocol->loadTable(object, tableTag, data, NULL);
+        loadTable(object, tableTag, data, NULL);
     }
 
-    return data;
+    fontTable->data = data;
+    fontTable->length = length;
 }
 
-static FontResourceRef CreateFontResource(const SFFontProtocol *protocol, void *object)
+static void BorrowSFNTTable(FontResourceRef fontResource, SFTag tableTag, FontTableRef fontTable)
+{
+    SFUInteger length = 0;
+    Data data = fontResource->getTablePointer(fontResource->object, tableTag, &length);
+
+    fontTable->data = data;
+    fontTable->length = (data ? length : 0);
+}
+
+static void InitializeFontTable(FontTableRef fontTable)
+{
+    fontTable->data = NULL;
+    fontTable->length = 0;
+    fontTable->lookupMask = NULL;
+    fontTable->digests = NULL;
+    fontTable->areDigestsBuilt = SFFalse;
+    fontTable->layoutIndex = NULL;
+    fontTable->isLayoutIndexBuilt = SFFalse;
+    fontTable->isLoaded = SFFalse;
+    fontTable->isReady = SFFalse;
+    fontTable->isSanitized = SFFalse;
+    fontTable->isRejected = SFFalse;
+}
+
+static FontResourceRef AllocateFontResource(void)
 {
     FontResourceRef fontResource = malloc(sizeof(FontResource));
+    fontResource->file = NULL;
+    fontResource->object = NULL;
+    fontResource->loadTable = NULL;
+    fontResource->getTablePointer = NULL;
+    fontResource->releaseTablePointer = NULL;
+    fontResource->glyphDefinitions = NULL;
+    fontResource->areGlyphDefinitionsBuilt = SFFalse;
+    fontResource->pairMatrices = NULL;
+    fontResource->isPairMatrixListCreated = SFFalse;
+    fontResource->isBorrowed = SFFalse;
+    fontResource->isCached = SFFalse;
+    fontResource->shouldSanitize = SanitizerEnabled;
+    fontResource->cacheKey = 0;
+    fontResource->hasFingerprint = SFFalse;
     fontResource->retainCount = 1;
 
-    /* Load the open type tables. */
-    fontResource->gdef = CopySFNTTable(protocol, object, TAG('G', 'D', 'E', 'F'));
-    fontResource->gsub = CopySFNTTable(protocol, object, TAG('G', 'S', 'U', 'B'));
-    fontResource->gpos = CopySFNTTable(protocol, object, TAG('G', 'P', 'O', 'S'));
+    InitializeFontTable(&fontResource->gdef);
+    InitializeFontTable(&fontResource->gsub);
+    InitializeFontTable(&fontResource->gpos);
+    MutexInitialize(&fontResource->loadMutex);
+
+    return fontResource;
+}
+
+static FontResourceRef CreateFontResource(const SFFontProtocol *protocol, void *object)
+{
+    FontResourceRef fontResource = AllocateFontResource();
+    fontResource->object = object;
+
+    /*
+     * The tables are only remembered how to be obtained here, and are loaded when they are needed
+     * for the first time.
+     */
+    if (protocol->getTablePointer) {
+        fontResource->getTablePointer = protocol->getTablePointer;
+        fontResource->releaseTablePointer = protocol->releaseTablePointer;
+        fontResource->isBorrowed = SFTrue;
+    } else {
+        fontResource->loadTable = protocol->loadTable;
+    }
+
+    return fontResource;
+}
+
+static void SearchSFNTTable(FontFileRef fontFile, SFUInteger faceIndex, SFTag tableTag, FontTableRef fontTable)
+{
+    InitializeFontTable(fontTable);
+    fontTable->data = FontFileSearchTable(fontFile, faceIndex, tableTag, &fontTable->length);
+    fontTable->isLoaded = SFTrue;
+}
+
+static FontResourceRef CreateFileResource(FontFileRef fontFile, SFUInteger faceIndex)
+{
+    FontResourceRef fontResource;
+    FontTable gdef;
+    FontTable gsub;
+    FontTable gpos;
+    SFUInteger index;
+
+    SearchSFNTTable(fontFile, faceIndex, TAG('G', 'D', 'E', 'F'), &gdef);
+    SearchSFNTTable(fontFile, faceIndex, TAG('G', 'S', 'U', 'B'), &gsub);
+    SearchSFNTTable(fontFile, faceIndex, TAG('G', 'P', 'O', 'S'), &gpos);
+
+    MutexLock(&fontFile->mutex);
+
+    /*
+     * Share the resource of another face referring to the same layout tables. The faces of a family
+     * usually differ in other tables only, which are kept by each face on its own.
+     */
+    for (index = 0; index < fontFile->resources.count; index++) {
+        fontResource = ListGetVal(&fontFile->resources, index);
+
+        if (fontResource->gdef.data == gdef.data
+            && fontResource->gsub.data == gsub.data
+            && fontResource->gpos.data == gpos.data
+            && fontResource->shouldSanitize == SanitizerEnabled) {
+            fontResource->retainCount++;
+            MutexUnlock(&fontFile->mutex);
+
+            return fontResource;
+        }
+    }
+
+    fontResource = AllocateFontResource();
+    fontResource->file = fontFile;
+    fontResource->isBorrowed = SFTrue;
+
+    /* Point the open type tables straight into the file as it costs nothing. */
+    fontResource->gdef = gdef;
+    fontResource->gsub = gsub;
+    fontResource->gpos = gpos;
+
+    ListAdd(&fontFile->resources, fontResource);
+
+    MutexUnlock(&fontFile->mutex);
+
+    /*
+     * Retain the file outside of its mutex. The resource cannot be destroyed by other faces in the
+     * meanwhile as this reference keeps it alive.
+     */
+    FontFileRetain(fontFile);
+
+    return fontResource;
+}
+
+static void SanitizeFontTable(SFTag tableTag, FontTableRef fontTable)
+{
+    Data data = fontTable->data;
+    SFUInteger length = fontTable->length;
+    SFBoolean isValid = SFTrue;
+
+    /* A missing table has nothing to be validated. */
+    if (data) {
+        switch (tableTag) {
+            case TAG('G', 'D', 'E', 'F'):
+                isValid = SanitizeGDEF(data, length);
+                break;
+
+            case TAG('G', 'S', 'U', 'B'):
+                isValid = SanitizeGSUB(data, length, &fontTable->lookupMask);
+                break;
+
+            case TAG('G', 'P', 'O', 'S'):
+                isValid = SanitizeGPOS(data, length, &fontTable->lookupMask);
+                break;
+        }
+    }
+
+    fontTable->isSanitized = SFTrue;
+    fontTable->isRejected = !isValid;
+}
+
+static Data GetFontTable(FontResourceRef fontResource, SFTag tableTag, FontTableRef fontTable)
+{
+    /*
+     * Take the lock only until the table is ready, so that the threads shaping with the same font
+     * do not contend with each other afterwards.
+     */
+    if (!FlagLoadAcquire(&fontTable->isReady)) {
+        MutexLock(&fontResource->loadMutex);
+
+        if (!fontTable->isLoaded) {
+            if (fontResource->getTablePointer) {
+                BorrowSFNTTable(fontResource, tableTag, fontTable);
+            } else {
+                CopySFNTTable(fontResource, tableTag, fontTable);
+            }
+
+            fontTable->isLoaded = SFTrue;
+        }
+
+        /* Validate the table only once, even if it is shared by several faces. */
+        if (fontResource->shouldSanitize && !fontTable->isSanitized) {
+            SanitizeFontTable(tableTag, fontTable);
+        }
+
+        FlagStoreRelease(&fontTable->isReady, SFTrue);
+
+        MutexUnlock(&fontResource->loadMutex);
+    }
+
+    return (fontTable->isRejected ? NULL : fontTable->data);
+}
+
+static void LoadAllFontTables(FontResourceRef fontResource)
+{
+    GetFontTable(fontResource, TAG('G', 'D', 'E', 'F'), &fontResource->gdef);
+    GetFontTable(fontResource, TAG('G', 'S', 'U', 'B'), &fontResource->gsub);
+    GetFontTable(fontResource, TAG('G', 'P', 'O', 'S'), &fontResource->gpos);
+}
+
+static void WriteUInt32(SFUInt8 *bytes, SFUInt32 value)
+{
+    bytes[0] = (SFUInt8)(value >> 24);
+    bytes[1] = (SFUInt8)(value >> 16);
+    bytes[2] = (SFUInt8)(value >> 8);
+    bytes[3] = (SFUInt8)(value >> 0);
+}
+
+static SFUInt32 HashBytes(SFUInt32 hash, const SFUInt8 *bytes, SFUInteger length)
+{
+    SFUInteger index;
+
+    /* Use FNV-1a as it is simple and good enough for distinguishing the fonts. */
+    for (index = 0; index < length; index++) {
+        hash ^= bytes[index];
+        hash *= 16777619;
+    }
+
+    return hash;
+}
+
+static SFUInt32 HashFontTable(SFUInt32 hash, FontTableRef fontTable)
+{
+    SFUInt8 lengthBytes[4];
+    SFUInteger sampleLength = fontTable->length;
+
+    WriteUInt32(lengthBytes, (SFUInt32)fontTable->length);
+
+    if (sampleLength > CACHE_KEY_SAMPLE_LENGTH) {
+        sampleLength = CACHE_KEY_SAMPLE_LENGTH;
+    }
+
+    hash = HashBytes(hash, lengthBytes, sizeof(lengthBytes));
+    hash = HashBytes(hash, fontTable->data, sampleLength);
+
+    return hash;
+}
+
+static SFUInt32 GetCacheKey(FontResourceRef fontResource)
+{
+    SFUInt32 hash = 2166136261U;
+
+    /*
+     * Only the lengths and the headers of the tables are hashed to keep the key cheap. The whole
+     * content is compared when the keys of two resources match.
+     */
+    hash = HashFontTable(hash, &fontResource->gdef);
+    hash = HashFontTable(hash, &fontResource->gsub);
+    hash = HashFontTable(hash, &fontResource->gpos);
+
+    return hash;
+}
+
+static SFBoolean IsSameFontTable(FontTableRef fontTable1, FontTableRef fontTable2)
+{
+    return fontTable1->length == fontTable2->length
+        && (fontTable1->data == fontTable2->data || fontTable1->length == 0
+            || memcmp(fontTable1->data, fontTable2->data, fontTable1->length) == 0);
+}
+
+static SFBoolean IsSameFontResource(FontResourceRef fontResource1, FontResourceRef fontResource2)
+{
+    return fontResource1->shouldSanitize == fontResource2->shouldSanitize
+        && IsSameFontTable(&fontResource1->gdef, &fontResource2->gdef)
+        && IsSameFontTable(&fontResource1->gsub, &fontResource2->gsub)
+        && IsSameFontTable(&fontResource1->gpos, &fontResource2->gpos);
+}
+
+/**
+ * Returns the index of the first resource in the cache whose key is not less than the given one.
+ */
+static SFUInteger SearchCachedResource(SFUInt32 cacheKey)
+{
+    SFUInteger low = 0;
+    SFUInteger high = ResourceCache.count;
+
+    while (low < high) {
+        SFUInteger mid = low + (high - low) / 2;
+
+        if (ResourceCache.items[mid]->cacheKey < cacheKey) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static void ReleaseFontTable(FontResourceRef fontResource, SFTag tableTag, FontTableRef fontTable)
+{
+    free(fontTable->lookupMask);
+
+    if (fontTable->digests) {
+        LookupDigestListDestroy(fontTable->digests);
+    }
+
+    if (fontTable->layoutIndex) {
+        LayoutIndexDestroy(fontTable->layoutIndex);
+    }
+
+    if (!fontTable->isLoaded) {
+        /* Nothing to release as the table was never used. */
+    } else if (!fontResource->isBorrowed) {
+        free((void *)fontTable->data);
+    } else if (fontTable->data && fontResource->releaseTablePointer) {
+        fontResource->releaseTablePointer(fontResource->object, tableTag, fontTable->data);
+    }
+}
+
+static void DestroyFontResource(FontResourceRef fontResource)
+{
+    ReleaseFontTable(fontResource, TAG('G', 'D', 'E', 'F'), &fontResource->gdef);
+    ReleaseFontTable(fontResource, TAG('G', 'S', 'U', 'B'), &fontResource->gsub);
+    ReleaseFontTable(fontResource, TAG('G', 'P', 'O', 'S'), &fontResource->gpos);
+
+    if (fontResource->glyphDefinitions) {
+        GlyphDefinitionsDestroy(fontResource->glyphDefinitions);
+    }
+    if (fontResource->pairMatrices) {
+        PairMatrixListDestroy(fontResource->pairMatrices);
+    }
+
+    /* The resource has already been removed from the list of the file. */
+    FontFileRelease(fontResource->file);
+
+    MutexFinalize(&fontResource->loadMutex);
+    free(fontResource);
+}
+
+/**
+ * Replaces the resource with an identical one from the global cache, or adds it to the cache if
+ * no such resource exists.
+ */
+static FontResourceRef ShareFontResource(FontResourceRef fontResource)
+{
+    SFUInt32 cacheKey = GetCacheKey(fontResource);
+    FontResourceRef cachedResource = NULL;
+    SFUInteger index;
+
+    MutexLock(&ResourceCacheMutex);
+
+    if (ResourceCache._itemSize == 0) {
+        ListInitialize(&ResourceCache, sizeof(FontResourceRef));
+    }
+
+    index = SearchCachedResource(cacheKey);
+
+    for (; index < ResourceCache.count; index++) {
+        FontResourceRef currentResource = ResourceCache.items[index];
+
+        if (currentResource->cacheKey != cacheKey) {
+            break;
+        }
+        if (IsSameFontResource(currentResource, fontResource)) {
+            cachedResource = currentResource;
+            cachedResource->retainCount++;
+            break;
+        }
+    }
+
+    if (!cachedResource) {
+        /*
+         * The resource may outlive the font creating it, so forget the object of that font. All the
+         * tables have already been loaded for the comparison, so nothing is obtained from it anymore.
+         */
+        SFAssert(fontResource->gdef.isReady && fontResource->gsub.isReady
+                 && fontResource->gpos.isReady);
+        fontResource->object = NULL;
+        fontResource->loadTable = NULL;
+
+        fontResource->isCached = SFTrue;
+        fontResource->cacheKey = cacheKey;
+
+        ListInsert(&ResourceCache, index, fontResource);
+    }
+
+    MutexUnlock(&ResourceCacheMutex);
+
+    if (cachedResource) {
+        DestroyFontResource(fontResource);
+        return cachedResource;
+    }
 
     return fontResource;
 }
@@ -53,7 +459,17 @@ static FontResourceRef CreateFontResource(const SFFontProtocol *protocol, void *
 static FontResourceRef RetainFontResource(FontResourceRef fontResource)
 {
     if (fontResource) {
-        fontResource->retainCount++;
+        if (fontResource->isCached) {
+            MutexLock(&ResourceCacheMutex);
+            fontResource->retainCount++;
+            MutexUnlock(&ResourceCacheMutex);
+        } else if (fontResource->file) {
+            MutexLock(&fontResource->file->mutex);
+            fontResource->retainCount++;
+            MutexUnlock(&fontResource->file->mutex);
+        } else {
+            fontResource->retainCount++;
+        }
     }
 
     return fontResource;
@@ -61,41 +477,246 @@ static FontResourceRef RetainFontResource(FontResourceRef fontResource)
 
 static void ReleaseFontResource(FontResourceRef fontResource)
 {
-    if (fontResource && --fontResource->retainCount == 0) {
-        free((void *)fontResource->gdef);
-        free((void *)fontResource->gsub);
-        free((void *)fontResource->gpos);
-        free(fontResource);
+    if (fontResource) {
+        SFBoolean isReleased;
+
+        if (fontResource->isCached) {
+            MutexLock(&ResourceCacheMutex);
+
+            isReleased = (--fontResource->retainCount == 0);
+
+            /* Evict the resource from the cache as no font is referring to it anymore. */
+            if (isReleased) {
+                SFUInteger index = ListIndexOfItem(&ResourceCache, &fontResource,
+                                                   0, ResourceCache.count);
+                ListRemoveAt(&ResourceCache, index);
+
+                if (ResourceCache.count == 0) {
+                    ListFinalize(&ResourceCache);
+                    ResourceCache._itemSize = 0;
+                }
+            }
+
+            MutexUnlock(&ResourceCacheMutex);
+        } else if (fontResource->file) {
+            FontFileRef fontFile = fontResource->file;
+
+            MutexLock(&fontFile->mutex);
+
+            isReleased = (--fontResource->retainCount == 0);
+
+            /* Stop sharing the resource with other faces before anyone else can find it. */
+            if (isReleased) {
+                SFUInteger index = ListIndexOfItem(&fontFile->resources, &fontResource,
+                                                   0, fontFile->resources.count);
+                ListRemoveAt(&fontFile->resources, index);
+            }
+
+            MutexUnlock(&fontFile->mutex);
+        } else {
+            isReleased = (--fontResource->retainCount == 0);
+        }
+
+        if (isReleased) {
+            DestroyFontResource(fontResource);
+        }
     }
 }
 
+/**
+ * Builds the advances of the default instance of a face along with validating its HVAR table.
+ */
+static SFAdvance *CreateFaceAdvanceArray(FontFileRef fontFile, SFUInteger faceIndex,
+    SFUInteger *outCount, Data *outHVAR)
+{
+    SFUInteger hheaLength;
+    SFUInteger hmtxLength;
+    SFUInteger maxpLength;
+    SFUInteger hvarLength;
+    Data hhea = FontFileSearchTable(fontFile, faceIndex, TAG('h', 'h', 'e', 'a'), &hheaLength);
+    Data hmtx = FontFileSearchTable(fontFile, faceIndex, TAG('h', 'm', 't', 'x'), &hmtxLength);
+    Data maxp = FontFileSearchTable(fontFile, faceIndex, TAG('m', 'a', 'x', 'p'), &maxpLength);
+    Data hvar = FontFileSearchTable(fontFile, faceIndex, TAG('H', 'V', 'A', 'R'), &hvarLength);
+
+    /* The deltas are applied without any checks, so HVAR table is always validated. */
+    if (hvar && !SanitizeHVAR(hvar, hvarLength)) {
+        hvar = NULL;
+    }
+
+    *outHVAR = hvar;
+
+    return CreateAdvanceArray(hhea, hheaLength, hmtx, hmtxLength, maxp, maxpLength, outCount);
+}
+
+static SFGlyphID ZeroGlyphID(void *object, SFCodepoint codepoint)
+{
+    return 0;
+}
+
 static SFInt32 ZeroGlyphAdvance(void *object, SFFontLayout fontLayout, SFGlyphID glyphID)
 {
     return 0;
 }
 
+static SFFontRef CreateFileFont(FontFileRef fontFile, SFUInteger faceIndex,
+    const SFFontProtocol *protocol, void *object)
+{
+    SFFontRef font = malloc(sizeof(SFFont));
+    font->object = object;
+    font->parent = NULL;
+    font->resource = CreateFileResource(fontFile, faceIndex);
+    font->characterMap = NULL;
+    font->glyphCache = NULL;
+    font->advanceArray = NULL;
+    font->advanceCount = 0;
+    font->ownsAdvanceArray = SFFalse;
+    font->hvarTable = NULL;
+    font->coordArray = NULL;
+    font->coordCount = 0;
+    font->regionScalars = NULL;
+    font->areRegionScalarsComputed = SFFalse;
+    font->retainCount = 1;
+
+    PatternCacheInitialize(&font->patternCache);
+
+    if (protocol) {
+        font->protocol = *protocol;
+    } else {
+        memset(&font->protocol, 0, sizeof(SFFontProtocol));
+    }
+
+    /* The tables are always taken from the file. */
+    font->protocol.loadTable = NULL;
+    font->protocol.getTablePointer = NULL;
+    font->protocol.releaseTablePointer = NULL;
+
+    /* Map the code points with the cmap table of the face if the protocol does not do it. */
+    if (!font->protocol.getGlyphIDForCodepoint && !font->protocol.getGlyphIDsForCodepoints) {
+        SFUInteger cmapLength;
+        Data cmap = FontFileSearchTable(fontFile, faceIndex, TAG('c', 'm', 'a', 'p'), &cmapLength);
+
+        font->characterMap = CharacterMapCreate(cmap, cmapLength);
+
+        if (!font->characterMap) {
+            font->protocol.getGlyphIDForCodepoint = ZeroGlyphID;
+        }
+    } else if (font->protocol.getGlyphIDForCodepoint) {
+        font->glyphCache = GlyphCacheCreate();
+    }
+    /* Take the advances from hmtx table of the face if the protocol does not provide them. */
+    if (!font->protocol.getAdvanceForGlyph && !font->protocol.getAdvancesForGlyphs) {
+        font->advanceArray = CreateFaceAdvanceArray(fontFile, faceIndex,
+                                                    &font->advanceCount, &font->hvarTable);
+        font->ownsAdvanceArray = SFTrue;
+
+        if (!font->advanceArray) {
+            font->protocol.getAdvanceForGlyph = ZeroGlyphAdvance;
+        }
+    }
+
+    return font;
+}
+
 SFFontRef SFFontCreateWithProtocol(const SFFontProtocol *protocol, void *object)
 {
     /* Verify that required functions exist in the protocol. */
-    if (protocol && protocol->loadTable && protocol->getGlyphIDForCodepoint) {
+    if (protocol && (protocol->loadTable || protocol->getTablePointer)
+        && (protocol->getGlyphIDForCodepoint || protocol->getGlyphIDsForCodepoints)) {
         SFFontRef font = malloc(sizeof(SFFont));
         font->protocol = *protocol;
         font->object = object;
+        font->parent = NULL;
         font->resource = CreateFontResource(protocol, object);
+        font->characterMap = NULL;
+        font->glyphCache = (protocol->getGlyphIDForCodepoint ? GlyphCacheCreate() : NULL);
+        font->advanceArray = NULL;
+        font->advanceCount = 0;
+        font->ownsAdvanceArray = SFFalse;
+        font->hvarTable = NULL;
         font->coordArray = NULL;
         font->coordCount = 0;
+        font->regionScalars = NULL;
+        font->areRegionScalarsComputed = SFFalse;
         font->retainCount = 1;
 
-        if (!font->protocol.getAdvanceForGlyph) {
+        PatternCacheInitialize(&font->patternCache);
+
+        if (!font->protocol.getAdvanceForGlyph && !font->protocol.getAdvancesForGlyphs) {
             font->protocol.getAdvanceForGlyph = ZeroGlyphAdvance;
         }
 
+        /* Borrowed tables are owned by the object, so only the copied ones can be shared. */
+        if (ResourceCacheEnabled && !font->resource->isBorrowed) {
+            /* The content is needed for comparison, so the tables cannot be loaded lazily. */
+            LoadAllFontTables(font->resource);
+            font->resource = ShareFontResource(font->resource);
+        }
+
+        return font;
+    }
+
+    return NULL;
+}
+
+void SFFontSetResourceCacheEnabled(SFBoolean enabled)
+{
+    ResourceCacheEnabled = enabled;
+}
+
+void SFFontSetSanitizerEnabled(SFBoolean enabled)
+{
+    SanitizerEnabled = enabled;
+}
+
+SFFontRef SFFontCreateWithFile(const char *filePath, const SFFontProtocol *protocol, void *object)
+{
+    if (filePath) {
+        FontFileRef fontFile = FontFileCreateWithPath(filePath);
+
+        if (fontFile) {
+            SFFontRef font = CreateFileFont(fontFile, 0, protocol, object);
+            FontFileRelease(fontFile);
+
+            return font;
+        }
+    }
+
+    return NULL;
+}
+
+SFFontRef SFFontCreateWithMemory(const void *buffer, SFUInteger length,
+    const SFFontProtocol *protocol, void *object)
+{
+    FontFileRef fontFile = FontFileCreateWithMemory(buffer, length);
+
+    if (fontFile) {
+        SFFontRef font = CreateFileFont(fontFile, 0, protocol, object);
+        FontFileRelease(fontFile);
+
         return font;
     }
 
     return NULL;
 }
 
+SFUInteger SFFontGetFaceCount(SFFontRef font)
+{
+    FontFileRef fontFile = font->resource->file;
+    return (fontFile ? fontFile->faceCount : 0);
+}
+
+SFFontRef SFFontCreateWithFace(SFFontRef font, SFUInteger faceIndex,
+    const SFFontProtocol *protocol, void *object)
+{
+    FontFileRef fontFile = font->resource->file;
+
+    if (fontFile && FontFileGetTableDirectory(fontFile, faceIndex)) {
+        return CreateFileFont(fontFile, faceIndex, protocol, object);
+    }
+
+    return NULL;
+}
+
 SFFontRef SFFontCreateWithVariationCoordinates(SFFontRef font, void *object,
     const SFInt16 *coordArray, SFUInteger coordCount)
 {
@@ -103,33 +724,422 @@ SFFontRef SFFontCreateWithVariationCoordinates(SFFontRef font, void *object,
         SFFontRef derivedFont = malloc(sizeof(SFFont));
         derivedFont->protocol = font->protocol;
         derivedFont->object = object;
+        derivedFont->parent = SFFontRetain(font);
         derivedFont->resource = RetainFontResource(font->resource);
+        derivedFont->characterMap = font->characterMap;
+        /* The glyphs are obtained with a different object, so the cache cannot be shared. */
+        derivedFont->glyphCache = (font->glyphCache ? GlyphCacheCreate() : NULL);
+        derivedFont->advanceArray = font->advanceArray;
+        derivedFont->advanceCount = font->advanceCount;
+        derivedFont->ownsAdvanceArray = SFFalse;
+        derivedFont->hvarTable = font->hvarTable;
         derivedFont->coordArray = malloc(sizeof(SFInt16) * coordCount);
         derivedFont->coordCount = coordCount;
+        derivedFont->regionScalars = NULL;
+        derivedFont->areRegionScalarsComputed = SFFalse;
         derivedFont->retainCount = 1;
 
+        PatternCacheInitialize(&derivedFont->patternCache);
+
         memcpy(derivedFont->coordArray, coordArray, sizeof(SFInt16) * coordCount);
 
+        /* Give the instance its own advances, varied from the ones of the default instance. */
+        if (derivedFont->advanceArray && derivedFont->hvarTable) {
+            SFFontRef faceFont = font;
+
+            /* The advances of the default instance are kept by the font of the face. */
+            while (faceFont->parent) {
+                faceFont = faceFont->parent;
+            }
+
+            derivedFont->advanceArray = CreateVariedAdvanceArray(
+                faceFont->advanceArray, faceFont->advanceCount,
+                derivedFont->hvarTable, coordArray, coordCount);
+            derivedFont->ownsAdvanceArray = SFTrue;
+        }
+
         return derivedFont;
     }
 
     return NULL;
 }
 
+static SFFontFingerprint ComputeResourceFingerprint(FontResourceRef fontResource)
+{
+    FontTableRef tables[3];
+    SFUInt8 digests[3 * 20];
+    SFFontFingerprint fingerprint;
+    SFUInteger index;
+
+    tables[0] = &fontResource->gdef;
+    tables[1] = &fontResource->gsub;
+    tables[2] = &fontResource->gpos;
+
+    /* Hash each table separately and then combine their lengths and hashes. */
+    for (index = 0; index < 3; index++) {
+        SFUInt8 *digest = &digests[index * 20];
+        SFUInt32 hash[4];
+
+        Hash128(tables[index]->data, tables[index]->length, (SFUInt32)index, hash);
+
+        WriteUInt32(digest + 0, (SFUInt32)tables[index]->length);
+        WriteUInt32(digest + 4, hash[0]);
+        WriteUInt32(digest + 8, hash[1]);
+        WriteUInt32(digest + 12, hash[2]);
+        WriteUInt32(digest + 16, hash[3]);
+    }
+
+    Hash128(digests, sizeof(digests), 0, fingerprint.words);
+
+    return fingerprint;
+}
+
+static SFFontFingerprint GetResourceFingerprint(FontResourceRef fontResource)
+{
+    SFFontFingerprint fingerprint;
+    SFBoolean hasFingerprint;
+
+    LoadAllFontTables(fontResource);
+
+    MutexLock(&FingerprintMutex);
+    fingerprint = fontResource->fingerprint;
+    hasFingerprint = fontResource->hasFingerprint;
+    MutexUnlock(&FingerprintMutex);
+
+    if (!hasFingerprint) {
+        /* Compute outside the lock as the tables might be large. */
+        fingerprint = ComputeResourceFingerprint(fontResource);
+
+        MutexLock(&FingerprintMutex);
+        fontResource->fingerprint = fingerprint;
+        fontResource->hasFingerprint = SFTrue;
+        MutexUnlock(&FingerprintMutex);
+    }
+
+    return fingerprint;
+}
+
+SFFontFingerprint SFFontGetFingerprint(SFFontRef font)
+{
+    SFFontFingerprint fingerprint = GetResourceFingerprint(font->resource);
+
+    if (font->coordCount > 0) {
+        SFUInteger length = 16 + (font->coordCount * 2);
+        SFUInt8 *bytes = malloc(length);
+        SFUInteger index;
+
+        for (index = 0; index < 4; index++) {
+            WriteUInt32(&bytes[index * 4], fingerprint.words[index]);
+        }
+
+        for (index = 0; index < font->coordCount; index++) {
+            SFUInt16 coord = (SFUInt16)font->coordArray[index];
+
+            bytes[16 + (index * 2) + 0] = (SFUInt8)(coord >> 8);
+            bytes[16 + (index * 2) + 1] = (SFUInt8)(coord >> 0);
+        }
+
+        Hash128(bytes, length, 0, fingerprint.words);
+        free(bytes);
+    }
+
+    return fingerprint;
+}
+
+SF_INTERNAL Data SFFontGetGDEFTable(SFFontRef font)
+{
+    return GetFontTable(font->resource, TAG('G', 'D', 'E', 'F'), &font->resource->gdef);
+}
+
+SF_INTERNAL GlyphDefinitionsRef SFFontGetGlyphDefinitions(SFFontRef font)
+{
+    FontResourceRef fontResource = font->resource;
+    GlyphDefinitionsRef glyphDefinitions;
+    /* Load the table before taking the lock as loading takes it as well. */
+    Data gdef = SFFontGetGDEFTable(font);
+
+    if (!FlagLoadAcquire(&fontResource->areGlyphDefinitionsBuilt)) {
+        MutexLock(&fontResource->loadMutex);
+
+        if (!fontResource->areGlyphDefinitionsBuilt) {
+            fontResource->glyphDefinitions = GlyphDefinitionsCreate(gdef, fontResource->gdef.length);
+            FlagStoreRelease(&fontResource->areGlyphDefinitionsBuilt, SFTrue);
+        }
+
+        MutexUnlock(&fontResource->loadMutex);
+    }
+
+    glyphDefinitions = fontResource->glyphDefinitions;
+
+    return glyphDefinitions;
+}
+
+SF_INTERNAL const VarScalar *SFFontGetRegionScalars(SFFontRef font)
+{
+    FontResourceRef fontResource = font->resource;
+    const VarScalar *regionScalars;
+    /* Load the table before taking the lock as loading takes it as well. */
+    Data gdef = SFFontGetGDEFTable(font);
+
+    if (!FlagLoadAcquire(&font->areRegionScalarsComputed)) {
+        MutexLock(&fontResource->loadMutex);
+
+        /* The scalars depend on the instance only, so compute them once for all deltas. */
+        if (!font->areRegionScalarsComputed) {
+            Data varStore = (gdef ? GDEF_ItemVarStoreTable(gdef) : NULL);
+
+            if (varStore) {
+                font->regionScalars = CreateRegionScalars(varStore, font->coordArray, font->coordCount);
+            }
+            FlagStoreRelease(&font->areRegionScalarsComputed, SFTrue);
+        }
+
+        MutexUnlock(&fontResource->loadMutex);
+    }
+
+    regionScalars = font->regionScalars;
+
+    return regionScalars;
+}
+
+SF_INTERNAL Data SFFontGetGSUBTable(SFFontRef font)
+{
+    return GetFontTable(font->resource, TAG('G', 'S', 'U', 'B'), &font->resource->gsub);
+}
+
+SF_INTERNAL Data SFFontGetGPOSTable(SFFontRef font)
+{
+    return GetFontTable(font->resource, TAG('G', 'P', 'O', 'S'), &font->resource->gpos);
+}
+
+static LookupDigestListRef GetLookupDigests(FontResourceRef fontResource,
+    Data table, FontTableRef fontTable, SFBoolean isGPOS)
+{
+    LookupDigestListRef digests;
+
+    if (!FlagLoadAcquire(&fontTable->areDigestsBuilt)) {
+        MutexLock(&fontResource->loadMutex);
+
+        if (!fontTable->areDigestsBuilt) {
+            fontTable->digests = LookupDigestListCreate(table, fontTable->length, isGPOS);
+            FlagStoreRelease(&fontTable->areDigestsBuilt, SFTrue);
+        }
+
+        MutexUnlock(&fontResource->loadMutex);
+    }
+
+    digests = fontTable->digests;
+
+    return digests;
+}
+
+SF_INTERNAL LookupDigestListRef SFFontGetGSUBDigests(SFFontRef font)
+{
+    Data gsub = SFFontGetGSUBTable(font);
+    return GetLookupDigests(font->resource, gsub, &font->resource->gsub, SFFalse);
+}
+
+SF_INTERNAL LookupDigestListRef SFFontGetGPOSDigests(SFFontRef font)
+{
+    Data gpos = SFFontGetGPOSTable(font);
+    return GetLookupDigests(font->resource, gpos, &font->resource->gpos, SFTrue);
+}
+
+static LayoutIndexRef GetLayoutIndex(FontResourceRef fontResource, Data table, FontTableRef fontTable)
+{
+    LayoutIndexRef layoutIndex;
+
+    if (!FlagLoadAcquire(&fontTable->isLayoutIndexBuilt)) {
+        MutexLock(&fontResource->loadMutex);
+
+        if (!fontTable->isLayoutIndexBuilt) {
+            fontTable->layoutIndex = LayoutIndexCreate(table, fontTable->length);
+            FlagStoreRelease(&fontTable->isLayoutIndexBuilt, SFTrue);
+        }
+
+        MutexUnlock(&fontResource->loadMutex);
+    }
+
+    layoutIndex = fontTable->layoutIndex;
+
+    return layoutIndex;
+}
+
+SF_INTERNAL LayoutIndexRef SFFontGetGSUBLayoutIndex(SFFontRef font)
+{
+    Data gsub = SFFontGetGSUBTable(font);
+    return GetLayoutIndex(font->resource, gsub, &font->resource->gsub);
+}
+
+SF_INTERNAL LayoutIndexRef SFFontGetGPOSLayoutIndex(SFFontRef font)
+{
+    Data gpos = SFFontGetGPOSTable(font);
+    return GetLayoutIndex(font->resource, gpos, &font->resource->gpos);
+}
+
+SF_INTERNAL PairMatrixListRef SFFontGetPairMatrixList(SFFontRef font)
+{
+    FontResourceRef fontResource = font->resource;
+    /* Load the table before taking the lock as loading takes it as well. */
+    Data gpos = SFFontGetGPOSTable(font);
+
+    if (!FlagLoadAcquire(&fontResource->isPairMatrixListCreated)) {
+        MutexLock(&fontResource->loadMutex);
+
+        if (!fontResource->isPairMatrixListCreated) {
+            if (gpos) {
+                fontResource->pairMatrices = PairMatrixListCreate(gpos, fontResource->gpos.length);
+            }
+            FlagStoreRelease(&fontResource->isPairMatrixListCreated, SFTrue);
+        }
+
+        MutexUnlock(&fontResource->loadMutex);
+    }
+
+    return fontResource->pairMatrices;
+}
+
+SF_INTERNAL const SFUInt8 *SFFontGetGSUBLookupMask(SFFontRef font)
+{
+    SFFontGetGSUBTable(font);
+    return font->resource->gsub.lookupMask;
+}
+
+SF_INTERNAL const SFUInt8 *SFFontGetGPOSLookupMask(SFFontRef font)
+{
+    SFFontGetGPOSTable(font);
+    return font->resource->gpos.lookupMask;
+}
+
+static SFGlyphID GetCachedGlyphID(SFFontRef font, SFCodepoint codepoint)
+{
+    GlyphCacheRef glyphCache = font->glyphCache;
+    SFGlyphID glyphID;
+
+    if (!GlyphCacheLookup(glyphCache, codepoint, &glyphID)) {
+        glyphID = font->protocol.getGlyphIDForCodepoint(font->object, codepoint);
+        GlyphCacheStore(glyphCache, codepoint, glyphID);
+    }
+
+    return glyphID;
+}
+
 SF_INTERNAL SFGlyphID SFFontGetGlyphIDForCodepoint(SFFontRef font, SFCodepoint codepoint)
 {
-    return font->protocol.getGlyphIDForCodepoint(font->object, codepoint);
+    SFGlyphID glyphID;
+
+    if (font->characterMap) {
+        return CharacterMapGetGlyphID(font->characterMap, codepoint);
+    }
+    if (font->glyphCache) {
+        return GetCachedGlyphID(font, codepoint);
+    }
+    if (font->protocol.getGlyphIDForCodepoint) {
+        return font->protocol.getGlyphIDForCodepoint(font->object, codepoint);
+    }
+
+    font->protocol.getGlyphIDsForCodepoints(font->object, &codepoint, &glyphID, 1);
+
+    return glyphID;
+}
+
+SF_INTERNAL void SFFontGetGlyphIDsForCodepoints(SFFontRef font,
+    const SFCodepoint *codepoints, SFGlyphID *glyphIDs, SFUInteger count)
+{
+    if (font->characterMap) {
+        CharacterMapRef characterMap = font->characterMap;
+        SFUInteger index;
+
+        for (index = 0; index < count; index++) {
+            glyphIDs[index] = CharacterMapGetGlyphID(characterMap, codepoints[index]);
+        }
+    } else if (font->protocol.getGlyphIDsForCodepoints) {
+        font->protocol.getGlyphIDsForCodepoints(font->object, codepoints, glyphIDs, count);
+    } else if (font->glyphCache) {
+        SFUInteger index;
+
+        for (index = 0; index < count; index++) {
+            glyphIDs[index] = GetCachedGlyphID(font, codepoints[index]);
+        }
+    } else {
+        SFFontProtocolGetGlyphIDForCodepointFunc getGlyphID = font->protocol.getGlyphIDForCodepoint;
+        void *object = font->object;
+        SFUInteger index;
+
+        for (index = 0; index < count; index++) {
+            glyphIDs[index] = getGlyphID(object, codepoints[index]);
+        }
+    }
+}
+
+SF_INTERNAL SFGlyphID SFFontGetGlyphIDForVariation(SFFontRef font,
+    SFCodepoint codepoint, SFCodepoint variationSelector)
+{
+    if (font->characterMap) {
+        return CharacterMapGetVariantGlyphID(font->characterMap, codepoint, variationSelector);
+    }
+
+    return 0;
 }
 
 SF_INTERNAL SFAdvance SFFontGetAdvanceForGlyph(SFFontRef font, SFFontLayout fontLayout, SFGlyphID glyphID)
 {
-    return font->protocol.getAdvanceForGlyph(font->object, fontLayout, glyphID);
+    SFAdvance advance;
+
+    if (font->advanceArray) {
+        /* Only the horizontal advances are known to the built-in metrics. */
+        if (fontLayout == SFFontLayoutHorizontal && glyphID < font->advanceCount) {
+            return font->advanceArray[glyphID];
+        }
+
+        return 0;
+    }
+    if (font->protocol.getAdvanceForGlyph) {
+        return font->protocol.getAdvanceForGlyph(font->object, fontLayout, glyphID);
+    }
+
+    font->protocol.getAdvancesForGlyphs(font->object, fontLayout, &glyphID, &advance, 1);
+
+    return advance;
+}
+
+SF_INTERNAL void SFFontGetAdvancesForGlyphs(SFFontRef font, SFFontLayout fontLayout,
+    const SFGlyphID *glyphIDs, SFAdvance *advances, SFUInteger count)
+{
+    if (font->protocol.getAdvancesForGlyphs) {
+        font->protocol.getAdvancesForGlyphs(font->object, fontLayout, glyphIDs, advances, count);
+    } else if (font->advanceArray && fontLayout == SFFontLayoutHorizontal) {
+        const SFAdvance *advanceArray = font->advanceArray;
+        SFUInteger advanceCount = font->advanceCount;
+        SFUInteger index;
+
+        for (index = 0; index < count; index++) {
+            SFGlyphID glyphID = glyphIDs[index];
+            advances[index] = (glyphID < advanceCount ? advanceArray[glyphID] : 0);
+        }
+    } else {
+        SFUInteger index;
+
+        for (index = 0; index < count; index++) {
+            advances[index] = SFFontGetAdvanceForGlyph(font, fontLayout, glyphIDs[index]);
+        }
+    }
+}
+
+void SFFontGetGlyphCacheStatistics(SFFontRef font, SFUInteger *hitCount, SFUInteger *missCount)
+{
+    GlyphCacheRef glyphCache = font->glyphCache;
+
+    *hitCount = (glyphCache ? glyphCache->hitCount : 0);
+    *missCount = (glyphCache ? glyphCache->missCount : 0);
 }
 
 SFFontRef SFFontRetain(SFFontRef font)
 {
     if (font) {
+        MutexLock(&FontRetainMutex);
         font->retainCount++;
+        MutexUnlock(&FontRetainMutex);
     }
 
     return font;
@@ -137,12 +1147,39 @@ SFFontRef SFFontRetain(SFFontRef font)
 
 void SFFontRelease(SFFontRef font)
 {
-    if (font && --font->retainCount == 0) {
+    SFBoolean isReleased = SFFalse;
+
+    if (font) {
+        MutexLock(&FontRetainMutex);
+        isReleased = (--font->retainCount == 0);
+        MutexUnlock(&FontRetainMutex);
+    }
+
+    if (isReleased) {
+        /* Only the cache holds the cached patterns by now, so let them go before anything else. */
+        PatternCacheFinalize(&font->patternCache);
+
+        /* Release the resource first as it may still be referring to the object. */
+        ReleaseFontResource(font->resource);
+
         if (font->protocol.finalize) {
             font->protocol.finalize(font->object);
         }
 
-        ReleaseFontResource(font->resource);
+        if (font->glyphCache) {
+            GlyphCacheDestroy(font->glyphCache);
+        }
+        if (font->ownsAdvanceArray) {
+            free(font->advanceArray);
+        }
+        /* The derived fonts borrow the character map of their parent. */
+        if (font->characterMap && !font->parent) {
+            CharacterMapDestroy(font->characterMap);
+        }
+
+        SFFontRelease(font->parent);
+        free(font->coordArray);
+        free(font->regionScalars);
         free(font);
     }
 }
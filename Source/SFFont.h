@@ -21,25 +21,164 @@
 #include <SFFont.h>
 
 #include "SFBase.h"
+#include "CharacterMap.h"
 #include "Data.h"
+#include "FontFile.h"
+#include "GlyphCache.h"
+#include "GlyphDefinitions.h"
+#include "LayoutIndex.h"
+#include "LookupDigest.h"
+#include "Mutex.h"
+#include "OpenType.h"
+#include "PairMatrix.h"
+#include "PatternCache.h"
+
+typedef struct _FontTable {
+    Data data;                  /**< The data of the table, NULL if the font does not contain it. */
+    SFUInteger length;          /**< The length of the table in bytes. */
+    SFUInt8 *lookupMask;        /**< The bit set of usable lookups, if validated by the sanitizer. */
+    LookupDigestListRef digests; /**< The glyph digests of the lookups, if built already. */
+    SFBoolean areDigestsBuilt;  /**< Whether the digests of the lookups have been built. */
+    LayoutIndexRef layoutIndex; /**< The index of the script list, if built already. */
+    SFBoolean isLayoutIndexBuilt; /**< Whether the index of the script list has been built. */
+    SFBoolean isLoaded;         /**< Whether the table has been loaded from the object or file. */
+    SFBoolean isReady;          /**< Whether the table has been loaded and validated if needed. */
+    SFBoolean isSanitized;      /**< Whether the table has been validated by the sanitizer. */
+    SFBoolean isRejected;       /**< Whether the sanitizer has found the table malformed. */
+} FontTable, *FontTableRef;
 
 typedef struct _FontResource {
-    Data gdef;
-    Data gsub;
-    Data gpos;
+    FontTable gdef;
+    FontTable gsub;
+    FontTable gpos;
+    GlyphDefinitionsRef glyphDefinitions; /**< The dense classes and mark sets of GDEF table, if any. */
+    SFBoolean areGlyphDefinitionsBuilt; /**< Whether the glyph definitions have been built already. */
+    PairMatrixListRef pairMatrices; /**< The compiled pair subtables of GPOS table, if any. */
+    SFBoolean isPairMatrixListCreated; /**< Whether the list of compiled pair subtables has been created. */
+    FontFileRef file;           /**< The file from which the tables were obtained. */
+    void *object;               /**< The object from which the tables are obtained. */
+    SFFontProtocolLoadTableFunc loadTable;
+    SFFontProtocolGetTablePointerFunc getTablePointer;
+    SFFontProtocolReleaseTablePointerFunc releaseTablePointer;
+    Mutex loadMutex;            /**< The mutex guarding the lazy loading of the tables. */
+    SFBoolean isBorrowed;       /**< Whether the tables are borrowed from the object or copied. */
+    SFBoolean isCached;         /**< Whether the resource is kept in the global resource cache. */
+    SFBoolean shouldSanitize;   /**< Whether the tables are validated when they are loaded. */
+    SFUInt32 cacheKey;          /**< The key of the resource in the global resource cache. */
+    SFFontFingerprint fingerprint; /**< The hash of the tables, valid if computed already. */
+    SFBoolean hasFingerprint;   /**< Whether the hash of the tables has been computed. */
     SFUInteger retainCount;
 } FontResource, *FontResourceRef;
 
 typedef struct _SFFont {
     SFFontProtocol protocol;
     void *object;
+    SFFontRef parent;
     FontResourceRef resource;
+    CharacterMapRef characterMap; /**< The built-in character map, owned by the font of the face. */
+    GlyphCacheRef glyphCache;   /**< The cache in front of the glyph function of the protocol, if any. */
+    SFAdvance *advanceArray;    /**< The built-in advances, used if the protocol has no advance function. */
+    SFUInteger advanceCount;    /**< The number of glyphs in the built-in advance array. */
+    SFBoolean ownsAdvanceArray; /**< Whether the advances are owned by this font instead of its parent. */
+    Data hvarTable;             /**< The validated HVAR table of the face, used for varying the advances. */
     SFInt16 *coordArray;
     SFUInteger coordCount;
+    VarScalar *regionScalars;   /**< The scalars of GDEF variation regions for this instance, if computed. */
+    SFBoolean areRegionScalarsComputed; /**< Whether the region scalars have been computed. */
+    PatternCache patternCache;  /**< The patterns built for this font, if the cache is enabled. */
     SFUInteger retainCount;
 } SFFont;
 
+/**
+ * Returns the GDEF table of the font, loading it on first use. The returned data is NULL if the
+ * font does not contain the table.
+ */
+SF_INTERNAL Data SFFontGetGDEFTable(SFFontRef font);
+
+/**
+ * Returns the dense glyph classes and mark glyph sets of GDEF table, building them on first use.
+ * The returned definitions are NULL if the font does not contain the table or it is malformed.
+ */
+SF_INTERNAL GlyphDefinitionsRef SFFontGetGlyphDefinitions(SFFontRef font);
+
+/**
+ * Returns the scalars of the variation regions of GDEF table for the instance of the font,
+ * computing them on first use. The returned scalars are NULL if the font has no variation store,
+ * or the format of the store is unknown.
+ */
+SF_INTERNAL const VarScalar *SFFontGetRegionScalars(SFFontRef font);
+
+/**
+ * Returns the GSUB table of the font, loading it on first use.
+ */
+SF_INTERNAL Data SFFontGetGSUBTable(SFFontRef font);
+
+/**
+ * Returns the GPOS table of the font, loading it on first use.
+ */
+SF_INTERNAL Data SFFontGetGPOSTable(SFFontRef font);
+
+/**
+ * Returns the glyph digests of GSUB lookups, building them on first use, or NULL if the font does
+ * not contain the table.
+ */
+SF_INTERNAL LookupDigestListRef SFFontGetGSUBDigests(SFFontRef font);
+
+/**
+ * Returns the glyph digests of GPOS lookups, building them on first use.
+ */
+SF_INTERNAL LookupDigestListRef SFFontGetGPOSDigests(SFFontRef font);
+
+/**
+ * Returns the index of GSUB scripts, languages and features, building it on first use, or NULL if
+ * the font does not contain the table or its lists cannot be read.
+ */
+SF_INTERNAL LayoutIndexRef SFFontGetGSUBLayoutIndex(SFFontRef font);
+
+/**
+ * Returns the index of GPOS scripts, languages and features, building it on first use.
+ */
+SF_INTERNAL LayoutIndexRef SFFontGetGPOSLayoutIndex(SFFontRef font);
+
+/**
+ * Returns the list of compiled PairPos format 2 subtables of GPOS table, or NULL if the table is
+ * not available. The lookups of the list are compiled on first use.
+ */
+SF_INTERNAL PairMatrixListRef SFFontGetPairMatrixList(SFFontRef font);
+
+/**
+ * Returns the bit set of GSUB lookups that passed the sanitizer, or NULL if the table has not been
+ * validated. The lookup indexes of a validated table are guaranteed to be in range.
+ */
+SF_INTERNAL const SFUInt8 *SFFontGetGSUBLookupMask(SFFontRef font);
+
+/**
+ * Returns the bit set of GPOS lookups that passed the sanitizer, or NULL if the table has not been
+ * validated.
+ */
+SF_INTERNAL const SFUInt8 *SFFontGetGPOSLookupMask(SFFontRef font);
+
 SF_INTERNAL SFGlyphID SFFontGetGlyphIDForCodepoint(SFFontRef font, SFCodepoint codepoint);
+
+/**
+ * Maps the given code points into glyph IDs, with a single call to the font protocol if possible.
+ */
+SF_INTERNAL void SFFontGetGlyphIDsForCodepoints(SFFontRef font,
+    const SFCodepoint *codepoints, SFGlyphID *glyphIDs, SFUInteger count);
+
+/**
+ * Returns the glyph of a variation sequence, or zero if the font does not support the sequence.
+ * Only the built-in character map knows about the variation sequences.
+ */
+SF_INTERNAL SFGlyphID SFFontGetGlyphIDForVariation(SFFontRef font,
+    SFCodepoint codepoint, SFCodepoint variationSelector);
+
 SF_INTERNAL SFAdvance SFFontGetAdvanceForGlyph(SFFontRef font, SFFontLayout fontLayout, SFGlyphID glyphID);
 
+/**
+ * Gets the advances of the given glyphs, with a single call to the font protocol if possible.
+ */
+SF_INTERNAL void SFFontGetAdvancesForGlyphs(SFFontRef font, SFFontLayout fontLayout,
+    const SFGlyphID *glyphIDs, SFAdvance *advances, SFUInteger count);
+
 #endif
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SF_INTERNAL_SFNT_H
+#define _SF_INTERNAL_SFNT_H
+
+#include "Data.h"
+#include "SFBase.h"
+
+/**************************************TTC HEADER (COLLECTION)*************************************/
+
+#define TTCHeader_TTCTag(data)                          Data_UInt32(data, 0)
+#define TTCHeader_MajorVersion(data)                    Data_UInt16(data, 4)
+#define TTCHeader_MinorVersion(data)                    Data_UInt16(data, 6)
+#define TTCHeader_NumFonts(data)                        Data_UInt32(data, 8)
+#define TTCHeader_TableDirectoryOffset(data, index)     Data_UInt32(data, 12 + ((index) * 4))
+#define TTCHeader_Size(numFonts)                        (12 + ((numFonts) * 4))
+
+/**************************************************************************************************/
+
+/*****************************************TABLE DIRECTORY******************************************/
+
+#define TableDirectory_SFNTVersion(data)                Data_UInt32(data, 0)
+#define TableDirectory_NumTables(data)                  Data_UInt16(data, 4)
+#define TableDirectory_SearchRange(data)                Data_UInt16(data, 6)
+#define TableDirectory_EntrySelector(data)              Data_UInt16(data, 8)
+#define TableDirectory_RangeShift(data)                 Data_UInt16(data, 10)
+#define TableDirectory_TableRecord(data, index)         Data_Subdata(data, 12 + ((index) * 16))
+#define TableDirectory_Size(numTables)                  (12 + ((numTables) * 16))
+
+#define TableRecord_TableTag(data)                      Data_UInt32(data, 0)
+#define TableRecord_CheckSum(data)                      Data_UInt32(data, 4)
+#define TableRecord_Offset(data)                        Data_UInt32(data, 8)
+#define TableRecord_Length(data)                        Data_UInt32(data, 12)
+
+/**************************************************************************************************/
+
+#endif
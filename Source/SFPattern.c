@@ -21,8 +21,41 @@
 #include <string.h>
 
 #include "SFBase.h"
+#include "Data.h"
+#include "Mutex.h"
+#include "SFFont.h"
 #include "SFPattern.h"
 
+/*
+ * The image of a pattern is made of a header followed by the feature tags, the feature units and
+ * the lookups of all units, each written in big endian byte order.
+ */
+#define PatternBlob_Version                 1
+
+#define BlobHeader_Size                     48
+#define BlobHeader_Magic(data)              Data_UInt32(data, 0)
+#define BlobHeader_Version(data)            Data_UInt16(data, 4)
+#define BlobHeader_Direction(data)          Data_UInt16(data, 6)
+#define BlobHeader_Fingerprint(data, index) Data_UInt32(data, 8 + ((index) * 4))
+#define BlobHeader_ScriptTag(data)          Data_UInt32(data, 24)
+#define BlobHeader_LanguageTag(data)        Data_UInt32(data, 28)
+#define BlobHeader_FeatureCount(data)       Data_UInt32(data, 32)
+#define BlobHeader_GSUBUnitCount(data)      Data_UInt32(data, 36)
+#define BlobHeader_GPOSUnitCount(data)      Data_UInt32(data, 40)
+#define BlobHeader_LookupCount(data)        Data_UInt32(data, 44)
+
+#define BlobUnit_Size                       16
+#define BlobUnit_LookupCount(data)          Data_UInt32(data, 0)
+#define BlobUnit_RangeStart(data)           Data_UInt32(data, 4)
+#define BlobUnit_RangeCount(data)           Data_UInt32(data, 8)
+#define BlobUnit_Mask(data)                 Data_UInt16(data, 12)
+
+#define BlobLookup_Size                     4
+#define BlobLookup_Index(data)              Data_UInt16(data, 0)
+#define BlobLookup_Value(data)              Data_UInt16(data, 2)
+
+static Mutex SharedPatternMutex = MUTEX_INITIALIZER;
+
 SF_INTERNAL SFPatternRef SFPatternCreate(void)
 {
     SFPatternRef pattern = malloc(sizeof(SFPattern));
@@ -36,10 +69,17 @@ SF_INTERNAL SFPatternRef SFPatternCreate(void)
     pattern->languageTag = 0;
     pattern->defaultDirection = SFTextDirectionLeftToRight;
     pattern->_retainCount = 1;
+    pattern->_isShared = SFFalse;
+    pattern->_isPacked = SFFalse;
 
     return pattern;
 }
 
+SF_INTERNAL void SFPatternMarkShared(SFPatternRef pattern)
+{
+    pattern->_isShared = SFTrue;
+}
+
 static void FinalizeFeatureUnit(SFFeatureUnitRef featureUnit)
 {
     free(featureUnit->lookups.items);
@@ -47,15 +87,43 @@ static void FinalizeFeatureUnit(SFFeatureUnitRef featureUnit)
 
 static void SFPatternFinalize(SFPatternRef pattern)
 {
-    SFUInteger featureCount = pattern->featureUnits.gsub + pattern->featureUnits.gpos;
-    SFUInteger index;
+    /*
+     * A shared pattern is finalized by the cache of its font, which has already given up the
+     * reference of the pattern to the font.
+     */
+    if (!pattern->_isShared) {
+        SFFontRelease(pattern->font);
+    }
 
-    /* Finalize all feature units. */
-    for (index = 0; index < featureCount; index++) {
-        FinalizeFeatureUnit((SFFeatureUnitRef)&pattern->featureUnits.items[index]);
+    if (!pattern->_isPacked) {
+        SFUInteger featureCount = pattern->featureUnits.gsub + pattern->featureUnits.gpos;
+        SFUInteger index;
+
+        /* Finalize all feature units. */
+        for (index = 0; index < featureCount; index++) {
+            FinalizeFeatureUnit((SFFeatureUnitRef)&pattern->featureUnits.items[index]);
+        }
+
+        free(pattern->featureUnits.items);
+        free(pattern->featureTags.items);
     }
 
-    free(pattern->featureUnits.items);
+    /* The arrays of a packed pattern are placed in the same block. */
+    free(pattern);
+}
+
+static void WriteBlobUInt16(SFUInt8 *bytes, SFUInt16 value)
+{
+    bytes[0] = (SFUInt8)(value >> 8);
+    bytes[1] = (SFUInt8)(value >> 0);
+}
+
+static void WriteBlobUInt32(SFUInt8 *bytes, SFUInt32 value)
+{
+    bytes[0] = (SFUInt8)(value >> 24);
+    bytes[1] = (SFUInt8)(value >> 16);
+    bytes[2] = (SFUInt8)(value >> 8);
+    bytes[3] = (SFUInt8)(value >> 0);
 }
 
 SFFontRef SFPatternGetFont(SFPatternRef pattern)
@@ -83,10 +151,242 @@ void SFPatternGetFeatureTags(SFPatternRef pattern, SFTag *buffer)
     memcpy(buffer, pattern->featureTags.items, sizeof(SFTag) * pattern->featureTags.count);
 }
 
+SFUInteger SFPatternSerialize(SFPatternRef pattern, void *buffer, SFUInteger capacity)
+{
+    SFUInteger featureCount = pattern->featureTags.count;
+    SFUInteger unitCount = pattern->featureUnits.gsub + pattern->featureUnits.gpos;
+    SFUInteger lookupCount = 0;
+    SFUInteger length;
+    SFUInteger index;
+
+    for (index = 0; index < unitCount; index++) {
+        lookupCount += pattern->featureUnits.items[index].lookups.count;
+    }
+
+    length = BlobHeader_Size
+           + (featureCount * sizeof(SFUInt32))
+           + (unitCount * BlobUnit_Size)
+           + (lookupCount * BlobLookup_Size);
+
+    if (buffer && capacity >= length) {
+        SFFontFingerprint fingerprint = SFFontGetFingerprint(pattern->font);
+        SFUInt8 *bytes = buffer;
+        SFUInt8 *unitBytes;
+        SFUInt8 *lookupBytes;
+
+        WriteBlobUInt32(&bytes[0], TAG('S', 'F', 'P', 'T'));
+        WriteBlobUInt16(&bytes[4], PatternBlob_Version);
+        WriteBlobUInt16(&bytes[6], (SFUInt16)pattern->defaultDirection);
+
+        for (index = 0; index < 4; index++) {
+            WriteBlobUInt32(&bytes[8 + (index * 4)], fingerprint.words[index]);
+        }
+
+        WriteBlobUInt32(&bytes[24], pattern->scriptTag);
+        WriteBlobUInt32(&bytes[28], pattern->languageTag);
+        WriteBlobUInt32(&bytes[32], (SFUInt32)featureCount);
+        WriteBlobUInt32(&bytes[36], (SFUInt32)pattern->featureUnits.gsub);
+        WriteBlobUInt32(&bytes[40], (SFUInt32)pattern->featureUnits.gpos);
+        WriteBlobUInt32(&bytes[44], (SFUInt32)lookupCount);
+
+        for (index = 0; index < featureCount; index++) {
+            WriteBlobUInt32(&bytes[BlobHeader_Size + (index * 4)], pattern->featureTags.items[index]);
+        }
+
+        unitBytes = &bytes[BlobHeader_Size + (featureCount * 4)];
+        lookupBytes = &unitBytes[unitCount * BlobUnit_Size];
+
+        for (index = 0; index < unitCount; index++) {
+            SFFeatureUnitRef featureUnit = &pattern->featureUnits.items[index];
+            SFUInteger lookupIndex;
+
+            WriteBlobUInt32(&unitBytes[0], (SFUInt32)featureUnit->lookups.count);
+            WriteBlobUInt32(&unitBytes[4], (SFUInt32)featureUnit->range.start);
+            WriteBlobUInt32(&unitBytes[8], (SFUInt32)featureUnit->range.count);
+            WriteBlobUInt16(&unitBytes[12], featureUnit->mask);
+            WriteBlobUInt16(&unitBytes[14], 0);
+            unitBytes += BlobUnit_Size;
+
+            for (lookupIndex = 0; lookupIndex < featureUnit->lookups.count; lookupIndex++) {
+                SFLookupInfo *lookupInfo = &featureUnit->lookups.items[lookupIndex];
+
+                WriteBlobUInt16(&lookupBytes[0], lookupInfo->index);
+                WriteBlobUInt16(&lookupBytes[2], lookupInfo->value);
+                lookupBytes += BlobLookup_Size;
+            }
+        }
+    }
+
+    return length;
+}
+
+/**
+ * Checks that the units of an image cover valid ranges of features and their lookups are in
+ * ascending order, adding up to the given count.
+ */
+static SFBoolean ValidateBlobUnits(Data unitArray, SFUInteger unitCount,
+    Data lookupArray, SFUInteger lookupCount, SFUInteger featureCount)
+{
+    SFUInteger lookupTotal = 0;
+    SFUInteger unitIndex;
+
+    for (unitIndex = 0; unitIndex < unitCount; unitIndex++) {
+        Data unit = Data_Subdata(unitArray, unitIndex * BlobUnit_Size);
+        SFUInteger unitLookups = BlobUnit_LookupCount(unit);
+        SFUInteger rangeStart = BlobUnit_RangeStart(unit);
+        SFUInteger rangeCount = BlobUnit_RangeCount(unit);
+        SFUInteger lookupIndex;
+
+        if (rangeStart > featureCount || rangeCount > featureCount - rangeStart
+            || unitLookups > lookupCount - lookupTotal) {
+            return SFFalse;
+        }
+
+        for (lookupIndex = 1; lookupIndex < unitLookups; lookupIndex++) {
+            Data lookup = Data_Subdata(lookupArray, (lookupTotal + lookupIndex) * BlobLookup_Size);
+
+            if (BlobLookup_Index(lookup - BlobLookup_Size) >= BlobLookup_Index(lookup)) {
+                return SFFalse;
+            }
+        }
+
+        lookupTotal += unitLookups;
+    }
+
+    return (lookupTotal == lookupCount);
+}
+
+SFPatternRef SFPatternCreateFromBlob(SFFontRef font, const void *blob, SFUInteger length)
+{
+    Data data = blob;
+    SFFontFingerprint fingerprint;
+    SFUInteger featureCount;
+    SFUInteger gsubCount;
+    SFUInteger gposCount;
+    SFUInteger unitCount;
+    SFUInteger lookupCount;
+    SFUInteger remaining;
+    Data tagArray;
+    Data unitArray;
+    Data lookupArray;
+    SFPatternRef pattern;
+    SFFeatureUnit *unitItems;
+    SFTag *tagItems;
+    SFLookupInfo *lookupItems;
+    SFUInteger index;
+
+    if (!font || !data || length < BlobHeader_Size
+        || BlobHeader_Magic(data) != TAG('S', 'F', 'P', 'T')
+        || BlobHeader_Version(data) != PatternBlob_Version
+        || BlobHeader_Direction(data) > SFTextDirectionRightToLeft) {
+        return NULL;
+    }
+
+    fingerprint = SFFontGetFingerprint(font);
+
+    for (index = 0; index < 4; index++) {
+        if (BlobHeader_Fingerprint(data, index) != fingerprint.words[index]) {
+            return NULL;
+        }
+    }
+
+    /* Make sure that the arrays fill up the image exactly. */
+    featureCount = BlobHeader_FeatureCount(data);
+    gsubCount = BlobHeader_GSUBUnitCount(data);
+    gposCount = BlobHeader_GPOSUnitCount(data);
+    lookupCount = BlobHeader_LookupCount(data);
+    remaining = length - BlobHeader_Size;
+
+    if (featureCount > remaining / sizeof(SFUInt32)) {
+        return NULL;
+    }
+    remaining -= featureCount * sizeof(SFUInt32);
+
+    if (gsubCount > remaining / BlobUnit_Size || gposCount > (remaining / BlobUnit_Size) - gsubCount) {
+        return NULL;
+    }
+    unitCount = gsubCount + gposCount;
+    remaining -= unitCount * BlobUnit_Size;
+
+    if (lookupCount > remaining / BlobLookup_Size || remaining != lookupCount * BlobLookup_Size) {
+        return NULL;
+    }
+
+    tagArray = Data_Subdata(data, BlobHeader_Size);
+    unitArray = Data_Subdata(tagArray, featureCount * sizeof(SFUInt32));
+    lookupArray = Data_Subdata(unitArray, unitCount * BlobUnit_Size);
+
+    if (!ValidateBlobUnits(unitArray, unitCount, lookupArray, lookupCount, featureCount)) {
+        return NULL;
+    }
+
+    /* Place the units first as they have the strictest alignment among the arrays. */
+    pattern = malloc(sizeof(SFPattern)
+                     + (sizeof(SFFeatureUnit) * unitCount)
+                     + (sizeof(SFTag) * featureCount)
+                     + (sizeof(SFLookupInfo) * lookupCount));
+    unitItems = (SFFeatureUnit *)(pattern + 1);
+    tagItems = (SFTag *)(unitItems + unitCount);
+    lookupItems = (SFLookupInfo *)(tagItems + featureCount);
+
+    pattern->font = SFFontRetain(font);
+    pattern->featureTags.items = tagItems;
+    pattern->featureTags.count = featureCount;
+    pattern->featureUnits.items = unitItems;
+    pattern->featureUnits.gsub = gsubCount;
+    pattern->featureUnits.gpos = gposCount;
+    pattern->scriptTag = BlobHeader_ScriptTag(data);
+    pattern->languageTag = BlobHeader_LanguageTag(data);
+    pattern->defaultDirection = BlobHeader_Direction(data);
+    pattern->_retainCount = 1;
+    pattern->_isShared = SFFalse;
+    pattern->_isPacked = SFTrue;
+
+    for (index = 0; index < featureCount; index++) {
+        tagItems[index] = Data_UInt32(tagArray, index * sizeof(SFUInt32));
+    }
+
+    for (index = 0; index < lookupCount; index++) {
+        Data lookup = Data_Subdata(lookupArray, index * BlobLookup_Size);
+
+        lookupItems[index].index = BlobLookup_Index(lookup);
+        lookupItems[index].value = BlobLookup_Value(lookup);
+    }
+
+    for (index = 0; index < unitCount; index++) {
+        Data unit = Data_Subdata(unitArray, index * BlobUnit_Size);
+        SFFeatureUnitRef featureUnit = &unitItems[index];
+
+        featureUnit->lookups.items = lookupItems;
+        featureUnit->lookups.count = BlobUnit_LookupCount(unit);
+        featureUnit->range.start = BlobUnit_RangeStart(unit);
+        featureUnit->range.count = BlobUnit_RangeCount(unit);
+        featureUnit->mask = BlobUnit_Mask(unit);
+
+        lookupItems += featureUnit->lookups.count;
+    }
+
+    return pattern;
+}
+
 SFPatternRef SFPatternRetain(SFPatternRef pattern)
 {
     if (pattern) {
-        pattern->_retainCount++;
+        if (pattern->_isShared) {
+            MutexLock(&SharedPatternMutex);
+
+            /*
+             * The cache of the font holds the last reference of a shared pattern without keeping
+             * the font alive, so the font is retained again once someone else holds the pattern.
+             */
+            if (++pattern->_retainCount == 2) {
+                SFFontRetain(pattern->font);
+            }
+
+            MutexUnlock(&SharedPatternMutex);
+        } else {
+            pattern->_retainCount++;
+        }
     }
 
     return pattern;
@@ -94,7 +394,24 @@ SFPatternRef SFPatternRetain(SFPatternRef pattern)
 
 void SFPatternRelease(SFPatternRef pattern)
 {
-    if (pattern && --pattern->_retainCount == 0) {
-        SFPatternFinalize(pattern);
+    if (pattern) {
+        SFBoolean isReleased;
+        SFBoolean releasesFont = SFFalse;
+
+        if (pattern->_isShared) {
+            MutexLock(&SharedPatternMutex);
+            isReleased = (--pattern->_retainCount == 0);
+            releasesFont = (pattern->_retainCount == 1);
+            MutexUnlock(&SharedPatternMutex);
+        } else {
+            isReleased = (--pattern->_retainCount == 0);
+        }
+
+        if (releasesFont) {
+            /* The font might finalize its cache and this pattern along with it. */
+            SFFontRelease(pattern->font);
+        } else if (isReleased) {
+            SFPatternFinalize(pattern);
+        }
     }
 }
@@ -68,8 +68,19 @@ typedef struct _SFPattern {
     SFTag languageTag;                  /**< Tag of the language. */
     SFTextDirection defaultDirection;   /**< Default direction of the script. */
     SFUInteger _retainCount;
+    SFBoolean _isShared;                /**< Whether the pattern is shared by a pattern cache. */
+    SFBoolean _isPacked;                /**< Whether the arrays are allocated along with the pattern. */
 } SFPattern;
 
 SF_INTERNAL SFPatternRef SFPatternCreate(void);
 
+/**
+ * Marks a pattern as shared between threads, after which its retain count is synchronized.
+ *
+ * The caller must hold the last of the other references, which from then on refers to the font
+ * only while someone else retains the pattern as well. This lets the cache of a font keep its
+ * patterns without keeping the font alive.
+ */
+SF_INTERNAL void SFPatternMarkShared(SFPatternRef pattern);
+
 #endif
@@ -17,6 +17,7 @@
 #include <SFConfig.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "SFArtist.h"
 #include "SFAssert.h"
@@ -33,21 +34,43 @@ static int LookupIndexComparison(const void *item1, const void *item2)
     return (int)(ref1->index - ref2->index);
 }
 
-static SFLookupInfo *FindLookupInfo(SFPatternBuilderRef builder, SFUInt16 lookupIndex)
+static void ReserveLookupSlot(SFPatternBuilderRef builder, SFUInt16 lookupIndex)
 {
-    SFUInteger lookupCount = builder->_lookupInfos.count;
-    SFLookupInfo *lookupItems = builder->_lookupInfos.items;
-    SFUInteger index;
+    SFUInteger oldCount = builder->_slotCount;
 
-    for (index = 0; index < lookupCount; index++) {
-        SFLookupInfo *currentItem = &lookupItems[index];
+    if (lookupIndex >= oldCount) {
+        SFUInteger newCount = (oldCount ? oldCount * 2 : 64);
 
-        if (currentItem->index == lookupIndex) {
-            return currentItem;
+        if (newCount <= lookupIndex) {
+            newCount = (SFUInteger)lookupIndex + 1;
         }
+
+        builder->_lookupSlots = realloc(builder->_lookupSlots, sizeof(SFUInt32) * newCount);
+        builder->_slotCount = newCount;
+
+        /* Mark the new lookup indexes as not added. */
+        memset(&builder->_lookupSlots[oldCount], 0, sizeof(SFUInt32) * (newCount - oldCount));
     }
+}
 
-    return NULL;
+static SFUInteger SearchFeatureTag(SFPatternBuilderRef builder, SFTag featureTag)
+{
+    SFTag *tagItems = builder->_sortedTags.items;
+    SFUInteger low = 0;
+    SFUInteger high = builder->_sortedTags.count;
+
+    /* Find the position of first tag which is not less than the given one. */
+    while (low < high) {
+        SFUInteger mid = low + ((high - low) >> 1);
+
+        if (tagItems[mid] < featureTag) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
 }
 
 SF_INTERNAL void SFPatternBuilderInitialize(SFPatternBuilderRef builder, SFPatternRef pattern)
@@ -67,10 +90,15 @@ SF_INTERNAL void SFPatternBuilderInitialize(SFPatternBuilderRef builder, SFPatte
     builder->_featureMask = 0;
     builder->_featureKind = 0;
     builder->_canBuild = SFTrue;
+    builder->_lookupSlots = NULL;
+    builder->_slotCount = 0;
 
     ListInitialize(&builder->_featureTags, sizeof(SFTag));
     ListSetCapacity(&builder->_featureTags, 24);
 
+    ListInitialize(&builder->_sortedTags, sizeof(SFTag));
+    ListSetCapacity(&builder->_sortedTags, 24);
+
     ListInitialize(&builder->_featureUnits, sizeof(SFFeatureUnit));
     ListSetCapacity(&builder->_featureUnits, 24);
 
@@ -84,6 +112,8 @@ SF_INTERNAL void SFPatternBuilderFinalize(SFPatternBuilderRef builder)
     SFAssert(builder->_canBuild == SFFalse);
 
     ListFinalize(&builder->_lookupInfos);
+    ListFinalize(&builder->_sortedTags);
+    free(builder->_lookupSlots);
 }
 
 SF_INTERNAL void SFPatternBuilderSetFont(SFPatternBuilderRef builder, SFFontRef font)
@@ -110,7 +140,10 @@ SF_INTERNAL void SFPatternBuilderSetLanguage(SFPatternBuilderRef builder, SFTag
 
 SF_INTERNAL SFBoolean SFPatternBuilderContainsFeature(SFPatternBuilderRef builder, SFTag featureTag)
 {
-    return ListContainsItem(&builder->_featureTags, &featureTag);
+    SFUInteger index = SearchFeatureTag(builder, featureTag);
+
+    return (index < builder->_sortedTags.count
+            && builder->_sortedTags.items[index] == featureTag);
 }
 
 SF_INTERNAL void SFPatternBuilderBeginFeatures(SFPatternBuilderRef builder, SFFeatureKind featureKind)
@@ -129,12 +162,14 @@ SF_INTERNAL void SFPatternBuilderAddFeature(SFPatternBuilderRef builder,
     /* The kind of features must be specified before adding them. */
     SFAssert(builder->_featureKind != 0);
     /* Only unique features can be added. */
-    SFAssert(!ListContainsItem(&builder->_featureTags, &featureTag));
+    SFAssert(!SFPatternBuilderContainsFeature(builder, featureTag));
     /* Feature value must be non-zero. */
     SFAssert(featureValue != 0);
 
     /* Add the feature in the list. */
     ListAdd(&builder->_featureTags, featureTag);
+    /* Keep the tags sorted for looking them up. */
+    ListInsert(&builder->_sortedTags, SearchFeatureTag(builder, featureTag), featureTag);
     /* Set the value of the feature. */
     builder->_featureValue = featureValue;
     /* Insert the mask of the feature. */
@@ -143,15 +178,17 @@ SF_INTERNAL void SFPatternBuilderAddFeature(SFPatternBuilderRef builder,
 
 SF_INTERNAL void SFPatternBuilderAddLookup(SFPatternBuilderRef builder, SFUInt16 lookupIndex)
 {
-    SFLookupInfo *oldItem;
+    SFUInt32 slot;
 
     /* A feature MUST be available before adding lookups. */
     SFAssert((builder->_featureTags.count - builder->_featureIndex) > 0);
 
-    oldItem = FindLookupInfo(builder, lookupIndex);
+    ReserveLookupSlot(builder, lookupIndex);
+    slot = builder->_lookupSlots[lookupIndex];
 
     /* Add only unique lookup indexes. */
-    if (oldItem) {
+    if (slot) {
+        SFLookupInfo *oldItem = ListGetRef(&builder->_lookupInfos, slot - 1);
         oldItem->value = builder->_featureValue;
     } else {
         SFLookupInfo lookupInfo;
@@ -159,16 +196,25 @@ SF_INTERNAL void SFPatternBuilderAddLookup(SFPatternBuilderRef builder, SFUInt16
         lookupInfo.value = builder->_featureValue;
 
         ListAdd(&builder->_lookupInfos, lookupInfo);
+        builder->_lookupSlots[lookupIndex] = (SFUInt32)builder->_lookupInfos.count;
     }
 }
 
 SF_INTERNAL void SFPatternBuilderMakeFeatureUnit(SFPatternBuilderRef builder)
 {
+    SFLookupInfo *lookupItems = builder->_lookupInfos.items;
+    SFUInteger lookupCount = builder->_lookupInfos.count;
     SFFeatureUnit featureUnit;
+    SFUInteger index;
 
     /* At least one feature MUST be available before making a feature unit. */
     SFAssert((builder->_featureTags.count - builder->_featureIndex) > 0);
 
+    /* Release the slots of lookups for the next feature unit. */
+    for (index = 0; index < lookupCount; index++) {
+        builder->_lookupSlots[lookupItems[index].index] = 0;
+    }
+
     /* Sort all lookup indexes. */
     ListSort(&builder->_lookupInfos, 0, builder->_lookupInfos.count, LookupIndexComparison);
     /* Set lookup indexes in current feature unit. */
@@ -41,7 +41,11 @@ typedef struct _SFPatternBuilder {
     SFFeatureKind _featureKind;     /**< Kind of features being added. */
     SFBoolean _canBuild;
 
+    SFUInt32 *_lookupSlots;         /**< Positions of lookups in the unit being built plus one, indexed by lookup index. */
+    SFUInteger _slotCount;          /**< Total number of lookup indexes covered by the slots. */
+
     LIST(SFTag) _featureTags;
+    LIST(SFTag) _sortedTags;        /**< Tags of added features in ascending order. */
     LIST(SFFeatureUnit) _featureUnits;
     LIST(SFLookupInfo) _lookupInfos;
 } SFPatternBuilder, *SFPatternBuilderRef;
@@ -21,6 +21,7 @@
 
 #include "Common.h"
 #include "Data.h"
+#include "LayoutIndex.h"
 #include "OpenType.h"
 #include "UnifiedEngine.h"
 #include "SFBase.h"
@@ -29,6 +30,8 @@
 #include "SFPattern.h"
 #include "SFScheme.h"
 
+static SFBoolean PatternCacheEnabled = SFFalse;
+
 static void AddFeatureLookups(SFPatternBuilderRef patternBuilder, Data featureTable)
 {
     SFUInt16 lookupCount = Feature_LookupCount(featureTable);
@@ -58,7 +61,7 @@ static SFBoolean GetCustomValue(SFSchemeRef scheme, SFTag featureTag, SFUInt16 *
 }
 
 static void AddFeatureUnit(SFSchemeRef scheme, SFPatternBuilderRef patternBuilder,
-    Data langSysTable, Data featureListTable, Data featureSubstTable,
+    LayoutIndexRef layoutIndex, IndexedLangSysRef langSys, Data featureSubstTable,
     FeatureInfo *featureInfos, SFUInteger featureCount)
 {
     SFBoolean exists = SFFalse;
@@ -82,7 +85,7 @@ static void AddFeatureUnit(SFSchemeRef scheme, SFPatternBuilderRef patternBuilde
 
         /* Process the feature if it is enabled. */
         if (featureValue != 0) {
-            Data featureTable = SearchRelevantFeatureTable(langSysTable, featureListTable, featureSubstTable, featureTag);
+            Data featureTable = LayoutIndexSearchFeatureTable(layoutIndex, langSys, featureSubstTable, featureTag);
 
             /* Add the feature if it exists in the language. */
             if (featureTable) {
@@ -100,7 +103,7 @@ static void AddFeatureUnit(SFSchemeRef scheme, SFPatternBuilderRef patternBuilde
 }
 
 static void AddKnownFeatures(SFSchemeRef scheme, SFPatternBuilderRef patternBuilder,
-    Data langSysTable, Data featureListTable, Data featureSubstTable,
+    LayoutIndexRef layoutIndex, IndexedLangSysRef langSys, Data featureSubstTable,
     FeatureInfo *featureInfos, SFUInteger featureCount)
 {
     SFUInteger index = 0;
@@ -125,7 +128,7 @@ static void AddKnownFeatures(SFSchemeRef scheme, SFPatternBuilderRef patternBuil
             unitLength = next - index;
         }
 
-        AddFeatureUnit(scheme, patternBuilder, langSysTable, featureListTable, featureSubstTable, featureInfo, unitLength);
+        AddFeatureUnit(scheme, patternBuilder, layoutIndex, langSys, featureSubstTable, featureInfo, unitLength);
         index += unitLength;
     }
 }
@@ -144,7 +147,7 @@ static SFBoolean IsKnownFeature(SFTag featureTag, FeatureInfo *featureInfos, SFU
 }
 
 static void AddCustomFeatures(SFSchemeRef scheme, SFPatternBuilderRef patternBuilder,
-    Data langSysTable, Data featureListTable, Data featureSubstTable,
+    LayoutIndexRef layoutIndex, IndexedLangSysRef langSys, Data featureSubstTable,
     FeatureInfo *featureInfos, SFUInteger featureCount)
 {
     SFBoolean exists = SFFalse;
@@ -163,7 +166,7 @@ static void AddCustomFeatures(SFSchemeRef scheme, SFPatternBuilderRef patternBui
 
             /* Process the feature if it is enabled. */
             if (featureValue != 0) {
-                Data featureTable = SearchRelevantFeatureTable(langSysTable, featureListTable, featureSubstTable, featureTag);
+                Data featureTable = LayoutIndexSearchFeatureTable(layoutIndex, langSys, featureSubstTable, featureTag);
 
                 /* Add the feature if it exists in the language. */
                 if (featureTable) {
@@ -182,35 +185,39 @@ static void AddCustomFeatures(SFSchemeRef scheme, SFPatternBuilderRef patternBui
 }
 
 static void AddHeaderTable(SFSchemeRef scheme, SFPatternBuilderRef patternBuilder,
-    Data headerTable, FeatureInfo *featureInfos, SFUInteger featureCount)
+    Data headerTable, LayoutIndexRef layoutIndex, FeatureInfo *featureInfos, SFUInteger featureCount)
 {
     SFUInt32 headerVersion = Header_Version(headerTable);
-    Data scriptListTable = Header_ScriptListTable(headerTable);
-    Data featureListTable = Header_FeatureListTable(headerTable);
     Data featureSubstTable = NULL;
-    Data scriptTable;
-    Data langSysTable;
+    IndexedScriptRef script;
+    IndexedLangSysRef langSys;
+
+    /* Skip the table if its lists could not be indexed. */
+    if (!layoutIndex) {
+        return;
+    }
 
-    /* Get script table belonging to the desired tag. */
-    scriptTable = SearchScriptTable(scriptListTable, scheme->_scriptTag);
+    /* Get script belonging to the desired tag. */
+    script = LayoutIndexSearchScript(layoutIndex, scheme->_scriptTag);
 
-    /* Use the default script table if the desired script tag is not available. */
-    if (!scriptTable) {
-        scriptTable = SearchScriptTable(scriptListTable, TAG('D', 'F', 'L', 'T'));
+    /* Use the default script if the desired script tag is not available. */
+    if (!script) {
+        script = LayoutIndexSearchScript(layoutIndex, TAG('D', 'F', 'L', 'T'));
     }
 
-    if (scriptTable) {
-        /* Get lang sys table belonging to the desired tag. */
-        langSysTable = SearchLangSysTable(scriptTable, scheme->_languageTag);
+    if (script) {
+        /* Get lang sys belonging to the desired tag. */
+        langSys = LayoutIndexSearchLangSys(script, scheme->_languageTag);
 
-        if (langSysTable) {
-            if (headerVersion == 0x00010001) {
+        if (langSys) {
+            /* The feature variations table is optional even in version 1.1 of the header. */
+            if (headerVersion == 0x00010001 && HeaderV11_FeatureVariationsOffset(headerTable)) {
                 Data featureVarsTable = HeaderV11_FeatureVariationsTable(headerTable);
                 featureSubstTable = SearchFeatureSubstitutionTable(featureVarsTable, scheme->_font->coordArray, scheme->_font->coordCount);
             }
 
-            AddKnownFeatures(scheme, patternBuilder, langSysTable, featureListTable, featureSubstTable, featureInfos, featureCount);
-            AddCustomFeatures(scheme, patternBuilder, langSysTable, featureListTable, featureSubstTable, featureInfos, featureCount);
+            AddKnownFeatures(scheme, patternBuilder, layoutIndex, langSys, featureSubstTable, featureInfos, featureCount);
+            AddCustomFeatures(scheme, patternBuilder, layoutIndex, langSys, featureSubstTable, featureInfos, featureCount);
         }
     }
 }
@@ -289,34 +296,80 @@ void SFSchemeSetFeatureValues(SFSchemeRef scheme,
     scheme->_featureCount = uniqueCount;
 }
 
+void SFSchemeSetPatternCacheEnabled(SFBoolean enabled)
+{
+    PatternCacheEnabled = enabled;
+}
+
+static SFPatternRef CreatePattern(SFSchemeRef scheme)
+{
+    SFFontRef font = scheme->_font;
+    ScriptKnowledgeRef knowledge = ShapingKnowledgeSeekScript(scheme->_knowledge, scheme->_scriptTag);
+    Data gsubTable = SFFontGetGSUBTable(font);
+    Data gposTable = SFFontGetGPOSTable(font);
+    SFPatternRef pattern = SFPatternCreate();
+    SFPatternBuilder builder;
+
+    SFPatternBuilderInitialize(&builder, pattern);
+    SFPatternBuilderSetFont(&builder, scheme->_font);
+    SFPatternBuilderSetScript(&builder, scheme->_scriptTag, knowledge->defaultDirection);
+    SFPatternBuilderSetLanguage(&builder, scheme->_languageTag);
+
+    if (gsubTable) {
+        SFPatternBuilderBeginFeatures(&builder, SFFeatureKindSubstitution);
+        AddHeaderTable(scheme, &builder, gsubTable, SFFontGetGSUBLayoutIndex(font), knowledge->substFeatures.items, knowledge->substFeatures.count);
+        SFPatternBuilderEndFeatures(&builder);
+    }
+
+    if (gposTable) {
+        SFPatternBuilderBeginFeatures(&builder, SFFeatureKindPositioning);
+        AddHeaderTable(scheme, &builder, gposTable, SFFontGetGPOSLayoutIndex(font), knowledge->posFeatures.items, knowledge->posFeatures.count);
+        SFPatternBuilderEndFeatures(&builder);
+    }
+
+    SFPatternBuilderBuild(&builder);
+    SFPatternBuilderFinalize(&builder);
+
+    return pattern;
+}
+
 SFPatternRef SFSchemeBuildPattern(SFSchemeRef scheme)
 {
     SFFontRef font = scheme->_font;
 
     if (font) {
-        ScriptKnowledgeRef knowledge = ShapingKnowledgeSeekScript(scheme->_knowledge, scheme->_scriptTag);
-        SFPatternRef pattern = SFPatternCreate();
-        SFPatternBuilder builder;
-
-        SFPatternBuilderInitialize(&builder, pattern);
-        SFPatternBuilderSetFont(&builder, scheme->_font);
-        SFPatternBuilderSetScript(&builder, scheme->_scriptTag, knowledge->defaultDirection);
-        SFPatternBuilderSetLanguage(&builder, scheme->_languageTag);
-
-        if (font->resource->gsub) {
-            SFPatternBuilderBeginFeatures(&builder, SFFeatureKindSubstitution);
-            AddHeaderTable(scheme, &builder, font->resource->gsub, knowledge->substFeatures.items, knowledge->substFeatures.count);
-            SFPatternBuilderEndFeatures(&builder);
-        }
+        PatternCacheRef patternCache = &font->patternCache;
+        PatternKey key;
+        SFPatternRef pattern;
+        SFPatternRef cachedPattern;
 
-        if (font->resource->gpos) {
-            SFPatternBuilderBeginFeatures(&builder, SFFeatureKindPositioning);
-            AddHeaderTable(scheme, &builder, font->resource->gpos, knowledge->posFeatures.items, knowledge->posFeatures.count);
-            SFPatternBuilderEndFeatures(&builder);
+        if (!PatternCacheEnabled) {
+            return CreatePattern(scheme);
         }
 
-        SFPatternBuilderBuild(&builder);
-        SFPatternBuilderFinalize(&builder);
+        /*
+         * The order of custom features is kept in the key as it decides the order of their tags in
+         * the pattern.
+         */
+        key.knowledge = scheme->_knowledge;
+        key.scriptTag = scheme->_scriptTag;
+        key.languageTag = scheme->_languageTag;
+        key.featureTags = scheme->_featureTags;
+        key.featureValues = scheme->_featureValues;
+        key.featureCount = scheme->_featureCount;
+
+        pattern = PatternCacheSearch(patternCache, &key);
+
+        if (!pattern) {
+            pattern = CreatePattern(scheme);
+            cachedPattern = PatternCacheInsert(patternCache, &key, pattern);
+
+            /* Use the pattern built by another thread in the meanwhile. */
+            if (cachedPattern != pattern) {
+                SFPatternRelease(pattern);
+                pattern = cachedPattern;
+            }
+        }
 
         return pattern;
     }
@@ -0,0 +1,1777 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <SFConfig.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SFBase.h"
+#include "Common.h"
+#include "Data.h"
+#include "GDEF.h"
+#include "GPOS.h"
+#include "GSUB.h"
+#include "HMTX.h"
+#include "Variations.h"
+#include "Sanitizer.h"
+
+/**
+ * The number of operations allowed per byte of a table, so that the subtables shared by many
+ * offsets cannot make the validation run for much longer than the size of the table.
+ */
+#define SanitizerOperationFactor    8
+#define SanitizerMinOperations      16384
+
+/**
+ * The state of a lookup subtable that has already been validated, holding its lookup type in the
+ * lower bits.
+ */
+#define SubtableStateTypeMask       0x0F
+#define SubtableStateValid          0x10
+
+typedef struct _Sanitizer {
+    Data table;                 /**< The table being validated. */
+    SFUInteger length;          /**< The length of the table in bytes. */
+    SFUInteger operationCount;  /**< The number of operations left before giving up. */
+    SFUInt8 *subtableStates;    /**< The states of the lookup subtables by their position. */
+    SFUInt16 featureCount;      /**< The number of features in the feature list. */
+    SFUInt16 lookupCount;       /**< The number of lookups in the lookup list. */
+    SFBoolean isGPOS;           /**< Whether the table is GPOS rather than GSUB. */
+    SFBoolean isExhausted;      /**< Whether the operations have run out. */
+} Sanitizer, *SanitizerRef;
+
+static SFBoolean SanitizeSubtable(SanitizerRef sanitizer, LookupType lookupType, Data subtable);
+
+static void InitializeSanitizer(SanitizerRef sanitizer, Data table, SFUInteger length, SFBoolean isGPOS)
+{
+    sanitizer->table = table;
+    sanitizer->length = length;
+    sanitizer->subtableStates = NULL;
+    sanitizer->featureCount = 0;
+    sanitizer->lookupCount = 0;
+    sanitizer->isGPOS = isGPOS;
+    sanitizer->isExhausted = SFFalse;
+
+    if (length > ((SFUInteger)-1) / SanitizerOperationFactor) {
+        sanitizer->operationCount = (SFUInteger)-1;
+    } else if (length < SanitizerMinOperations / SanitizerOperationFactor) {
+        sanitizer->operationCount = SanitizerMinOperations;
+    } else {
+        sanitizer->operationCount = length * SanitizerOperationFactor;
+    }
+}
+
+static SFBoolean ConsumeOperations(SanitizerRef sanitizer, SFUInteger count)
+{
+    if (sanitizer->isExhausted || count >= sanitizer->operationCount) {
+        sanitizer->operationCount = 0;
+        sanitizer->isExhausted = SFTrue;
+        return SFFalse;
+    }
+
+    sanitizer->operationCount -= count;
+    return SFTrue;
+}
+
+static SFBoolean CheckRange(SanitizerRef sanitizer, Data data, SFUInteger size)
+{
+    SFUInteger start = (SFUInteger)(data - sanitizer->table);
+
+    return (start <= sanitizer->length && size <= sanitizer->length - start
+            && ConsumeOperations(sanitizer, 1));
+}
+
+static SFBoolean CheckArray(SanitizerRef sanitizer, Data data, SFUInteger count, SFUInteger itemSize)
+{
+    SFUInteger start = (SFUInteger)(data - sanitizer->table);
+
+    if (start > sanitizer->length) {
+        return SFFalse;
+    }
+
+    /* Divide rather than multiply so that huge counts cannot overflow. */
+    if (itemSize != 0 && count > (sanitizer->length - start) / itemSize) {
+        return SFFalse;
+    }
+
+    /* The items of an array are usually visited right after checking it. */
+    return ConsumeOperations(sanitizer, count + 1);
+}
+
+/**
+ * Returns the subtable at given offset from an already validated parent, or NULL if the subtable
+ * would begin outside of the table.
+ */
+static Data GetSubtable(SanitizerRef sanitizer, Data parent, SFUInt32 offset)
+{
+    SFUInteger start = (SFUInteger)(parent - sanitizer->table);
+
+    if (offset > sanitizer->length - start) {
+        return NULL;
+    }
+
+    return Data_Subdata(parent, offset);
+}
+
+static SFBoolean SanitizeGlyphRanges(SanitizerRef sanitizer, Data rangeArray, SFUInt16 rangeCount)
+{
+    SFUInt32 minStart = 0;
+    SFUInteger index;
+
+    if (!CheckArray(sanitizer, rangeArray, rangeCount, GlyphRange_Size())) {
+        return SFFalse;
+    }
+
+    /* The ranges are binary searched, so they must be sorted and must not overlap. */
+    for (index = 0; index < rangeCount; index++) {
+        Data rangeRecord = Data_Subdata(rangeArray, index * GlyphRange_Size());
+        SFUInt16 startGlyph = GlyphRange_Start(rangeRecord);
+        SFUInt16 endGlyph = GlyphRange_End(rangeRecord);
+
+        if (startGlyph < minStart || startGlyph > endGlyph) {
+            return SFFalse;
+        }
+
+        minStart = (SFUInt32)endGlyph + 1;
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeCoverage(SanitizerRef sanitizer, Data coverage)
+{
+    if (!coverage || !CheckRange(sanitizer, coverage, 2)) {
+        return SFFalse;
+    }
+
+    switch (Coverage_Format(coverage)) {
+        case 1: {
+            SFUInt16 glyphCount;
+            Data glyphArray;
+            SFUInteger index;
+
+            if (!CheckRange(sanitizer, coverage, 4)) {
+                return SFFalse;
+            }
+
+            glyphCount = CoverageF1_GlyphCount(coverage);
+            glyphArray = CoverageF1_GlyphArray(coverage);
+
+            if (!CheckArray(sanitizer, glyphArray, glyphCount, 2)) {
+                return SFFalse;
+            }
+
+            /* The glyphs are binary searched, so they must be in increasing order. */
+            for (index = 1; index < glyphCount; index++) {
+                if (GlyphArray_Value(glyphArray, index) <= GlyphArray_Value(glyphArray, index - 1)) {
+                    return SFFalse;
+                }
+            }
+            break;
+        }
+
+        case 2:
+            if (!CheckRange(sanitizer, coverage, 4)) {
+                return SFFalse;
+            }
+
+            return SanitizeGlyphRanges(sanitizer, CoverageF2_GlyphRangeArray(coverage),
+                                       CoverageF2_RangeCount(coverage));
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeClassDef(SanitizerRef sanitizer, Data classDef)
+{
+    if (!classDef || !CheckRange(sanitizer, classDef, 2)) {
+        return SFFalse;
+    }
+
+    switch (ClassDef_Format(classDef)) {
+        case 1:
+            return (CheckRange(sanitizer, classDef, 6)
+                 && CheckArray(sanitizer, ClassDefF1_ClassValueArray(classDef),
+                               ClassDefF1_GlyphCount(classDef), 2));
+
+        case 2:
+            if (!CheckRange(sanitizer, classDef, 4)) {
+                return SFFalse;
+            }
+
+            return SanitizeGlyphRanges(sanitizer, ClassDefF2_GlyphRangeArray(classDef),
+                                       ClassDefF2_ClassRangeCount(classDef));
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeDevice(SanitizerRef sanitizer, Data device)
+{
+    SFUInt16 startSize;
+    SFUInt16 endSize;
+    SFUInt16 deltaFormat;
+
+    if (!device || !CheckRange(sanitizer, device, 6)) {
+        return SFFalse;
+    }
+
+    startSize = Device_StartSize(device);
+    endSize = Device_EndSize(device);
+    deltaFormat = Device_DeltaFormat(device);
+
+    /* Formats 1, 2 and 3 pack 8, 4 and 2 values respectively in each delta word. */
+    if (deltaFormat >= 1 && deltaFormat <= 3 && startSize <= endSize) {
+        SFUInteger wordCount = ((SFUInteger)(endSize - startSize) >> (4 - deltaFormat)) + 1;
+        return CheckArray(sanitizer, Data_Subdata(device, 6), wordCount, 2);
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeDeviceOffset(SanitizerRef sanitizer, Data parent, SFOffset offset)
+{
+    /* A null device offset is skipped while positioning. */
+    if (offset) {
+        return SanitizeDevice(sanitizer, GetSubtable(sanitizer, parent, offset));
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeValueRecord(SanitizerRef sanitizer, Data parent,
+    Data valueRecord, SFUInt16 valueFormat)
+{
+    SFUInteger valueOffset = 2 * (ValueFormat_XPlacement(valueFormat)
+                                  + ValueFormat_YPlacement(valueFormat)
+                                  + ValueFormat_XAdvance(valueFormat)
+                                  + ValueFormat_YAdvance(valueFormat));
+    SFUInt16 deviceFlag;
+
+    /* The value record itself has already been checked by the caller. */
+    for (deviceFlag = 0x0010; deviceFlag <= 0x0080; deviceFlag <<= 1) {
+        if (valueFormat & deviceFlag) {
+            SFOffset deviceOffset = Data_UInt16(valueRecord, valueOffset);
+
+            if (!SanitizeDeviceOffset(sanitizer, parent, deviceOffset)) {
+                return SFFalse;
+            }
+
+            valueOffset += 2;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean HasDeviceTables(SFUInt16 valueFormat)
+{
+    return (valueFormat & 0x00F0) != 0;
+}
+
+static SFBoolean SanitizeAnchor(SanitizerRef sanitizer, Data anchor)
+{
+    if (!anchor || !CheckRange(sanitizer, anchor, 2)) {
+        return SFFalse;
+    }
+
+    switch (Anchor_Format(anchor)) {
+        case 1:
+        case 2:
+            return CheckRange(sanitizer, anchor, 6);
+
+        case 3:
+            return (CheckRange(sanitizer, anchor, 10)
+                 && SanitizeDeviceOffset(sanitizer, anchor, AnchorF3_XDeviceOffset(anchor))
+                 && SanitizeDeviceOffset(sanitizer, anchor, AnchorF3_YDeviceOffset(anchor)));
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeFeature(SanitizerRef sanitizer, Data feature)
+{
+    SFUInt16 lookupCount;
+    SFUInteger index;
+
+    if (!feature || !CheckRange(sanitizer, feature, 4)) {
+        return SFFalse;
+    }
+
+    lookupCount = Feature_LookupCount(feature);
+
+    if (!CheckArray(sanitizer, Data_Subdata(feature, 4), lookupCount, 2)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < lookupCount; index++) {
+        if (Feature_LookupListIndex(feature, index) >= sanitizer->lookupCount) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeFeatureList(SanitizerRef sanitizer, Data featureList)
+{
+    SFUInt16 featureCount;
+    SFUInteger index;
+
+    if (!featureList || !CheckRange(sanitizer, featureList, 2)) {
+        return SFFalse;
+    }
+
+    featureCount = FeatureList_FeatureCount(featureList);
+
+    if (!CheckArray(sanitizer, Data_Subdata(featureList, 2), featureCount, TagRecord_Size())) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < featureCount; index++) {
+        Data featureRecord = FeatureList_FeatureRecord(featureList, index);
+        SFOffset featureOffset = FeatureRecord_FeatureOffset(featureRecord);
+
+        if (!SanitizeFeature(sanitizer, GetSubtable(sanitizer, featureList, featureOffset))) {
+            return SFFalse;
+        }
+    }
+
+    sanitizer->featureCount = featureCount;
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeLangSys(SanitizerRef sanitizer, Data langSys)
+{
+    SFUInt16 featureCount;
+    SFUInteger index;
+
+    if (!langSys || !CheckRange(sanitizer, langSys, 6)) {
+        return SFFalse;
+    }
+
+    featureCount = LangSys_FeatureCount(langSys);
+
+    if (!CheckArray(sanitizer, Data_Subdata(langSys, 6), featureCount, 2)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < featureCount; index++) {
+        if (LangSys_FeatureIndex(langSys, index) >= sanitizer->featureCount) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeScript(SanitizerRef sanitizer, Data script)
+{
+    SFOffset defaultOffset;
+    SFUInt16 langSysCount;
+    SFUInteger index;
+
+    if (!script || !CheckRange(sanitizer, script, 4)) {
+        return SFFalse;
+    }
+
+    defaultOffset = Script_DefaultLangSysOffset(script);
+    langSysCount = Script_LangSysCount(script);
+
+    if (defaultOffset && !SanitizeLangSys(sanitizer, GetSubtable(sanitizer, script, defaultOffset))) {
+        return SFFalse;
+    }
+
+    if (!CheckArray(sanitizer, Data_Subdata(script, 4), langSysCount, TagRecord_Size())) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < langSysCount; index++) {
+        Data langSysRecord = Script_LangSysRecord(script, index);
+        SFOffset langSysOffset = LangSysRecord_LangSysOffset(langSysRecord);
+
+        if (!SanitizeLangSys(sanitizer, GetSubtable(sanitizer, script, langSysOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeScriptList(SanitizerRef sanitizer, Data scriptList)
+{
+    SFUInt16 scriptCount;
+    SFUInteger index;
+
+    if (!scriptList || !CheckRange(sanitizer, scriptList, 2)) {
+        return SFFalse;
+    }
+
+    scriptCount = ScriptList_ScriptCount(scriptList);
+
+    if (!CheckArray(sanitizer, Data_Subdata(scriptList, 2), scriptCount, TagRecord_Size())) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < scriptCount; index++) {
+        Data scriptRecord = ScriptList_ScriptRecord(scriptList, index);
+        SFOffset scriptOffset = ScriptRecord_ScriptOffset(scriptRecord);
+
+        if (!SanitizeScript(sanitizer, GetSubtable(sanitizer, scriptList, scriptOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeConditionSet(SanitizerRef sanitizer, Data conditionSet)
+{
+    SFUInt16 conditionCount;
+    SFUInteger index;
+
+    if (!conditionSet || !CheckRange(sanitizer, conditionSet, 2)) {
+        return SFFalse;
+    }
+
+    conditionCount = ConditionSet_ConditionCount(conditionSet);
+
+    if (!CheckArray(sanitizer, Data_Subdata(conditionSet, 2), conditionCount, 4)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < conditionCount; index++) {
+        SFUInt32 conditionOffset = ConditionSet_ConditionOffset(conditionSet, index);
+        Data condition = GetSubtable(sanitizer, conditionSet, conditionOffset);
+
+        if (!condition || !CheckRange(sanitizer, condition, 2)) {
+            return SFFalse;
+        }
+
+        if (Condition_Format(condition) == 1 && !CheckRange(sanitizer, condition, 8)) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeFeatureSubst(SanitizerRef sanitizer, Data featureSubst)
+{
+    SFUInt16 substCount;
+    SFUInteger index;
+
+    if (!featureSubst || !CheckRange(sanitizer, featureSubst, 6)) {
+        return SFFalse;
+    }
+
+    substCount = FeatureSubst_SubstCount(featureSubst);
+
+    if (!CheckArray(sanitizer, Data_Subdata(featureSubst, 6), substCount, 6)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < substCount; index++) {
+        Data substRecord = FeatureSubst_FeatureSubstRecord(featureSubst, index);
+        SFUInt32 featureOffset = FeatureSubstRecord_AltFeatureOffset(substRecord);
+
+        if (!SanitizeFeature(sanitizer, GetSubtable(sanitizer, featureSubst, featureOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeFeatureVars(SanitizerRef sanitizer, Data featureVars)
+{
+    SFUInt32 recordCount;
+    SFUInt32 index;
+
+    if (!featureVars || !CheckRange(sanitizer, featureVars, 8)) {
+        return SFFalse;
+    }
+
+    recordCount = FeatureVars_FeatureVarCount(featureVars);
+
+    if (!CheckArray(sanitizer, Data_Subdata(featureVars, 8), recordCount, 8)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < recordCount; index++) {
+        Data varRecord = FeatureVars_FeatureVarRecord(featureVars, index);
+        SFUInt32 conditionSetOffset = FeatureVarRecord_ConditionSetOffset(varRecord);
+        SFUInt32 featureSubstOffset = FeatureVarRecord_FeatureSubstOffset(varRecord);
+
+        if (!SanitizeConditionSet(sanitizer, GetSubtable(sanitizer, featureVars, conditionSetOffset))
+            || !SanitizeFeatureSubst(sanitizer, GetSubtable(sanitizer, featureVars, featureSubstOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeGlyphArray(SanitizerRef sanitizer, Data arrayTable)
+{
+    /* Sequences, alternate sets and ligature sets all start with a count of 16-bit values. */
+    return (arrayTable
+         && CheckRange(sanitizer, arrayTable, 2)
+         && CheckArray(sanitizer, Data_Subdata(arrayTable, 2), Data_UInt16(arrayTable, 0), 2));
+}
+
+static SFBoolean SanitizeOffsetArray(SanitizerRef sanitizer, Data parent,
+    SFUInteger arrayOffset, SFUInteger count)
+{
+    return CheckArray(sanitizer, Data_Subdata(parent, arrayOffset), count, 2);
+}
+
+static SFBoolean SanitizeValueArray(SanitizerRef sanitizer, Data valueArray,
+    SFUInteger valueCount, Data coverageParent)
+{
+    SFUInteger index;
+
+    if (!CheckArray(sanitizer, valueArray, valueCount, 2)) {
+        return SFFalse;
+    }
+
+    /* Format 3 rules store offsets to coverage tables instead of glyphs or classes. */
+    if (coverageParent) {
+        for (index = 0; index < valueCount; index++) {
+            SFOffset coverageOffset = UInt16Array_Value(valueArray, index);
+            Data coverage = GetSubtable(sanitizer, coverageParent, coverageOffset);
+
+            if (!SanitizeCoverage(sanitizer, coverage)) {
+                return SFFalse;
+            }
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeLookupRecords(SanitizerRef sanitizer, Data lookupArray, SFUInteger lookupCount)
+{
+    SFUInteger index;
+
+    if (!CheckArray(sanitizer, lookupArray, lookupCount, 4)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < lookupCount; index++) {
+        Data lookupRecord = LookupArray_Value(lookupArray, index);
+
+        if (LookupRecord_LookupListIndex(lookupRecord) >= sanitizer->lookupCount) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeRule(SanitizerRef sanitizer, Data rule,
+    SFBoolean includeFirst, Data coverageParent)
+{
+    SFUInt16 glyphCount;
+    SFUInteger valueCount;
+
+    if (!rule || !CheckRange(sanitizer, rule, 4)) {
+        return SFFalse;
+    }
+
+    glyphCount = Rule_GlyphCount(rule);
+
+    /* A rule without any glyph is never applied. */
+    if (glyphCount == 0) {
+        return SFTrue;
+    }
+
+    valueCount = glyphCount - !includeFirst;
+
+    return (SanitizeValueArray(sanitizer, Rule_ValueArray(rule), valueCount, coverageParent)
+         && SanitizeLookupRecords(sanitizer, Rule_LookupArray(rule, valueCount), Rule_LookupCount(rule)));
+}
+
+static SFBoolean SanitizeRuleSet(SanitizerRef sanitizer, Data ruleSet)
+{
+    SFUInt16 ruleCount;
+    SFUInteger index;
+
+    if (!ruleSet || !CheckRange(sanitizer, ruleSet, 2)) {
+        return SFFalse;
+    }
+
+    ruleCount = RuleSet_RuleCount(ruleSet);
+
+    if (!SanitizeOffsetArray(sanitizer, ruleSet, 2, ruleCount)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < ruleCount; index++) {
+        SFOffset ruleOffset = RuleSet_RuleOffset(ruleSet, index);
+
+        if (ruleOffset && !SanitizeRule(sanitizer, GetSubtable(sanitizer, ruleSet, ruleOffset), SFFalse, NULL)) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeRuleSets(SanitizerRef sanitizer, Data context,
+    SFUInteger arrayOffset, SFUInteger ruleSetCount, SFBoolean isChained,
+    SFBoolean hasBacktrack, SFBoolean hasLookahead);
+
+static SFBoolean SanitizeContext(SanitizerRef sanitizer, Data context)
+{
+    switch (Context_Format(context)) {
+        case 1:
+            return (CheckRange(sanitizer, context, 6)
+                 && SanitizeCoverage(sanitizer, ContextF1_CoverageTable(context))
+                 && SanitizeRuleSets(sanitizer, context, 6, ContextF1_RuleSetCount(context),
+                                     SFFalse, SFFalse, SFFalse));
+
+        case 2:
+            return (CheckRange(sanitizer, context, 8)
+                 && SanitizeCoverage(sanitizer, ContextF2_CoverageTable(context))
+                 && SanitizeClassDef(sanitizer, ContextF2_ClassDefTable(context))
+                 && SanitizeRuleSets(sanitizer, context, 8, ContextF2_RuleSetCount(context),
+                                     SFFalse, SFFalse, SFFalse));
+
+        case 3:
+            return SanitizeRule(sanitizer, ContextF3_Rule(context), SFTrue, context);
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeChainRule(SanitizerRef sanitizer, Data chainRule,
+    SFBoolean includeFirst, Data coverageParent, SFBoolean hasBacktrack, SFBoolean hasLookahead)
+{
+    Data backtrackRecord = ChainRule_BacktrackRecord(chainRule);
+    SFUInt16 backtrackCount;
+    Data inputRecord;
+    SFUInt16 inputCount;
+    SFUInteger valueCount;
+    Data lookaheadRecord;
+    SFUInt16 lookaheadCount;
+    Data contextRecord;
+
+    if (!chainRule || !CheckRange(sanitizer, backtrackRecord, 2)) {
+        return SFFalse;
+    }
+
+    backtrackCount = BacktrackRecord_GlyphCount(backtrackRecord);
+
+    /* A missing class definition can only be skipped if no rule refers to it. */
+    if ((backtrackCount && !hasBacktrack)
+        || !SanitizeValueArray(sanitizer, BacktrackRecord_ValueArray(backtrackRecord), backtrackCount, coverageParent)) {
+        return SFFalse;
+    }
+
+    inputRecord = BacktrackRecord_InputRecord(backtrackRecord, backtrackCount);
+
+    if (!CheckRange(sanitizer, inputRecord, 2)) {
+        return SFFalse;
+    }
+
+    inputCount = InputRecord_GlyphCount(inputRecord);
+
+    /* A rule without any input glyph is never applied. */
+    if (inputCount == 0) {
+        return SFTrue;
+    }
+
+    valueCount = inputCount - !includeFirst;
+
+    if (!SanitizeValueArray(sanitizer, InputRecord_ValueArray(inputRecord), valueCount, coverageParent)) {
+        return SFFalse;
+    }
+
+    lookaheadRecord = InputRecord_LookaheadRecord(inputRecord, valueCount);
+
+    if (!CheckRange(sanitizer, lookaheadRecord, 2)) {
+        return SFFalse;
+    }
+
+    lookaheadCount = LookaheadRecord_GlyphCount(lookaheadRecord);
+
+    if ((lookaheadCount && !hasLookahead)
+        || !SanitizeValueArray(sanitizer, LookaheadRecord_ValueArray(lookaheadRecord), lookaheadCount, coverageParent)) {
+        return SFFalse;
+    }
+
+    contextRecord = LookaheadRecord_ContextRecord(lookaheadRecord, lookaheadCount);
+
+    return (CheckRange(sanitizer, contextRecord, 2)
+         && SanitizeLookupRecords(sanitizer, ContextRecord_LookupArray(contextRecord),
+                                  ContextRecord_LookupCount(contextRecord)));
+}
+
+static SFBoolean SanitizeChainRuleSet(SanitizerRef sanitizer, Data chainRuleSet,
+    SFBoolean hasBacktrack, SFBoolean hasLookahead)
+{
+    SFUInt16 ruleCount;
+    SFUInteger index;
+
+    if (!chainRuleSet || !CheckRange(sanitizer, chainRuleSet, 2)) {
+        return SFFalse;
+    }
+
+    ruleCount = ChainRuleSet_ChainRuleCount(chainRuleSet);
+
+    if (!SanitizeOffsetArray(sanitizer, chainRuleSet, 2, ruleCount)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < ruleCount; index++) {
+        SFOffset ruleOffset = ChainRuleSet_ChainRuleOffset(chainRuleSet, index);
+        Data chainRule = GetSubtable(sanitizer, chainRuleSet, ruleOffset);
+
+        if (ruleOffset && !SanitizeChainRule(sanitizer, chainRule, SFFalse, NULL, hasBacktrack, hasLookahead)) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeRuleSets(SanitizerRef sanitizer, Data context,
+    SFUInteger arrayOffset, SFUInteger ruleSetCount, SFBoolean isChained,
+    SFBoolean hasBacktrack, SFBoolean hasLookahead)
+{
+    Data offsetArray = Data_Subdata(context, arrayOffset);
+    SFUInteger index;
+
+    if (!SanitizeOffsetArray(sanitizer, context, arrayOffset, ruleSetCount)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < ruleSetCount; index++) {
+        SFOffset ruleSetOffset = UInt16Array_Value(offsetArray, index);
+        Data ruleSet = GetSubtable(sanitizer, context, ruleSetOffset);
+
+        /* A null rule set is skipped while applying the subtable. */
+        if (ruleSetOffset) {
+            if (isChained) {
+                if (!SanitizeChainRuleSet(sanitizer, ruleSet, hasBacktrack, hasLookahead)) {
+                    return SFFalse;
+                }
+            } else {
+                if (!SanitizeRuleSet(sanitizer, ruleSet)) {
+                    return SFFalse;
+                }
+            }
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeOptionalClassDef(SanitizerRef sanitizer, Data parent, SFOffset classDefOffset)
+{
+    if (classDefOffset) {
+        return SanitizeClassDef(sanitizer, GetSubtable(sanitizer, parent, classDefOffset));
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeChainContext(SanitizerRef sanitizer, Data chainContext)
+{
+    switch (ChainContext_Format(chainContext)) {
+        case 1:
+            return (CheckRange(sanitizer, chainContext, 6)
+                 && SanitizeCoverage(sanitizer, ChainContextF1_CoverageTable(chainContext))
+                 && SanitizeRuleSets(sanitizer, chainContext, 6, ChainContextF1_ChainRuleSetCount(chainContext),
+                                     SFTrue, SFTrue, SFTrue));
+
+        case 2: {
+            SFOffset backtrackOffset;
+            SFOffset lookaheadOffset;
+
+            if (!CheckRange(sanitizer, chainContext, 12)) {
+                return SFFalse;
+            }
+
+            backtrackOffset = ChainContextF2_BacktrackClassDefOffset(chainContext);
+            lookaheadOffset = ChainContextF2_LookaheadClassDefOffset(chainContext);
+
+            return (SanitizeCoverage(sanitizer, ChainContextF2_CoverageTable(chainContext))
+                 && SanitizeClassDef(sanitizer, ChainContextF2_InputClassDefTable(chainContext))
+                 && SanitizeOptionalClassDef(sanitizer, chainContext, backtrackOffset)
+                 && SanitizeOptionalClassDef(sanitizer, chainContext, lookaheadOffset)
+                 && SanitizeRuleSets(sanitizer, chainContext, 12, ChainContextF2_ChainRuleSetCount(chainContext),
+                                     SFTrue, backtrackOffset != 0, lookaheadOffset != 0));
+        }
+
+        case 3:
+            return SanitizeChainRule(sanitizer, ChainContextF3_ChainRuleTable(chainContext),
+                                     SFTrue, chainContext, SFTrue, SFTrue);
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeExtension(SanitizerRef sanitizer, Data extension)
+{
+    switch (Extension_Format(extension)) {
+        case 1: {
+            LookupType extensionType = (sanitizer->isGPOS ? LookupTypeExtensionPositioning : LookupTypeExtension);
+            LookupType lookupType;
+            Data innerSubtable;
+
+            if (!CheckRange(sanitizer, extension, 8)) {
+                return SFFalse;
+            }
+
+            lookupType = ExtensionF1_LookupType(extension);
+            innerSubtable = GetSubtable(sanitizer, extension, ExtensionF1_ExtensionOffset(extension));
+
+            /* An extension must not point to another extension, otherwise it may recurse forever. */
+            if (lookupType == extensionType) {
+                return SFFalse;
+            }
+
+            return SanitizeSubtable(sanitizer, lookupType, innerSubtable);
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeSingleSubst(SanitizerRef sanitizer, Data singleSubst)
+{
+    switch (SingleSubst_Format(singleSubst)) {
+        case 1:
+            return (CheckRange(sanitizer, singleSubst, 6)
+                 && SanitizeCoverage(sanitizer, SingleSubstF1_CoverageTable(singleSubst)));
+
+        case 2:
+            return (CheckRange(sanitizer, singleSubst, 6)
+                 && SanitizeCoverage(sanitizer, SingleSubstF2_CoverageTable(singleSubst))
+                 && SanitizeOffsetArray(sanitizer, singleSubst, 6, SingleSubstF2_GlyphCount(singleSubst)));
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeSequenceSubst(SanitizerRef sanitizer, Data sequenceSubst)
+{
+    SFUInt16 sequenceCount;
+    SFUInteger index;
+
+    /* Multiple and alternate substitutions share the same layout. */
+    if (MultipleSubst_Format(sequenceSubst) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, sequenceSubst, 6)
+        || !SanitizeCoverage(sanitizer, MultipleSubstF1_CoverageTable(sequenceSubst))) {
+        return SFFalse;
+    }
+
+    sequenceCount = MultipleSubstF1_SequenceCount(sequenceSubst);
+
+    if (!SanitizeOffsetArray(sanitizer, sequenceSubst, 6, sequenceCount)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < sequenceCount; index++) {
+        SFOffset sequenceOffset = MultipleSubstF1_SequenceOffset(sequenceSubst, index);
+
+        if (!SanitizeGlyphArray(sanitizer, GetSubtable(sanitizer, sequenceSubst, sequenceOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeLigatureSet(SanitizerRef sanitizer, Data ligatureSet)
+{
+    SFUInt16 ligatureCount;
+    SFUInteger index;
+
+    if (!ligatureSet || !CheckRange(sanitizer, ligatureSet, 2)) {
+        return SFFalse;
+    }
+
+    ligatureCount = LigatureSet_LigatureCount(ligatureSet);
+
+    if (!SanitizeOffsetArray(sanitizer, ligatureSet, 2, ligatureCount)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < ligatureCount; index++) {
+        SFOffset ligatureOffset = LigatureSet_LigatureOffset(ligatureSet, index);
+        Data ligature = GetSubtable(sanitizer, ligatureSet, ligatureOffset);
+        SFUInt16 compCount;
+
+        if (!ligature || !CheckRange(sanitizer, ligature, 4)) {
+            return SFFalse;
+        }
+
+        compCount = Ligature_CompCount(ligature);
+
+        /* The first component is implied by the coverage. */
+        if (compCount > 1 && !SanitizeOffsetArray(sanitizer, ligature, 4, compCount - 1)) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeLigatureSubst(SanitizerRef sanitizer, Data ligatureSubst)
+{
+    SFUInt16 ligSetCount;
+    SFUInteger index;
+
+    if (LigatureSubst_Format(ligatureSubst) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, ligatureSubst, 6)
+        || !SanitizeCoverage(sanitizer, LigatureSubstF1_CoverageTable(ligatureSubst))) {
+        return SFFalse;
+    }
+
+    ligSetCount = LigatureSubstF1_LigSetCount(ligatureSubst);
+
+    if (!SanitizeOffsetArray(sanitizer, ligatureSubst, 6, ligSetCount)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < ligSetCount; index++) {
+        SFOffset ligSetOffset = LigatureSubstF1_LigatureSetOffset(ligatureSubst, index);
+
+        if (!SanitizeLigatureSet(sanitizer, GetSubtable(sanitizer, ligatureSubst, ligSetOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeReverseChainSubst(SanitizerRef sanitizer, Data reverseChain)
+{
+    Data backtrackRecord;
+    SFUInt16 backtrackCount;
+    Data lookaheadRecord;
+    SFUInt16 lookaheadCount;
+    Data substRecord;
+
+    if (ReverseChainSubst_Format(reverseChain) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, reverseChain, 6)
+        || !SanitizeCoverage(sanitizer, ReverseChainSubstF1_CoverageTable(reverseChain))) {
+        return SFFalse;
+    }
+
+    backtrackRecord = ReverseChainSubstF1_RevBacktrackRecord(reverseChain);
+    backtrackCount = RevBacktrackRecord_GlyphCount(backtrackRecord);
+
+    if (!SanitizeValueArray(sanitizer, RevBacktrackRecord_CoverageOffsets(backtrackRecord), backtrackCount, reverseChain)) {
+        return SFFalse;
+    }
+
+    lookaheadRecord = RevBacktrackRecord_RevLookaheadRecord(backtrackRecord, backtrackCount);
+
+    if (!CheckRange(sanitizer, lookaheadRecord, 2)) {
+        return SFFalse;
+    }
+
+    lookaheadCount = RevLookaheadRecord_GlyphCount(lookaheadRecord);
+
+    if (!SanitizeValueArray(sanitizer, RevLookaheadRecord_CoverageOffsets(lookaheadRecord), lookaheadCount, reverseChain)) {
+        return SFFalse;
+    }
+
+    substRecord = RevLookaheadRecord_RevSubstRecord(lookaheadRecord, lookaheadCount);
+
+    return SanitizeGlyphArray(sanitizer, substRecord);
+}
+
+static SFBoolean SanitizeSubstSubtable(SanitizerRef sanitizer, LookupType lookupType, Data subtable)
+{
+    switch (lookupType) {
+        case LookupTypeSingle:
+            return SanitizeSingleSubst(sanitizer, subtable);
+
+        case LookupTypeMultiple:
+        case LookupTypeAlternate:
+            return SanitizeSequenceSubst(sanitizer, subtable);
+
+        case LookupTypeLigature:
+            return SanitizeLigatureSubst(sanitizer, subtable);
+
+        case LookupTypeContext:
+            return SanitizeContext(sanitizer, subtable);
+
+        case LookupTypeChainingContext:
+            return SanitizeChainContext(sanitizer, subtable);
+
+        case LookupTypeExtension:
+            return SanitizeExtension(sanitizer, subtable);
+
+        case LookupTypeReverseChainingContext:
+            return SanitizeReverseChainSubst(sanitizer, subtable);
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeSinglePos(SanitizerRef sanitizer, Data singlePos)
+{
+    switch (SinglePos_Format(singlePos)) {
+        case 1: {
+            SFUInt16 valueFormat;
+            Data valueRecord;
+
+            if (!CheckRange(sanitizer, singlePos, 6)) {
+                return SFFalse;
+            }
+
+            valueFormat = SinglePosF1_ValueFormat(singlePos);
+            valueRecord = SinglePosF1_ValueRecord(singlePos);
+
+            return (SanitizeCoverage(sanitizer, SinglePosF1_CoverageTable(singlePos))
+                 && CheckRange(sanitizer, valueRecord, ValueRecord_Size(valueFormat))
+                 && SanitizeValueRecord(sanitizer, singlePos, valueRecord, valueFormat));
+        }
+
+        case 2: {
+            SFUInt16 valueFormat;
+            SFUInt16 valueCount;
+            SFUInteger valueSize;
+            SFUInteger index;
+
+            if (!CheckRange(sanitizer, singlePos, 8)) {
+                return SFFalse;
+            }
+
+            valueFormat = SinglePosF2_ValueFormat(singlePos);
+            valueCount = SinglePosF2_ValueCount(singlePos);
+            valueSize = ValueRecord_Size(valueFormat);
+
+            if (!SanitizeCoverage(sanitizer, SinglePosF2_CoverageTable(singlePos))
+                || !CheckArray(sanitizer, Data_Subdata(singlePos, 8), valueCount, valueSize)) {
+                return SFFalse;
+            }
+
+            if (HasDeviceTables(valueFormat)) {
+                for (index = 0; index < valueCount; index++) {
+                    Data valueRecord = SinglePosF2_ValueRecord(singlePos, index, valueSize);
+
+                    if (!SanitizeValueRecord(sanitizer, singlePos, valueRecord, valueFormat)) {
+                        return SFFalse;
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizePairSet(SanitizerRef sanitizer, Data pairSet,
+    SFUInt16 valueFormat1, SFUInt16 valueFormat2)
+{
+    SFUInteger value1Size = ValueRecord_Size(valueFormat1);
+    SFUInteger value2Size = ValueRecord_Size(valueFormat2);
+    SFUInteger recordSize = PairValueRecord_Size(value1Size, value2Size);
+    SFUInt16 valueCount;
+    SFUInteger index;
+
+    if (!pairSet || !CheckRange(sanitizer, pairSet, 2)) {
+        return SFFalse;
+    }
+
+    valueCount = PairSet_PairValueCount(pairSet);
+
+    if (!CheckArray(sanitizer, PairSet_PairValueRecordArray(pairSet), valueCount, recordSize)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < valueCount; index++) {
+        Data pairRecord = PairSet_PairValueRecord(pairSet, index, recordSize);
+
+        /* The records are binary searched by the second glyph. */
+        if (index > 0) {
+            Data prevRecord = PairSet_PairValueRecord(pairSet, index - 1, recordSize);
+
+            if (PairValueRecord_SecondGlyph(pairRecord) <= PairValueRecord_SecondGlyph(prevRecord)) {
+                return SFFalse;
+            }
+        }
+
+        if (!SanitizeValueRecord(sanitizer, pairSet, PairValueRecord_Value1(pairRecord), valueFormat1)
+            || !SanitizeValueRecord(sanitizer, pairSet, PairValueRecord_Value2(pairRecord, value1Size), valueFormat2)) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizePairPos(SanitizerRef sanitizer, Data pairPos)
+{
+    switch (PairPos_Format(pairPos)) {
+        case 1: {
+            SFUInt16 valueFormat1;
+            SFUInt16 valueFormat2;
+            SFUInt16 pairSetCount;
+            SFUInteger index;
+
+            if (!CheckRange(sanitizer, pairPos, 10)) {
+                return SFFalse;
+            }
+
+            valueFormat1 = PairPosF1_ValueFormat1(pairPos);
+            valueFormat2 = PairPosF1_ValueFormat2(pairPos);
+            pairSetCount = PairPosF1_PairSetCount(pairPos);
+
+            if (!SanitizeCoverage(sanitizer, PairPosF1_CoverageTable(pairPos))
+                || !SanitizeOffsetArray(sanitizer, pairPos, 10, pairSetCount)) {
+                return SFFalse;
+            }
+
+            for (index = 0; index < pairSetCount; index++) {
+                SFOffset pairSetOffset = PairPosF1_PairSetOffset(pairPos, index);
+                Data pairSet = GetSubtable(sanitizer, pairPos, pairSetOffset);
+
+                if (!SanitizePairSet(sanitizer, pairSet, valueFormat1, valueFormat2)) {
+                    return SFFalse;
+                }
+            }
+            break;
+        }
+
+        case 2: {
+            SFUInt16 valueFormat1;
+            SFUInt16 valueFormat2;
+            SFUInt16 class1Count;
+            SFUInt16 class2Count;
+            SFUInteger value1Size;
+            SFUInteger class2Size;
+            SFUInteger class1Size;
+
+            if (!CheckRange(sanitizer, pairPos, 16)) {
+                return SFFalse;
+            }
+
+            valueFormat1 = PairPosF2_ValueFormat1(pairPos);
+            valueFormat2 = PairPosF2_ValueFormat2(pairPos);
+            class1Count = PairPosF2_Class1Count(pairPos);
+            class2Count = PairPosF2_Class2Count(pairPos);
+            value1Size = ValueRecord_Size(valueFormat1);
+            class2Size = Class2Record_Size(value1Size, ValueRecord_Size(valueFormat2));
+            class1Size = Class1Record_Size(class2Count, class2Size);
+
+            if (!SanitizeCoverage(sanitizer, PairPosF2_CoverageTable(pairPos))
+                || !SanitizeClassDef(sanitizer, PairPosF2_ClassDef1Table(pairPos))
+                || !SanitizeClassDef(sanitizer, PairPosF2_ClassDef2Table(pairPos))
+                || !CheckArray(sanitizer, Data_Subdata(pairPos, 16), class1Count, class1Size)) {
+                return SFFalse;
+            }
+
+            if (HasDeviceTables(valueFormat1) || HasDeviceTables(valueFormat2)) {
+                SFUInteger class1Index;
+                SFUInteger class2Index;
+
+                for (class1Index = 0; class1Index < class1Count; class1Index++) {
+                    Data class1Record = PairPosF2_Class1Record(pairPos, class1Index, class1Size);
+
+                    for (class2Index = 0; class2Index < class2Count; class2Index++) {
+                        Data class2Record = Class1Record_Class2Record(class1Record, class2Index, class2Size);
+
+                        if (!SanitizeValueRecord(sanitizer, pairPos, Class2Record_Value1(class2Record), valueFormat1)
+                            || !SanitizeValueRecord(sanitizer, pairPos, Class2Record_Value2(class2Record, value1Size), valueFormat2)) {
+                            return SFFalse;
+                        }
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeCursivePos(SanitizerRef sanitizer, Data cursivePos)
+{
+    SFUInt16 entryExitCount;
+    SFUInteger index;
+
+    if (CursivePos_Format(cursivePos) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, cursivePos, 6)
+        || !SanitizeCoverage(sanitizer, CursivePos_CoverageTable(cursivePos))) {
+        return SFFalse;
+    }
+
+    entryExitCount = CursivePos_EntryExitCount(cursivePos);
+
+    if (!CheckArray(sanitizer, Data_Subdata(cursivePos, 6), entryExitCount, 4)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < entryExitCount; index++) {
+        Data entryExitRecord = CursivePos_EntryExitRecord(cursivePos, index);
+        SFOffset entryOffset = EntryExitRecord_EntryAnchorOffset(entryExitRecord);
+        SFOffset exitOffset = EntryExitRecord_ExitAnchorOffset(entryExitRecord);
+
+        /* Null anchors are skipped while positioning. */
+        if ((entryOffset && !SanitizeAnchor(sanitizer, GetSubtable(sanitizer, cursivePos, entryOffset)))
+            || (exitOffset && !SanitizeAnchor(sanitizer, GetSubtable(sanitizer, cursivePos, exitOffset)))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeMarkArray(SanitizerRef sanitizer, Data markArray)
+{
+    SFUInt16 markCount;
+    SFUInteger index;
+
+    if (!markArray || !CheckRange(sanitizer, markArray, 2)) {
+        return SFFalse;
+    }
+
+    markCount = MarkArray_MarkCount(markArray);
+
+    if (!CheckArray(sanitizer, Data_Subdata(markArray, 2), markCount, 4)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < markCount; index++) {
+        Data markRecord = MarkArray_MarkRecord(markArray, index);
+        SFOffset anchorOffset = MarkRecord_MarkAnchorOffset(markRecord);
+
+        if (!SanitizeAnchor(sanitizer, GetSubtable(sanitizer, markArray, anchorOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeAnchorMatrix(SanitizerRef sanitizer, Data parent,
+    SFUInteger rowCount, SFUInt16 classCount)
+{
+    Data anchorArray = Data_Subdata(parent, 2);
+    SFUInteger anchorCount;
+    SFUInteger index;
+
+    /* Base, ligature component and mark2 records are rows of anchor offsets, one per class. */
+    if (!CheckArray(sanitizer, anchorArray, rowCount, 2 * (SFUInteger)classCount)) {
+        return SFFalse;
+    }
+
+    anchorCount = rowCount * classCount;
+
+    for (index = 0; index < anchorCount; index++) {
+        SFOffset anchorOffset = UInt16Array_Value(anchorArray, index);
+
+        if (!SanitizeAnchor(sanitizer, GetSubtable(sanitizer, parent, anchorOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeMarkAttachPos(SanitizerRef sanitizer, Data markAttachPos)
+{
+    SFUInt16 classCount;
+    Data attachArray;
+
+    /* Mark to base and mark to mark attachments share the same layout. */
+    if (MarkBasePos_Format(markAttachPos) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, markAttachPos, 12)) {
+        return SFFalse;
+    }
+
+    classCount = MarkBasePos_ClassCount(markAttachPos);
+    attachArray = MarkBasePos_BaseArrayTable(markAttachPos);
+
+    return (SanitizeCoverage(sanitizer, MarkBasePos_MarkCoverageTable(markAttachPos))
+         && SanitizeCoverage(sanitizer, MarkBasePos_BaseCoverageTable(markAttachPos))
+         && SanitizeMarkArray(sanitizer, MarkBasePos_MarkArrayTable(markAttachPos))
+         && CheckRange(sanitizer, attachArray, 2)
+         && SanitizeAnchorMatrix(sanitizer, attachArray, BaseArray_BaseCount(attachArray), classCount));
+}
+
+static SFBoolean SanitizeMarkLigPos(SanitizerRef sanitizer, Data markLigPos)
+{
+    SFUInt16 classCount;
+    Data ligArray;
+    SFUInt16 ligCount;
+    SFUInteger index;
+
+    if (MarkLigPos_Format(markLigPos) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, markLigPos, 12)) {
+        return SFFalse;
+    }
+
+    classCount = MarkLigPos_ClassCount(markLigPos);
+    ligArray = MarkLigPos_LigatureArrayTable(markLigPos);
+
+    if (!SanitizeCoverage(sanitizer, MarkLigPos_MarkCoverageTable(markLigPos))
+        || !SanitizeCoverage(sanitizer, MarkLigPos_LigatureCoverageTable(markLigPos))
+        || !SanitizeMarkArray(sanitizer, MarkLigPos_MarkArrayTable(markLigPos))
+        || !CheckRange(sanitizer, ligArray, 2)) {
+        return SFFalse;
+    }
+
+    ligCount = LigatureArray_LigatureCount(ligArray);
+
+    if (!SanitizeOffsetArray(sanitizer, ligArray, 2, ligCount)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < ligCount; index++) {
+        SFOffset ligAttachOffset = LigatureArray_LigatureAttachOffset(ligArray, index);
+        Data ligAttach = GetSubtable(sanitizer, ligArray, ligAttachOffset);
+        SFUInt16 compCount;
+
+        if (!ligAttach || !CheckRange(sanitizer, ligAttach, 2)) {
+            return SFFalse;
+        }
+
+        compCount = LigatureAttach_ComponentCount(ligAttach);
+
+        /* The last component is used as a fallback, so there must be at least one. */
+        if (compCount == 0 || !SanitizeAnchorMatrix(sanitizer, ligAttach, compCount, classCount)) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizePosSubtable(SanitizerRef sanitizer, LookupType lookupType, Data subtable)
+{
+    switch (lookupType) {
+        case LookupTypeSingleAdjustment:
+            return SanitizeSinglePos(sanitizer, subtable);
+
+        case LookupTypePairAdjustment:
+            return SanitizePairPos(sanitizer, subtable);
+
+        case LookupTypeCursiveAttachment:
+            return SanitizeCursivePos(sanitizer, subtable);
+
+        case LookupTypeMarkToBaseAttachment:
+        case LookupTypeMarkToMarkAttachment:
+            return SanitizeMarkAttachPos(sanitizer, subtable);
+
+        case LookupTypeMarkToLigatureAttachment:
+            return SanitizeMarkLigPos(sanitizer, subtable);
+
+        case LookupTypeContextPositioning:
+            return SanitizeContext(sanitizer, subtable);
+
+        case LookupTypeChainedContextPositioning:
+            return SanitizeChainContext(sanitizer, subtable);
+
+        case LookupTypeExtensionPositioning:
+            return SanitizeExtension(sanitizer, subtable);
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeSubtable(SanitizerRef sanitizer, LookupType lookupType, Data subtable)
+{
+    SFUInteger position;
+    SFBoolean isValid;
+
+    /* Every subtable begins with its format. */
+    if (!subtable || !CheckRange(sanitizer, subtable, 2)) {
+        return SFFalse;
+    }
+
+    position = (SFUInteger)(subtable - sanitizer->table);
+
+    /* Validate a subtable shared by multiple offsets only once. */
+    if (sanitizer->subtableStates && lookupType <= SubtableStateTypeMask) {
+        SFUInt8 state = sanitizer->subtableStates[position];
+
+        if (state) {
+            /* The same subtable cannot be meant for different types of lookups. */
+            return ((state & SubtableStateTypeMask) == lookupType && (state & SubtableStateValid));
+        }
+    }
+
+    if (sanitizer->isGPOS) {
+        isValid = SanitizePosSubtable(sanitizer, lookupType, subtable);
+    } else {
+        isValid = SanitizeSubstSubtable(sanitizer, lookupType, subtable);
+    }
+
+    if (sanitizer->subtableStates && lookupType <= SubtableStateTypeMask) {
+        sanitizer->subtableStates[position] = (SFUInt8)(lookupType | (isValid ? SubtableStateValid : 0));
+    }
+
+    return isValid;
+}
+
+static SFBoolean SanitizeLookup(SanitizerRef sanitizer, Data lookup)
+{
+    LookupType lookupType;
+    LookupFlag lookupFlag;
+    SFUInt16 subtableCount;
+    SFUInteger index;
+
+    if (!lookup || !CheckRange(sanitizer, lookup, 6)) {
+        return SFFalse;
+    }
+
+    lookupType = Lookup_LookupType(lookup);
+    lookupFlag = Lookup_LookupFlag(lookup);
+    subtableCount = Lookup_SubtableCount(lookup);
+
+    if (!SanitizeOffsetArray(sanitizer, lookup, 6, subtableCount)) {
+        return SFFalse;
+    }
+
+    /* The mark filtering set is read from where the engine expects it. */
+    if ((lookupFlag & LookupFlagUseMarkFilteringSet)
+        && !CheckRange(sanitizer, lookup, 10 + ((SFUInteger)subtableCount * 2))) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < subtableCount; index++) {
+        SFOffset subtableOffset = Lookup_SubtableOffset(lookup, index);
+        Data subtable = GetSubtable(sanitizer, lookup, subtableOffset);
+
+        if (!SanitizeSubtable(sanitizer, lookupType, subtable)) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeLayoutTable(Data table, SFUInteger length, SFBoolean isGPOS,
+    SFUInt8 **outLookupMask)
+{
+    Sanitizer sanitizer;
+    SFUInt32 version;
+    Data lookupList;
+    SFUInt8 *lookupMask;
+    SFUInteger maskSize;
+    SFUInteger index;
+
+    *outLookupMask = NULL;
+
+    InitializeSanitizer(&sanitizer, table, length, isGPOS);
+
+    if (!table || !CheckRange(&sanitizer, table, 10)) {
+        return SFFalse;
+    }
+
+    version = Header_Version(table);
+
+    if ((version >> 16) != 1 || (version == 0x00010001 && !CheckRange(&sanitizer, table, 14))) {
+        return SFFalse;
+    }
+
+    lookupList = GetSubtable(&sanitizer, table, Header_LookupListOffset(table));
+
+    if (!lookupList || !CheckRange(&sanitizer, lookupList, 2)) {
+        return SFFalse;
+    }
+
+    sanitizer.lookupCount = LookupList_LookupCount(lookupList);
+
+    if (!SanitizeOffsetArray(&sanitizer, lookupList, 2, sanitizer.lookupCount)
+        || !SanitizeFeatureList(&sanitizer, GetSubtable(&sanitizer, table, Header_FeatureListOffset(table)))
+        || !SanitizeScriptList(&sanitizer, GetSubtable(&sanitizer, table, Header_ScriptListOffset(table)))) {
+        return SFFalse;
+    }
+
+    if (version == 0x00010001) {
+        SFUInt32 featureVarsOffset = HeaderV11_FeatureVariationsOffset(table);
+
+        if (featureVarsOffset
+            && !SanitizeFeatureVars(&sanitizer, GetSubtable(&sanitizer, table, featureVarsOffset))) {
+            return SFFalse;
+        }
+    }
+
+    maskSize = ((SFUInteger)sanitizer.lookupCount >> 3) + 1;
+    lookupMask = malloc(maskSize);
+    memset(lookupMask, 0, maskSize);
+
+    /* Keep a state for each byte of the table as a subtable may begin anywhere. */
+    sanitizer.subtableStates = calloc(length, sizeof(SFUInt8));
+
+    /* Keep the table, but leave out the lookups that are malformed. */
+    for (index = 0; index < sanitizer.lookupCount; index++) {
+        SFOffset lookupOffset = LookupList_LookupOffset(lookupList, index);
+        Data lookup = GetSubtable(&sanitizer, lookupList, lookupOffset);
+
+        if (SanitizeLookup(&sanitizer, lookup)) {
+            lookupMask[index >> 3] |= (SFUInt8)(1 << (index & 7));
+        }
+    }
+
+    free(sanitizer.subtableStates);
+
+    /* Reject the whole table if it took too long to validate. */
+    if (sanitizer.isExhausted) {
+        free(lookupMask);
+        return SFFalse;
+    }
+
+    *outLookupMask = lookupMask;
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeItemVarStore(SanitizerRef sanitizer, Data varStore)
+{
+    Data regionList;
+    SFUInt16 dataCount;
+    SFUInteger index;
+
+    if (!varStore || !CheckRange(sanitizer, varStore, 2)) {
+        return SFFalse;
+    }
+
+    /* Unknown formats are ignored while positioning. */
+    if (ItemVarStore_Format(varStore) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, varStore, 8)) {
+        return SFFalse;
+    }
+
+    regionList = GetSubtable(sanitizer, varStore, ItemVarStore_VarRegionListOffset(varStore));
+
+    if (!regionList || !CheckRange(sanitizer, regionList, 4)
+        || !CheckArray(sanitizer, Data_Subdata(regionList, 4), VarRegionList_RegionCount(regionList),
+                       (SFUInteger)VarRegionList_AxisCount(regionList) * 6)) {
+        return SFFalse;
+    }
+
+    dataCount = ItemVarStore_ItemVarDataCount(varStore);
+
+    if (!CheckArray(sanitizer, Data_Subdata(varStore, 8), dataCount, 4)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < dataCount; index++) {
+        SFUInt32 varDataOffset = ItemVarStore_ItemVarDataOffset(varStore, index);
+        Data varData = GetSubtable(sanitizer, varStore, varDataOffset);
+        SFUInt16 itemCount;
+        SFUInt16 shortDeltaCount;
+        SFUInt16 regionIndexCount;
+
+        if (!varData || !CheckRange(sanitizer, varData, 6)) {
+            return SFFalse;
+        }
+
+        itemCount = ItemVarData_ItemCount(varData);
+        shortDeltaCount = ItemVarData_ShortDeltaCount(varData);
+        regionIndexCount = ItemVarData_RegionIndexCount(varData);
+
+        if (!SanitizeOffsetArray(sanitizer, varData, 6, regionIndexCount)
+            || !CheckArray(sanitizer, ItemVarData_DeltaSetRowsArray(varData, regionIndexCount), itemCount,
+                           DeltaSetRecord_Size((SFUInteger)shortDeltaCount, regionIndexCount))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+static SFBoolean SanitizeDeltaSetIndexMap(SanitizerRef sanitizer, Data indexMap)
+{
+    SFUInt8 entryFormat;
+    SFUInt32 mapCount;
+    Data mapData;
+
+    if (!indexMap || !CheckRange(sanitizer, indexMap, 4)) {
+        return SFFalse;
+    }
+
+    entryFormat = DeltaSetIndexMap_EntryFormat(indexMap);
+
+    switch (DeltaSetIndexMap_Format(indexMap)) {
+        case 0:
+            mapCount = DeltaSetIndexMapF0_MapCount(indexMap);
+            mapData = DeltaSetIndexMapF0_MapData(indexMap);
+            break;
+
+        case 1:
+            if (!CheckRange(sanitizer, indexMap, 6)) {
+                return SFFalse;
+            }
+
+            mapCount = DeltaSetIndexMapF1_MapCount(indexMap);
+            mapData = DeltaSetIndexMapF1_MapData(indexMap);
+            break;
+
+        default:
+            return SFFalse;
+    }
+
+    /* An empty map cannot provide the last entry for the glyphs beyond it. */
+    return (mapCount > 0 && (entryFormat & 0xC0) == 0
+            && CheckArray(sanitizer, mapData, mapCount, EntryFormat_MapEntrySize(entryFormat)));
+}
+
+static SFBoolean SanitizeMarkGlyphSets(SanitizerRef sanitizer, Data markGlyphSets)
+{
+    SFUInt16 markSetCount;
+    SFUInteger index;
+
+    if (!markGlyphSets || !CheckRange(sanitizer, markGlyphSets, 2)) {
+        return SFFalse;
+    }
+
+    if (MarkGlyphSets_Format(markGlyphSets) != 1) {
+        return SFTrue;
+    }
+
+    if (!CheckRange(sanitizer, markGlyphSets, 4)) {
+        return SFFalse;
+    }
+
+    markSetCount = MarkGlyphSets_MarkSetCount(markGlyphSets);
+
+    if (!CheckArray(sanitizer, Data_Subdata(markGlyphSets, 4), markSetCount, 4)) {
+        return SFFalse;
+    }
+
+    for (index = 0; index < markSetCount; index++) {
+        SFUInt32 coverageOffset = MarkGlyphSets_CoverageOffset(markGlyphSets, index);
+
+        if (!SanitizeCoverage(sanitizer, GetSubtable(sanitizer, markGlyphSets, coverageOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+SF_INTERNAL SFBoolean SanitizeGDEF(Data gdef, SFUInteger length)
+{
+    Sanitizer sanitizer;
+    SFUInt32 version;
+    SFOffset classDefOffset;
+
+    InitializeSanitizer(&sanitizer, gdef, length, SFFalse);
+
+    if (!gdef || !CheckRange(&sanitizer, gdef, 12)) {
+        return SFFalse;
+    }
+
+    version = GDEF_Version(gdef);
+
+    if ((version >> 16) != 1
+        || (version >= 0x00010002 && !CheckRange(&sanitizer, gdef, 14))
+        || (version >= 0x00010003 && !CheckRange(&sanitizer, gdef, 18))) {
+        return SFFalse;
+    }
+
+    /* Only the subtables used while shaping are validated, each of them being optional. */
+    classDefOffset = GDEF_GlyphClassDefOffset(gdef);
+    if (classDefOffset && !SanitizeClassDef(&sanitizer, GetSubtable(&sanitizer, gdef, classDefOffset))) {
+        return SFFalse;
+    }
+
+    classDefOffset = GDEF_MarkAttachClassDefOffset(gdef);
+    if (classDefOffset && !SanitizeClassDef(&sanitizer, GetSubtable(&sanitizer, gdef, classDefOffset))) {
+        return SFFalse;
+    }
+
+    if (version >= 0x00010002) {
+        SFOffset markGlyphSetsOffset = GDEFv12_MarkGlyphSetsDefOffset(gdef);
+
+        if (markGlyphSetsOffset
+            && !SanitizeMarkGlyphSets(&sanitizer, GetSubtable(&sanitizer, gdef, markGlyphSetsOffset))) {
+            return SFFalse;
+        }
+    }
+
+    if (version >= 0x00010003) {
+        SFUInt32 varStoreOffset = GDEFv13_ItemVarStoreOffset(gdef);
+
+        if (varStoreOffset
+            && !SanitizeItemVarStore(&sanitizer, GetSubtable(&sanitizer, gdef, varStoreOffset))) {
+            return SFFalse;
+        }
+    }
+
+    return SFTrue;
+}
+
+SF_INTERNAL SFBoolean SanitizeHVAR(Data hvar, SFUInteger length)
+{
+    Sanitizer sanitizer;
+    SFUInt32 mappingOffset;
+
+    InitializeSanitizer(&sanitizer, hvar, length, SFFalse);
+
+    if (!hvar || !CheckRange(&sanitizer, hvar, HVAR_Size()) || HVAR_MajorVersion(hvar) != 1) {
+        return SFFalse;
+    }
+
+    /* Only the advance deltas are used, so the side bearing mappings are not validated. */
+    if (!SanitizeItemVarStore(&sanitizer, GetSubtable(&sanitizer, hvar, HVAR_ItemVarStoreOffset(hvar)))) {
+        return SFFalse;
+    }
+
+    mappingOffset = HVAR_AdvanceWidthMappingOffset(hvar);
+    if (mappingOffset && !SanitizeDeltaSetIndexMap(&sanitizer, GetSubtable(&sanitizer, hvar, mappingOffset))) {
+        return SFFalse;
+    }
+
+    return SFTrue;
+}
+
+SF_INTERNAL SFBoolean SanitizeGSUB(Data gsub, SFUInteger length, SFUInt8 **outLookupMask)
+{
+    return SanitizeLayoutTable(gsub, length, SFFalse, outLookupMask);
+}
+
+SF_INTERNAL SFBoolean SanitizeGPOS(Data gpos, SFUInteger length, SFUInt8 **outLookupMask)
+{
+    return SanitizeLayoutTable(gpos, length, SFTrue, outLookupMask);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SF_INTERNAL_SANITIZER_H
+#define _SF_INTERNAL_SANITIZER_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+
+/**
+ * Returns whether the lookup at given index is enabled in the lookup mask of a sanitized table.
+ */
+#define LookupMask_Contains(mask, index) \
+    (((mask)[(index) >> 3] >> ((index) & 7)) & 1)
+
+/**
+ * Validates all offsets, counts and orderings of a GDEF table once, so that it can be accessed
+ * without any further checks.
+ *
+ * @return
+ *      SFTrue if the table is well formed, SFFalse otherwise.
+ */
+SF_INTERNAL SFBoolean SanitizeGDEF(Data gdef, SFUInteger length);
+
+/**
+ * Validates the item variation store and the advance width mapping of an HVAR table.
+ *
+ * @return
+ *      SFTrue if the table is well formed, SFFalse otherwise.
+ */
+SF_INTERNAL SFBoolean SanitizeHVAR(Data hvar, SFUInteger length);
+
+/**
+ * Validates a GSUB table. The header, script list and feature list must be well formed for the
+ * table to be accepted. A malformed lookup only disables itself and is cleared in the returned
+ * lookup mask, which holds one bit per lookup and must be freed by the caller. A subtable shared
+ * by multiple lookups is validated only once, and the table is rejected if validating it takes
+ * many more operations than its size warrants.
+ *
+ * @return
+ *      SFTrue if the table is accepted, SFFalse otherwise.
+ */
+SF_INTERNAL SFBoolean SanitizeGSUB(Data gsub, SFUInteger length, SFUInt8 **outLookupMask);
+
+/**
+ * Validates a GPOS table in the same way as a GSUB table.
+ */
+SF_INTERNAL SFBoolean SanitizeGPOS(Data gpos, SFUInteger length, SFUInt8 **outLookupMask);
+
+#endif
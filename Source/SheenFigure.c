@@ -20,13 +20,26 @@
 #ifdef SF_CONFIG_UNITY
 
 #include "ArabicEngine.c"
+#include "CharacterMap.c"
+#include "DeltaCache.c"
+#include "FontFile.c"
+#include "GlyphCache.c"
+#include "GlyphDefinitions.c"
 #include "GlyphDiscovery.c"
 #include "GlyphManipulation.c"
 #include "GlyphPositioning.c"
 #include "GlyphSubstitution.c"
+#include "Hash.c"
+#include "LayoutIndex.c"
 #include "List.c"
 #include "Locator.c"
+#include "LookupDigest.c"
+#include "Metrics.c"
+#include "Mutex.c"
 #include "OpenType.c"
+#include "PairCache.c"
+#include "PairMatrix.c"
+#include "PatternCache.c"
 #include "SFAlbum.c"
 #include "SFArtist.c"
 #include "SFBase.c"
@@ -36,8 +49,10 @@
 #include "SFPattern.c"
 #include "SFPatternBuilder.c"
 #include "SFScheme.c"
+#include "Sanitizer.c"
 #include "ShapingEngine.c"
 #include "ShapingKnowledge.c"
+#include "SlotCache.c"
 #include "StandardEngine.c"
 #include "TextProcessor.c"
 #include "UnifiedEngine.c"
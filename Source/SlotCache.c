@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <SFConfig.h>
+#include <stddef.h>
+
+#include "SFBase.h"
+#include "Data.h"
+#include "SlotCache.h"
+
+SF_INTERNAL void SlotCacheClear(void *entries, SFUInteger entryCount, SFUInteger entrySize)
+{
+    SFUInt8 *entryBytes = entries;
+    SFUInteger index;
+
+    for (index = 0; index < entryCount; index++) {
+        SlotKey *key = (SlotKey *)(entryBytes + (index * entrySize));
+        key->table = NULL;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SF_INTERNAL_SLOT_CACHE_H
+#define _SF_INTERNAL_SLOT_CACHE_H
+
+#include <SFConfig.h>
+
+#include "SFBase.h"
+#include "Data.h"
+
+/**
+ * The key of an entry in a direct-mapped cache, made of a table and a number qualifying it within
+ * the table. The entries of such caches begin with the key so that they are managed alike.
+ */
+typedef struct _SlotKey {
+    Data table;                 /**< The table of the entry, NULL if the entry is vacant. */
+    SFUInt32 number;            /**< The number qualifying the table, such as a glyph pair or a size. */
+} SlotKey;
+
+/**
+ * Mixes the number along with the address of the table, taking the top bits of the product as the
+ * slot in a cache of 2^bits entries.
+ */
+#define SlotIndexOf(table, number, bits) \
+    ((SFUInteger)(((((SFUInt32)(SFUInteger)(table)) ^ (SFUInt32)(number)) * 0x9E3779B1UL) & 0xFFFFFFFF) >> (32 - (bits)))
+
+#define SlotKeyMatches(key, table_, number_) \
+    ((key)->table == (table_) && (key)->number == (number_))
+
+#define SlotKeySet(key, table_, number_) \
+do {                                     \
+    (key)->table = (table_);             \
+    (key)->number = (number_);           \
+} while (0)
+
+/**
+ * Vacates all entries of a cache, so that it no longer refers to any table. Each entry must begin
+ * with a slot key.
+ */
+SF_INTERNAL void SlotCacheClear(void *entries, SFUInteger entryCount, SFUInteger entrySize);
+
+#endif
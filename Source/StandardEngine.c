@@ -94,8 +94,8 @@ static void StandardEngineProcessAlbum(const void *object, SFAlbumRef album)
     SFArtistRef artist = standardEngine->_artist;
     TextProcessor processor;
 
-    TextProcessorInitialize(&processor, artist->pattern, album, artist->textDirection,
-                              artist->ppemWidth, artist->ppemHeight, SFFalse);
+    TextProcessorInitialize(&processor, artist->pattern, album, &artist->_pairCache, &artist->_deltaCache,
+                              artist->textDirection, artist->ppemWidth, artist->ppemHeight, SFFalse);
     TextProcessorDiscoverGlyphs(&processor);
     TextProcessorSubstituteGlyphs(&processor);
     TextProcessorPositionGlyphs(&processor);
@@ -19,6 +19,7 @@
 #include "Common.h"
 #include "Data.h"
 #include "GDEF.h"
+#include "GPOS.h"
 #include "GSUB.h"
 #include "Locator.h"
 #include "SFAlbum.h"
@@ -27,6 +28,7 @@
 #include "SFBase.h"
 #include "SFFont.h"
 #include "SFPattern.h"
+#include "Sanitizer.h"
 
 #include "GlyphDiscovery.h"
 #include "GlyphManipulation.h"
@@ -36,22 +38,33 @@
 
 static void ApplyFeatureRange(TextProcessorRef textProcessor, SFFeatureKind featureKind, SFUInteger index, SFUInteger count);
 
+static SFBoolean IsLookupUsable(TextProcessorRef textProcessor, SFUInt16 lookupIndex);
 static LookupType PrepareLookup(TextProcessorRef textProcessor, SFUInt16 lookupIndex, Data *outLookupTable);
-static void ApplySubtables(TextProcessorRef textProcessor, Data lookupTable, LookupType lookupType);
+static LookupDigestRef GetLookupDigest(TextProcessorRef textProcessor, SFUInt16 lookupIndex);
+static PairMatrixRef *GetPairMatrices(TextProcessorRef textProcessor, SFUInt16 lookupIndex, LookupType lookupType);
+static void ApplySubtables(TextProcessorRef textProcessor, LookupDigestRef lookupDigest,
+    PairMatrixRef *pairMatrices, Data lookupTable, LookupType lookupType);
 
 SF_INTERNAL void TextProcessorInitialize(TextProcessorRef textProcessor,
-    SFPatternRef pattern, SFAlbumRef album, SFTextDirection textDirection,
+    SFPatternRef pattern, SFAlbumRef album, PairCacheRef pairCache, DeltaCacheRef deltaCache,
+    SFTextDirection textDirection,
     SFUInt16 ppemWidth, SFUInt16 ppemHeight, SFBoolean zeroWidthMarks)
 {
     SFFontRef font = pattern->font;
-    Data gdef = font->resource->gdef;
+    Data gdef = SFFontGetGDEFTable(font);
 
     textProcessor->_pattern = pattern;
     textProcessor->_album = album;
     textProcessor->_coordArray = font->coordArray;
     textProcessor->_coordCount = font->coordCount;
+    textProcessor->_regionScalars = NULL;
+    textProcessor->_glyphDefinitions = SFFontGetGlyphDefinitions(font);
     textProcessor->_glyphClassDef = NULL;
     textProcessor->_itemVarStore = NULL;
+    textProcessor->_pairMatrixList = NULL;
+    textProcessor->_pairMatrix = NULL;
+    textProcessor->_pairCache = pairCache;
+    textProcessor->_deltaCache = deltaCache;
     textProcessor->_textDirection = textDirection;
     textProcessor->_ppemWidth = ppemWidth;
     textProcessor->_ppemHeight = ppemHeight;
@@ -59,11 +72,15 @@ SF_INTERNAL void TextProcessorInitialize(TextProcessorRef textProcessor,
     textProcessor->_containsZeroWidthCodepoints = SFFalse;
 
     if (gdef) {
-        textProcessor->_glyphClassDef = GDEF_GlyphClassDefTable(gdef);
+        textProcessor->_glyphClassDef = GDEF_OptionalGlyphClassDefTable(gdef);
         textProcessor->_itemVarStore = GDEF_ItemVarStoreTable(gdef);
+
+        if (textProcessor->_itemVarStore) {
+            textProcessor->_regionScalars = SFFontGetRegionScalars(font);
+        }
     }
 
-    LocatorInitialize(&textProcessor->_locator, album, gdef);
+    LocatorInitialize(&textProcessor->_locator, album, gdef, textProcessor->_glyphDefinitions);
 }
 
 SF_INTERNAL void TextProcessorDiscoverGlyphs(TextProcessorRef textProcessor)
@@ -76,12 +93,14 @@ SF_INTERNAL void TextProcessorSubstituteGlyphs(TextProcessorRef textProcessor)
 {
     SFAlbumRef album = textProcessor->_album;
     SFPatternRef pattern = textProcessor->_pattern;
-    Data gsubTable = pattern->font->resource->gsub;
+    Data gsubTable = SFFontGetGSUBTable(pattern->font);
 
     if (gsubTable) {
         Data lookupListTable = Header_LookupListTable(gsubTable);
 
         textProcessor->_lookupList = lookupListTable;
+        textProcessor->_lookupMask = SFFontGetGSUBLookupMask(pattern->font);
+        textProcessor->_lookupDigests = SFFontGetGSUBDigests(pattern->font);
         textProcessor->_lookupOperation = ApplySubstitutionSubtable;
 
         ApplyFeatureRange(textProcessor, SFFeatureKindSubstitution, 0, pattern->featureUnits.gsub);
@@ -132,32 +151,38 @@ SF_INTERNAL void TextProcessorPositionGlyphs(TextProcessorRef textProcessor)
     SFAlbumRef album = textProcessor->_album;
     SFPatternRef pattern = textProcessor->_pattern;
     SFFontRef font = pattern->font;
-    Data gposTable = font->resource->gpos;
+    Data gposTable = SFFontGetGPOSTable(font);
     SFUInteger glyphCount = album->glyphCount;
     SFUInteger index;
 
     SFAlbumBeginArranging(album);
 
-    /* Set positions and advances of all glyphs. */
+    /* Get the advances of all glyphs at once. */
+    if (glyphCount) {
+        SFFontGetAdvancesForGlyphs(font, SFFontLayoutHorizontal,
+            SFAlbumGetGlyphArray(album, 0), SFAlbumGetAdvanceArray(album, 0), glyphCount);
+    }
+
+    /* Set positions of all glyphs. */
     for (index = 0; index < glyphCount; index++) {
-        SFGlyphID glyphID = SFAlbumGetGlyph(album, index);
         GlyphTraits traits = SFAlbumGetAllTraits(album, index);
-        SFAdvance advance = 0;
 
         /* Ignore placeholder glyphs. */
-        if (traits != GlyphTraitPlaceholder) {
-            advance = SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, glyphID);
+        if (traits == GlyphTraitPlaceholder) {
+            SFAlbumSetAdvance(album, index, 0);
         }
 
         SFAlbumSetX(album, index, 0);
         SFAlbumSetY(album, index, 0);
-        SFAlbumSetAdvance(album, index, advance);
     }
 
     if (gposTable) {
         Data lookupListTable = Header_LookupListTable(gposTable);
 
         textProcessor->_lookupList = lookupListTable;
+        textProcessor->_lookupMask = SFFontGetGPOSLookupMask(font);
+        textProcessor->_lookupDigests = SFFontGetGPOSDigests(font);
+        textProcessor->_pairMatrixList = SFFontGetPairMatrixList(font);
         textProcessor->_lookupOperation = ApplyPositioningSubtable;
 
         ApplyFeatureRange(textProcessor, SFFeatureKindPositioning, pattern->featureUnits.gsub, pattern->featureUnits.gpos);
@@ -195,26 +220,40 @@ static void ApplyFeatureRange(TextProcessorRef textProcessor, SFFeatureKind feat
             SFAlbumRef album = textProcessor->_album;
             LocatorRef locator = &textProcessor->_locator;
             SFLookupInfoRef lookupInfo = &lookupArray[lookupIndex];
+            LookupDigestRef lookupDigest;
+            PairMatrixRef *pairMatrices;
             Data lookupTable;
             LookupType lookupType;
 
+            if (!IsLookupUsable(textProcessor, lookupInfo->index)) {
+                continue;
+            }
+
+            lookupDigest = GetLookupDigest(textProcessor, lookupInfo->index);
+
+            /* Skip the lookup if none of the glyphs in the album can be affected by it. */
+            if (lookupDigest && !GlyphDigestMayIntersect(&lookupDigest->digest, &album->_glyphDigest)) {
+                continue;
+            }
+
             LocatorReset(locator, 0, album->glyphCount);
             LocatorSetFeatureMask(locator, featureUnit->mask);
 
             lookupType = PrepareLookup(textProcessor, lookupInfo->index, &lookupTable);
+            pairMatrices = GetPairMatrices(textProcessor, lookupInfo->index, lookupType);
             textProcessor->_lookupValue = lookupInfo->value;
             textProcessor->_lookupNesting = 0;
 
             /* Apply current lookup on all glyphs. */
             if (!reversible || lookupType != LookupTypeReverseChainingContext) {
                 while (LocatorMoveNext(locator)) {
-                    ApplySubtables(textProcessor, lookupTable, lookupType);
+                    ApplySubtables(textProcessor, lookupDigest, pairMatrices, lookupTable, lookupType);
                 }
             } else {
                 LocatorJumpTo(locator, album->glyphCount);
 
                 while (LocatorMovePrevious(locator)) {
-                    ApplySubtables(textProcessor, lookupTable, lookupType);
+                    ApplySubtables(textProcessor, lookupDigest, pairMatrices, lookupTable, lookupType);
                 }
             }
         }
@@ -226,8 +265,23 @@ SF_PRIVATE void ApplyLookup(TextProcessorRef textProcessor, SFUInt16 lookupIndex
     Data lookupTable;
     LookupType lookupType;
 
-    lookupType = PrepareLookup(textProcessor, lookupIndex, &lookupTable);
-    ApplySubtables(textProcessor, lookupTable, lookupType);
+    if (IsLookupUsable(textProcessor, lookupIndex)) {
+        lookupType = PrepareLookup(textProcessor, lookupIndex, &lookupTable);
+        ApplySubtables(textProcessor, GetLookupDigest(textProcessor, lookupIndex),
+                       GetPairMatrices(textProcessor, lookupIndex, lookupType), lookupTable, lookupType);
+    }
+}
+
+static SFBoolean IsLookupUsable(TextProcessorRef textProcessor, SFUInt16 lookupIndex)
+{
+    const SFUInt8 *lookupMask = textProcessor->_lookupMask;
+
+    /* The sanitizer has already validated the index, so only skip the malformed lookups. */
+    if (lookupMask) {
+        return LookupMask_Contains(lookupMask, lookupIndex);
+    }
+
+    return (lookupIndex < LookupList_LookupCount(textProcessor->_lookupList));
 }
 
 static LookupType PrepareLookup(TextProcessorRef textProcessor, SFUInt16 lookupIndex, Data *outLookupTable)
@@ -254,15 +308,61 @@ static LookupType PrepareLookup(TextProcessorRef textProcessor, SFUInt16 lookupI
     return lookupType;
 }
 
-static void ApplySubtables(TextProcessorRef textProcessor, Data lookupTable, LookupType lookupType)
+static LookupDigestRef GetLookupDigest(TextProcessorRef textProcessor, SFUInt16 lookupIndex)
+{
+    LookupDigestListRef lookupDigests = textProcessor->_lookupDigests;
+
+    if (lookupDigests && lookupIndex < lookupDigests->count) {
+        return &lookupDigests->items[lookupIndex];
+    }
+
+    return NULL;
+}
+
+static PairMatrixRef *GetPairMatrices(TextProcessorRef textProcessor, SFUInt16 lookupIndex, LookupType lookupType)
+{
+    PairMatrixListRef pairMatrixList = textProcessor->_pairMatrixList;
+
+    /* Only the pair positioning lookups have a compiled form. */
+    if (pairMatrixList && textProcessor->_lookupOperation == ApplyPositioningSubtable
+        && (lookupType == LookupTypePairAdjustment || lookupType == LookupTypeExtensionPositioning)) {
+        return PairMatrixListGetMatrices(pairMatrixList, lookupIndex);
+    }
+
+    return NULL;
+}
+
+static void ApplySubtables(TextProcessorRef textProcessor, LookupDigestRef lookupDigest,
+    PairMatrixRef *pairMatrices, Data lookupTable, LookupType lookupType)
 {
     SFUInt16 subtableCount = Lookup_SubtableCount(lookupTable);
+    GlyphDigest *subtableDigests = NULL;
+    SFGlyphID locGlyph = 0;
     SFUInteger subtableIndex;
 
+    /* Skip the whole lookup if none of its subtables can start at current glyph. */
+    if (lookupDigest) {
+        locGlyph = SFAlbumGetGlyph(textProcessor->_album, textProcessor->_locator.index);
+
+        if (!GlyphDigestMayContain(&lookupDigest->digest, locGlyph)) {
+            return;
+        }
+
+        if (lookupDigest->subtableCount == subtableCount) {
+            subtableDigests = lookupDigest->subtables;
+        }
+    }
+
     /* Apply subtables in order until one of them performs substitution/positioning. */
     for (subtableIndex = 0; subtableIndex < subtableCount; subtableIndex++) {
         Data subtable = Lookup_SubtableData(lookupTable, subtableIndex);
 
+        if (subtableDigests && !GlyphDigestMayContain(&subtableDigests[subtableIndex], locGlyph)) {
+            continue;
+        }
+
+        textProcessor->_pairMatrix = (pairMatrices ? pairMatrices[subtableIndex] : NULL);
+
         if (textProcessor->_lookupOperation(textProcessor, lookupType, subtable)) {
             /* A subtable has performed substitution/positioning, so break the loop. */
             break;
@@ -22,7 +22,13 @@
 #include "SFAlbum.h"
 #include "SFBase.h"
 #include "SFFont.h"
+#include "DeltaCache.h"
+#include "GlyphDefinitions.h"
+#include "LookupDigest.h"
 #include "Locator.h"
+#include "OpenType.h"
+#include "PairCache.h"
+#include "PairMatrix.h"
 #include "SFPattern.h"
 
 typedef struct _TextProcessor {
@@ -30,9 +36,17 @@ typedef struct _TextProcessor {
     SFAlbumRef _album;
     const SFInt16 *_coordArray;
     SFUInteger _coordCount;
+    const VarScalar *_regionScalars;
+    GlyphDefinitionsRef _glyphDefinitions;
     Data _glyphClassDef;
     Data _itemVarStore;
     Data _lookupList;
+    LookupDigestListRef _lookupDigests;
+    PairMatrixListRef _pairMatrixList;
+    PairMatrixRef _pairMatrix;
+    PairCacheRef _pairCache;
+    DeltaCacheRef _deltaCache;
+    const SFUInt8 *_lookupMask;
     SFUInt16 _lookupValue;
     SFUInt16 _lookupNesting;
     SFBoolean (*_lookupOperation)(struct _TextProcessor *, LookupType, Data);
@@ -44,8 +58,14 @@ typedef struct _TextProcessor {
     Locator _locator;
 } TextProcessor, *TextProcessorRef;
 
+/**
+ * Initializes the text processor. The pair cache is optional and must only have been used with the
+ * same pattern before. The delta cache is optional as well and must only have been used with the
+ * same font and variation coordinates before.
+ */
 SF_INTERNAL void TextProcessorInitialize(TextProcessorRef textProcessor,
-   SFPatternRef pattern, SFAlbumRef album, SFTextDirection textDirection,
+   SFPatternRef pattern, SFAlbumRef album, PairCacheRef pairCache, DeltaCacheRef deltaCache,
+   SFTextDirection textDirection,
    SFUInt16 ppemWidth, SFUInt16 ppemHeight, SFBoolean zeroWidthMarks);
 
 SF_INTERNAL void TextProcessorDiscoverGlyphs(TextProcessorRef textProcessor);
@@ -64,4 +64,18 @@
 
 /**************************************************************************************************/
 
+/*************************************DELTA SET INDEX MAP TABLE************************************/
+
+#define DeltaSetIndexMap_Format(data)                   Data_UInt8(data, 0)
+#define DeltaSetIndexMap_EntryFormat(data)              Data_UInt8(data, 1)
+#define DeltaSetIndexMapF0_MapCount(data)               Data_UInt16(data, 2)
+#define DeltaSetIndexMapF0_MapData(data)                Data_Subdata(data, 4)
+#define DeltaSetIndexMapF1_MapCount(data)               Data_UInt32(data, 2)
+#define DeltaSetIndexMapF1_MapData(data)                Data_Subdata(data, 6)
+
+#define EntryFormat_InnerIndexBitCount(format)          (((format) & 0x0F) + 1)
+#define EntryFormat_MapEntrySize(format)                ((((format) & 0x30) >> 4) + 1)
+
+/**************************************************************************************************/
+
 #endif
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SHEENFIGURE_BENCHMARK__BENCHMARK_H
+#define __SHEENFIGURE_BENCHMARK__BENCHMARK_H
+
+/**
+ * Measures the searches of coverage and class definition tables against libc bsearch. Returns
+ * false if the results differ.
+ */
+bool RunSearchBenchmark();
+
+/**
+ * Measures building patterns of fonts with growing lookup lists. Returns false if a pattern does
+ * not contain the expected lookups.
+ */
+bool RunPatternBenchmark();
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <Headers/SFFont.h>
+#include <Headers/SFScheme.h>
+#include <Source/SFPattern.h>
+}
+
+#include "OpenType/Builder.h"
+#include "OpenType/Writer.h"
+#include "Utilities/General.h"
+#include "Benchmark.h"
+
+using namespace std;
+using namespace SheenFigure::Tester::OpenType;
+using namespace SheenFigure::Tester::Utilities;
+
+namespace {
+
+/* The sizes of lookup lists being measured. */
+const size_t LOOKUP_COUNTS[] = { 250, 500, 1000, 2000, 5000 };
+const size_t FEATURE_COUNT = 50;
+const size_t TOTAL_LOOKUPS = 1 << 18;
+
+SFTag FeatureTag(size_t index)
+{
+    char name[5];
+    snprintf(name, sizeof(name), "f%03u", (unsigned)index);
+
+    return tag(name);
+}
+
+/*
+ * Creates a GSUB table whose lookups are striped across the features in descending order. The
+ * lookups have no subtables so that thousands of them fit in 16-bit offsets.
+ */
+vector<uint8_t> CreateGSUB(size_t lookupCount)
+{
+    Builder builder;
+    vector<reference_wrapper<LookupTable>> lookups;
+    map<UInt32, reference_wrapper<FeatureTable>> featureRecords;
+    vector<UInt16> featureIndexes;
+
+    for (size_t i = 0; i < lookupCount; i++) {
+        lookups.push_back(builder.createLookup({ NULL, 0 }, (LookupFlag)0));
+    }
+
+    for (size_t feature = 0; feature < FEATURE_COUNT; feature++) {
+        vector<UInt16> lookupIndexes;
+
+        for (size_t i = lookupCount; i-- > 0;) {
+            if (i % FEATURE_COUNT == feature) {
+                lookupIndexes.push_back((UInt16)i);
+            }
+        }
+
+        featureRecords.insert({ FeatureTag(feature), builder.createFeature(lookupIndexes) });
+        featureIndexes.push_back((UInt16)feature);
+    }
+
+    FeatureListTable &featureList = builder.createFeatureList(featureRecords);
+    ScriptListTable &scriptList = builder.createScriptList({
+        {tag("latn"), builder.createScript(builder.createLangSys(featureIndexes))}
+    });
+    LookupListTable &lookupList = builder.createLookupList(lookups);
+    GSUB &gsub = builder.createGSUB(&scriptList, &featureList, &lookupList);
+
+    Writer writer;
+    writer.write(&gsub);
+
+    return vector<uint8_t>(writer.data(), writer.data() + writer.size());
+}
+
+void LoadTable(void *object, SFTag tableTag, SFUInt8 *buffer, SFUInteger *length)
+{
+    const vector<uint8_t> *gsub = (const vector<uint8_t> *)object;
+
+    if (tableTag == tag("GSUB")) {
+        if (length) {
+            *length = (SFUInteger)gsub->size();
+        }
+        if (buffer) {
+            memcpy(buffer, gsub->data(), gsub->size());
+        }
+    }
+}
+
+SFGlyphID GetGlyphID(void *object, SFCodepoint codepoint)
+{
+    return 0;
+}
+
+SFInt32 GetAdvance(void *object, SFFontLayout fontLayout, SFGlyphID glyphID)
+{
+    return 0;
+}
+
+bool ContainsAllLookups(SFPatternRef pattern, size_t lookupCount)
+{
+    if (pattern->featureUnits.gsub != 1) {
+        return false;
+    }
+
+    SFFeatureUnit *featureUnit = &pattern->featureUnits.items[0];
+    if (featureUnit->lookups.count != lookupCount) {
+        return false;
+    }
+
+    for (size_t i = 0; i < lookupCount; i++) {
+        if (featureUnit->lookups.items[i].index != i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Measure(size_t lookupCount)
+{
+    vector<uint8_t> gsub = CreateGSUB(lookupCount);
+    const SFFontProtocol protocol = { NULL, &LoadTable, &GetGlyphID, &GetAdvance };
+    SFFontRef font = SFFontCreateWithProtocol(&protocol, &gsub);
+
+    vector<SFTag> featureTags;
+    vector<SFUInt16> featureValues;
+    for (size_t feature = 0; feature < FEATURE_COUNT; feature++) {
+        featureTags.push_back(FeatureTag(feature));
+        featureValues.push_back(1);
+    }
+
+    SFSchemeRef scheme = SFSchemeCreate();
+    SFSchemeSetFont(scheme, font);
+    SFSchemeSetScriptTag(scheme, tag("latn"));
+    SFSchemeSetLanguageTag(scheme, tag("dflt"));
+    SFSchemeSetFeatureValues(scheme, featureTags.data(), featureValues.data(), FEATURE_COUNT);
+
+    /* Build the first pattern outside the measurement so that the tables are loaded already. */
+    SFPatternRef pattern = SFSchemeBuildPattern(scheme);
+    bool matched = ContainsAllLookups(pattern, lookupCount);
+    SFPatternRelease(pattern);
+
+    size_t buildCount = TOTAL_LOOKUPS / lookupCount;
+    auto begin = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < buildCount; i++) {
+        SFPatternRelease(SFSchemeBuildPattern(scheme));
+    }
+
+    auto end = chrono::steady_clock::now();
+    chrono::duration<double, micro> elapsed = end - begin;
+    double buildTime = elapsed.count() / buildCount;
+
+    printf("%-8zu %8zu %12.2f %12.2f\n", lookupCount, buildCount,
+           buildTime, buildTime * 1000.0 / lookupCount);
+
+    SFSchemeRelease(scheme);
+    SFFontRelease(font);
+
+    return matched;
+}
+
+}
+
+bool RunPatternBenchmark()
+{
+    bool matched = true;
+
+    printf("%-8s %8s %12s %12s\n", "Lookups", "Builds", "us/Pattern", "ns/Lookup");
+
+    for (size_t lookupCount : LOOKUP_COUNTS) {
+        matched &= Measure(lookupCount);
+    }
+
+    if (!matched) {
+        fprintf(stderr, "The patterns do not contain the expected lookups.\n");
+    }
+
+    return matched;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include <Source/Common.h>
+#include <Source/Data.h>
+#include <Source/OpenType.h>
+}
+
+#include "Benchmark.h"
+
+using namespace std;
+
+namespace {
+
+/* The sizes of coverage and class definition tables being measured. */
+const size_t TABLE_SIZES[] = { 1, 4, 16, 64, 256, 1024, 4096, 10000 };
+const size_t QUERY_COUNT = 1 << 12;
+const size_t TOTAL_SEARCHES = 1 << 24;
+
+/* The previous implementation based on libc bsearch, kept for comparison. */
+int UInt16ItemsComparison(const void *item1, const void *item2)
+{
+    SFUInt16 val1 = *(const SFUInt16 *)item1;
+    SFUInt16 val2 = Data_UInt16((Data)item2, 0);
+
+    return (int)val1 - (int)val2;
+}
+
+int GlyphRangeComparison(const void *item1, const void *item2)
+{
+    SFUInt16 val1 = *(const SFUInt16 *)item1;
+    Data ref2 = (Data)item2;
+
+    if (val1 < GlyphRange_Start(ref2)) {
+        return -1;
+    }
+    if (val1 > GlyphRange_End(ref2)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+SFUInteger ReferenceCoverageIndex(Data coverageTable, SFGlyphID glyphID)
+{
+    switch (Coverage_Format(coverageTable)) {
+    case 1: {
+        Data glyphArray = CoverageF1_GlyphArray(coverageTable);
+        const void *item = bsearch(&glyphID, glyphArray, CoverageF1_GlyphCount(coverageTable),
+                                   sizeof(SFUInt16), UInt16ItemsComparison);
+        if (item) {
+            return (SFUInteger)((Data)item - glyphArray) / sizeof(SFUInt16);
+        }
+        break;
+    }
+
+    case 2: {
+        Data record = (Data)bsearch(&glyphID, CoverageF2_GlyphRangeArray(coverageTable),
+                                    CoverageF2_RangeCount(coverageTable),
+                                    GlyphRange_Size(), GlyphRangeComparison);
+        if (record) {
+            return RangeRecord_StartCoverageIndex(record) + (glyphID - RangeRecord_StartGlyphID(record));
+        }
+        break;
+    }
+    }
+
+    return SFInvalidIndex;
+}
+
+SFUInt16 ReferenceGlyphClass(Data classDefTable, SFGlyphID glyphID)
+{
+    Data record = (Data)bsearch(&glyphID, ClassDefF2_GlyphRangeArray(classDefTable),
+                                ClassDefF2_ClassRangeCount(classDefTable),
+                                GlyphRange_Size(), GlyphRangeComparison);
+    if (record) {
+        return ClassRangeRecord_Class(record);
+    }
+
+    return 0;
+}
+
+void AppendUInt16(vector<uint8_t> &table, uint16_t value)
+{
+    table.push_back((uint8_t)(value >> 8));
+    table.push_back((uint8_t)value);
+}
+
+/* Creates a table of given format containing every even glyph so that half of the queries miss. */
+vector<uint8_t> CreateTable(uint16_t format, size_t size)
+{
+    vector<uint8_t> table;
+    AppendUInt16(table, format);
+    AppendUInt16(table, (uint16_t)size);
+
+    for (size_t i = 0; i < size; i++) {
+        uint16_t glyph = (uint16_t)(i * 2);
+
+        if (format == 1) {
+            AppendUInt16(table, glyph);
+        } else {
+            AppendUInt16(table, glyph);
+            AppendUInt16(table, glyph);
+            AppendUInt16(table, (uint16_t)i);
+        }
+    }
+
+    return table;
+}
+
+vector<SFGlyphID> CreateQueries(size_t size)
+{
+    vector<SFGlyphID> queries(QUERY_COUNT);
+    uint32_t seed = 0x2545F491;
+
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        seed = seed * 1664525 + 1013904223;
+        queries[i] = (SFGlyphID)((seed >> 8) % (size * 2));
+    }
+
+    return queries;
+}
+
+template<class Search>
+double MeasureSearch(const vector<SFGlyphID> &queries, Search search, SFUInteger &checksum)
+{
+    auto begin = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < TOTAL_SEARCHES; i++) {
+        checksum += search(queries[i & (QUERY_COUNT - 1)]);
+    }
+
+    auto end = chrono::steady_clock::now();
+    chrono::duration<double, nano> elapsed = end - begin;
+
+    return elapsed.count() / TOTAL_SEARCHES;
+}
+
+template<class Reference, class Current>
+bool Compare(const char *name, size_t size, Reference reference, Current current)
+{
+    vector<SFGlyphID> queries = CreateQueries(size);
+    SFUInteger referenceSum = 0;
+    SFUInteger currentSum = 0;
+    double referenceTime = MeasureSearch(queries, reference, referenceSum);
+    double currentTime = MeasureSearch(queries, current, currentSum);
+
+    printf("%-16s %6zu %10.2f %10.2f %8.2fx\n", name, size,
+           referenceTime, currentTime, referenceTime / currentTime);
+
+    return referenceSum == currentSum;
+}
+
+}
+
+bool RunSearchBenchmark()
+{
+    bool matched = true;
+
+    printf("%-16s %6s %10s %10s %9s\n", "Table", "Size", "bsearch", "Current", "Speedup");
+
+    for (size_t size : TABLE_SIZES) {
+        vector<uint8_t> coverageF1 = CreateTable(1, size);
+        vector<uint8_t> coverageF2 = CreateTable(2, size);
+        Data dataF1 = coverageF1.data();
+        Data dataF2 = coverageF2.data();
+
+        matched &= Compare("Coverage F1", size,
+                           [=](SFGlyphID glyph) { return ReferenceCoverageIndex(dataF1, glyph); },
+                           [=](SFGlyphID glyph) { return SearchCoverageIndex(dataF1, glyph); });
+        matched &= Compare("Coverage F2", size,
+                           [=](SFGlyphID glyph) { return ReferenceCoverageIndex(dataF2, glyph); },
+                           [=](SFGlyphID glyph) { return SearchCoverageIndex(dataF2, glyph); });
+        matched &= Compare("ClassDef F2", size,
+                           [=](SFGlyphID glyph) { return (SFUInteger)ReferenceGlyphClass(dataF2, glyph); },
+                           [=](SFGlyphID glyph) { return (SFUInteger)SearchGlyphClass(dataF2, glyph); });
+    }
+
+    if (!matched) {
+        fprintf(stderr, "The search results do not match the reference implementation.\n");
+    }
+
+    return matched;
+}
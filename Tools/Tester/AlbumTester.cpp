@@ -335,6 +335,46 @@ void AlbumTester::testGetGlyph()
     SFAlbumFinalize(&album);
 }
 
+void AlbumTester::testGlyphDigest()
+{
+    Codepoints codepoints(5);
+
+    SFAlbum album;
+    SFAlbumInitialize(&album);
+    SFAlbumReset(&album, codepoints.ptr());
+    SFAlbumBeginFilling(&album);
+
+    /* Test that the added glyphs are digested. */
+    SFAlbumAddGlyph(&album, 10, GlyphTraitNone, 0);
+    SFAlbumAddGlyph(&album, 300, GlyphTraitNone, 1);
+
+    assert(GlyphDigestMayContain(&album._glyphDigest, 10));
+    assert(GlyphDigestMayContain(&album._glyphDigest, 300));
+    assert(!GlyphDigestMayContain(&album._glyphDigest, 11));
+
+    /* Test that the substituted glyphs are digested while keeping the previous ones. */
+    SFAlbumSetGlyph(&album, 0, 1000);
+
+    assert(GlyphDigestMayContain(&album._glyphDigest, 1000));
+    assert(GlyphDigestMayContain(&album._glyphDigest, 10));
+
+    /* Test that the glyphs written in the array are digested on request. */
+    SFAlbumGetGlyphArray(&album, 0)[1] = 2000;
+    SFAlbumDigestGlyphs(&album, 1, 1);
+
+    assert(GlyphDigestMayContain(&album._glyphDigest, 2000));
+
+    SFAlbumEndFilling(&album);
+
+    /* Test that the digest is cleared on reset. */
+    SFAlbumReset(&album, codepoints.ptr());
+
+    assert(!GlyphDigestMayContain(&album._glyphDigest, 10));
+    assert(!GlyphDigestMayContain(&album._glyphDigest, 2000));
+
+    SFAlbumFinalize(&album);
+}
+
 void AlbumTester::testSetAssociation()
 {
     SFAlbum album;
@@ -698,6 +738,7 @@ void AlbumTester::test()
     testReserveGlyphs();
     testSetGlyph();
     testGetGlyph();
+    testGlyphDigest();
     testSetAssociation();
     testGetAssociation();
     testFeatureMask();
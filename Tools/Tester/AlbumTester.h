@@ -30,6 +30,7 @@ public:
     void testReserveGlyphs();
     void testSetGlyph();
     void testGetGlyph();
+    void testGlyphDigest();
     void testSetAssociation();
     void testGetAssociation();
     void testFeatureMask();
@@ -0,0 +1,430 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <Source/CharacterMap.h>
+#include <Source/SFFont.h>
+}
+
+#include "Utilities/General.h"
+#include "CharacterMapTester.h"
+
+using namespace std;
+using namespace SheenFigure::Tester;
+using namespace SheenFigure::Tester::Utilities;
+
+struct EncodingSubtable {
+    SFUInt16 platformID;
+    SFUInt16 encodingID;
+    vector<SFUInt8> data;
+};
+
+static void *OBJECT_FONT = &OBJECT_FONT;
+
+static void appendUInt16(vector<SFUInt8> &data, SFUInt16 value)
+{
+    data.push_back((SFUInt8)(value >> 8));
+    data.push_back((SFUInt8)(value >> 0));
+}
+
+static void appendUInt24(vector<SFUInt8> &data, SFUInt32 value)
+{
+    data.push_back((SFUInt8)(value >> 16));
+    appendUInt16(data, (SFUInt16)value);
+}
+
+static void appendUInt32(vector<SFUInt8> &data, SFUInt32 value)
+{
+    appendUInt16(data, (SFUInt16)(value >> 16));
+    appendUInt16(data, (SFUInt16)(value >> 0));
+}
+
+static vector<SFUInt8> createFormat4()
+{
+    /* Segments: 'A'-'C' by delta, U+0100-U+0101 by glyph array, and the final sentinel. */
+    const SFUInt16 endCodes[] = { 0x0043, 0x0101, 0xFFFF };
+    const SFUInt16 startCodes[] = { 0x0041, 0x0100, 0xFFFF };
+    const SFUInt16 idDeltas[] = { (SFUInt16)(5 - 0x41), 0, 1 };
+    const SFUInt16 idRangeOffsets[] = { 0, 4, 0 };
+    const SFUInt16 glyphIDs[] = { 7, 0 };
+    vector<SFUInt8> data;
+
+    appendUInt16(data, 4);
+    appendUInt16(data, 16 + (3 * 8) + 4);
+    appendUInt16(data, 0);
+    appendUInt16(data, 3 * 2);
+    appendUInt16(data, 4);
+    appendUInt16(data, 1);
+    appendUInt16(data, 2);
+
+    for (int i = 0; i < 3; i++) {
+        appendUInt16(data, endCodes[i]);
+    }
+    appendUInt16(data, 0);
+    for (int i = 0; i < 3; i++) {
+        appendUInt16(data, startCodes[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        appendUInt16(data, idDeltas[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        appendUInt16(data, idRangeOffsets[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        appendUInt16(data, glyphIDs[i]);
+    }
+
+    return data;
+}
+
+static vector<SFUInt8> createFormat12()
+{
+    /* One of the groups crosses the BMP boundary. */
+    const SFUInt32 groups[][3] = {
+        { 0x00041, 0x00042, 20 },
+        { 0x0FFFF, 0x10001, 50 },
+        { 0x1F600, 0x1F601, 30 },
+        { 0x20000, 0x20000, 40 },
+    };
+    const SFUInt32 groupCount = sizeof(groups) / sizeof(groups[0]);
+    vector<SFUInt8> data;
+
+    appendUInt16(data, 12);
+    appendUInt16(data, 0);
+    appendUInt32(data, 16 + (groupCount * 12));
+    appendUInt32(data, 0);
+    appendUInt32(data, groupCount);
+
+    for (SFUInt32 i = 0; i < groupCount; i++) {
+        appendUInt32(data, groups[i][0]);
+        appendUInt32(data, groups[i][1]);
+        appendUInt32(data, groups[i][2]);
+    }
+
+    return data;
+}
+
+static vector<SFUInt8> createFormat14()
+{
+    vector<SFUInt8> data;
+
+    appendUInt16(data, 14);
+    appendUInt32(data, 38);
+    appendUInt32(data, 1);
+
+    /* Variation selector record of U+FE00. */
+    appendUInt24(data, 0xFE00);
+    appendUInt32(data, 21);
+    appendUInt32(data, 29);
+
+    /* Default sequence of 'A'. */
+    appendUInt32(data, 1);
+    appendUInt24(data, 0x41);
+    data.push_back(0);
+
+    /* Non-default sequence of 'B'. */
+    appendUInt32(data, 1);
+    appendUInt24(data, 0x42);
+    appendUInt16(data, 99);
+
+    return data;
+}
+
+static vector<SFUInt8> createCMAP(const vector<EncodingSubtable> &subtables)
+{
+    vector<SFUInt8> data;
+    SFUInt32 offset = 4 + (SFUInt32)(subtables.size() * 8);
+
+    appendUInt16(data, 0);
+    appendUInt16(data, (SFUInt16)subtables.size());
+
+    for (const auto &subtable : subtables) {
+        appendUInt16(data, subtable.platformID);
+        appendUInt16(data, subtable.encodingID);
+        appendUInt32(data, offset);
+
+        offset += (SFUInt32)subtable.data.size();
+    }
+
+    for (const auto &subtable : subtables) {
+        data.insert(data.end(), subtable.data.begin(), subtable.data.end());
+    }
+
+    return data;
+}
+
+static vector<SFUInt8> createSFNT(const vector<SFUInt8> &cmap)
+{
+    vector<SFUInt8> data;
+
+    appendUInt32(data, 0x00010000);
+    appendUInt16(data, 1);
+    appendUInt16(data, 16);
+    appendUInt16(data, 0);
+    appendUInt16(data, 0);
+
+    appendUInt32(data, tag("cmap"));
+    appendUInt32(data, 0);
+    appendUInt32(data, 12 + 16);
+    appendUInt32(data, (SFUInt32)cmap.size());
+
+    data.insert(data.end(), cmap.begin(), cmap.end());
+
+    return data;
+}
+
+static SFGlyphID getGlyphIDForCodepoint(void *object, SFCodepoint codepoint)
+{
+    assert(object == OBJECT_FONT);
+
+    return 1000;
+}
+
+CharacterMapTester::CharacterMapTester()
+{
+}
+
+void CharacterMapTester::testFormat4()
+{
+    vector<SFUInt8> cmap = createCMAP({ { 3, 1, createFormat4() } });
+    CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size());
+
+    assert(characterMap != NULL);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0000) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0040) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0041) == 5);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0043) == 7);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0044) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0100) == 7);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0101) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0xFFFF) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x1F600) == 0);
+    assert(CharacterMapGetVariantGlyphID(characterMap, 0x0041, 0xFE00) == 0);
+
+    CharacterMapDestroy(characterMap);
+}
+
+void CharacterMapTester::testFormat12()
+{
+    /* Test that the format 12 subtable is preferred over the format 4 one. */
+    vector<SFUInt8> cmap = createCMAP({
+        { 3, 1, createFormat4() },
+        { 3, 10, createFormat12() },
+    });
+    CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size());
+
+    assert(characterMap != NULL);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0041) == 20);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0042) == 21);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0043) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0100) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0xFFFF) == 50);
+    assert(CharacterMapGetGlyphID(characterMap, 0x10000) == 51);
+    assert(CharacterMapGetGlyphID(characterMap, 0x10001) == 52);
+    assert(CharacterMapGetGlyphID(characterMap, 0x10002) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x1F5FF) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x1F600) == 30);
+    assert(CharacterMapGetGlyphID(characterMap, 0x1F601) == 31);
+    assert(CharacterMapGetGlyphID(characterMap, 0x20000) == 40);
+    assert(CharacterMapGetGlyphID(characterMap, 0x10FFFF) == 0);
+
+    CharacterMapDestroy(characterMap);
+}
+
+void CharacterMapTester::testFormat14()
+{
+    vector<SFUInt8> cmap = createCMAP({
+        { 0, 3, createFormat4() },
+        { 0, 5, createFormat14() },
+    });
+    CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size());
+
+    assert(characterMap != NULL);
+    assert(CharacterMapGetVariantGlyphID(characterMap, 0x0041, 0xFE00) == 5);
+    assert(CharacterMapGetVariantGlyphID(characterMap, 0x0042, 0xFE00) == 99);
+    assert(CharacterMapGetVariantGlyphID(characterMap, 0x0043, 0xFE00) == 0);
+    assert(CharacterMapGetVariantGlyphID(characterMap, 0x0041, 0xFE01) == 0);
+    assert(CharacterMapGetGlyphID(characterMap, 0x0042) == 6);
+
+    CharacterMapDestroy(characterMap);
+}
+
+void CharacterMapTester::testMalformedTables()
+{
+    /* Test with a missing table and a truncated header. */
+    {
+        vector<SFUInt8> cmap = createCMAP({ { 3, 1, createFormat4() } });
+
+        assert(CharacterMapCreate(NULL, 0) == NULL);
+        assert(CharacterMapCreate(cmap.data(), 3) == NULL);
+        assert(CharacterMapCreate(cmap.data(), 11) == NULL);
+    }
+
+    /* Test with a format 4 subtable whose segments do not fit in the table. */
+    {
+        vector<SFUInt8> format4 = createFormat4();
+        format4[7] = 0xFE;
+
+        vector<SFUInt8> cmap = createCMAP({ { 3, 1, format4 } });
+        assert(CharacterMapCreate(cmap.data(), cmap.size()) == NULL);
+    }
+
+    /* Test with a glyph array cut short, so that only the affected code points are left out. */
+    {
+        vector<SFUInt8> cmap = createCMAP({ { 3, 1, createFormat4() } });
+        CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size() - 4);
+
+        assert(characterMap != NULL);
+        assert(CharacterMapGetGlyphID(characterMap, 0x0041) == 5);
+        assert(CharacterMapGetGlyphID(characterMap, 0x0100) == 0);
+
+        CharacterMapDestroy(characterMap);
+    }
+
+    /* Test with a format 12 subtable having too many groups, falling back to format 4. */
+    {
+        vector<SFUInt8> format12 = createFormat12();
+        format12[12] = 0x01;
+
+        vector<SFUInt8> cmap = createCMAP({ { 3, 1, createFormat4() }, { 3, 10, format12 } });
+        CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size());
+
+        assert(characterMap != NULL);
+        assert(CharacterMapGetGlyphID(characterMap, 0x0041) == 5);
+        assert(CharacterMapGetGlyphID(characterMap, 0x1F600) == 0);
+
+        CharacterMapDestroy(characterMap);
+    }
+
+    /* Test with format 4 segments overlapping each other, which must be rejected. */
+    {
+        vector<SFUInt8> format4 = createFormat4();
+        /* Move the start of the second segment below the end of the first one. */
+        format4[24] = 0x00;
+        format4[25] = 0x42;
+
+        vector<SFUInt8> cmap = createCMAP({ { 3, 1, format4 } });
+        assert(CharacterMapCreate(cmap.data(), cmap.size()) == NULL);
+    }
+
+    /* Test with format 12 groups out of order, falling back to format 4. */
+    {
+        vector<SFUInt8> format12 = createFormat12();
+        /* Swap the first two groups. */
+        std::swap_ranges(format12.begin() + 16, format12.begin() + 28, format12.begin() + 28);
+
+        vector<SFUInt8> cmap = createCMAP({ { 3, 1, createFormat4() }, { 3, 10, format12 } });
+        CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size());
+
+        assert(characterMap != NULL);
+        assert(CharacterMapGetGlyphID(characterMap, 0x0041) == 5);
+        assert(CharacterMapGetGlyphID(characterMap, 0xFFFF) == 0);
+
+        CharacterMapDestroy(characterMap);
+    }
+
+    /* Test with a format 14 subtable pointing outside of the table, which must be ignored. */
+    {
+        vector<SFUInt8> format14 = createFormat14();
+        format14[18] = 0xFF;
+
+        vector<SFUInt8> cmap = createCMAP({ { 3, 1, createFormat4() }, { 0, 5, format14 } });
+        CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size());
+
+        assert(characterMap != NULL);
+        assert(CharacterMapGetVariantGlyphID(characterMap, 0x0042, 0xFE00) == 0);
+
+        CharacterMapDestroy(characterMap);
+    }
+
+    /* Test that a symbol subtable is used when no Unicode subtable exists. */
+    {
+        vector<SFUInt8> cmap = createCMAP({ { 1, 0, createFormat12() }, { 3, 0, createFormat4() } });
+        CharacterMapRef characterMap = CharacterMapCreate(cmap.data(), cmap.size());
+
+        assert(characterMap != NULL);
+        assert(CharacterMapGetGlyphID(characterMap, 0x0041) == 5);
+
+        CharacterMapDestroy(characterMap);
+    }
+}
+
+void CharacterMapTester::testBuiltInFontMapping()
+{
+    vector<SFUInt8> cmap = createCMAP({
+        { 3, 1, createFormat4() },
+        { 3, 10, createFormat12() },
+        { 0, 5, createFormat14() },
+    });
+    vector<SFUInt8> sfnt = createSFNT(cmap);
+
+    /* Test that the cmap table is used in the absence of glyph ID functions. */
+    {
+        SFFontRef font = SFFontCreateWithMemory(sfnt.data(), sfnt.size(), NULL, NULL);
+        SFFontRef derived;
+        SFInt16 coords[] = { 0 };
+        SFCodepoint codepoints[] = { 0x41, 0x43, 0x1F601 };
+        SFGlyphID glyphs[3];
+
+        assert(font != NULL);
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x41) == 20);
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x1F600) == 30);
+        assert(SFFontGetGlyphIDForVariation(font, 0x42, 0xFE00) == 99);
+
+        SFFontGetGlyphIDsForCodepoints(font, codepoints, glyphs, 3);
+        assert(glyphs[0] == 20);
+        assert(glyphs[1] == 0);
+        assert(glyphs[2] == 31);
+
+        derived = SFFontCreateWithVariationCoordinates(font, NULL, coords, 1);
+        assert(SFFontGetGlyphIDForCodepoint(derived, 0x42) == 21);
+
+        SFFontRelease(derived);
+        SFFontRelease(font);
+    }
+
+    /* Test that the glyph ID function of the protocol takes precedence. */
+    {
+        SFFontProtocol protocol = {
+            NULL,
+            NULL,
+            &getGlyphIDForCodepoint,
+            NULL,
+        };
+        SFFontRef font = SFFontCreateWithMemory(sfnt.data(), sfnt.size(), &protocol, OBJECT_FONT);
+
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x41) == 1000);
+        assert(SFFontGetGlyphIDForVariation(font, 0x42, 0xFE00) == 0);
+
+        SFFontRelease(font);
+    }
+}
+
+void CharacterMapTester::test()
+{
+    testFormat4();
+    testFormat12();
+    testFormat14();
+    testMalformedTables();
+    testBuiltInFontMapping();
+}
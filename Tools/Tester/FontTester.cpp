@@ -16,7 +16,10 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdio>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <Source/SFFont.h>
@@ -25,11 +28,17 @@ extern "C" {
 #include "Utilities/General.h"
 #include "FontTester.h"
 
+using namespace std;
 using namespace SheenFigure::Tester;
 using namespace SheenFigure::Tester::Utilities;
 
 static void *OBJECT_FONT = &OBJECT_FONT;
 static int FINALIZE_COUNT = 0;
+static int LOAD_COUNT = 0;
+static int RELEASE_COUNT = 0;
+static int RELEASE_COUNT_AT_FINALIZE = 0;
+static int BATCH_COUNT = 0;
+static int GLYPH_COUNT = 0;
 
 static const char *TABLE_GDEF = "GDEF";
 static const char *TABLE_GSUB = "GSUB";
@@ -39,12 +48,17 @@ static void finalize(void *object)
 {
     assert(object == OBJECT_FONT);
     FINALIZE_COUNT++;
+    RELEASE_COUNT_AT_FINALIZE = RELEASE_COUNT;
 }
 
 static void loadTable(void *object, SFTag tableTag, SFUInt8 *buffer, SFUInteger *length)
 {
     assert(object == OBJECT_FONT);
 
+    if (!buffer) {
+        LOAD_COUNT++;
+    }
+
     switch (tableTag) {
     case tag("GDEF"):
         if (buffer) {
@@ -81,13 +95,76 @@ static void loadTable(void *object, SFTag tableTag, SFUInt8 *buffer, SFUInteger
     }
 }
 
+static const SFUInt8 *getTablePointer(void *object, SFTag tableTag, SFUInteger *length)
+{
+    assert(object == OBJECT_FONT);
+
+    LOAD_COUNT++;
+
+    switch (tableTag) {
+    case tag("GDEF"):
+        *length = 4;
+        return (const SFUInt8 *)TABLE_GDEF;
+
+    case tag("GSUB"):
+        *length = 4;
+        return (const SFUInt8 *)TABLE_GSUB;
+
+    case tag("GPOS"):
+        *length = 4;
+        return (const SFUInt8 *)TABLE_GPOS;
+
+    default:
+        return NULL;
+    }
+}
+
+static void releaseTablePointer(void *object, SFTag tableTag, const SFUInt8 *pointer)
+{
+    assert(object == OBJECT_FONT);
+
+    switch (tableTag) {
+    case tag("GDEF"):
+        assert(pointer == (const SFUInt8 *)TABLE_GDEF);
+        break;
+
+    case tag("GSUB"):
+        assert(pointer == (const SFUInt8 *)TABLE_GSUB);
+        break;
+
+    case tag("GPOS"):
+        assert(pointer == (const SFUInt8 *)TABLE_GPOS);
+        break;
+
+    default:
+        assert(false);
+        break;
+    }
+
+    RELEASE_COUNT++;
+}
+
 static SFGlyphID getGlyphIDForCodepoint(void *object, SFCodepoint codepoint)
 {
     assert(object == OBJECT_FONT);
 
+    GLYPH_COUNT++;
+
     return (SFGlyphID)((codepoint >> 16) ^ (codepoint & 0xFFFF));
 }
 
+static void getGlyphIDsForCodepoints(void *object,
+    const SFCodepoint *codepoints, SFGlyphID *glyphIDs, SFUInteger count)
+{
+    assert(object == OBJECT_FONT);
+
+    BATCH_COUNT++;
+
+    for (SFUInteger i = 0; i < count; i++) {
+        glyphIDs[i] = getGlyphIDForCodepoint(object, codepoints[i]);
+    }
+}
+
 static SFAdvance getAdvanceForGlyph(void *object, SFFontLayout fontLayout, SFGlyphID glyphID)
 {
     assert(object == OBJECT_FONT);
@@ -104,6 +181,27 @@ static SFAdvance getAdvanceForGlyph(void *object, SFFontLayout fontLayout, SFGly
     }
 }
 
+static void getAdvancesForGlyphs(void *object, SFFontLayout fontLayout,
+    const SFGlyphID *glyphIDs, SFAdvance *advances, SFUInteger count)
+{
+    assert(object == OBJECT_FONT);
+
+    BATCH_COUNT++;
+
+    for (SFUInteger i = 0; i < count; i++) {
+        advances[i] = getAdvanceForGlyph(object, fontLayout, glyphIDs[i]);
+    }
+}
+
+static void loadGDEFTable(void *object, SFTag tableTag, SFUInt8 *buffer, SFUInteger *length)
+{
+    if (tableTag == tag("GDEF")) {
+        loadTable(object, tableTag, buffer, length);
+    } else if (length) {
+        *length = 0;
+    }
+}
+
 static SFFontRef SFFontCreateWithCompleteFunctionality(void)
 {
     const SFFontProtocol protocol = {
@@ -126,6 +224,120 @@ static SFFontRef SFFontCreateWithRequiredFunctionality(void)
     return SFFontCreateWithProtocol(&protocol, (void *)OBJECT_FONT);
 }
 
+static SFFontRef SFFontCreateWithBorrowedTables(void)
+{
+    const SFFontProtocol protocol = {
+        &finalize,
+        NULL,
+        &getGlyphIDForCodepoint,
+        &getAdvanceForGlyph,
+        &getTablePointer,
+        &releaseTablePointer,
+    };
+    return SFFontCreateWithProtocol(&protocol, (void *)OBJECT_FONT);
+}
+
+static SFFontRef SFFontCreateWithBatchFunctionality(void)
+{
+    const SFFontProtocol protocol = {
+        NULL,
+        &loadTable,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        &getGlyphIDsForCodepoints,
+        &getAdvancesForGlyphs,
+    };
+    return SFFontCreateWithProtocol(&protocol, (void *)OBJECT_FONT);
+}
+
+static void appendUInt16(vector<SFUInt8> &data, SFUInt16 value)
+{
+    data.push_back((SFUInt8)(value >> 8));
+    data.push_back((SFUInt8)(value >> 0));
+}
+
+static void appendUInt32(vector<SFUInt8> &data, SFUInt32 value)
+{
+    appendUInt16(data, (SFUInt16)(value >> 16));
+    appendUInt16(data, (SFUInt16)(value >> 0));
+}
+
+static vector<SFUInt8> createSFNTData()
+{
+    const char *tables[] = { TABLE_GDEF, TABLE_GPOS, TABLE_GSUB };
+    const SFUInt16 tableCount = sizeof(tables) / sizeof(tables[0]);
+    const SFUInt32 dataOffset = 12 + (tableCount * 16);
+    vector<SFUInt8> data;
+
+    appendUInt32(data, 0x00010000);
+    appendUInt16(data, tableCount);
+    appendUInt16(data, 32);
+    appendUInt16(data, 1);
+    appendUInt16(data, 16);
+
+    for (SFUInt16 i = 0; i < tableCount; i++) {
+        appendUInt32(data, tag(tables[i]));
+        appendUInt32(data, 0);
+        appendUInt32(data, dataOffset + (i * 4));
+        appendUInt32(data, 4);
+    }
+
+    for (SFUInt16 i = 0; i < tableCount; i++) {
+        data.insert(data.end(), tables[i], tables[i] + 4);
+    }
+
+    return data;
+}
+
+static vector<SFUInt8> createTTCData()
+{
+    const char *tags[] = { "GDEF", "GPOS", "GSUB", "hmtx" };
+    const char *tables[] = { TABLE_GDEF, TABLE_GPOS, TABLE_GSUB, "GSB2", "HMT1", "HMT2" };
+    const SFUInt32 dataOffset = 24 + (3 * 76);
+    /*
+     * The first two faces share the layout tables but not the metrics, the third one has a
+     * separate GSUB.
+     */
+    const SFUInt32 faceTables[3][4] = {
+        { 0, 1, 2, 4 },
+        { 0, 1, 2, 5 },
+        { 0, 1, 3, 4 },
+    };
+    vector<SFUInt8> data;
+
+    appendUInt32(data, tag("ttcf"));
+    appendUInt16(data, 1);
+    appendUInt16(data, 0);
+    appendUInt32(data, 3);
+
+    for (SFUInt32 i = 0; i < 3; i++) {
+        appendUInt32(data, 24 + (i * 76));
+    }
+
+    for (SFUInt32 i = 0; i < 3; i++) {
+        appendUInt32(data, 0x00010000);
+        appendUInt16(data, 4);
+        appendUInt16(data, 64);
+        appendUInt16(data, 2);
+        appendUInt16(data, 0);
+
+        for (SFUInt32 j = 0; j < 4; j++) {
+            appendUInt32(data, tag(tags[j]));
+            appendUInt32(data, 0);
+            appendUInt32(data, dataOffset + (faceTables[i][j] * 4));
+            appendUInt32(data, 4);
+        }
+    }
+
+    for (SFUInt32 i = 0; i < 6; i++) {
+        data.insert(data.end(), tables[i], tables[i] + 4);
+    }
+
+    return data;
+}
+
 FontTester::FontTester()
 {
 }
@@ -167,13 +379,455 @@ void FontTester::testLoadedTables()
 {
     SFFontRef font = SFFontCreateWithCompleteFunctionality();
 
-    assert(memcmp(font->resource->gdef, TABLE_GDEF, 4) == 0);
-    assert(memcmp(font->resource->gsub, TABLE_GSUB, 4) == 0);
-    assert(memcmp(font->resource->gpos, TABLE_GPOS, 4) == 0);
+    assert(memcmp(SFFontGetGDEFTable(font), TABLE_GDEF, 4) == 0);
+    assert(memcmp(SFFontGetGSUBTable(font), TABLE_GSUB, 4) == 0);
+    assert(memcmp(SFFontGetGPOSTable(font), TABLE_GPOS, 4) == 0);
+
+    SFFontRelease(font);
+}
+
+void FontTester::testBorrowedTables()
+{
+    /* Test with a single font. */
+    {
+        FINALIZE_COUNT = 0;
+        RELEASE_COUNT = 0;
+
+        SFFontRef font = SFFontCreateWithBorrowedTables();
+        assert(font != NULL);
+
+        assert(SFFontGetGDEFTable(font) == (const SFUInt8 *)TABLE_GDEF);
+        assert(SFFontGetGSUBTable(font) == (const SFUInt8 *)TABLE_GSUB);
+        assert(SFFontGetGPOSTable(font) == (const SFUInt8 *)TABLE_GPOS);
+        assert(font->resource->gdef.length == 4);
+        assert(font->resource->gsub.length == 4);
+        assert(font->resource->gpos.length == 4);
+
+        SFFontRelease(font);
+        assert(RELEASE_COUNT == 3);
+        assert(FINALIZE_COUNT == 1);
+        /* The tables MUST be released before finalizing the object. */
+        assert(RELEASE_COUNT_AT_FINALIZE == 3);
+    }
+
+    /* Test with a derived font outliving its parent. */
+    {
+        FINALIZE_COUNT = 0;
+        RELEASE_COUNT = 0;
+
+        SFInt16 coords[] = { 0x4000 };
+        SFFontRef font = SFFontCreateWithBorrowedTables();
+        SFFontRef derived = SFFontCreateWithVariationCoordinates(font, (void *)OBJECT_FONT, coords, 1);
+
+        assert(SFFontGetGDEFTable(font) == (const SFUInt8 *)TABLE_GDEF);
+        assert(SFFontGetGPOSTable(font) == (const SFUInt8 *)TABLE_GPOS);
+
+        SFFontRelease(font);
+        assert(RELEASE_COUNT == 0);
+        assert(FINALIZE_COUNT == 0);
+
+        /* The remaining table MUST be loadable after releasing the parent. */
+        assert(SFFontGetGSUBTable(derived) == (const SFUInt8 *)TABLE_GSUB);
+
+        SFFontRelease(derived);
+        assert(RELEASE_COUNT == 3);
+        assert(FINALIZE_COUNT == 2);
+        /* The parent MUST be finalized after releasing the tables. */
+        assert(RELEASE_COUNT_AT_FINALIZE == 3);
+    }
+}
+
+void FontTester::testLazyTables()
+{
+    /* Test that copied tables are loaded on first use only. */
+    {
+        LOAD_COUNT = 0;
+
+        SFFontRef font = SFFontCreateWithCompleteFunctionality();
+        assert(LOAD_COUNT == 0);
+
+        assert(memcmp(SFFontGetGSUBTable(font), TABLE_GSUB, 4) == 0);
+        assert(LOAD_COUNT == 1);
+        assert(memcmp(SFFontGetGSUBTable(font), TABLE_GSUB, 4) == 0);
+        assert(LOAD_COUNT == 1);
+
+        SFFontRelease(font);
+    }
+
+    /* Test that borrowed tables are obtained on first use and released only if obtained. */
+    {
+        LOAD_COUNT = 0;
+        RELEASE_COUNT = 0;
+
+        SFFontRef font = SFFontCreateWithBorrowedTables();
+        assert(LOAD_COUNT == 0);
+
+        assert(SFFontGetGPOSTable(font) == (const SFUInt8 *)TABLE_GPOS);
+        assert(LOAD_COUNT == 1);
+
+        SFFontRelease(font);
+        assert(RELEASE_COUNT == 1);
+    }
+
+    /* Test that a font which is never used does not load anything. */
+    {
+        LOAD_COUNT = 0;
+        RELEASE_COUNT = 0;
+
+        SFFontRef font = SFFontCreateWithBorrowedTables();
+        SFFontRelease(font);
+
+        assert(LOAD_COUNT == 0);
+        assert(RELEASE_COUNT == 0);
+    }
+}
+
+void FontTester::testLazyTablesAcrossThreads()
+{
+    LOAD_COUNT = 0;
+
+    /* Load the tables of fresh fonts on multiple threads at once. */
+    for (int i = 0; i < 100; i++) {
+        SFFontRef font = SFFontCreateWithBorrowedTables();
+        vector<thread> threads;
+
+        for (int j = 0; j < 4; j++) {
+            threads.push_back(thread([font]() {
+                assert(SFFontGetGDEFTable(font) == (const SFUInt8 *)TABLE_GDEF);
+                assert(SFFontGetGSUBTable(font) == (const SFUInt8 *)TABLE_GSUB);
+                assert(SFFontGetGPOSTable(font) == (const SFUInt8 *)TABLE_GPOS);
+
+                SFFontGetGlyphDefinitions(font);
+                SFFontGetGSUBDigests(font);
+                SFFontGetGPOSLayoutIndex(font);
+            }));
+        }
+
+        for (size_t j = 0; j < threads.size(); j++) {
+            threads[j].join();
+        }
+
+        SFFontRelease(font);
+    }
+
+    /* Each table must have been obtained once per font. */
+    assert(LOAD_COUNT == 300);
+}
+
+void FontTester::testFileTables()
+{
+    vector<SFUInt8> data = createSFNTData();
+
+    /* Test with a memory buffer. */
+    {
+        SFFontRef font = SFFontCreateWithMemory(data.data(), data.size(), NULL, NULL);
+        assert(font != NULL);
+
+        assert(SFFontGetGDEFTable(font) == &data[60]);
+        assert(SFFontGetGPOSTable(font) == &data[64]);
+        assert(SFFontGetGSUBTable(font) == &data[68]);
+        assert(font->resource->gdef.length == 4);
+        assert(font->resource->gsub.length == 4);
+        assert(font->resource->gpos.length == 4);
+
+        assert(SFFontGetGlyphIDForCodepoint(font, 'A') == 0);
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, 1) == 0);
+
+        SFFontRelease(font);
+    }
+
+    /* Test with a mapped file. */
+    {
+        const char *path = "SheenFigureTester.ttf";
+        FILE *file = fopen(path, "wb");
+        fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+
+        SFFontRef font = SFFontCreateWithFile(path, NULL, NULL);
+        assert(font != NULL);
+
+        assert(memcmp(SFFontGetGDEFTable(font), TABLE_GDEF, 4) == 0);
+        assert(memcmp(SFFontGetGSUBTable(font), TABLE_GSUB, 4) == 0);
+        assert(memcmp(SFFontGetGPOSTable(font), TABLE_GPOS, 4) == 0);
+
+        SFFontRelease(font);
+        remove(path);
+    }
+
+    /* Test with a table exceeding the data. */
+    {
+        vector<SFUInt8> truncated(data.begin(), data.end() - 2);
+
+        SFFontRef font = SFFontCreateWithMemory(truncated.data(), truncated.size(), NULL, NULL);
+        assert(font != NULL);
+
+        assert(SFFontGetGDEFTable(font) != NULL);
+        assert(SFFontGetGPOSTable(font) != NULL);
+        assert(SFFontGetGSUBTable(font) == NULL);
+
+        SFFontRelease(font);
+    }
+
+    /* Test with invalid data. */
+    {
+        assert(SFFontCreateWithMemory(TABLE_GDEF, 4, NULL, NULL) == NULL);
+        assert(SFFontCreateWithMemory(data.data(), 20, NULL, NULL) == NULL);
+        assert(SFFontCreateWithFile("", NULL, NULL) == NULL);
+    }
+}
+
+void FontTester::testCollectionFaces()
+{
+    vector<SFUInt8> data = createTTCData();
+
+    /* Test the faces of a collection. */
+    {
+        SFFontRef font1 = SFFontCreateWithMemory(data.data(), data.size(), NULL, NULL);
+        assert(font1 != NULL);
+        assert(SFFontGetFaceCount(font1) == 3);
+
+        SFFontRef font2 = SFFontCreateWithFace(font1, 1, NULL, NULL);
+        SFFontRef font3 = SFFontCreateWithFace(font1, 2, NULL, NULL);
+        assert(font2 != NULL);
+        assert(font3 != NULL);
+        assert(SFFontCreateWithFace(font1, 3, NULL, NULL) == NULL);
+
+        /* The faces referring to the same layout tables MUST share the resource. */
+        assert(font1->resource == font2->resource);
+        assert(font1->resource->retainCount == 2);
+        assert(font1->resource != font3->resource);
+        assert(font1->resource->file == font3->resource->file);
+
+        assert(SFFontGetGSUBTable(font1) == &data[260]);
+        assert(SFFontGetGSUBTable(font3) == &data[264]);
+        assert(SFFontGetGDEFTable(font1) == SFFontGetGDEFTable(font3));
+
+        /* The file MUST remain valid after releasing the first face. */
+        SFFontRelease(font1);
+        assert(font2->resource->retainCount == 1);
+        assert(font2->resource->file->resources.count == 2);
+
+        SFFontRef font4 = SFFontCreateWithFace(font3, 0, NULL, NULL);
+        assert(font4->resource == font2->resource);
+
+        SFFontRelease(font2);
+        SFFontRelease(font4);
+        assert(font3->resource->file->resources.count == 1);
+        assert(memcmp(SFFontGetGSUBTable(font3), "GSB2", 4) == 0);
+
+        SFFontRelease(font3);
+    }
+
+    /* Test with a single font file. */
+    {
+        vector<SFUInt8> single = createSFNTData();
+        SFFontRef font = SFFontCreateWithMemory(single.data(), single.size(), NULL, NULL);
+
+        assert(SFFontGetFaceCount(font) == 1);
+        assert(SFFontCreateWithFace(font, 1, NULL, NULL) == NULL);
+
+        SFFontRelease(font);
+    }
+
+    /* Test with a font not backed by a file. */
+    {
+        SFFontRef font = SFFontCreateWithCompleteFunctionality();
+
+        assert(SFFontGetFaceCount(font) == 0);
+        assert(SFFontCreateWithFace(font, 0, NULL, NULL) == NULL);
+
+        SFFontRelease(font);
+    }
+
+    /* Test with invalid collections. */
+    {
+        vector<SFUInt8> truncated(data.begin(), data.begin() + 22);
+        assert(SFFontCreateWithMemory(truncated.data(), truncated.size(), NULL, NULL) == NULL);
+
+        /* Make the first table directory point past the data. */
+        vector<SFUInt8> invalid = data;
+        invalid[15] = 0xFF;
+        assert(SFFontCreateWithMemory(invalid.data(), invalid.size(), NULL, NULL) == NULL);
+    }
+}
+
+void FontTester::testCollectionFacesAcrossThreads()
+{
+    vector<SFUInt8> data = createTTCData();
+    SFFontRef font = SFFontCreateWithMemory(data.data(), data.size(), NULL, NULL);
+    vector<thread> threads;
+
+    /* Create and release the faces sharing the resources of the file on multiple threads. */
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(thread([font]() {
+            for (int j = 0; j < 1000; j++) {
+                SFFontRef shared = SFFontCreateWithFace(font, 1, NULL, NULL);
+                SFFontRef separate = SFFontCreateWithFace(font, 2, NULL, NULL);
+                SFInt16 coord = 0x2000;
+                SFFontRef variant = SFFontCreateWithVariationCoordinates(shared, NULL, &coord, 1);
+
+                assert(shared->resource == font->resource);
+                assert(separate->resource->file == font->resource->file);
+                assert(variant->resource == font->resource);
+
+                SFFontRelease(variant);
+                SFFontRelease(shared);
+                SFFontRelease(separate);
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    assert(font->resource->retainCount == 1);
+    assert(font->resource->file->resources.count == 1);
+    assert(font->resource->file->retainCount == 1);
 
     SFFontRelease(font);
 }
 
+void FontTester::testResourceCache()
+{
+    const SFFontProtocol protocol = {
+        NULL,
+        &loadGDEFTable,
+        &getGlyphIDForCodepoint,
+        &getAdvanceForGlyph,
+    };
+
+    /* Test that the cache is disabled by default. */
+    {
+        SFFontRef font1 = SFFontCreateWithCompleteFunctionality();
+        SFFontRef font2 = SFFontCreateWithCompleteFunctionality();
+
+        assert(font1->resource != font2->resource);
+
+        SFFontRelease(font1);
+        SFFontRelease(font2);
+    }
+
+    SFFontSetResourceCacheEnabled(SFTrue);
+
+    /* Test that identical fonts share the resource. */
+    {
+        SFFontRef font1 = SFFontCreateWithCompleteFunctionality();
+        SFFontRef font2 = SFFontCreateWithCompleteFunctionality();
+        SFFontRef font3 = SFFontCreateWithProtocol(&protocol, (void *)OBJECT_FONT);
+
+        assert(font1->resource == font2->resource);
+        assert(font1->resource->retainCount == 2);
+        assert(font1->resource != font3->resource);
+        assert(SFFontGetGSUBTable(font3) == NULL);
+
+        SFInt16 coords[] = { 0x4000 };
+        SFFontRef derived = SFFontCreateWithVariationCoordinates(font1, (void *)OBJECT_FONT, coords, 1);
+        assert(derived->resource->retainCount == 3);
+
+        /* The shared tables MUST remain valid after releasing the first font. */
+        SFFontRelease(derived);
+        SFFontRelease(font1);
+        assert(font2->resource->retainCount == 1);
+        assert(memcmp(SFFontGetGSUBTable(font2), TABLE_GSUB, 4) == 0);
+
+        /* The shared resource MUST not refer to the object of any font. */
+        assert(font2->resource->object == NULL);
+        assert(font2->resource->loadTable == NULL);
+
+        SFFontRelease(font2);
+        SFFontRelease(font3);
+    }
+
+    /* Test that an evicted resource is not reused. */
+    {
+        SFFontRef font1 = SFFontCreateWithCompleteFunctionality();
+        assert(font1->resource->retainCount == 1);
+
+        SFFontRelease(font1);
+    }
+
+    /* Test that the borrowed tables are never shared. */
+    {
+        SFFontRef font1 = SFFontCreateWithBorrowedTables();
+        SFFontRef font2 = SFFontCreateWithBorrowedTables();
+
+        assert(font1->resource != font2->resource);
+
+        SFFontRelease(font1);
+        SFFontRelease(font2);
+    }
+
+    SFFontSetResourceCacheEnabled(SFFalse);
+}
+
+static bool isSameFingerprint(const SFFontFingerprint &f1, const SFFontFingerprint &f2)
+{
+    return memcmp(f1.words, f2.words, sizeof(f1.words)) == 0;
+}
+
+void FontTester::testFingerprint()
+{
+    vector<SFUInt8> data = createSFNTData();
+
+    SFFontRef loaded = SFFontCreateWithCompleteFunctionality();
+    SFFontRef borrowed = SFFontCreateWithBorrowedTables();
+    SFFontRef memory = SFFontCreateWithMemory(data.data(), data.size(), NULL, NULL);
+
+    SFFontFingerprint fingerprint = SFFontGetFingerprint(loaded);
+    assert(loaded->resource->hasFingerprint);
+
+    /* Test that the fingerprint only depends on the content of the tables. */
+    assert(isSameFingerprint(SFFontGetFingerprint(loaded), fingerprint));
+    assert(isSameFingerprint(SFFontGetFingerprint(borrowed), fingerprint));
+    assert(isSameFingerprint(SFFontGetFingerprint(memory), fingerprint));
+
+    /* Test that different tables give a different fingerprint. */
+    {
+        const SFFontProtocol protocol = {
+            NULL,
+            &loadGDEFTable,
+            &getGlyphIDForCodepoint,
+            NULL,
+        };
+        SFFontRef font = SFFontCreateWithProtocol(&protocol, (void *)OBJECT_FONT);
+
+        assert(!isSameFingerprint(SFFontGetFingerprint(font), fingerprint));
+
+        SFFontRelease(font);
+    }
+
+    /* Test that the variation coordinates are taken into account. */
+    {
+        SFInt16 coords1[] = { 0x4000 };
+        SFInt16 coords2[] = { 0x4000, 0 };
+        SFInt16 coords3[] = { -0x4000 };
+        SFFontRef derived1 = SFFontCreateWithVariationCoordinates(loaded, (void *)OBJECT_FONT, coords1, 1);
+        SFFontRef derived2 = SFFontCreateWithVariationCoordinates(loaded, (void *)OBJECT_FONT, coords2, 2);
+        SFFontRef derived3 = SFFontCreateWithVariationCoordinates(loaded, (void *)OBJECT_FONT, coords3, 1);
+        SFFontRef derived4 = SFFontCreateWithVariationCoordinates(memory, NULL, coords1, 1);
+
+        SFFontFingerprint fingerprint1 = SFFontGetFingerprint(derived1);
+        SFFontFingerprint fingerprint2 = SFFontGetFingerprint(derived2);
+        SFFontFingerprint fingerprint3 = SFFontGetFingerprint(derived3);
+        SFFontFingerprint fingerprint4 = SFFontGetFingerprint(derived4);
+
+        assert(!isSameFingerprint(fingerprint1, fingerprint));
+        assert(!isSameFingerprint(fingerprint1, fingerprint2));
+        assert(!isSameFingerprint(fingerprint1, fingerprint3));
+        assert(isSameFingerprint(fingerprint1, fingerprint4));
+
+        SFFontRelease(derived1);
+        SFFontRelease(derived2);
+        SFFontRelease(derived3);
+        SFFontRelease(derived4);
+    }
+
+    SFFontRelease(loaded);
+    SFFontRelease(borrowed);
+    SFFontRelease(memory);
+}
+
 void FontTester::testGetGlyphIDForCodepoint()
 {
     SFFontRef font = SFFontCreateWithCompleteFunctionality();
@@ -189,6 +843,123 @@ void FontTester::testGetGlyphIDForCodepoint()
     SFFontRelease(font);
 }
 
+void FontTester::testGlyphCache()
+{
+    SFFontRef font = SFFontCreateWithCompleteFunctionality();
+    SFUInteger hitCount;
+    SFUInteger missCount;
+
+    assert(font != NULL);
+
+    SFFontGetGlyphCacheStatistics(font, &hitCount, &missCount);
+    assert(hitCount == 0 && missCount == 0);
+
+    /* Test that a repeated code point is not passed to the protocol again. */
+    {
+        SFGlyphID expected = getGlyphIDForCodepoint(OBJECT_FONT, 0x10FFFF);
+
+        GLYPH_COUNT = 0;
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x10FFFF) == expected);
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x10FFFF) == expected);
+        assert(GLYPH_COUNT == 1);
+
+        SFFontGetGlyphCacheStatistics(font, &hitCount, &missCount);
+        assert(hitCount == 1 && missCount == 1);
+    }
+
+    /* Test that the code points sharing a slot evict each other. */
+    {
+        SFGlyphID expected1 = getGlyphIDForCodepoint(OBJECT_FONT, 0x41);
+        SFGlyphID expected2 = getGlyphIDForCodepoint(OBJECT_FONT, 0x2DC);
+
+        GLYPH_COUNT = 0;
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x41) == expected1);
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x2DC) == expected2);
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x41) == expected1);
+        assert(GLYPH_COUNT == 3);
+    }
+
+    /* Test that the batched mapping goes through the cache as well. */
+    {
+        const SFCodepoint codepoints[] = { 0x41, 0x41, 0x627, 0x41, 0x627 };
+        const SFUInteger count = sizeof(codepoints) / sizeof(codepoints[0]);
+        SFGlyphID glyphs[count];
+
+        GLYPH_COUNT = 0;
+        SFFontGetGlyphIDsForCodepoints(font, codepoints, glyphs, count);
+        assert(GLYPH_COUNT == 1);
+
+        for (SFUInteger i = 0; i < count; i++) {
+            assert(glyphs[i] == getGlyphIDForCodepoint(OBJECT_FONT, codepoints[i]));
+        }
+    }
+
+    /* Test that the code points outside the Unicode range are never cached. */
+    {
+        GLYPH_COUNT = 0;
+        SFFontGetGlyphIDForCodepoint(font, 0x110000);
+        SFFontGetGlyphIDForCodepoint(font, 0x110000);
+        assert(GLYPH_COUNT == 2);
+    }
+
+    SFFontRelease(font);
+
+    /* Test that the batched protocol is not cached. */
+    {
+        font = SFFontCreateWithBatchFunctionality();
+
+        SFFontGetGlyphIDForCodepoint(font, 0x41);
+        SFFontGetGlyphCacheStatistics(font, &hitCount, &missCount);
+        assert(hitCount == 0 && missCount == 0);
+
+        SFFontRelease(font);
+    }
+}
+
+void FontTester::testGetGlyphIDsForCodepoints()
+{
+    const SFCodepoint codepoints[] = { 0, 0x41, 0xFFFF, 0x10FFFF };
+    const SFUInteger count = sizeof(codepoints) / sizeof(codepoints[0]);
+
+    /* Test as implemented function. */
+    {
+        SFFontRef font = SFFontCreateWithBatchFunctionality();
+        SFGlyphID glyphs[count];
+
+        assert(font != NULL);
+
+        BATCH_COUNT = 0;
+        SFFontGetGlyphIDsForCodepoints(font, codepoints, glyphs, count);
+        assert(BATCH_COUNT == 1);
+
+        for (SFUInteger i = 0; i < count; i++) {
+            assert(glyphs[i] == getGlyphIDForCodepoint(OBJECT_FONT, codepoints[i]));
+        }
+
+        /* A single code point should also be mapped through the batched function. */
+        assert(SFFontGetGlyphIDForCodepoint(font, 0x41) == getGlyphIDForCodepoint(OBJECT_FONT, 0x41));
+        assert(BATCH_COUNT == 2);
+
+        SFFontRelease(font);
+    }
+
+    /* Test as un-implemented function. */
+    {
+        SFFontRef font = SFFontCreateWithRequiredFunctionality();
+        SFGlyphID glyphs[count];
+
+        BATCH_COUNT = 0;
+        SFFontGetGlyphIDsForCodepoints(font, codepoints, glyphs, count);
+        assert(BATCH_COUNT == 0);
+
+        for (SFUInteger i = 0; i < count; i++) {
+            assert(glyphs[i] == getGlyphIDForCodepoint(OBJECT_FONT, codepoints[i]));
+        }
+
+        SFFontRelease(font);
+    }
+}
+
 void FontTester::testGetAdvanceForGlyph()
 {
     /* Test as implemented function. */
@@ -234,11 +1005,65 @@ void FontTester::testGetAdvanceForGlyph()
     }
 }
 
+void FontTester::testGetAdvancesForGlyphs()
+{
+    const SFGlyphID glyphs[] = { 0, 0x41, 0x7FFF, 0xFFFF };
+    const SFUInteger count = sizeof(glyphs) / sizeof(glyphs[0]);
+
+    /* Test as implemented function. */
+    {
+        SFFontRef font = SFFontCreateWithBatchFunctionality();
+        SFAdvance advances[count];
+
+        BATCH_COUNT = 0;
+        SFFontGetAdvancesForGlyphs(font, SFFontLayoutVertical, glyphs, advances, count);
+        assert(BATCH_COUNT == 1);
+
+        for (SFUInteger i = 0; i < count; i++) {
+            assert(advances[i] == getAdvanceForGlyph(OBJECT_FONT, SFFontLayoutVertical, glyphs[i]));
+        }
+
+        /* A single glyph should also be measured through the batched function. */
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, 0x41)
+               == getAdvanceForGlyph(OBJECT_FONT, SFFontLayoutHorizontal, 0x41));
+        assert(BATCH_COUNT == 2);
+
+        SFFontRelease(font);
+    }
+
+    /* Test as un-implemented function. */
+    {
+        SFFontRef font = SFFontCreateWithCompleteFunctionality();
+        SFAdvance advances[count];
+
+        BATCH_COUNT = 0;
+        SFFontGetAdvancesForGlyphs(font, SFFontLayoutHorizontal, glyphs, advances, count);
+        assert(BATCH_COUNT == 0);
+
+        for (SFUInteger i = 0; i < count; i++) {
+            assert(advances[i] == getAdvanceForGlyph(OBJECT_FONT, SFFontLayoutHorizontal, glyphs[i]));
+        }
+
+        SFFontRelease(font);
+    }
+}
+
 void FontTester::test()
 {
     testBadProtocol();
     testFinalizeCallback();
     testLoadedTables();
+    testBorrowedTables();
+    testLazyTables();
+    testLazyTablesAcrossThreads();
+    testFileTables();
+    testCollectionFaces();
+    testCollectionFacesAcrossThreads();
+    testResourceCache();
+    testFingerprint();
     testGetGlyphIDForCodepoint();
+    testGetGlyphIDsForCodepoints();
+    testGlyphCache();
     testGetAdvanceForGlyph();
+    testGetAdvancesForGlyphs();
 }
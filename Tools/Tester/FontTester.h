@@ -27,8 +27,19 @@ public:
     void testBadProtocol();
     void testFinalizeCallback();
     void testLoadedTables();
+    void testBorrowedTables();
+    void testLazyTables();
+    void testLazyTablesAcrossThreads();
+    void testFileTables();
+    void testCollectionFaces();
+    void testCollectionFacesAcrossThreads();
+    void testResourceCache();
+    void testFingerprint();
     void testGetGlyphIDForCodepoint();
+    void testGetGlyphIDsForCodepoints();
+    void testGlyphCache();
     void testGetAdvanceForGlyph();
+    void testGetAdvancesForGlyphs();
 
     void test();
 };
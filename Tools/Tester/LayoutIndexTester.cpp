@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <cstddef>
+
+extern "C" {
+#include <Source/LayoutIndex.h>
+}
+
+#include "LayoutIndexTester.h"
+
+using namespace SheenFigure::Tester;
+
+/* A GSUB table with unsorted and duplicate tags, and records that cannot be read. */
+static const SFUInt8 GSUB_TABLE[] = {
+    /* Header */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x68, 0x00, 0x00,
+    /* Script List (10): 'latn', 'arab', 'latn' */
+    0x00, 0x03,
+    0x6C, 0x61, 0x74, 0x6E, 0x00, 0x14,
+    0x61, 0x72, 0x61, 0x62, 0x00, 0x56,
+    0x6C, 0x61, 0x74, 0x6E, 0x00, 0x5A,
+    /* Script (30): 'URD ', 'ENG ', 'ENG ', 'TRK ' beyond the table */
+    0x00, 0x1C, 0x00, 0x04,
+    0x55, 0x52, 0x44, 0x20, 0x00, 0x26,
+    0x45, 0x4E, 0x47, 0x20, 0x00, 0x2E,
+    0x45, 0x4E, 0x47, 0x20, 0x00, 0x3A,
+    0x54, 0x52, 0x4B, 0x20, 0xFF, 0x00,
+    /* Default Lang Sys (58): 'kern', 'liga' */
+    0x00, 0x00, 0xFF, 0xFF, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00,
+    /* Lang Sys (68): 'liga' */
+    0x00, 0x00, 0xFF, 0xFF, 0x00, 0x01, 0x00, 0x02,
+    /* Lang Sys (76): 'liga', 'liga', out of range */
+    0x00, 0x00, 0xFF, 0xFF, 0x00, 0x03, 0x00, 0x02, 0x00, 0x00, 0x00, 0x09,
+    /* Lang Sys (88): 'kern' */
+    0x00, 0x00, 0xFF, 0xFF, 0x00, 0x01, 0x00, 0x01,
+    /* Script (96) */
+    0x00, 0x00, 0x00, 0x00,
+    /* Script (100) */
+    0x00, 0x00, 0x00, 0x00,
+    /* Feature List (104): 'liga', 'kern', 'liga' */
+    0x00, 0x03,
+    0x6C, 0x69, 0x67, 0x61, 0x00, 0x14,
+    0x6B, 0x65, 0x72, 0x6E, 0x00, 0x1A,
+    0x6C, 0x69, 0x67, 0x61, 0x00, 0x20,
+    /* Feature (124): Lookup 0 */
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00,
+    /* Feature (130): Lookup 1 */
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x01,
+    /* Feature (136): Lookup 2 */
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x02
+};
+
+/* A GSUB table whose scripts and language systems refer to the same tables. */
+static const SFUInt8 SHARED_TABLE[] = {
+    /* Header */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x30, 0x00, 0x00,
+    /* Script List (10): 'latn', 'cyrl' */
+    0x00, 0x02,
+    0x6C, 0x61, 0x74, 0x6E, 0x00, 0x0E,
+    0x63, 0x79, 0x72, 0x6C, 0x00, 0x0E,
+    /* Script (24): 'ENG ', 'FRA ' */
+    0x00, 0x00, 0x00, 0x02,
+    0x45, 0x4E, 0x47, 0x20, 0x00, 0x10,
+    0x46, 0x52, 0x41, 0x20, 0x00, 0x10,
+    /* Lang Sys (40): 'liga' */
+    0x00, 0x00, 0xFF, 0xFF, 0x00, 0x01, 0x00, 0x00,
+    /* Feature List (48): 'liga' */
+    0x00, 0x01,
+    0x6C, 0x69, 0x67, 0x61, 0x00, 0x08,
+    /* Feature (56): Lookup 0 */
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00
+};
+
+static const SFTag LATN = SFTagMake('l', 'a', 't', 'n');
+static const SFTag LIGA = SFTagMake('l', 'i', 'g', 'a');
+static const SFTag KERN = SFTagMake('k', 'e', 'r', 'n');
+
+LayoutIndexTester::LayoutIndexTester()
+{
+}
+
+void LayoutIndexTester::testScripts()
+{
+    LayoutIndexRef layoutIndex = LayoutIndexCreate(GSUB_TABLE, sizeof(GSUB_TABLE));
+    assert(layoutIndex != NULL);
+    assert(layoutIndex->scriptCount == 3);
+
+    /* Test that the first one of the duplicate scripts is found. */
+    IndexedScriptRef latn = LayoutIndexSearchScript(layoutIndex, LATN);
+    assert(latn != NULL);
+    assert(latn->table == &GSUB_TABLE[30]);
+
+    IndexedScriptRef arab = LayoutIndexSearchScript(layoutIndex, SFTagMake('a', 'r', 'a', 'b'));
+    assert(arab != NULL);
+    assert(arab->table == &GSUB_TABLE[96]);
+    assert(arab->defaultLangSys == NULL);
+    assert(arab->langSysCount == 0);
+
+    /* Test the tags around and between the existing ones. */
+    assert(LayoutIndexSearchScript(layoutIndex, SFTagMake('a', 'a', 'a', 'a')) == NULL);
+    assert(LayoutIndexSearchScript(layoutIndex, SFTagMake('c', 'y', 'r', 'l')) == NULL);
+    assert(LayoutIndexSearchScript(layoutIndex, SFTagMake('z', 'z', 'z', 'z')) == NULL);
+
+    LayoutIndexDestroy(layoutIndex);
+}
+
+void LayoutIndexTester::testLanguages()
+{
+    LayoutIndexRef layoutIndex = LayoutIndexCreate(GSUB_TABLE, sizeof(GSUB_TABLE));
+    IndexedScriptRef latn = LayoutIndexSearchScript(layoutIndex, LATN);
+
+    /* Test that the language system beyond the table is left out. */
+    assert(latn->langSysCount == 3);
+    assert(LayoutIndexSearchLangSys(latn, SFTagMake('T', 'R', 'K', ' ')) == NULL);
+
+    /* Test that the default tag refers to the default language system. */
+    IndexedLangSysRef langSys = LayoutIndexSearchLangSys(latn, SFTagMake('d', 'f', 'l', 't'));
+    assert(langSys != NULL);
+    assert(langSys == latn->defaultLangSys);
+    assert(langSys->table == &GSUB_TABLE[58]);
+
+    langSys = LayoutIndexSearchLangSys(latn, SFTagMake('U', 'R', 'D', ' '));
+    assert(langSys != NULL);
+    assert(langSys->table == &GSUB_TABLE[68]);
+
+    /* Test that the first one of the duplicate language systems is found. */
+    langSys = LayoutIndexSearchLangSys(latn, SFTagMake('E', 'N', 'G', ' '));
+    assert(langSys != NULL);
+    assert(langSys->table == &GSUB_TABLE[76]);
+
+    LayoutIndexDestroy(layoutIndex);
+}
+
+void LayoutIndexTester::testFeatures()
+{
+    LayoutIndexRef layoutIndex = LayoutIndexCreate(GSUB_TABLE, sizeof(GSUB_TABLE));
+    IndexedScriptRef latn = LayoutIndexSearchScript(layoutIndex, LATN);
+    IndexedLangSysRef langSys;
+
+    /* Test the features listed in the reverse order of their tags. */
+    langSys = latn->defaultLangSys;
+    assert(LayoutIndexSearchFeatureTable(layoutIndex, langSys, NULL, LIGA) == &GSUB_TABLE[124]);
+    assert(LayoutIndexSearchFeatureTable(layoutIndex, langSys, NULL, KERN) == &GSUB_TABLE[130]);
+
+    langSys = LayoutIndexSearchLangSys(latn, SFTagMake('U', 'R', 'D', ' '));
+    assert(LayoutIndexSearchFeatureTable(layoutIndex, langSys, NULL, LIGA) == &GSUB_TABLE[136]);
+    assert(LayoutIndexSearchFeatureTable(layoutIndex, langSys, NULL, KERN) == NULL);
+
+    /*
+     * Test that the first one of the features having the same tag is found and the feature index
+     * beyond the feature list is left out.
+     */
+    langSys = LayoutIndexSearchLangSys(latn, SFTagMake('E', 'N', 'G', ' '));
+    assert(langSys->featureCount == 2);
+    assert(LayoutIndexSearchFeatureTable(layoutIndex, langSys, NULL, LIGA) == &GSUB_TABLE[136]);
+
+    LayoutIndexDestroy(layoutIndex);
+}
+
+void LayoutIndexTester::testSharedTables()
+{
+    LayoutIndexRef layoutIndex = LayoutIndexCreate(SHARED_TABLE, sizeof(SHARED_TABLE));
+    assert(layoutIndex != NULL);
+    assert(layoutIndex->scriptCount == 2);
+
+    /* Test that the scripts referring to the same table share its language systems. */
+    IndexedScriptRef latn = LayoutIndexSearchScript(layoutIndex, LATN);
+    IndexedScriptRef cyrl = LayoutIndexSearchScript(layoutIndex, SFTagMake('c', 'y', 'r', 'l'));
+    assert(latn != NULL && cyrl != NULL);
+    assert(latn->table == &SHARED_TABLE[24]);
+    assert(cyrl->table == latn->table);
+    assert(cyrl->langSyses == latn->langSyses);
+    assert(latn->langSysCount == 2);
+
+    /* Test that the language systems referring to the same table share its features. */
+    IndexedLangSysRef eng = LayoutIndexSearchLangSys(cyrl, SFTagMake('E', 'N', 'G', ' '));
+    IndexedLangSysRef fra = LayoutIndexSearchLangSys(cyrl, SFTagMake('F', 'R', 'A', ' '));
+    assert(eng != NULL && fra != NULL);
+    assert(eng->table == &SHARED_TABLE[40]);
+    assert(fra->features == eng->features);
+    assert(LayoutIndexSearchFeatureTable(layoutIndex, fra, NULL, LIGA) == &SHARED_TABLE[56]);
+
+    LayoutIndexDestroy(layoutIndex);
+}
+
+void LayoutIndexTester::testMalformedLists()
+{
+    /* Test that a truncated header gives no index. */
+    assert(LayoutIndexCreate(GSUB_TABLE, 9) == NULL);
+    assert(LayoutIndexCreate(NULL, 0) == NULL);
+
+    /* Test that a truncated script list gives no index. */
+    assert(LayoutIndexCreate(GSUB_TABLE, 20) == NULL);
+
+    /* Test that a truncated feature list gives no index. */
+    assert(LayoutIndexCreate(GSUB_TABLE, 120) == NULL);
+}
+
+void LayoutIndexTester::test()
+{
+    testScripts();
+    testLanguages();
+    testFeatures();
+    testSharedTables();
+    testMalformedLists();
+}
@@ -20,6 +20,7 @@
 
 extern "C" {
 #include <Source/SFAlbum.h>
+#include <Source/GlyphDefinitions.h>
 #include <Source/Locator.h>
 }
 
@@ -253,7 +254,7 @@ static void testMoveNext(const GlyphTraits *traits, SFInteger count)
     SFAlbumRef album = SFAlbumCreateWithTraits(traits, (SFUInteger)count);
 
     Locator locator;
-    LocatorInitialize(&locator, album, NULL);
+    LocatorInitialize(&locator, album, NULL, NULL);
 
     const SFUInt16 *lookupFlagArray = LOOKUP_FLAG_LIST;
     SFInteger lookupFlagCount = sizeof(LOOKUP_FLAG_LIST) / sizeof(SFUInt16);
@@ -289,7 +290,7 @@ static void testSkip(const GlyphTraits *traits, SFInteger count)
     SFAlbumRef album = SFAlbumCreateWithTraits(traits, (SFUInteger)count);
 
     Locator locator;
-    LocatorInitialize(&locator, album, NULL);
+    LocatorInitialize(&locator, album, NULL, NULL);
 
     const SFUInt16 *lookupFlagArray = LOOKUP_FLAG_LIST;
     SFInteger lookupFlagCount = sizeof(LOOKUP_FLAG_LIST) / sizeof(SFUInt16);
@@ -333,7 +334,7 @@ static void testJumpTo(const GlyphTraits *traits, SFInteger count)
     SFAlbumRef album = SFAlbumCreateWithTraits(traits, (SFUInteger)count);
 
     Locator locator;
-    LocatorInitialize(&locator, album, NULL);
+    LocatorInitialize(&locator, album, NULL, NULL);
 
     const SFUInt16 *lookupFlagArray = LOOKUP_FLAG_LIST;
     SFInteger lookupFlagCount = sizeof(LOOKUP_FLAG_LIST) / sizeof(SFUInt16);
@@ -371,7 +372,7 @@ static void testGetAfter(const GlyphTraits *traits, SFInteger count)
     SFAlbumRef album = SFAlbumCreateWithTraits(traits, (SFUInteger)count);
 
     Locator locator;
-    LocatorInitialize(&locator, album, NULL);
+    LocatorInitialize(&locator, album, NULL, NULL);
 
     const SFUInt16 *lookupFlagArray = LOOKUP_FLAG_LIST;
     SFInteger lookupFlagCount = sizeof(LOOKUP_FLAG_LIST) / sizeof(SFUInt16);
@@ -405,7 +406,7 @@ static void testGetBefore(const GlyphTraits *traits, SFInteger count)
     SFAlbumRef album = SFAlbumCreateWithTraits(traits, (SFUInteger)count);
 
     Locator locator;
-    LocatorInitialize(&locator, album, NULL);
+    LocatorInitialize(&locator, album, NULL, NULL);
 
     const SFUInt16 *lookupFlagArray = LOOKUP_FLAG_LIST;
     SFInteger lookupFlagCount = sizeof(LOOKUP_FLAG_LIST) / sizeof(SFUInt16);
@@ -474,6 +475,7 @@ LocatorTester::LocatorTester()
     writer.write(&gdef);
 
     m_gdef = new uint8_t[writer.size()];
+    m_gdefSize = (size_t)writer.size();
     memcpy(m_gdef, writer.data(), (size_t)writer.size());
 }
 
@@ -586,19 +588,40 @@ void LocatorTester::testMarkFilteringSet()
     }
 
     SFAlbumRef album = SFAlbumCreateWithTraits(traits, (SFUInteger)count);
+    GlyphDefinitionsRef definitions = GlyphDefinitionsCreate(m_gdef, m_gdefSize);
+    assert(definitions != NULL);
+    /* A truncated table should not be used for dense glyph definitions. */
+    assert(GlyphDefinitionsCreate(m_gdef, m_gdefSize - 1) == NULL);
+
+    /* Test by searching GDEF table as well as with the dense glyph definitions. */
+    for (int pass = 0; pass < 2; pass++) {
+        Locator locator;
+        LocatorInitialize(&locator, album, m_gdef, pass ? definitions : NULL);
+        LocatorReset(&locator, 0, (SFUInteger)count);
+        LocatorSetLookupFlag(&locator, LookupFlagUseMarkFilteringSet);
+        LocatorSetMarkFilteringSet(&locator, 0);
+
+        /* Zero mark filtering set contains even glyphs, so we should get only those. */
+        SFUInteger matched = 0;
+        while (LocatorMoveNext(&locator)) {
+            SFGlyphID glyph = SFAlbumGetGlyph(album, locator.index);
+            assert((glyph % 2) == 0);
+            matched++;
+        }
+        assert(matched == 5);
 
-    Locator locator;
-    LocatorInitialize(&locator, album, m_gdef);
-    LocatorReset(&locator, 0, (SFUInteger)count);
-    LocatorSetLookupFlag(&locator, LookupFlagUseMarkFilteringSet);
-    LocatorSetMarkFilteringSet(&locator, 0);
-
-    /* Zero mark filtering set contains even glyphs, so we should get only those. */
-    while (LocatorMoveNext(&locator)) {
-        SFGlyphID glyph = SFAlbumGetGlyph(album, locator.index);
-        assert((glyph % 2) == 0);
+        /* An unknown mark filtering set should not filter any glyph. */
+        LocatorReset(&locator, 0, (SFUInteger)count);
+        LocatorSetMarkFilteringSet(&locator, 1);
+
+        matched = 0;
+        while (LocatorMoveNext(&locator)) {
+            matched++;
+        }
+        assert(matched == (SFUInteger)count);
     }
 
+    GlyphDefinitionsDestroy(definitions);
     SFAlbumRelease(album);
 }
 
@@ -611,18 +634,27 @@ void LocatorTester::testMarkAttachmentType()
     }
 
     SFAlbumRef album = SFAlbumCreateWithTraits(traits, (SFUInteger)count);
+    GlyphDefinitionsRef definitions = GlyphDefinitionsCreate(m_gdef, m_gdefSize);
+    assert(definitions != NULL);
 
-    Locator locator;
-    LocatorInitialize(&locator, album, m_gdef);
-    LocatorReset(&locator, 0, (SFUInteger)count);
-    LocatorSetLookupFlag(&locator, 0x0100);
-
-    /* Class 1 contains odd glyphs, so we should get only those. */
-    while (LocatorMoveNext(&locator)) {
-        SFGlyphID glyph = SFAlbumGetGlyph(album, locator.index);
-        assert((glyph % 2) == 1);
+    /* Test by searching GDEF table as well as with the dense glyph definitions. */
+    for (int pass = 0; pass < 2; pass++) {
+        Locator locator;
+        LocatorInitialize(&locator, album, m_gdef, pass ? definitions : NULL);
+        LocatorReset(&locator, 0, (SFUInteger)count);
+        LocatorSetLookupFlag(&locator, 0x0100);
+
+        /* Class 1 contains odd glyphs, so we should get only those. */
+        SFUInteger matched = 0;
+        while (LocatorMoveNext(&locator)) {
+            SFGlyphID glyph = SFAlbumGetGlyph(album, locator.index);
+            assert((glyph % 2) == 1);
+            matched++;
+        }
+        assert(matched == 5);
     }
 
+    GlyphDefinitionsDestroy(definitions);
     SFAlbumRelease(album);
 }
 
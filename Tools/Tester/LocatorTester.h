@@ -37,6 +37,7 @@ public:
 
 private:
     uint8_t *m_gdef;
+    size_t m_gdefSize;
 };
 
 }
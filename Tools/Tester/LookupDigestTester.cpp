@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <cstddef>
+
+extern "C" {
+#include <Source/LookupDigest.h>
+}
+
+#include "LookupDigestTester.h"
+
+using namespace SheenFigure::Tester;
+
+/* A GSUB table having only a lookup list, with a lookup of each interesting kind. */
+static const SFUInt8 GSUB_TABLE[] = {
+    /* Header */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A,
+    /* Lookup List (10) */
+    0x00, 0x04, 0x00, 0x0A, 0x00, 0x32, 0x00, 0x54, 0x00, 0x62,
+    /* Lookup 0 (20): Single substitution with two subtables */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x0A, 0x00, 0x18,
+    /* Single Substitution (30) */
+    0x00, 0x01, 0x00, 0x06, 0x00, 0x01,
+    /* Coverage (36): Glyphs 10 and 11 */
+    0x00, 0x01, 0x00, 0x02, 0x00, 0x0A, 0x00, 0x0B,
+    /* Single Substitution (44) */
+    0x00, 0x01, 0x00, 0x06, 0x00, 0x01,
+    /* Coverage (50): Glyphs 1000 to 1010 */
+    0x00, 0x02, 0x00, 0x01, 0x03, 0xE8, 0x03, 0xF2, 0x00, 0x00,
+    /* Lookup 1 (60): Chained context */
+    0x00, 0x06, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08,
+    /* Chained Context Format 3 (68) */
+    0x00, 0x03, 0x00, 0x01, 0x00, 0x0E, 0x00, 0x01, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00,
+    /* Backtrack Coverage (82): Glyph 5 */
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x05,
+    /* Input Coverage (88): Glyph 300 */
+    0x00, 0x01, 0x00, 0x01, 0x01, 0x2C,
+    /* Lookup 2 (94): Single substitution with a dangling coverage */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08,
+    /* Single Substitution (102) */
+    0x00, 0x01, 0x70, 0x00, 0x00, 0x01,
+    /* Lookup 3 (108): Extension */
+    0x00, 0x07, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08,
+    /* Extension (116) */
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x08,
+    /* Single Substitution (124) */
+    0x00, 0x01, 0x00, 0x06, 0x00, 0x01,
+    /* Coverage (130): Glyph 20 */
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x14
+};
+
+static LookupDigestListRef createDigests()
+{
+    LookupDigestListRef digests = LookupDigestListCreate(GSUB_TABLE, sizeof(GSUB_TABLE), SFFalse);
+    assert(digests != NULL);
+    assert(digests->count == 4);
+
+    return digests;
+}
+
+LookupDigestTester::LookupDigestTester()
+{
+}
+
+void LookupDigestTester::testCoverageDigests()
+{
+    LookupDigestListRef digests = createDigests();
+    LookupDigestRef lookup = &digests->items[0];
+
+    assert(lookup->subtableCount == 2);
+
+    /* Test that the digests contain all covered glyphs. */
+    assert(GlyphDigestMayContain(&lookup->subtables[0], 10));
+    assert(GlyphDigestMayContain(&lookup->subtables[0], 11));
+    for (SFGlyphID glyph = 1000; glyph <= 1010; glyph++) {
+        assert(GlyphDigestMayContain(&lookup->subtables[1], glyph));
+        assert(GlyphDigestMayContain(&lookup->digest, glyph));
+    }
+    assert(GlyphDigestMayContain(&lookup->digest, 10));
+
+    /* Test that the glyphs of one subtable are rejected by the other one. */
+    assert(!GlyphDigestMayContain(&lookup->subtables[0], 1005));
+    assert(!GlyphDigestMayContain(&lookup->subtables[1], 10));
+
+    /* Test that unrelated glyphs are rejected by the whole lookup. */
+    assert(!GlyphDigestMayContain(&lookup->digest, 20));
+    assert(!GlyphDigestMayContain(&lookup->digest, 300));
+
+    /* Test the intersection with the digest of a glyph run. */
+    GlyphDigest run;
+    GlyphDigestClear(&run);
+    GlyphDigestAddGlyph(&run, 20);
+    GlyphDigestAddGlyph(&run, 300);
+    assert(!GlyphDigestMayIntersect(&lookup->digest, &run));
+
+    GlyphDigestAddGlyph(&run, 1003);
+    assert(GlyphDigestMayIntersect(&lookup->digest, &run));
+
+    LookupDigestListDestroy(digests);
+}
+
+void LookupDigestTester::testContextDigests()
+{
+    LookupDigestListRef digests = createDigests();
+    LookupDigestRef lookup = &digests->items[1];
+
+    /* Only the first input glyph can start the chained context. */
+    assert(GlyphDigestMayContain(&lookup->digest, 300));
+    assert(!GlyphDigestMayContain(&lookup->digest, 5));
+
+    LookupDigestListDestroy(digests);
+}
+
+void LookupDigestTester::testExtensionDigests()
+{
+    LookupDigestListRef digests = createDigests();
+    LookupDigestRef lookup = &digests->items[3];
+
+    assert(GlyphDigestMayContain(&lookup->digest, 20));
+    assert(!GlyphDigestMayContain(&lookup->digest, 21));
+
+    LookupDigestListDestroy(digests);
+}
+
+void LookupDigestTester::testMalformedLookups()
+{
+    /* Test that a subtable which cannot be summarized accepts all glyphs. */
+    {
+        LookupDigestListRef digests = createDigests();
+        LookupDigestRef lookup = &digests->items[2];
+
+        assert(GlyphDigestMayContain(&lookup->digest, 0));
+        assert(GlyphDigestMayContain(&lookup->digest, 12345));
+        assert(GlyphDigestMayContain(&lookup->subtables[0], 0xFFFF));
+
+        LookupDigestListDestroy(digests);
+    }
+
+    /* Test that a truncated lookup accepts all glyphs without subtable digests. */
+    {
+        LookupDigestListRef digests = LookupDigestListCreate(GSUB_TABLE, 64, SFFalse);
+        LookupDigestRef lookup = &digests->items[1];
+
+        assert(lookup->subtables == NULL);
+        assert(GlyphDigestMayContain(&lookup->digest, 5));
+
+        LookupDigestListDestroy(digests);
+    }
+
+    /* Test that an unreadable lookup list gives no digests. */
+    assert(LookupDigestListCreate(GSUB_TABLE, 9, SFFalse) == NULL);
+    assert(LookupDigestListCreate(GSUB_TABLE, 15, SFFalse) == NULL);
+}
+
+void LookupDigestTester::test()
+{
+    testCoverageDigests();
+    testContextDigests();
+    testExtensionDigests();
+    testMalformedLookups();
+}
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <Source/Metrics.h>
+#include <Source/Sanitizer.h>
+#include <Source/SFFont.h>
+}
+
+#include "Utilities/General.h"
+#include "MetricsTester.h"
+
+using namespace std;
+using namespace SheenFigure::Tester;
+using namespace SheenFigure::Tester::Utilities;
+
+static const SFUInteger GLYPH_COUNT = 5;
+
+static void *OBJECT_FONT = &OBJECT_FONT;
+
+static void appendUInt16(vector<SFUInt8> &data, SFUInt16 value)
+{
+    data.push_back((SFUInt8)(value >> 8));
+    data.push_back((SFUInt8)(value >> 0));
+}
+
+static void appendUInt32(vector<SFUInt8> &data, SFUInt32 value)
+{
+    appendUInt16(data, (SFUInt16)(value >> 16));
+    appendUInt16(data, (SFUInt16)(value >> 0));
+}
+
+static vector<SFUInt8> createHHEA()
+{
+    vector<SFUInt8> data(34, 0);
+    data[1] = 0x01;
+
+    /* Only three glyphs have a full metric. */
+    appendUInt16(data, 3);
+
+    return data;
+}
+
+static vector<SFUInt8> createMAXP()
+{
+    vector<SFUInt8> data;
+    appendUInt32(data, 0x00005000);
+    appendUInt16(data, GLYPH_COUNT);
+
+    return data;
+}
+
+static vector<SFUInt8> createHMTX()
+{
+    vector<SFUInt8> data;
+
+    for (SFUInt16 i = 1; i <= 3; i++) {
+        appendUInt16(data, i * 100);
+        appendUInt16(data, 0);
+    }
+    appendUInt16(data, 0);
+    appendUInt16(data, 0);
+
+    return data;
+}
+
+static vector<SFUInt8> createHVAR(bool hasMapping)
+{
+    const SFInt16 deltas[] = { 10, 20, -30, 0, 40 };
+    vector<SFUInt8> data;
+
+    /* Header */
+    appendUInt16(data, 1);
+    appendUInt16(data, 0);
+    appendUInt32(data, 20);
+    appendUInt32(data, hasMapping ? 60 : 0);
+    appendUInt32(data, 0);
+    appendUInt32(data, 0);
+
+    /* Item Variation Store (20) */
+    appendUInt16(data, 1);
+    appendUInt32(data, 12);
+    appendUInt16(data, 1);
+    appendUInt32(data, 22);
+
+    /* Variation Region List (32), with a single region peaking at 0.5 of the only axis. */
+    appendUInt16(data, 1);
+    appendUInt16(data, 1);
+    appendUInt16(data, 0);
+    appendUInt16(data, 0x2000);
+    appendUInt16(data, 0x4000);
+
+    /* Item Variation Data (42) */
+    appendUInt16(data, GLYPH_COUNT);
+    appendUInt16(data, 1);
+    appendUInt16(data, 1);
+    appendUInt16(data, 0);
+
+    for (SFUInteger i = 0; i < GLYPH_COUNT; i++) {
+        appendUInt16(data, (SFUInt16)deltas[i]);
+    }
+
+    /* Advance Width Mapping (60), swapping the first two glyphs. */
+    if (hasMapping) {
+        data.push_back(0);
+        data.push_back(0x00);
+        appendUInt16(data, 2);
+        data.push_back(1);
+        data.push_back(0);
+    }
+
+    return data;
+}
+
+static vector<SFUInt8> createSFNT(const vector<pair<const char *, vector<SFUInt8>>> &tables)
+{
+    SFUInt16 tableCount = (SFUInt16)tables.size();
+    SFUInt32 offset = 12 + (tableCount * 16);
+    vector<SFUInt8> data;
+
+    appendUInt32(data, 0x00010000);
+    appendUInt16(data, tableCount);
+    appendUInt16(data, 0);
+    appendUInt16(data, 0);
+    appendUInt16(data, 0);
+
+    for (const auto &table : tables) {
+        appendUInt32(data, tag(table.first));
+        appendUInt32(data, 0);
+        appendUInt32(data, offset);
+        appendUInt32(data, (SFUInt32)table.second.size());
+
+        offset += (SFUInt32)((table.second.size() + 3) & ~3);
+    }
+
+    for (const auto &table : tables) {
+        data.insert(data.end(), table.second.begin(), table.second.end());
+        data.resize((data.size() + 3) & ~3);
+    }
+
+    return data;
+}
+
+static SFAdvance getAdvanceForGlyph(void *object, SFFontLayout fontLayout, SFGlyphID glyphID)
+{
+    assert(object == OBJECT_FONT);
+
+    return 1000;
+}
+
+MetricsTester::MetricsTester()
+{
+}
+
+void MetricsTester::testAdvanceArray()
+{
+    vector<SFUInt8> hhea = createHHEA();
+    vector<SFUInt8> hmtx = createHMTX();
+    vector<SFUInt8> maxp = createMAXP();
+    SFUInteger count = 0;
+
+    /* Test that the glyphs beyond the last metric take its advance. */
+    {
+        SFAdvance *advances = CreateAdvanceArray(hhea.data(), hhea.size(), hmtx.data(), hmtx.size(),
+                                                 maxp.data(), maxp.size(), &count);
+        const SFAdvance expected[] = { 100, 200, 300, 300, 300 };
+
+        assert(advances != NULL);
+        assert(count == GLYPH_COUNT);
+        assert(equal(advances, advances + count, expected));
+
+        free(advances);
+    }
+
+    /* Test that only the glyphs with full metrics are known without maxp table. */
+    {
+        SFAdvance *advances = CreateAdvanceArray(hhea.data(), hhea.size(), hmtx.data(), hmtx.size(),
+                                                 NULL, 0, &count);
+        assert(advances != NULL);
+        assert(count == 3);
+
+        free(advances);
+    }
+
+    /* Test with the metrics that do not fit in hmtx table. */
+    {
+        SFAdvance *advances = CreateAdvanceArray(hhea.data(), hhea.size(), hmtx.data(), 11,
+                                                 maxp.data(), maxp.size(), &count);
+        assert(advances == NULL);
+    }
+
+    /* Test with a truncated hhea table. */
+    {
+        SFAdvance *advances = CreateAdvanceArray(hhea.data(), 35, hmtx.data(), hmtx.size(),
+                                                 maxp.data(), maxp.size(), &count);
+        assert(advances == NULL);
+    }
+}
+
+void MetricsTester::testVariedAdvanceArray()
+{
+    const SFAdvance advances[] = { 100, 200, 300, 300, 300 };
+    const SFInt16 peakCoords[] = { 0x2000 };
+    const SFInt16 halfCoords[] = { 0x3000 };
+    const SFInt16 outerCoords[] = { -0x4000 };
+
+    /* Test with implicit mapping of glyphs to delta sets. */
+    {
+        vector<SFUInt8> hvar = createHVAR(false);
+        assert(SanitizeHVAR(hvar.data(), hvar.size()));
+
+        SFAdvance *peak = CreateVariedAdvanceArray(advances, GLYPH_COUNT, hvar.data(), peakCoords, 1);
+        const SFAdvance expectedPeak[] = { 110, 220, 270, 300, 340 };
+        assert(equal(peak, peak + GLYPH_COUNT, expectedPeak));
+        free(peak);
+
+        SFAdvance *half = CreateVariedAdvanceArray(advances, GLYPH_COUNT, hvar.data(), halfCoords, 1);
+        const SFAdvance expectedHalf[] = { 105, 210, 285, 300, 320 };
+        assert(equal(half, half + GLYPH_COUNT, expectedHalf));
+        free(half);
+
+        SFAdvance *outer = CreateVariedAdvanceArray(advances, GLYPH_COUNT, hvar.data(), outerCoords, 1);
+        assert(equal(outer, outer + GLYPH_COUNT, advances));
+        free(outer);
+    }
+
+    /* Test with an explicit advance width mapping. */
+    {
+        vector<SFUInt8> hvar = createHVAR(true);
+        assert(SanitizeHVAR(hvar.data(), hvar.size()));
+
+        SFAdvance *peak = CreateVariedAdvanceArray(advances, GLYPH_COUNT, hvar.data(), peakCoords, 1);
+        const SFAdvance expectedPeak[] = { 120, 210, 310, 310, 310 };
+        assert(equal(peak, peak + GLYPH_COUNT, expectedPeak));
+        free(peak);
+    }
+}
+
+void MetricsTester::testMalformedHVAR()
+{
+    vector<SFUInt8> hvar = createHVAR(true);
+
+    assert(!SanitizeHVAR(NULL, 0));
+    assert(!SanitizeHVAR(hvar.data(), 19));
+    assert(!SanitizeHVAR(hvar.data(), hvar.size() - 1));
+    assert(!SanitizeHVAR(hvar.data(), 59));
+
+    /* Test with an unknown major version. */
+    hvar[1] = 2;
+    assert(!SanitizeHVAR(hvar.data(), hvar.size()));
+    hvar[1] = 1;
+
+    /* Test with reserved bits of entry format in advance width mapping. */
+    hvar[61] = 0xC0;
+    assert(!SanitizeHVAR(hvar.data(), hvar.size()));
+}
+
+void MetricsTester::testBuiltInFontAdvances()
+{
+    vector<SFUInt8> sfnt = createSFNT({
+        { "HVAR", createHVAR(false) },
+        { "hhea", createHHEA() },
+        { "hmtx", createHMTX() },
+        { "maxp", createMAXP() },
+    });
+
+    /* Test that the tables are used in the absence of advance functions. */
+    {
+        SFFontRef font = SFFontCreateWithMemory(sfnt.data(), sfnt.size(), NULL, NULL);
+        const SFInt16 coords[] = { 0x2000 };
+        const SFGlyphID glyphs[] = { 0, 1, 2, 3, 4, 5 };
+        SFAdvance advances[6];
+
+        assert(font != NULL);
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, 0) == 100);
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, 4) == 300);
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, 5) == 0);
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutVertical, 0) == 0);
+
+        SFFontRef instance = SFFontCreateWithVariationCoordinates(font, NULL, coords, 1);
+        const SFAdvance expected[] = { 110, 220, 270, 300, 340, 0 };
+
+        SFFontGetAdvancesForGlyphs(instance, SFFontLayoutHorizontal, glyphs, advances, 6);
+        assert(equal(advances, advances + 6, expected));
+
+        /* The default instance must be left untouched. */
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, 0) == 100);
+
+        SFFontRelease(instance);
+        SFFontRelease(font);
+    }
+
+    /* Test that the advance function of the protocol takes precedence. */
+    {
+        SFFontProtocol protocol = {
+            NULL,
+            NULL,
+            NULL,
+            &getAdvanceForGlyph,
+        };
+        SFFontRef font = SFFontCreateWithMemory(sfnt.data(), sfnt.size(), &protocol, OBJECT_FONT);
+
+        assert(SFFontGetAdvanceForGlyph(font, SFFontLayoutHorizontal, 0) == 1000);
+
+        SFFontRelease(font);
+    }
+}
+
+void MetricsTester::test()
+{
+    testAdvanceArray();
+    testVariedAdvanceArray();
+    testMalformedHVAR();
+    testBuiltInFontAdvances();
+}
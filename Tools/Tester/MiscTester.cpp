@@ -16,12 +16,16 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <vector>
 
 extern "C" {
 #include <Source/Common.h>
 #include <Source/Data.h>
+#include <Source/DeltaCache.h>
 #include <Source/OpenType.h>
+#include <Source/PairCache.h>
+#include <Source/PairMatrix.h>
 }
 
 #include "OpenType/Builder.h"
@@ -36,6 +40,253 @@ MiscTester::MiscTester()
 {
 }
 
+void MiscTester::testCoverageIndex()
+{
+    /* Test the first format with arrays of different lengths. */
+    for (UInt16 count = 0; count <= 33; count++) {
+        vector<Glyph> glyphs;
+        for (UInt16 i = 0; i < count; i++) {
+            glyphs.push_back((Glyph)(i * 3 + 1));
+        }
+
+        CoverageTable coverage;
+        coverage.coverageFormat = 1;
+        coverage.format1.glyphCount = count;
+        coverage.format1.glyphArray = glyphs.data();
+
+        Writer writer;
+        writer.write(&coverage);
+
+        Data data = writer.data();
+
+        for (Glyph glyph = 0; glyph <= count * 3 + 2; glyph++) {
+            SFUInteger expected = (glyph % 3 == 1 && glyph / 3 < count ? glyph / 3 : SFInvalidIndex);
+            assert(SearchCoverageIndex(data, glyph) == expected);
+        }
+        assert(SearchCoverageIndex(data, 0xFFFF) == SFInvalidIndex);
+    }
+
+    /* Test the second format with arrays of different lengths. */
+    for (UInt16 count = 0; count <= 17; count++) {
+        vector<RangeRecord> ranges(count);
+        for (UInt16 i = 0; i < count; i++) {
+            ranges[i].start = (Glyph)(i * 10 + 5);
+            ranges[i].end = (Glyph)(i * 10 + 9);
+            ranges[i].startCoverageIndex = (UInt16)(i * 5);
+        }
+
+        CoverageTable coverage;
+        coverage.coverageFormat = 2;
+        coverage.format2.rangeCount = count;
+        coverage.format2.rangeRecord = ranges.data();
+
+        Writer writer;
+        writer.write(&coverage);
+
+        Data data = writer.data();
+
+        for (Glyph glyph = 0; glyph <= count * 10 + 10; glyph++) {
+            SFUInteger expected = SFInvalidIndex;
+            if (glyph % 10 >= 5 && glyph / 10 < count) {
+                expected = (glyph / 10) * 5 + (glyph % 10 - 5);
+            }
+            assert(SearchCoverageIndex(data, glyph) == expected);
+        }
+    }
+}
+
+void MiscTester::testGlyphClass()
+{
+    Builder builder;
+
+    /* Test the first format. */
+    {
+        ClassDefTable &classDef = builder.createClassDef(10, 3, { 1, 0, 2 });
+
+        Writer writer;
+        writer.write(&classDef);
+
+        Data data = writer.data();
+
+        assert(SearchGlyphClass(data, 9) == 0);
+        assert(SearchGlyphClass(data, 10) == 1);
+        assert(SearchGlyphClass(data, 11) == 0);
+        assert(SearchGlyphClass(data, 12) == 2);
+        assert(SearchGlyphClass(data, 13) == 0);
+    }
+
+    /* Test the second format with arrays of different lengths. */
+    for (UInt16 count = 0; count <= 17; count++) {
+        vector<class_range> ranges;
+        for (UInt16 i = 0; i < count; i++) {
+            ranges.push_back(class_range((Glyph)(i * 10 + 5), (Glyph)(i * 10 + 9), (UInt16)(i + 1)));
+        }
+
+        ClassDefTable &classDef = builder.createClassDef(ranges);
+
+        Writer writer;
+        writer.write(&classDef);
+
+        Data data = writer.data();
+
+        for (Glyph glyph = 0; glyph <= count * 10 + 10; glyph++) {
+            UInt16 expected = 0;
+            if (glyph % 10 >= 5 && glyph / 10 < count) {
+                expected = (UInt16)(glyph / 10 + 1);
+            }
+            assert(SearchGlyphClass(data, glyph) == expected);
+        }
+    }
+}
+
+void MiscTester::testPairMatrix()
+{
+    Builder builder;
+
+    ValueRecord &positive = builder.createValueRecord({ 10, 20, 30, 40 });
+    ValueRecord &negative = builder.createValueRecord({ -1, -2, -3, -4 });
+    ValueRecord &device = builder.createValueRecord({ 10, 20, 30, 40 }, {
+        &builder.createDevice({8, 10}, { -1, 0, 1 }), nullptr, nullptr, nullptr
+    });
+    reference_wrapper<ClassDefTable> classDefs[] = {
+        builder.createClassDef(11, 3, { 1, 2, 3 }),
+        builder.createClassDef(21, 2, { 1, 2 }),
+    };
+
+    /* Test the compiled classes and values. */
+    {
+        PairAdjustmentPosSubtable &pairPos = builder.createPairPos({ 11, 12 }, classDefs, {
+            pair_rule { 1, 2, positive, negative },
+            pair_rule { 2, 1, negative, positive }
+        });
+
+        Writer writer;
+        writer.write(&pairPos);
+
+        Data data = writer.data();
+        PairMatrixRef pairMatrix = PairMatrixCreate(data, writer.size());
+
+        assert(pairMatrix != NULL);
+        assert(pairMatrix->source == data);
+        assert(pairMatrix->valueCount == 8);
+
+        /* Test that only the covered glyphs have a valid first class. */
+        assert(PairMatrixGetClass1(pairMatrix, 10) == PairMatrixInvalidClass);
+        assert(PairMatrixGetClass1(pairMatrix, 11) == 1);
+        assert(PairMatrixGetClass1(pairMatrix, 12) == 2);
+        assert(PairMatrixGetClass1(pairMatrix, 13) == PairMatrixInvalidClass);
+
+        /* Test that the glyphs outside second class definition fall in class zero. */
+        assert(PairMatrixGetClass2(pairMatrix, 0) == 0);
+        assert(PairMatrixGetClass2(pairMatrix, 21) == 1);
+        assert(PairMatrixGetClass2(pairMatrix, 22) == 2);
+        assert(PairMatrixGetClass2(pairMatrix, 23) == 0);
+
+        const SFInt16 *values = PairMatrixGetValues(pairMatrix, 1, 2);
+        const SFInt16 expected1[] = { 10, 20, 30, 40, -1, -2, -3, -4 };
+        assert(memcmp(values, expected1, sizeof(expected1)) == 0);
+
+        values = PairMatrixGetValues(pairMatrix, 2, 1);
+        const SFInt16 expected2[] = { -1, -2, -3, -4, 10, 20, 30, 40 };
+        assert(memcmp(values, expected2, sizeof(expected2)) == 0);
+
+        values = PairMatrixGetValues(pairMatrix, 1, 1);
+        const SFInt16 expected3[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        assert(memcmp(values, expected3, sizeof(expected3)) == 0);
+
+        PairMatrixDestroy(pairMatrix);
+
+        /* Test with truncated class records. */
+        assert(PairMatrixCreate(data, 16) == NULL);
+    }
+
+    /* Test that the subtables referring to device tables are not compiled. */
+    {
+        PairAdjustmentPosSubtable &pairPos = builder.createPairPos({ 11 }, classDefs, {
+            pair_rule { 1, 2, device, negative }
+        });
+
+        Writer writer;
+        writer.write(&pairPos);
+
+        assert(PairMatrixCreate(writer.data(), writer.size()) == NULL);
+    }
+
+    /* Test that the first format is not compiled. */
+    {
+        PairAdjustmentPosSubtable &pairPos = builder.createPairPos({
+            pair_rule { 1, 2, positive, negative }
+        });
+
+        Writer writer;
+        writer.write(&pairPos);
+
+        assert(PairMatrixCreate(writer.data(), writer.size()) == NULL);
+    }
+}
+
+void MiscTester::testPairCache()
+{
+    SFUInt8 table[16] = { 0 };
+    Data firstSubtable = &table[0];
+    Data secondSubtable = &table[8];
+    Data parent = NULL;
+    Data values = NULL;
+
+    PairCache pairCache;
+    PairCacheClear(&pairCache);
+
+    /* Test that an empty cache misses. */
+    assert(!PairCacheLookup(&pairCache, firstSubtable, 1, 2, &parent, &values));
+
+    /* Test that both the kerned and the unkerned pairs are found. */
+    PairCacheStore(&pairCache, firstSubtable, 1, 2, &table[2], &table[4]);
+    PairCacheStore(&pairCache, firstSubtable, 2, 1, NULL, NULL);
+
+    assert(PairCacheLookup(&pairCache, firstSubtable, 1, 2, &parent, &values));
+    assert(parent == &table[2] && values == &table[4]);
+    assert(PairCacheLookup(&pairCache, firstSubtable, 2, 1, &parent, &values));
+    assert(parent == NULL && values == NULL);
+
+    /* Test that the pairs of other subtables are not confused. */
+    assert(!PairCacheLookup(&pairCache, secondSubtable, 1, 2, &parent, &values));
+
+    /* Test that clearing the cache forgets all pairs. */
+    PairCacheClear(&pairCache);
+    assert(!PairCacheLookup(&pairCache, firstSubtable, 1, 2, &parent, &values));
+}
+
+void MiscTester::testDeltaCache()
+{
+    SFUInt8 table[16] = { 0 };
+    Data firstDevice = &table[0];
+    Data secondDevice = &table[8];
+    SFInt32 pixels = 0;
+
+    DeltaCache deltaCache;
+    DeltaCacheClear(&deltaCache);
+
+    /* Test that an empty cache misses. */
+    assert(!DeltaCacheLookup(&deltaCache, firstDevice, 12, &pixels));
+
+    /* Test that the pixels are found against the table and the size. */
+    DeltaCacheStore(&deltaCache, firstDevice, 12, -2);
+    DeltaCacheStore(&deltaCache, firstDevice, 16, 3);
+
+    assert(DeltaCacheLookup(&deltaCache, firstDevice, 12, &pixels));
+    assert(pixels == -2);
+    assert(DeltaCacheLookup(&deltaCache, firstDevice, 16, &pixels));
+    assert(pixels == 3);
+
+    /* Test that the pixels of other tables and sizes are not confused. */
+    assert(!DeltaCacheLookup(&deltaCache, secondDevice, 12, &pixels));
+    assert(!DeltaCacheLookup(&deltaCache, firstDevice, 13, &pixels));
+
+    /* Test that clearing the cache forgets all pixels. */
+    DeltaCacheClear(&deltaCache);
+    assert(!DeltaCacheLookup(&deltaCache, firstDevice, 12, &pixels));
+}
+
 void MiscTester::testDevicePixels()
 {
     Builder builder;
@@ -171,7 +422,7 @@ void MiscTester::testVariationPixels()
         Writer writer;
         writer.write(&varIndex);
 
-        assert(GetVariationPixels(writer.data(), storeTable, &coord, 1) == -130);
+        assert(GetVariationPixels(writer.data(), storeTable, NULL, &coord, 1) == -130);
     }
 
     /* Test with i8 delta only. */
@@ -180,7 +431,7 @@ void MiscTester::testVariationPixels()
         Writer writer;
         writer.write(&varIndex);
 
-        assert(GetVariationPixels(writer.data(), storeTable, &coord, 1) == 10);
+        assert(GetVariationPixels(writer.data(), storeTable, NULL, &coord, 1) == 10);
     }
 
     /* Test with both i16 and i8 delta. */
@@ -189,7 +440,119 @@ void MiscTester::testVariationPixels()
         Writer writer;
         writer.write(&varIndex);
 
-        assert(GetVariationPixels(writer.data(), storeTable, &coord, 1) == 240);
+        assert(GetVariationPixels(writer.data(), storeTable, NULL, &coord, 1) == 240);
+    }
+
+    /* Test with precomputed region scalars. */
+    {
+        VarScalar *regionScalars = CreateRegionScalars(storeTable, &coord, 1);
+        Int16 zero = 0;
+
+        for (UInt16 outer = 0; outer < 3; outer++) {
+            VariationIndexTable &varIndex = builder.createVariationIndex(outer, 0);
+            Writer writer;
+            writer.write(&varIndex);
+
+            /* The scalars must take precedence over the passed coordinates. */
+            assert(GetVariationPixels(writer.data(), storeTable, regionScalars, &zero, 1)
+                   == GetVariationPixels(writer.data(), storeTable, NULL, &coord, 1));
+        }
+
+        free(regionScalars);
+    }
+}
+
+void MiscTester::testFixedVariations()
+{
+    Builder builder;
+
+    /* Test the rounding of fixed point deltas. */
+    {
+        assert(RoundFixedDelta(0) == 0);
+        assert(RoundFixedDelta(0x7FFF) == 0);
+        assert(RoundFixedDelta(0x8000) == 1);
+        assert(RoundFixedDelta(0x2C000) == 3);
+        assert(RoundFixedDelta((UInt32)-0x7FFF) == 0);
+        assert(RoundFixedDelta((UInt32)-0x8000) == -1);
+        assert(RoundFixedDelta((UInt32)-0x2C000) == -3);
+        assert(RoundFixedDelta(0x7FFFFFFF) == 32768);
+        assert(RoundFixedDelta(0x80000000) == -32768);
+    }
+
+    /* Test the fixed point region scalars against the floating point ones. */
+    {
+        VariationRegionList &regionList = builder.createRegionList({
+            { axis_coords { 0.1f, 0.0f, 0.2f } }, { axis_coords { 0.0f, 0.3f, 1.0f } },
+            { axis_coords { -1.0f, -0.7f, 0.0f } }, { axis_coords { 0.2f, 0.9f, 1.0f } },
+            { axis_coords { 0.0f, 0.5f, 1.0f }, axis_coords { -0.6f, -0.1f, 0.0f } },
+        });
+        Writer writer;
+        writer.write(&regionList);
+
+        Data table = writer.data();
+
+        for (Int32 first = -0x4000; first <= 0x4000; first += 0x133) {
+            for (Int32 second = -0x4000; second <= 0x4000; second += 0x401) {
+                Int16 coords[] = { (Int16)first, (Int16)second };
+
+                for (UInt16 region = 0; region < 5; region++) {
+                    double floatScalar = CalculateScalarForRegion(table, region, coords, 2);
+                    UInt32 fixedScalar = CalculateFixedScalarForRegion(table, region, coords, 2);
+
+                    assert(fixedScalar <= FixedScalarOne);
+                    assert(abs(fixedScalar / 65536.0 - floatScalar) <= 2.0 / 65536.0);
+                }
+            }
+        }
+    }
+
+    /* Test the fixed point pixels against the floating point ones. */
+    {
+        VariationRegionList &regionList = builder.createRegionList({
+            { axis_coords { 0.0f, 1.0f, 1.0f } }, { axis_coords { 0.0f, 0.3f, 1.0f } },
+            { axis_coords { -1.0f, -1.0f, 0.0f } }, { axis_coords { 0.0f, 1.0f, 1.0f } },
+        });
+        vector<ItemVariationDataSubtable> varData = {
+            builder.createVariationData({ 0, 1, 2 }, { {{ 1000, -333 }, { 97 }}, {{ -977, 120 }, { -13 }} }),
+            builder.createVariationData({ 0, 3, 0 }, { {{ 32767, 32767, -32768 }, { }} }),
+        };
+        ItemVariationStoreTable &varStore = builder.createVariationStore(regionList,
+            { varData.data(), varData.size() });
+        Writer sw;
+        sw.write(&varStore);
+
+        Data storeTable = sw.data();
+
+        for (Int32 value = -0x4000; value <= 0x4000; value += 0x0F1) {
+            Int16 coord = (Int16)value;
+            UInt32 *regionScalars = CreateFixedRegionScalars(storeTable, &coord, 1);
+
+            for (UInt16 row = 0; row < 2; row++) {
+                VariationIndexTable &varIndex = builder.createVariationIndex(0, row);
+                Writer writer;
+                writer.write(&varIndex);
+
+                Int32 floatPixels = GetFloatVariationPixels(writer.data(), storeTable, NULL, &coord, 1);
+                Int32 fixedPixels = GetFixedVariationPixels(writer.data(), storeTable, NULL, &coord, 1);
+
+                assert(abs(fixedPixels - floatPixels) <= 1);
+                assert(GetFixedVariationPixels(writer.data(), storeTable, regionScalars, NULL, 0) == fixedPixels);
+            }
+
+            free(regionScalars);
+        }
+
+        /* Test with intermediate sums exceeding 32 bits. */
+        {
+            VariationIndexTable &varIndex = builder.createVariationIndex(1, 0);
+            Writer writer;
+            writer.write(&varIndex);
+
+            Int16 coord = toF2DOT14(1.0f);
+
+            assert(GetFloatVariationPixels(writer.data(), storeTable, NULL, &coord, 1) == 32766);
+            assert(GetFixedVariationPixels(writer.data(), storeTable, NULL, &coord, 1) == 32766);
+        }
     }
 }
 
@@ -296,8 +659,14 @@ void MiscTester::testFeatureSubst()
 
 void MiscTester::test()
 {
+    testCoverageIndex();
+    testGlyphClass();
+    testPairMatrix();
+    testPairCache();
+    testDeltaCache();
     testDevicePixels();
     testRegionListScalar();
     testVariationPixels();
+    testFixedVariations();
     testFeatureSubst();
 }
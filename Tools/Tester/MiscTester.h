@@ -24,9 +24,15 @@ class MiscTester {
 public:
     MiscTester();
 
+    void testCoverageIndex();
+    void testGlyphClass();
+    void testPairMatrix();
+    void testPairCache();
+    void testDeltaCache();
     void testDevicePixels();
     void testRegionListScalar();
     void testVariationPixels();
+    void testFixedVariations();
     void testFeatureSubst();
     void test();
 };
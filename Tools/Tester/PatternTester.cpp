@@ -16,8 +16,11 @@
 
 #include <cassert>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 extern "C" {
+#include <Source/SFFont.h>
 #include <Source/SFPattern.h>
 #include <Source/SFPatternBuilder.h>
 }
@@ -40,7 +43,9 @@ void PatternTester::testNoFeatures()
     SFPatternBuilder builder;
     SFPatternBuilderInitialize(&builder, pattern);
 
+    /* Keep the font alive beyond the reference of the pattern as it lives on the stack. */
     SFFont font;
+    font.retainCount = 1;
     SFPatternBuilderSetFont(&builder, &font);
     SFPatternBuilderSetScript(&builder, tag("arab"), SFTextDirectionRightToLeft);
     SFPatternBuilderSetLanguage(&builder, tag("URDU"));
@@ -324,10 +329,168 @@ void PatternTester::testLookupIndexSorting()
     }
 }
 
+void PatternTester::testLookupIndexReuse()
+{
+    SFPatternRef pattern = SFPatternCreate();
+
+    SFPatternBuilder builder;
+    SFPatternBuilderInitialize(&builder, pattern);
+
+    SFPatternBuilderBeginFeatures(&builder, SFFeatureKindSubstitution);
+
+    /* Test the features added in the reverse order of their tags. */
+    SFPatternBuilderAddFeature(&builder, tag("liga"), 1, 0);
+    SFPatternBuilderAddLookup(&builder, 65535);
+    SFPatternBuilderAddLookup(&builder, 9);
+
+    SFPatternBuilderAddFeature(&builder, tag("ccmp"), 2, 0);
+    SFPatternBuilderAddLookup(&builder, 9);
+    SFPatternBuilderAddLookup(&builder, 300);
+    SFPatternBuilderMakeFeatureUnit(&builder);
+
+    assert(SFPatternBuilderContainsFeature(&builder, tag("ccmp")));
+    assert(SFPatternBuilderContainsFeature(&builder, tag("liga")));
+    assert(!SFPatternBuilderContainsFeature(&builder, tag("calt")));
+    assert(!SFPatternBuilderContainsFeature(&builder, tag("rlig")));
+
+    /* Test that the lookups of previous unit are added again in a new unit. */
+    SFPatternBuilderAddFeature(&builder, tag("calt"), 3, 0);
+    SFPatternBuilderAddLookup(&builder, 300);
+    SFPatternBuilderAddLookup(&builder, 65535);
+    SFPatternBuilderMakeFeatureUnit(&builder);
+
+    SFPatternBuilderEndFeatures(&builder);
+
+    SFPatternBuilderBuild(&builder);
+    SFPatternBuilderFinalize(&builder);
+
+    SFTag expectedTags[] = {
+        tag("liga"),
+        tag("ccmp"),
+        tag("calt"),
+    };
+    SFLookupInfo expectedLookups[] = { {9, 2}, {300, 2}, {65535, 1},
+                                       {300, 3}, {65535, 3} };
+    SFFeatureUnit expectedUnits[] = {
+        { { &expectedLookups[0], 3 }, { 0, 2 }, 0x00 },
+        { { &expectedLookups[3], 2 }, { 2, 1 }, 0x00 }
+    };
+    SFPattern expectedPattern = {
+        NULL,
+        { expectedTags, 3 },
+        { expectedUnits, 2, 0 },
+        0,
+        0,
+        SFTextDirectionLeftToRight,
+        1
+    };
+    assert(SFPatternEqualToPattern(pattern, &expectedPattern));
+
+    SFPatternRelease(pattern);
+}
+
+void PatternTester::testSerialization()
+{
+    const SFFontProtocol protocol = {
+        NULL,
+        [](void *, SFTag, SFUInt8 *, SFUInteger *) { },
+        [](void *, SFCodepoint) -> SFGlyphID { return 0; },
+        [](void *, SFFontLayout, SFGlyphID) -> SFInt32 { return 0; }
+    };
+    SFFontRef font = SFFontCreateWithProtocol(&protocol, NULL);
+
+    SFPatternRef pattern = SFPatternCreate();
+
+    SFPatternBuilder builder;
+    SFPatternBuilderInitialize(&builder, pattern);
+    SFPatternBuilderSetFont(&builder, font);
+
+    SFPatternBuilderBeginFeatures(&builder, SFFeatureKindSubstitution);
+    SFPatternBuilderAddFeature(&builder, tag("ccmp"), 1, 0x01);
+    SFPatternBuilderAddLookup(&builder, 0);
+    SFPatternBuilderAddLookup(&builder, 40000);
+    SFPatternBuilderMakeFeatureUnit(&builder);
+    SFPatternBuilderAddFeature(&builder, tag("liga"), 2, 0x02);
+    SFPatternBuilderAddFeature(&builder, tag("clig"), 3, 0x02);
+    SFPatternBuilderAddLookup(&builder, 7);
+    SFPatternBuilderMakeFeatureUnit(&builder);
+    SFPatternBuilderEndFeatures(&builder);
+
+    SFPatternBuilderBeginFeatures(&builder, SFFeatureKindPositioning);
+    SFPatternBuilderAddFeature(&builder, tag("kern"), 4, 0x04);
+    SFPatternBuilderAddLookup(&builder, 3);
+    SFPatternBuilderMakeFeatureUnit(&builder);
+    SFPatternBuilderEndFeatures(&builder);
+
+    SFPatternBuilderSetScript(&builder, tag("arab"), SFTextDirectionRightToLeft);
+    SFPatternBuilderSetLanguage(&builder, tag("URDU"));
+    SFPatternBuilderBuild(&builder);
+    SFPatternBuilderFinalize(&builder);
+
+    SFUInteger length = SFPatternSerialize(pattern, NULL, 0);
+
+    /* Test that nothing is written in an insufficient buffer. */
+    {
+        std::vector<SFUInt8> blob(length, 0xFF);
+        assert(SFPatternSerialize(pattern, blob.data(), length - 1) == length);
+        assert(blob == std::vector<SFUInt8>(length, 0xFF));
+    }
+
+    std::vector<SFUInt8> blob(length);
+    assert(SFPatternSerialize(pattern, blob.data(), blob.size()) == length);
+
+    /* Test that the loaded pattern is equal to the original one. */
+    {
+        SFPatternRef loaded = SFPatternCreateFromBlob(font, blob.data(), blob.size());
+        assert(loaded != NULL);
+        assert(SFPatternEqualToPattern(loaded, pattern));
+
+        SFPatternRelease(loaded);
+    }
+
+    /* Test with a truncated image. */
+    {
+        assert(SFPatternCreateFromBlob(font, blob.data(), blob.size() - 1) == NULL);
+        assert(SFPatternCreateFromBlob(font, blob.data(), 8) == NULL);
+    }
+
+    /* Test with the image of a different font. */
+    {
+        std::vector<SFUInt8> corrupted(blob);
+        corrupted[8] ^= 0x01;
+
+        assert(SFPatternCreateFromBlob(font, corrupted.data(), corrupted.size()) == NULL);
+    }
+
+    /* Test with the lookups of a unit out of order. */
+    {
+        std::vector<SFUInt8> corrupted(blob);
+        size_t lookupOffset = length - (4 * 4);
+        std::swap(corrupted[lookupOffset + 0], corrupted[lookupOffset + 4]);
+        std::swap(corrupted[lookupOffset + 1], corrupted[lookupOffset + 5]);
+
+        assert(SFPatternCreateFromBlob(font, corrupted.data(), corrupted.size()) == NULL);
+    }
+
+    /* Test with a unit exceeding the range of features. */
+    {
+        std::vector<SFUInt8> corrupted(blob);
+        size_t unitOffset = 48 + (4 * 4);
+        corrupted[unitOffset + 11] = 5;
+
+        assert(SFPatternCreateFromBlob(font, corrupted.data(), corrupted.size()) == NULL);
+    }
+
+    SFPatternRelease(pattern);
+    SFFontRelease(font);
+}
+
 void PatternTester::test()
 {
     testNoFeatures();
     testDistinctFeatures();
     testSimultaneousFeatures();
     testLookupIndexSorting();
+    testLookupIndexReuse();
+    testSerialization();
 }
@@ -28,6 +28,8 @@ public:
     void testDistinctFeatures();
     void testSimultaneousFeatures();
     void testLookupIndexSorting();
+    void testLookupIndexReuse();
+    void testSerialization();
 
     void test();
 };
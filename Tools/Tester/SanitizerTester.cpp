@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2018 Muhammad Tayyab Akram
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <Source/Sanitizer.h>
+#include <Source/SFFont.h>
+}
+
+#include "Utilities/General.h"
+#include "SanitizerTester.h"
+
+using namespace std;
+using namespace SheenFigure::Tester;
+using namespace SheenFigure::Tester::Utilities;
+
+/* A GSUB table with a feature referring to two single substitution lookups. */
+static const SFUInt8 GSUB_TABLE[] = {
+    /* Header */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x0C, 0x00, 0x1C,
+    /* Script List (10) */
+    0x00, 0x00,
+    /* Feature List (12) */
+    0x00, 0x01, 't', 'e', 's', 't', 0x00, 0x08,
+    /* Feature (20) */
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01,
+    /* Lookup List (28) */
+    0x00, 0x02, 0x00, 0x06, 0x00, 0x1C,
+    /* Lookup 0 (34) */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08,
+    /* Single Substitution 0 (42) */
+    0x00, 0x01, 0x00, 0x06, 0x00, 0x01,
+    /* Coverage 0 (48) */
+    0x00, 0x01, 0x00, 0x02, 0x00, 0x0A, 0x00, 0x0B,
+    /* Lookup 1 (56) */
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08,
+    /* Single Substitution 1 (64) */
+    0x00, 0x01, 0x00, 0x06, 0x00, 0x01,
+    /* Coverage 1 (70) */
+    0x00, 0x01, 0x00, 0x02, 0x00, 0x0C, 0x00, 0x0D
+};
+
+static const SFUInteger FEATURE_INDEX_1_OFFSET = 26;
+static const SFUInteger LOOKUP_1_OFFSET = 56;
+static const SFUInteger SUBTABLE_1_OFFSET = 64;
+static const SFUInteger COVERAGE_1_GLYPHS_OFFSET = 74;
+
+static vector<SFUInt8> GSUB_DATA;
+
+static void loadTable(void *object, SFTag tableTag, SFUInt8 *buffer, SFUInteger *length)
+{
+    SFUInteger size = 0;
+
+    if (tableTag == tag("GSUB")) {
+        size = (SFUInteger)GSUB_DATA.size();
+
+        if (buffer) {
+            memcpy(buffer, GSUB_DATA.data(), GSUB_DATA.size());
+        }
+    }
+
+    if (length) {
+        *length = size;
+    }
+}
+
+static SFGlyphID getGlyphIDForCodepoint(void *object, SFCodepoint codepoint)
+{
+    return 0;
+}
+
+static vector<SFUInt8> createGSUB()
+{
+    return vector<SFUInt8>(GSUB_TABLE, GSUB_TABLE + sizeof(GSUB_TABLE));
+}
+
+static void appendUInt16(vector<SFUInt8> &data, SFUInt16 value)
+{
+    data.push_back((SFUInt8)(value >> 8));
+    data.push_back((SFUInt8)(value >> 0));
+}
+
+/**
+ * Creates a GSUB table whose single substitution lookups all refer to one large coverage, either
+ * through one shared subtable or through a separate subtable for each lookup.
+ */
+static vector<SFUInt8> createSharedGSUB(SFUInt16 lookupCount, SFUInt16 glyphCount, bool sharesSubtable)
+{
+    const SFUInteger lookupListOffset = 14;
+    const SFUInteger lookupsOffset = lookupListOffset + 2 + (lookupCount * 2);
+    const SFUInteger subtablesOffset = lookupsOffset + (lookupCount * 8);
+    const SFUInteger coverageOffset = subtablesOffset + (sharesSubtable ? 6 : lookupCount * 6);
+    vector<SFUInt8> data;
+
+    /* Header, empty script list and empty feature list. */
+    appendUInt16(data, 1);
+    appendUInt16(data, 0);
+    appendUInt16(data, 10);
+    appendUInt16(data, 12);
+    appendUInt16(data, (SFUInt16)lookupListOffset);
+    appendUInt16(data, 0);
+    appendUInt16(data, 0);
+
+    appendUInt16(data, lookupCount);
+    for (SFUInt16 i = 0; i < lookupCount; i++) {
+        appendUInt16(data, (SFUInt16)(lookupsOffset - lookupListOffset + (i * 8)));
+    }
+
+    for (SFUInt16 i = 0; i < lookupCount; i++) {
+        SFUInteger lookupOffset = lookupsOffset + (i * 8);
+        SFUInteger subtableOffset = subtablesOffset + (sharesSubtable ? 0 : i * 6);
+
+        appendUInt16(data, 1);
+        appendUInt16(data, 0);
+        appendUInt16(data, 1);
+        appendUInt16(data, (SFUInt16)(subtableOffset - lookupOffset));
+    }
+
+    for (SFUInt16 i = 0; i < (sharesSubtable ? 1 : lookupCount); i++) {
+        SFUInteger subtableOffset = subtablesOffset + (i * 6);
+
+        appendUInt16(data, 1);
+        appendUInt16(data, (SFUInt16)(coverageOffset - subtableOffset));
+        appendUInt16(data, 1);
+    }
+
+    appendUInt16(data, 1);
+    appendUInt16(data, glyphCount);
+    for (SFUInt16 i = 0; i < glyphCount; i++) {
+        appendUInt16(data, i);
+    }
+
+    return data;
+}
+
+static bool sanitizeGSUB(const vector<SFUInt8> &table, SFUInteger length, SFUInt8 *outMask)
+{
+    SFUInt8 *lookupMask = NULL;
+    bool isValid = SanitizeGSUB(table.data(), length, &lookupMask);
+
+    if (isValid) {
+        assert(lookupMask != NULL);
+        *outMask = lookupMask[0];
+    } else {
+        assert(lookupMask == NULL);
+    }
+
+    free(lookupMask);
+
+    return isValid;
+}
+
+SanitizerTester::SanitizerTester()
+{
+}
+
+void SanitizerTester::testValidTable()
+{
+    vector<SFUInt8> gsub = createGSUB();
+    SFUInt8 lookupMask = 0;
+
+    assert(sanitizeGSUB(gsub, gsub.size(), &lookupMask));
+    assert(lookupMask == 0x03);
+    assert(LookupMask_Contains(&lookupMask, 0));
+    assert(LookupMask_Contains(&lookupMask, 1));
+}
+
+void SanitizerTester::testMalformedHeader()
+{
+    vector<SFUInt8> gsub = createGSUB();
+    SFUInt8 lookupMask = 0;
+
+    /* Test with a header which is cut short. */
+    assert(!sanitizeGSUB(gsub, 8, &lookupMask));
+
+    /* Test with an unknown major version. */
+    gsub[1] = 0x02;
+    assert(!sanitizeGSUB(gsub, gsub.size(), &lookupMask));
+}
+
+void SanitizerTester::testOutOfRangeFeature()
+{
+    vector<SFUInt8> gsub = createGSUB();
+    SFUInt8 lookupMask = 0;
+
+    /* A feature referring to a missing lookup must reject the whole table. */
+    gsub[FEATURE_INDEX_1_OFFSET + 1] = 0x02;
+    assert(!sanitizeGSUB(gsub, gsub.size(), &lookupMask));
+}
+
+void SanitizerTester::testUnsortedCoverage()
+{
+    vector<SFUInt8> gsub = createGSUB();
+    SFUInt8 lookupMask = 0;
+
+    /* Swap the glyphs of second coverage so that it can no longer be binary searched. */
+    gsub[COVERAGE_1_GLYPHS_OFFSET + 1] = 0x0D;
+    gsub[COVERAGE_1_GLYPHS_OFFSET + 3] = 0x0C;
+
+    assert(sanitizeGSUB(gsub, gsub.size(), &lookupMask));
+    assert(lookupMask == 0x01);
+}
+
+void SanitizerTester::testTruncatedLookup()
+{
+    vector<SFUInt8> gsub = createGSUB();
+    SFUInt8 lookupMask = 0;
+
+    /* Cut the last glyph of second coverage. */
+    assert(sanitizeGSUB(gsub, gsub.size() - 1, &lookupMask));
+    assert(lookupMask == 0x01);
+
+    /* Point the subtable of second lookup outside of the table. */
+    gsub[LOOKUP_1_OFFSET + 6] = 0xFF;
+    assert(sanitizeGSUB(gsub, gsub.size(), &lookupMask));
+    assert(lookupMask == 0x01);
+}
+
+void SanitizerTester::testRecursiveExtension()
+{
+    vector<SFUInt8> gsub = createGSUB();
+    SFUInt8 lookupMask = 0;
+
+    /* Make the second lookup an extension pointing to itself. */
+    const SFUInt8 extension[] = { 0x00, 0x01, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00 };
+    gsub[LOOKUP_1_OFFSET + 1] = 0x07;
+    memcpy(&gsub[SUBTABLE_1_OFFSET], extension, sizeof(extension));
+
+    assert(sanitizeGSUB(gsub, gsub.size(), &lookupMask));
+    assert(lookupMask == 0x01);
+
+    /* Make the extension point outside of the table. */
+    gsub[SUBTABLE_1_OFFSET + 3] = 0x01;
+    gsub[SUBTABLE_1_OFFSET + 4] = 0x00;
+    gsub[SUBTABLE_1_OFFSET + 5] = 0x00;
+    gsub[SUBTABLE_1_OFFSET + 6] = 0xFF;
+    gsub[SUBTABLE_1_OFFSET + 7] = 0xEA;
+
+    assert(sanitizeGSUB(gsub, gsub.size(), &lookupMask));
+    assert(lookupMask == 0x01);
+}
+
+void SanitizerTester::testSharedSubtables()
+{
+    const SFUInt16 lookupCount = 2000;
+    const SFUInt16 glyphCount = 2000;
+
+    /* Test that a subtable shared by all lookups is validated only once. */
+    {
+        vector<SFUInt8> gsub = createSharedGSUB(lookupCount, glyphCount, true);
+        SFUInt8 *lookupMask = NULL;
+
+        assert(SanitizeGSUB(gsub.data(), gsub.size(), &lookupMask));
+        for (SFUInt16 i = 0; i < lookupCount; i++) {
+            assert(LookupMask_Contains(lookupMask, i));
+        }
+
+        free(lookupMask);
+    }
+
+    /* Test that a coverage shared by many subtables exhausts the operations of the table. */
+    {
+        vector<SFUInt8> gsub = createSharedGSUB(lookupCount, glyphCount, false);
+        SFUInt8 *lookupMask = NULL;
+
+        assert(!SanitizeGSUB(gsub.data(), gsub.size(), &lookupMask));
+        assert(lookupMask == NULL);
+    }
+
+    /* Test that a few subtables sharing the coverage stay within the operations of the table. */
+    {
+        vector<SFUInt8> gsub = createSharedGSUB(4, glyphCount, false);
+        SFUInt8 *lookupMask = NULL;
+
+        assert(SanitizeGSUB(gsub.data(), gsub.size(), &lookupMask));
+        assert(lookupMask[0] == 0x0F);
+
+        free(lookupMask);
+    }
+}
+
+void SanitizerTester::testGDEF()
+{
+    const SFUInt8 gdef[] = {
+        /* Header */
+        0x00, 0x01, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        /* Glyph Class Definition (12) */
+        0x00, 0x02, 0x00, 0x02, 0x00, 0x01, 0x00, 0x02, 0x00, 0x01, 0x00, 0x05, 0x00, 0x08, 0x00, 0x03
+    };
+    vector<SFUInt8> table(gdef, gdef + sizeof(gdef));
+
+    assert(SanitizeGDEF(table.data(), table.size()));
+    assert(!SanitizeGDEF(table.data(), table.size() - 1));
+
+    /* Make the class ranges overlap. */
+    table[23] = 0x02;
+    assert(!SanitizeGDEF(table.data(), table.size()));
+}
+
+void SanitizerTester::testSanitizedFont()
+{
+    SFFontProtocol protocol = {
+        NULL,
+        &loadTable,
+        &getGlyphIDForCodepoint,
+        NULL,
+    };
+
+    SFFontSetSanitizerEnabled(SFTrue);
+
+    /* Test that a malformed table is hidden from the shaping process. */
+    {
+        GSUB_DATA = createGSUB();
+        GSUB_DATA[1] = 0x02;
+
+        SFFontRef font = SFFontCreateWithProtocol(&protocol, NULL);
+        assert(SFFontGetGSUBTable(font) == NULL);
+        assert(SFFontGetGSUBLookupMask(font) == NULL);
+        SFFontRelease(font);
+    }
+
+    /* Test that a malformed lookup is left out while keeping the table. */
+    {
+        GSUB_DATA = createGSUB();
+        GSUB_DATA[COVERAGE_1_GLYPHS_OFFSET + 1] = 0x0D;
+
+        SFFontRef font = SFFontCreateWithProtocol(&protocol, NULL);
+        const SFUInt8 *lookupMask = SFFontGetGSUBLookupMask(font);
+        assert(SFFontGetGSUBTable(font) != NULL);
+        assert(lookupMask != NULL);
+        assert(LookupMask_Contains(lookupMask, 0));
+        assert(!LookupMask_Contains(lookupMask, 1));
+        SFFontRelease(font);
+    }
+
+    SFFontSetSanitizerEnabled(SFFalse);
+
+    /* Test that the tables are not validated if the sanitizer is disabled. */
+    {
+        GSUB_DATA = createGSUB();
+        GSUB_DATA[1] = 0x02;
+
+        SFFontRef font = SFFontCreateWithProtocol(&protocol, NULL);
+        assert(SFFontGetGSUBTable(font) != NULL);
+        assert(SFFontGetGSUBLookupMask(font) == NULL);
+        SFFontRelease(font);
+    }
+
+    GSUB_DATA.clear();
+}
+
+void SanitizerTester::test()
+{
+    testValidTable();
+    testMalformedHeader();
+    testOutOfRangeFeature();
+    testUnsortedCoverage();
+    testTruncatedLookup();
+    testRecursiveExtension();
+    testSharedSubtables();
+    testGDEF();
+    testSanitizedFont();
+}
@@ -17,6 +17,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <thread>
 #include <vector>
 
 extern "C" {
@@ -355,8 +356,209 @@ void SchemeTester::testBuild()
     SFFontRelease(font);
 }
 
+void SchemeTester::testPatternCache()
+{
+    const SFFontProtocol protocol = {
+        NULL,
+        &loadTable,
+        [](void *, SFCodepoint) -> SFGlyphID { return 0; },
+        [](void *, SFFontLayout, SFGlyphID) -> SFInt32 { return 0; }
+    };
+    SFFontRef font = SFFontCreateWithProtocol(&protocol, NULL);
+
+    SFScheme scheme;
+    SFSchemeInitialize(&scheme, TestKnowledge::instance());
+    SFSchemeSetFont(&scheme, font);
+    SFSchemeSetScriptTag(&scheme, tag("test"));
+    SFSchemeSetLanguageTag(&scheme, tag("dflt"));
+
+    SFTag featureTags[] = { tag("cust"), tag("srq1") };
+    SFUInt16 featureValues[] = { 1, 0 };
+
+    /* Build the expected patterns without the cache. */
+    SFPatternRef defaultPattern = SFSchemeBuildPattern(&scheme);
+    SFSchemeSetFeatureValues(&scheme, featureTags, featureValues, 2);
+    SFPatternRef customPattern = SFSchemeBuildPattern(&scheme);
+    SFSchemeSetFeatureValues(&scheme, NULL, NULL, 0);
+
+    SFSchemeSetPatternCacheEnabled(SFTrue);
+
+    /* Test that identical inputs give the same pattern. */
+    {
+        SFPatternRef first = SFSchemeBuildPattern(&scheme);
+        SFPatternRef second = SFSchemeBuildPattern(&scheme);
+
+        assert(first == second);
+        assert(first != defaultPattern);
+        assert(SFPatternEqualToPattern(first, defaultPattern));
+
+        SFPatternRelease(first);
+        SFPatternRelease(second);
+    }
+
+    /* Test that different inputs give different patterns. */
+    {
+        SFPatternRef plain = SFSchemeBuildPattern(&scheme);
+
+        SFSchemeSetFeatureValues(&scheme, featureTags, featureValues, 2);
+        SFPatternRef custom = SFSchemeBuildPattern(&scheme);
+        SFPatternRef again = SFSchemeBuildPattern(&scheme);
+
+        assert(custom != plain);
+        assert(custom == again);
+        assert(SFPatternEqualToPattern(custom, customPattern));
+
+        SFSchemeSetLanguageTag(&scheme, tag("LNG "));
+        SFPatternRef language = SFSchemeBuildPattern(&scheme);
+
+        assert(language != custom);
+        assert(SFPatternGetLanguageTag(language) == tag("LNG "));
+
+        SFPatternRelease(plain);
+        SFPatternRelease(custom);
+        SFPatternRelease(again);
+        SFPatternRelease(language);
+    }
+
+    /* Test that a cached pattern outlives the references of the caller. */
+    {
+        SFSchemeSetLanguageTag(&scheme, tag("dflt"));
+        SFSchemeSetFeatureValues(&scheme, NULL, NULL, 0);
+
+        SFPatternRef pattern = SFSchemeBuildPattern(&scheme);
+        assert(SFPatternEqualToPattern(pattern, defaultPattern));
+
+        SFPatternRelease(pattern);
+    }
+
+    SFSchemeSetPatternCacheEnabled(SFFalse);
+
+    SFPatternRelease(defaultPattern);
+    SFPatternRelease(customPattern);
+    SFSchemeFinalize(&scheme);
+    SFFontRelease(font);
+}
+
+void SchemeTester::testPatternCacheRelease()
+{
+    const SFFontProtocol protocol = {
+        [](void *object) { (*static_cast<int *>(object))++; },
+        &loadTable,
+        [](void *, SFCodepoint) -> SFGlyphID { return 0; },
+        [](void *, SFFontLayout, SFGlyphID) -> SFInt32 { return 0; }
+    };
+
+    SFSchemeSetPatternCacheEnabled(SFTrue);
+
+    /* Test that the cached patterns do not keep the font alive. */
+    {
+        int finalizeCount = 0;
+        SFFontRef font = SFFontCreateWithProtocol(&protocol, &finalizeCount);
+
+        SFScheme scheme;
+        SFSchemeInitialize(&scheme, TestKnowledge::instance());
+        SFSchemeSetFont(&scheme, font);
+        SFSchemeSetScriptTag(&scheme, tag("test"));
+        SFSchemeSetLanguageTag(&scheme, tag("dflt"));
+        SFPatternRelease(SFSchemeBuildPattern(&scheme));
+
+        SFSchemeSetLanguageTag(&scheme, tag("LNG "));
+        SFPatternRelease(SFSchemeBuildPattern(&scheme));
+        SFSchemeFinalize(&scheme);
+
+        SFFontRelease(font);
+        assert(finalizeCount == 1);
+    }
+
+    /* Test that a cached pattern retained by the caller keeps the font alive. */
+    {
+        int finalizeCount = 0;
+        SFFontRef font = SFFontCreateWithProtocol(&protocol, &finalizeCount);
+
+        SFScheme scheme;
+        SFSchemeInitialize(&scheme, TestKnowledge::instance());
+        SFSchemeSetFont(&scheme, font);
+        SFSchemeSetScriptTag(&scheme, tag("test"));
+        SFSchemeSetLanguageTag(&scheme, tag("dflt"));
+
+        SFPatternRef pattern = SFSchemeBuildPattern(&scheme);
+        SFPatternRef cached = SFSchemeBuildPattern(&scheme);
+        assert(pattern == cached);
+        SFPatternRelease(cached);
+        SFSchemeFinalize(&scheme);
+
+        SFFontRelease(font);
+        assert(finalizeCount == 0);
+        assert(SFPatternGetFont(pattern) == font);
+
+        SFPatternRelease(pattern);
+        assert(finalizeCount == 1);
+    }
+
+    SFSchemeSetPatternCacheEnabled(SFFalse);
+}
+
+void SchemeTester::testPatternCacheAcrossThreads()
+{
+    const SFFontProtocol protocol = {
+        [](void *object) { (*static_cast<int *>(object))++; },
+        &loadTable,
+        [](void *, SFCodepoint) -> SFGlyphID { return 0; },
+        [](void *, SFFontLayout, SFGlyphID) -> SFInt32 { return 0; }
+    };
+    int finalizeCount = 0;
+    SFFontRef font = SFFontCreateWithProtocol(&protocol, &finalizeCount);
+    vector<thread> threads;
+
+    SFSchemeSetPatternCacheEnabled(SFTrue);
+
+    /*
+     * Build, retain and release the cached patterns of one font on multiple threads. Each thread
+     * uses its own patterns so that they keep pinning and unpinning the font concurrently.
+     */
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(thread([font, i]() {
+            SFTag featureTag = tag("cust");
+            SFUInt16 featureValue = (SFUInt16)(i + 1);
+
+            SFScheme scheme;
+            SFSchemeInitialize(&scheme, TestKnowledge::instance());
+            SFSchemeSetFont(&scheme, font);
+            SFSchemeSetScriptTag(&scheme, tag("test"));
+            SFSchemeSetFeatureValues(&scheme, &featureTag, &featureValue, 1);
+
+            for (int j = 0; j < 1000; j++) {
+                SFSchemeSetLanguageTag(&scheme, (j & 1) ? tag("LNG ") : tag("dflt"));
+
+                SFPatternRef pattern = SFSchemeBuildPattern(&scheme);
+                SFPatternRef retained = SFPatternRetain(pattern);
+                assert(SFPatternGetFont(pattern) == font);
+
+                SFPatternRelease(pattern);
+                SFPatternRelease(retained);
+            }
+
+            SFSchemeFinalize(&scheme);
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    SFSchemeSetPatternCacheEnabled(SFFalse);
+
+    /* The cache alone must not be keeping the font alive. */
+    assert(font->retainCount == 1);
+    SFFontRelease(font);
+    assert(finalizeCount == 1);
+}
+
 void SchemeTester::test()
 {
     testFeatures();
     testBuild();
+    testPatternCache();
+    testPatternCacheRelease();
+    testPatternCacheAcrossThreads();
 }
@@ -26,6 +26,9 @@ public:
 
     void testFeatures();
     void testBuild();
+    void testPatternCache();
+    void testPatternCacheRelease();
+    void testPatternCacheAcrossThreads();
 
     void test();
 };
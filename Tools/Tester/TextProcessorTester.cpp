@@ -142,13 +142,64 @@ static void processSubtable(SFAlbumRef album,
     SFAlbumReset(album, &codepoints);
 
     /* Process the album. */
+    PairCache pairCache;
+    PairCacheClear(&pairCache);
+    DeltaCache deltaCache;
+    DeltaCacheClear(&deltaCache);
+
     TextProcessor processor;
-    TextProcessorInitialize(&processor, pattern, album, direction, 8, 10, SFFalse);
+    TextProcessorInitialize(&processor, pattern, album, &pairCache, &deltaCache, direction, 8, 10, SFFalse);
     TextProcessorDiscoverGlyphs(&processor);
     TextProcessorSubstituteGlyphs(&processor);
     TextProcessorPositionGlyphs(&processor);
     TextProcessorWrapUp(&processor);
 
+    /* Test that the pair records and pixels found in the caches produce the same positions. */
+    if (positioning) {
+        SFAlbum cachedAlbum;
+        SFAlbumInitialize(&cachedAlbum);
+        SFCodepointsInitialize(&codepoints, &sequence, SFFalse);
+        SFAlbumReset(&cachedAlbum, &codepoints);
+
+        TextProcessorInitialize(&processor, pattern, &cachedAlbum, &pairCache, &deltaCache, direction, 8, 10, SFFalse);
+        TextProcessorDiscoverGlyphs(&processor);
+        TextProcessorSubstituteGlyphs(&processor);
+        TextProcessorPositionGlyphs(&processor);
+        TextProcessorWrapUp(&processor);
+
+        SFUInteger glyphCount = SFAlbumGetGlyphCount(album);
+        assert(SFAlbumGetGlyphCount(&cachedAlbum) == glyphCount);
+        assert(memcmp(SFAlbumGetGlyphOffsetsPtr(&cachedAlbum), SFAlbumGetGlyphOffsetsPtr(album),
+                      sizeof(SFPoint) * glyphCount) == 0);
+        assert(memcmp(SFAlbumGetGlyphAdvancesPtr(&cachedAlbum), SFAlbumGetGlyphAdvancesPtr(album),
+                      sizeof(SFInt32) * glyphCount) == 0);
+
+        SFAlbumFinalize(&cachedAlbum);
+    }
+
+    /* Test that the same positions are produced without any cache. */
+    if (positioning) {
+        SFAlbum uncachedAlbum;
+        SFAlbumInitialize(&uncachedAlbum);
+        SFCodepointsInitialize(&codepoints, &sequence, SFFalse);
+        SFAlbumReset(&uncachedAlbum, &codepoints);
+
+        TextProcessorInitialize(&processor, pattern, &uncachedAlbum, NULL, NULL, direction, 8, 10, SFFalse);
+        TextProcessorDiscoverGlyphs(&processor);
+        TextProcessorSubstituteGlyphs(&processor);
+        TextProcessorPositionGlyphs(&processor);
+        TextProcessorWrapUp(&processor);
+
+        SFUInteger glyphCount = SFAlbumGetGlyphCount(album);
+        assert(SFAlbumGetGlyphCount(&uncachedAlbum) == glyphCount);
+        assert(memcmp(SFAlbumGetGlyphOffsetsPtr(&uncachedAlbum), SFAlbumGetGlyphOffsetsPtr(album),
+                      sizeof(SFPoint) * glyphCount) == 0);
+        assert(memcmp(SFAlbumGetGlyphAdvancesPtr(&uncachedAlbum), SFAlbumGetGlyphAdvancesPtr(album),
+                      sizeof(SFInt32) * glyphCount) == 0);
+
+        SFAlbumFinalize(&uncachedAlbum);
+    }
+
     /* Release the allocated objects. */
     SFPatternRelease(pattern);
     SFFontRelease(font);
@@ -17,12 +17,17 @@
 #include <Parser/ArabicShaping.h>
 
 #include "AlbumTester.h"
+#include "CharacterMapTester.h"
 #include "FontTester.h"
 #include "JoiningTypeLookupTester.h"
+#include "LayoutIndexTester.h"
 #include "ListTester.h"
 #include "LocatorTester.h"
+#include "LookupDigestTester.h"
+#include "MetricsTester.h"
 #include "MiscTester.h"
 #include "PatternTester.h"
+#include "SanitizerTester.h"
 #include "SchemeTester.h"
 #include "TextProcessorTester.h"
 
@@ -36,21 +41,31 @@ int main(int argc, const char * argv[])
 
     ArabicShaping arabicShaping(dir);
     JoiningTypeLookupTester joiningTypeLookupTester(arabicShaping);
+    LayoutIndexTester layoutIndexTester;
     ListTester listTester;
     AlbumTester albumTester;
+    CharacterMapTester characterMapTester;
     LocatorTester locatorTester;
+    LookupDigestTester lookupDigestTester;
+    MetricsTester metricsTester;
     FontTester fontTester;
     PatternTester patternTester;
+    SanitizerTester sanitizerTester;
     SchemeTester schemeTester;
     TextProcessorTester textProcessorTester;
     MiscTester miscTester;
 
     albumTester.test();
+    characterMapTester.test();
     fontTester.test();
     joiningTypeLookupTester.test();
+    layoutIndexTester.test();
     listTester.test();
     locatorTester.test();
+    lookupDigestTester.test();
+    metricsTester.test();
     patternTester.test();
+    sanitizerTester.test();
     schemeTester.test();
     textProcessorTester.test();
     miscTester.test();